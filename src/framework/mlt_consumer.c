@@ -31,6 +31,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <math.h>
 #include <stdatomic.h>
 
 /** Define this if you want an automatic deinterlace (if necessary) when the
@@ -77,6 +78,31 @@ typedef struct
 	int process_head;
 	atomic_int started;
 	pthread_t *threads; /**< used to deallocate all threads */
+	/* fields for adapting the worker threads at runtime */
+	int autotune;
+	int active_threads; /**< workers with a lower index take frames */
+	int thread_count; /**< the number of workers created */
+	atomic_int worker_index;
+	int threads_min;
+	int threads_max;
+	int buffer_min;
+	int buffer_max;
+	int tune_buffer;
+	int64_t render_time; /**< summed by the workers under done_mutex */
+	int render_count;
+	struct timeval tune_start;
+	int tune_frames;
+	int tune_dropped;
+	int tune_ready;
+	int tune_direction;
+	double tune_throughput;
+	/* fields for scheduling frames by their presentation deadline */
+	int deadline;
+	int frame_duration;
+	int clock_valid;
+	mlt_position clock_pos; /**< the position of the frame last output */
+	int64_t clock_time; /**< microseconds when the frame at clock_pos was output */
+	double render_estimate[mlt_quality_draft + 1]; /**< microseconds to render a frame in each quality */
 }
 consumer_private;
 
@@ -151,6 +177,7 @@ int mlt_consumer_init( mlt_consumer self, void *child, mlt_profile profile )
 		mlt_events_register( properties, "consumer-stopped" );
 		mlt_events_register( properties, "consumer-thread-create" );
 		mlt_events_register( properties, "consumer-thread-join" );
+		mlt_events_register( properties, "consumer-autotune" );
 		mlt_events_listen( properties, self, "consumer-frame-show", ( mlt_listener )on_consumer_frame_show );
 
 		// Register a property-changed listener to handle the profile property -
@@ -558,6 +585,35 @@ int mlt_consumer_start( mlt_consumer self )
 	if ( abs( priv->real_time ) > 1 && mlt_properties_get_int( properties, "buffer" ) <= abs( priv->real_time ) )
 		mlt_properties_set_int( properties, "_buffer", abs( priv->real_time ) + 1 );
 
+	// Set the bounds for adapting the worker threads
+	priv->active_threads = abs( priv->real_time );
+	priv->autotune = abs( priv->real_time ) > 1 && mlt_properties_get_int( properties, "autotune" );
+	if ( priv->autotune )
+	{
+		int threads = abs( priv->real_time );
+		int buffer = mlt_properties_get_int( properties, "buffer" );
+
+		priv->threads_min = MAX( mlt_properties_get_int( properties, "autotune_threads_min" ), 1 );
+		priv->threads_max = mlt_properties_get( properties, "autotune_threads_max" ) ?
+			mlt_properties_get_int( properties, "autotune_threads_max" ) : 2 * threads;
+		priv->threads_max = MAX( priv->threads_max, priv->threads_min );
+		priv->buffer_min = MAX( mlt_properties_get_int( properties, "autotune_buffer_min" ), 1 );
+		priv->buffer_max = mlt_properties_get( properties, "autotune_buffer_max" ) ?
+			mlt_properties_get_int( properties, "autotune_buffer_max" ) : MAX( buffer, ( priv->threads_max + 1 ) * 10 );
+		priv->buffer_max = MAX( priv->buffer_max, priv->threads_max + 1 );
+		priv->active_threads = CLAMP( threads, priv->threads_min, priv->threads_max );
+		priv->tune_buffer = CLAMP( MAX( buffer, priv->active_threads + 1 ), MAX( priv->buffer_min, priv->active_threads + 1 ), priv->buffer_max );
+		priv->tune_direction = 1;
+		priv->tune_throughput = 0.0;
+	}
+
+	// Set up scheduling frames by their presentation deadline
+	priv->deadline = priv->real_time > 0 && mlt_properties_get_int( properties, "deadline" );
+	priv->frame_duration = frame_duration;
+	priv->clock_valid = 0;
+	memset( priv->render_estimate, 0, sizeof( priv->render_estimate ) );
+	mlt_properties_set_int( properties, "degrade_count", 0 );
+
 	// Store the parameters for audio processing.
 	priv->aud_counter = 0;
 	priv->fps = mlt_properties_get_double( properties, "fps" );
@@ -716,6 +772,97 @@ static inline long time_difference( struct timeval *time1 )
 	return time1->tv_sec * 1000000 + time1->tv_usec - time2.tv_sec * 1000000 - time2.tv_usec;
 }
 
+/** Get the current time.
+ *
+ * \private \memberof mlt_consumer_s
+ * \return the time in microseconds
+ */
+
+static inline int64_t time_now( void )
+{
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	return (int64_t) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+/** Update the output clock when a frame is given to the consumer.
+ *
+ * The frame is taken to be presented now, and the frames after it one frame
+ * duration apart. The clock is not valid during trick-play because every
+ * frame is shown then. The caller must hold the queue mutex.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param priv the private data of a consumer
+ * \param frame the frame being output
+ */
+
+static void consumer_clock_update( consumer_private *priv, mlt_frame frame )
+{
+	if ( mlt_properties_get_int( MLT_FRAME_PROPERTIES( frame ), "_speed" ) == 1 && priv->frame_duration > 0 )
+	{
+		priv->clock_time = time_now();
+		priv->clock_pos = mlt_frame_get_position( frame );
+		priv->clock_valid = 1;
+	}
+	else
+	{
+		priv->clock_valid = 0;
+	}
+}
+
+/** Decide the quality at which to render a frame so that it is ready by its deadline.
+ *
+ * The deadline of a frame is when the output clock reaches its position.
+ * Frames behind the clock (after a seek) or without a clock have no deadline.
+ * The caller must hold the queue mutex.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param priv the private data of a consumer
+ * \param frame the frame to render
+ * \return the best quality that can be ready in time, or -1 if none can
+ */
+
+static int consumer_schedule_frame( consumer_private *priv, mlt_frame frame )
+{
+	mlt_position pos = mlt_frame_get_position( frame );
+	if ( !priv->clock_valid || pos <= priv->clock_pos )
+		return mlt_quality_full;
+	int64_t slack = priv->clock_time + ( pos - priv->clock_pos ) * priv->frame_duration - time_now();
+	int quality;
+	for ( quality = mlt_quality_full; quality <= mlt_quality_draft; quality++ )
+		if ( slack >= priv->render_estimate[ quality ] )
+			return quality;
+	return -1;
+}
+
+/** Update the estimated time to render a frame.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param priv the private data of a consumer
+ * \param quality the quality at which the frame was rendered
+ * \param usec the microseconds it took
+ */
+
+static void consumer_estimate_update( consumer_private *priv, mlt_quality quality, int64_t usec )
+{
+	double *estimate = &priv->render_estimate[ quality ];
+	*estimate = *estimate > 0.0 ? 0.8 * *estimate + 0.2 * usec : usec;
+}
+
+/** Count the frames given to the consumer that were rendered in less than full quality.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param properties the properties of a consumer
+ * \param frame the frame being output
+ */
+
+static void consumer_count_degraded( mlt_properties properties, mlt_frame frame )
+{
+	if ( mlt_frame_get_quality( frame ) > mlt_quality_full &&
+		 mlt_properties_get_int( MLT_FRAME_PROPERTIES( frame ), "rendered" ) )
+		mlt_properties_set_int( properties, "degrade_count", mlt_properties_get_int( properties, "degrade_count" ) + 1 );
+}
+
 /** The thread procedure for asynchronously pulling frames through the service
  * network connected to a consumer.
  *
@@ -754,6 +901,8 @@ static void *consumer_read_ahead_thread( void *arg )
 
 	// Time structures
 	struct timeval ante;
+	struct timeval render_start;
+	mlt_quality quality = mlt_quality_full;
 
 	// Average time for get_frame and get_image
 	int count = 0;
@@ -858,6 +1007,25 @@ static void *consumer_read_ahead_thread( void *arg )
 			start_pos = pos;
 		}
 
+		// Schedule the frame by its deadline instead of the average cost
+		quality = mlt_quality_full;
+		if ( priv->deadline && priv->speed == 1 )
+		{
+			pthread_mutex_lock( &priv->queue_mutex );
+			int schedule = consumer_schedule_frame( priv, frame );
+			pthread_mutex_unlock( &priv->queue_mutex );
+
+			// Degrade rather than drop too many consecutive frames
+			if ( schedule < 0 && skipped >= drop_max )
+				schedule = mlt_quality_draft;
+			skip_next = schedule < 0;
+			if ( schedule > mlt_quality_full )
+			{
+				quality = schedule;
+				mlt_frame_set_quality( frame, quality );
+			}
+		}
+
 		// If skip flag not set or frame-dropping disabled
 		if ( !skip_next || priv->real_time == -1 )
 		{
@@ -870,7 +1038,15 @@ static void *consumer_read_ahead_thread( void *arg )
 				// Get the image
 				mlt_events_fire( MLT_CONSUMER_PROPERTIES( self ), "consumer-frame-render", mlt_event_data_from_frame(frame) );
 				mlt_log_timings_begin();
+				gettimeofday( &render_start, NULL );
 				mlt_frame_get_image( frame, &image, &priv->image_format, &width, &height, 0 );
+				if ( priv->deadline )
+				{
+					long render_time = time_difference( &render_start );
+					pthread_mutex_lock( &priv->queue_mutex );
+					consumer_estimate_update( priv, quality, render_time );
+					pthread_mutex_unlock( &priv->queue_mutex );
+				}
 				mlt_log_timings_end( NULL, "mlt_frame_get_image" );
 			}
 
@@ -983,6 +1159,39 @@ static inline int first_unprocessed_frame( mlt_consumer self )
 	return index;
 }
 
+/** Locate the unprocessed frame with the nearest deadline that can still meet it.
+ *
+ * This is used instead of first_unprocessed_frame() when scheduling by
+ * deadline. Frames that cannot be ready in time are left for the output to
+ * drop. The caller must hold the queue mutex.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param self a consumer
+ * \param[out] quality set to the quality at which to render the frame
+ * \return an index into the queue
+ */
+
+static int deadline_unprocessed_frame( mlt_consumer self, mlt_quality *quality )
+{
+	consumer_private *priv = self->local;
+	int count = mlt_deque_count( priv->queue );
+	int index;
+	for ( index = 0; index < count; index++ )
+	{
+		mlt_frame frame = mlt_deque_peek( priv->queue, index );
+		if ( !frame->is_processing )
+		{
+			int schedule = consumer_schedule_frame( priv, frame );
+			if ( schedule >= 0 )
+			{
+				*quality = schedule;
+				break;
+			}
+		}
+	}
+	return index;
+}
+
 /** The worker thread procedure for parallel processing frames.
  *
  * \private \memberof mlt_consumer_s
@@ -1012,6 +1221,13 @@ static void *consumer_worker_thread( void *arg )
 	mlt_frame frame = NULL;
 	uint8_t *image = NULL;
 
+	// Workers beyond the active count wait when adapting the thread count
+	int worker_index = atomic_fetch_add( &priv->worker_index, 1 );
+	struct timeval start;
+	long render_time = 0;
+	mlt_quality quality = mlt_quality_full;
+	mlt_quality rendered_quality = mlt_quality_full;
+
 	if ( preview_off && preview_format != 0 )
 		format = preview_format;
 
@@ -1022,13 +1238,18 @@ static void *consumer_worker_thread( void *arg )
 	{
 		// Get the next unprocessed frame from the work queue
 		pthread_mutex_lock( &priv->queue_mutex );
-		int index = first_unprocessed_frame( self );
-		while ( priv->ahead && index >= mlt_deque_count( priv->queue ) )
+		if ( priv->deadline && render_time )
+			consumer_estimate_update( priv, rendered_quality, render_time );
+		render_time = 0;
+		quality = mlt_quality_full;
+		int index = priv->deadline ? deadline_unprocessed_frame( self, &quality ) : first_unprocessed_frame( self );
+		while ( priv->ahead && ( index >= mlt_deque_count( priv->queue ) || worker_index >= priv->active_threads ) )
 		{
 			mlt_log_debug( MLT_CONSUMER_SERVICE(self), "waiting in worker index = %d queue count = %d\n",
 				index, mlt_deque_count( priv->queue ) );
 			pthread_cond_wait( &priv->queue_cond, &priv->queue_mutex );
-			index = first_unprocessed_frame( self );
+			quality = mlt_quality_full;
+			index = priv->deadline ? deadline_unprocessed_frame( self, &quality ) : first_unprocessed_frame( self );
 		}
 
 		// Mark the frame for processing
@@ -1039,6 +1260,9 @@ static void *consumer_worker_thread( void *arg )
 				index, mlt_frame_get_position(frame), mlt_deque_count( priv->queue ) );
 			frame->is_processing = 1;
 			mlt_properties_inc_ref( MLT_FRAME_PROPERTIES( frame ) );
+			if ( quality > mlt_quality_full )
+				mlt_frame_set_quality( frame, quality );
+			rendered_quality = quality;
 		}
 		pthread_mutex_unlock( &priv->queue_mutex );
 
@@ -1062,6 +1286,7 @@ static void *consumer_worker_thread( void *arg )
 			width = mlt_properties_get_int( properties, "width" );
 			height = mlt_properties_get_int( properties, "height" );
 			mlt_events_fire( MLT_CONSUMER_PROPERTIES( self ), "consumer-frame-render", mlt_event_data_from_frame(frame) );
+			gettimeofday( &start, NULL );
 			mlt_frame_get_image( frame, &image, &format, &width, &height, 0 );
 		}
 		mlt_properties_set_int( MLT_FRAME_PROPERTIES( frame ), "rendered", 1 );
@@ -1069,6 +1294,12 @@ static void *consumer_worker_thread( void *arg )
 
 		// Tell a waiting thread (non-realtime main consumer thread) that we are done.
 		pthread_mutex_lock( &priv->done_mutex );
+		if ( !video_off )
+		{
+			render_time = time_difference( &start );
+			priv->render_time += render_time;
+			priv->render_count++;
+		}
 		pthread_cond_broadcast( &priv->done_cond );
 		pthread_mutex_unlock( &priv->done_mutex );
 	}
@@ -1106,47 +1337,19 @@ static void consumer_read_ahead_start( mlt_consumer self )
 	priv->started = 1;
 }
 
-/** Start the worker threads.
+/** Create more worker threads.
  *
  * \private \memberof mlt_consumer_s
  * \param self a consumer
+ * \param n the number of threads to add
  */
 
-static void consumer_work_start( mlt_consumer self )
+static void consumer_work_spawn( mlt_consumer self, int n )
 {
 	consumer_private *priv = self->local;
-	int n = abs( priv->real_time );
-	pthread_t *thread;
-
-	if ( priv->started )
-		return;
-
-	thread = calloc( 1, sizeof( pthread_t ) * n );
-
-	// We're running now
-	priv->ahead = 1;
-	priv->threads = thread;
-	
-	// These keep track of the acceleration of frame dropping or recovery.
-	priv->consecutive_dropped = 0;
-	priv->consecutive_rendered = 0;
-	
-	// This is the position in the queue from which to look for a frame to process.
-	// If we always start from the head, then we may likely not complete processing
-	// before the frame is played out.
-	priv->process_head = 0;
+	pthread_t *thread = priv->threads + priv->thread_count;
 
-	// Create the queues
-	priv->queue = mlt_deque_init();
-	priv->worker_threads = mlt_deque_init();
-
-	// Create the mutexes
-	pthread_mutex_init( &priv->queue_mutex, NULL );
-	pthread_mutex_init( &priv->done_mutex, NULL );
-
-	// Create the conditions
-	pthread_cond_init( &priv->queue_cond, NULL );
-	pthread_cond_init( &priv->done_cond, NULL );
+	priv->thread_count += n;
 
 	// Create the read ahead
 	if ( mlt_properties_get( MLT_CONSUMER_PROPERTIES( self ), "priority" ) )
@@ -1184,6 +1387,58 @@ static void consumer_work_start( mlt_consumer self )
 			thread++;
 		}
 	}
+}
+
+/** Start the worker threads.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param self a consumer
+ */
+
+static void consumer_work_start( mlt_consumer self )
+{
+	consumer_private *priv = self->local;
+	int n = priv->autotune ? priv->threads_max : abs( priv->real_time );
+
+	if ( priv->started )
+		return;
+
+	// We're running now
+	priv->ahead = 1;
+	priv->threads = calloc( 1, sizeof( pthread_t ) * n );
+	priv->thread_count = 0;
+	priv->worker_index = 0;
+
+	// These keep track of the acceleration of frame dropping or recovery.
+	priv->consecutive_dropped = 0;
+	priv->consecutive_rendered = 0;
+	
+	// This is the position in the queue from which to look for a frame to process.
+	// If we always start from the head, then we may likely not complete processing
+	// before the frame is played out.
+	priv->process_head = 0;
+
+	// These measure the workers over a period for adapting them.
+	priv->render_time = 0;
+	priv->render_count = 0;
+	priv->tune_frames = 0;
+	priv->tune_dropped = 0;
+	priv->tune_ready = 0;
+	gettimeofday( &priv->tune_start, NULL );
+
+	// Create the queues
+	priv->queue = mlt_deque_init();
+	priv->worker_threads = mlt_deque_init();
+
+	// Create the mutexes
+	pthread_mutex_init( &priv->queue_mutex, NULL );
+	pthread_mutex_init( &priv->done_mutex, NULL );
+
+	// Create the conditions
+	pthread_cond_init( &priv->queue_cond, NULL );
+	pthread_cond_init( &priv->done_cond, NULL );
+
+	consumer_work_spawn( self, priv->active_threads );
 	priv->started = 1;
 }
 
@@ -1318,6 +1573,7 @@ void mlt_consumer_purge( mlt_consumer self )
 
 		if ( priv->started && priv->real_time )
 		{
+			priv->clock_valid = 0;
 			priv->is_purge = 1;
 			pthread_cond_broadcast( &priv->queue_cond );
 			pthread_mutex_unlock( &priv->queue_mutex );
@@ -1339,6 +1595,110 @@ void mlt_consumer_purge( mlt_consumer self )
 	}
 }
 
+/** Adapt the number of worker threads and the size of the buffer.
+ *
+ * This measures the workers over a period of about a second. With frame
+ * dropping, it adds workers and buffer when frames are dropped or none are
+ * ready in time, and removes them while the remaining workers would keep up.
+ * Without frame dropping, it moves the number of workers in the direction
+ * that raises the rate of frames.
+ *
+ * \private \memberof mlt_consumer_s
+ * \param self a consumer
+ * \param properties the consumer's properties
+ * \param rendered whether the frame taken from the queue was rendered in time
+ * \param ready the number of rendered frames that were at the head of the queue
+ */
+
+static void consumer_autotune( mlt_consumer self, mlt_properties properties, int rendered, int ready )
+{
+	consumer_private *priv = self->local;
+	struct timeval now;
+	int64_t elapsed;
+	int threads = priv->active_threads;
+	int buffer = priv->tune_buffer;
+	double render_time = 0.0;
+	double throughput;
+
+	priv->tune_frames++;
+	priv->tune_ready += ready;
+	if ( !rendered )
+		priv->tune_dropped++;
+
+	gettimeofday( &now, NULL );
+	elapsed = ( now.tv_sec - priv->tune_start.tv_sec ) * 1000000LL + now.tv_usec - priv->tune_start.tv_usec;
+	if ( elapsed < 1000000 || priv->tune_frames < 2 * threads )
+		return;
+
+	pthread_mutex_lock( &priv->done_mutex );
+	if ( priv->render_count )
+		render_time = (double) priv->render_time / priv->render_count;
+	priv->render_time = 0;
+	priv->render_count = 0;
+	pthread_mutex_unlock( &priv->done_mutex );
+	throughput = priv->tune_frames * 1000000.0 / elapsed;
+
+	if ( priv->real_time > 0 )
+	{
+		double interval = priv->fps > 0 ? 1000000.0 / priv->fps : 40000.0;
+		int needed = ceil( render_time * 1.25 / interval );
+
+		if ( priv->tune_dropped || priv->tune_ready < priv->tune_frames )
+		{
+			threads = MAX( threads + 1, needed );
+			buffer += threads;
+		}
+		else if ( needed < threads && 2 * priv->tune_ready > buffer * priv->tune_frames )
+		{
+			threads--;
+			buffer--;
+		}
+	}
+	else
+	{
+		// Keep going while the rate improves, and turn back when it worsens
+		if ( priv->tune_throughput > 0.0 && throughput < priv->tune_throughput * 0.97 )
+			priv->tune_direction = -priv->tune_direction;
+		if ( priv->tune_throughput == 0.0 || throughput > priv->tune_throughput * 1.03 || throughput < priv->tune_throughput * 0.97 )
+		{
+			threads += priv->tune_direction;
+			if ( threads < priv->threads_min || threads > priv->threads_max )
+				priv->tune_direction = -priv->tune_direction;
+			priv->tune_throughput = throughput;
+		}
+		buffer = 2 * threads;
+	}
+	threads = CLAMP( threads, priv->threads_min, priv->threads_max );
+	buffer = CLAMP( buffer, MAX( priv->buffer_min, threads + 1 ), priv->buffer_max );
+
+	if ( threads != priv->active_threads || buffer != priv->tune_buffer )
+	{
+		mlt_log_verbose( MLT_CONSUMER_SERVICE( self ), "autotune threads %d buffer %d render %.1f ms ready %.1f\n",
+			threads, buffer, render_time / 1000.0, (double) priv->tune_ready / priv->tune_frames );
+		if ( threads > priv->thread_count )
+			consumer_work_spawn( self, threads - priv->thread_count );
+		pthread_mutex_lock( &priv->queue_mutex );
+		priv->active_threads = threads;
+		priv->tune_buffer = buffer;
+		priv->process_head = CLAMP( priv->process_head, 0, buffer - threads );
+		pthread_cond_broadcast( &priv->queue_cond );
+		pthread_mutex_unlock( &priv->queue_mutex );
+	}
+
+	mlt_properties_set_int( properties, "autotune.threads", threads );
+	mlt_properties_set_int( properties, "autotune.buffer", buffer );
+	mlt_properties_set_double( properties, "autotune.render_time", render_time / 1000.0 );
+	mlt_properties_set_double( properties, "autotune.ready", (double) priv->tune_ready / priv->tune_frames );
+	mlt_properties_set_double( properties, "autotune.fps", throughput );
+	mlt_properties_set_int( properties, "autotune.dropped", priv->tune_dropped );
+	mlt_events_fire( properties, "consumer-autotune", mlt_event_data_none() );
+
+	priv->tune_start = now;
+	priv->tune_frames = 0;
+	priv->tune_dropped = 0;
+	priv->tune_ready = 0;
+}
+
 /** Use multiple worker threads and a work queue.
  */
 
@@ -1347,15 +1707,17 @@ static mlt_frame worker_get_frame( mlt_consumer self, mlt_properties properties
 	// Frame to return
 	mlt_frame frame = NULL;
 	consumer_private *priv = self->local;
-	int threads = abs( priv->real_time );
+	int threads = priv->active_threads;
 	int audio_off = mlt_properties_get_int( properties, "audio_off" );
 	int samples = 0;
+	int ready = 0;
+	int rendered = 0;
 	void *audio = NULL;
 	int buffer = mlt_properties_get_int( properties, "_buffer" );
 	buffer = buffer > 0 ? buffer : mlt_properties_get_int( properties, "buffer" );
 	// This is a heuristic to determine a suitable minimum buffer size for the number of threads.
 	int headroom = (priv->real_time < 0) ? threads : (2 + threads * threads);
-	buffer = MAX(buffer, headroom);
+	buffer = priv->autotune ? priv->tune_buffer : MAX(buffer, headroom);
 
 	// Start worker threads if not already started.
 	if ( ! priv->ahead )
@@ -1434,12 +1796,19 @@ static mlt_frame worker_get_frame( mlt_consumer self, mlt_properties properties
 
 	// Get the frame from the queue.
 	pthread_mutex_lock( &priv->queue_mutex );
+	if ( priv->autotune )
+		while ( ready < mlt_deque_count( priv->queue ) &&
+			mlt_properties_get_int( MLT_FRAME_PROPERTIES( MLT_FRAME( mlt_deque_peek( priv->queue, ready ) ) ), "rendered" ) )
+			ready++;
 	frame = mlt_deque_pop_front( priv->queue );
+	if ( priv->deadline && frame )
+		consumer_clock_update( priv, frame );
 	pthread_mutex_unlock( &priv->queue_mutex );
 	if ( ! frame ) {
 		priv->is_purge = 0;
 		return frame;
 	}
+	rendered = mlt_properties_get_int( MLT_FRAME_PROPERTIES( frame ), "rendered" );
 
 	// Adapt the worker process head to the runtime conditions.
 	if ( priv->real_time > 0 )
@@ -1471,7 +1840,7 @@ static mlt_frame worker_get_frame( mlt_consumer self, mlt_properties properties
 			mlt_log_verbose( self, "too many frames dropped - " );
 
 			// If using a default low-latency buffer level (SDL) and below the limit
-			if ( ( orig_buffer == 1 || prefill == 1 ) && buffer < (threads + 1) * 10 )
+			if ( !priv->autotune && ( orig_buffer == 1 || prefill == 1 ) && buffer < (threads + 1) * 10 )
 			{
 				// Auto-scale the buffer to compensate
 				mlt_log_verbose( self, "increasing buffer to %d\n", buffer + threads );
@@ -1492,7 +1861,11 @@ static mlt_frame worker_get_frame( mlt_consumer self, mlt_properties properties
 			mlt_properties_set_int( properties, "drop_count", ++dropped );
 			mlt_log_verbose( MLT_CONSUMER_SERVICE(self), "dropped video frame %d\n", dropped );
 		}
+		if ( priv->deadline )
+			consumer_count_degraded( properties, frame );
 	}
+	if ( priv->autotune && !priv->is_purge )
+		consumer_autotune( self, properties, rendered, ready );
 	if ( priv->is_purge ) {
 		priv->is_purge = 0;
 		mlt_frame_close( frame );
@@ -1549,6 +1922,8 @@ mlt_frame mlt_consumer_rt_frame( mlt_consumer self )
 		while( priv->ahead && mlt_deque_count( priv->queue ) < size )
 			pthread_cond_wait( &priv->queue_cond, &priv->queue_mutex );
 		frame = mlt_deque_pop_front( priv->queue );
+		if ( priv->deadline && frame )
+			consumer_clock_update( priv, frame );
 		mlt_log_timings_end( NULL, "wait_for_frame_queue" );
 		pthread_cond_broadcast( &priv->queue_cond );
 		pthread_mutex_unlock( &priv->queue_mutex );
@@ -1559,6 +1934,8 @@ mlt_frame mlt_consumer_rt_frame( mlt_consumer self )
 			mlt_properties_set_int( properties, "drop_count", ++dropped );
 			mlt_log_verbose( MLT_CONSUMER_SERVICE(self), "dropped video frame %d\n", dropped );
 		}
+		if ( priv->deadline && frame )
+			consumer_count_degraded( properties, frame );
 	}
 	else // real_time == 0
 	{
@@ -85,6 +85,28 @@
  * \properties \em audio_off set non-zero to disable audio processing
  * \properties \em video_off set non-zero to disable video processing
  * \properties \em drop_count the number of video frames not rendered since starting consumer
+ * \properties \em deadline set non-zero to schedule rendering by the presentation time of each
+ *   frame when real_time is greater than 0: workers render the nearest frame that can still be
+ *   ready in time, and a frame that would be late in full quality is rendered at a lower
+ *   mlt_quality (see mlt_frame_get_quality) before any frame is dropped
+ * \properties \em degrade_count the number of video frames rendered at less than full quality
+ *   since starting consumer with deadline; compare with drop_count
+ * \properties \em autotune set non-zero to adapt the number of worker threads and the buffer
+ *   while running, when real_time is greater than 1 or less than -1
+ * \properties \em autotune_threads_min the fewest worker threads to use with autotune, defaults to 1
+ * \properties \em autotune_threads_max the most worker threads to use with autotune, defaults to
+ *   twice the absolute value of real_time
+ * \properties \em autotune_buffer_min the smallest buffer to use with autotune, defaults to 1
+ * \properties \em autotune_buffer_max the largest buffer to use with autotune, defaults to
+ *   buffer or 10 frames per thread, whichever is more
+ * \properties \em autotune.threads the number of worker threads in use (read only)
+ * \properties \em autotune.buffer the buffer size in use (read only)
+ * \properties \em autotune.render_time the average milliseconds to render a frame in a worker (read only)
+ * \properties \em autotune.ready the average number of rendered frames waiting at output (read only)
+ * \properties \em autotune.fps the rate of frames output (read only)
+ * \properties \em autotune.dropped the number of frames not rendered in time (read only)
+ * \event \em consumer-autotune The base class fires this about once a second with autotune
+ *   after updating the autotune properties.
  */
 
 struct mlt_consumer_s
@@ -24,6 +24,7 @@
 #include <string.h>
 #include <pthread.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include "mlt_properties.h"
 #include "mlt_events.h"
@@ -45,10 +46,27 @@ static int events_destroyed = 0;
  * services.
  */
 
+/** \brief The listeners for one type of event
+ *
+ */
+
+typedef struct
+{
+	char *id;             /**< the name of the event, or NULL until it is registered */
+	mlt_event *events;    /**< the listeners, with NULL where one was disconnected */
+	int count;            /**< the number of entries in use in events */
+	int size;             /**< the number of entries allocated in events */
+	atomic_int listening; /**< the number of connected listeners, read without locking */
+}
+event_list;
+
 struct mlt_events_struct
 {
 	mlt_properties owner;
-	mlt_properties listeners;
+	event_list property_changed; /**< reserved for "property-changed", the most frequent event */
+	event_list **lists;          /**< all other registered events */
+	int count;
+	pthread_mutex_t mutex;
 };
 
 typedef struct mlt_events_struct *mlt_events;
@@ -60,12 +78,40 @@ typedef struct mlt_events_struct *mlt_events;
 struct mlt_event_struct
 {
 	mlt_events parent;
+	event_list *list;
 	int ref_count;
 	int block_count;
 	mlt_listener listener;
 	void *listener_data;
 };
 
+/* Private to the framework and defined in mlt_properties.c.
+*/
+
+extern mlt_events mlt_properties_get_events( mlt_properties self );
+extern void mlt_properties_set_events( mlt_properties self, mlt_events events );
+
+/** Disconnect an event from its events object.
+ *
+ * \private \memberof mlt_event_struct
+ * \param self an event
+ */
+
+static void mlt_event_detach( mlt_event self )
+{
+	mlt_events events = self->parent;
+	if ( events != NULL )
+	{
+		pthread_mutex_lock( &events->mutex );
+		if ( self->parent != NULL )
+		{
+			atomic_fetch_sub( &self->list->listening, 1 );
+			self->parent = NULL;
+		}
+		pthread_mutex_unlock( &events->mutex );
+	}
+}
+
 /** Increment the reference count on self event.
  *
  * \public \memberof mlt_event_struct
@@ -113,7 +159,7 @@ void mlt_event_close( mlt_event self )
 	if ( self != NULL )
 	{
 		if ( -- self->ref_count == 1 )
-			self->parent = NULL;
+			mlt_event_detach( self );
 		if ( self->ref_count <= 0 )
 		{
 #ifdef _MLT_EVENT_CHECKS_
@@ -142,13 +188,36 @@ void mlt_events_init( mlt_properties self )
 	if (!events && self) {
 		events = calloc( 1, sizeof( struct mlt_events_struct ) );
 		if (events) {
-			events->listeners = mlt_properties_new( );
+			pthread_mutexattr_t attr;
+			pthread_mutexattr_init( &attr );
+			pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+			pthread_mutex_init( &events->mutex, &attr );
+			pthread_mutexattr_destroy( &attr );
 			events->owner = self;
 			mlt_properties_set_data( self, "_events", events, 0, ( mlt_destructor )mlt_events_close, NULL );
+			mlt_properties_set_events( self, events );
 		}
 	}
 }
 
+/** Find the listeners of an event.
+ *
+ * \private \memberof mlt_events_struct
+ * \param events an events object, which must be locked
+ * \param id the name of an event
+ * \return the list of listeners or NULL if the event is not registered
+ */
+
+static event_list *mlt_events_find( mlt_events events, const char *id )
+{
+	if ( !strcmp( id, "property-changed" ) )
+		return events->property_changed.id ? &events->property_changed : NULL;
+	for ( int i = 0; i < events->count; i ++ )
+		if ( !strcmp( events->lists[ i ]->id, id ) )
+			return events->lists[ i ];
+	return NULL;
+}
+
 /** Register an event.
  *
  * \public \memberof mlt_events_struct
@@ -161,17 +230,70 @@ int mlt_events_register(mlt_properties self, const char *id)
 {
 	int error = 1;
 	mlt_events events = mlt_events_fetch( self );
-	if ( events != NULL )
+	if ( events != NULL && id != NULL )
 	{
-		mlt_properties list = events->listeners;
-		char temp[ 128 ];
-		sprintf( temp, "list:%s", id );
-		if ( mlt_properties_get_data( list, temp, NULL ) == NULL )
-			mlt_properties_set_data( list, temp, mlt_properties_new( ), 0, ( mlt_destructor )mlt_properties_close, NULL );
+		pthread_mutex_lock( &events->mutex );
+		error = 0;
+		if ( mlt_events_find( events, id ) == NULL )
+		{
+			if ( !strcmp( id, "property-changed" ) )
+			{
+				events->property_changed.id = strdup( id );
+			}
+			else
+			{
+				event_list **lists = realloc( events->lists, ( events->count + 1 ) * sizeof( event_list* ) );
+				event_list *list = calloc( 1, sizeof( event_list ) );
+				if ( lists != NULL )
+					events->lists = lists;
+				if ( lists != NULL && list != NULL )
+				{
+					list->id = strdup( id );
+					events->lists[ events->count ++ ] = list;
+				}
+				else
+				{
+					free( list );
+					error = 1;
+				}
+			}
+		}
+		pthread_mutex_unlock( &events->mutex );
 	}
 	return error;
 }
 
+/** Determine if an event has any listeners.
+ *
+ * This is cheap enough to call before preparing the data for an event,
+ * in particular for "property-changed", which is checked without locking.
+ * \public \memberof mlt_events_struct
+ * \param self a properties list
+ * \param id the name of an event
+ * \return true if at least one listener is connected
+ */
+
+int mlt_events_has_listeners( mlt_properties self, const char *id )
+{
+	int result = 0;
+	mlt_events events = mlt_events_fetch( self );
+	if ( events != NULL && id != NULL )
+	{
+		if ( !strcmp( id, "property-changed" ) )
+		{
+			result = atomic_load( &events->property_changed.listening ) > 0;
+		}
+		else
+		{
+			pthread_mutex_lock( &events->mutex );
+			event_list *list = mlt_events_find( events, id );
+			result = list != NULL && atomic_load( &list->listening ) > 0;
+			pthread_mutex_unlock( &events->mutex );
+		}
+	}
+	return result;
+}
+
 /** Fire an event.
  *
  * \public \memberof mlt_events_struct
@@ -184,28 +306,28 @@ int mlt_events_register(mlt_properties self, const char *id)
 int mlt_events_fire(mlt_properties self, const char *id, mlt_event_data event_data)
 {
 	int result = 0;
+	if ( !mlt_events_has_listeners( self, id ) )
+		return result;
+
 	mlt_events events = mlt_events_fetch( self );
-	if ( events != NULL )
+	pthread_mutex_lock( &events->mutex );
+	event_list *list = mlt_events_find( events, id );
+	for ( int i = 0; list != NULL && i < list->count; i ++ )
 	{
-		mlt_properties list = events->listeners;
-		mlt_properties listeners = NULL;
-		char temp[ 128 ];
-		sprintf( temp, "list:%s", id );
-		listeners = mlt_properties_get_data( list, temp, NULL );
-
-		if ( listeners != NULL )
+		mlt_event event = list->events[ i ];
+		if ( event != NULL && event->parent != NULL && event->block_count == 0 )
 		{
-			for ( int i = 0; i < mlt_properties_count( listeners ); i ++ )
-			{
-				mlt_event event = mlt_properties_get_data_at( listeners, i, NULL );
-				if ( event != NULL && event->parent != NULL && event->block_count == 0 )
-				{
-					event->listener( event->parent->owner, event->listener_data, event_data );
-					++result;
-				}
-			}
+			mlt_listener listener = event->listener;
+			void *listener_data = event->listener_data;
+
+			// Do not hold the lock while calling out
+			pthread_mutex_unlock( &events->mutex );
+			listener( events->owner, listener_data, event_data );
+			pthread_mutex_lock( &events->mutex );
+			++result;
 		}
 	}
+	pthread_mutex_unlock( &events->mutex );
 	return result;
 }
 
@@ -223,32 +345,40 @@ mlt_event mlt_events_listen( mlt_properties self, void *listener_data, const cha
 {
 	mlt_event event = NULL;
 	mlt_events events = mlt_events_fetch( self );
-	if ( events != NULL )
+	if ( events != NULL && id != NULL )
 	{
-		mlt_properties list = events->listeners;
-		mlt_properties listeners = NULL;
-		char temp[ 128 ];
-		sprintf( temp, "list:%s", id );
-		listeners = mlt_properties_get_data( list, temp, NULL );
-		if ( listeners != NULL )
+		pthread_mutex_lock( &events->mutex );
+		event_list *list = mlt_events_find( events, id );
+		if ( list != NULL )
 		{
 			int first_null = -1;
 			int i = 0;
-			for ( i = 0; event == NULL && i < mlt_properties_count( listeners ); i ++ )
+			for ( i = 0; event == NULL && i < list->count; i ++ )
 			{
-				mlt_event entry = mlt_properties_get_data_at( listeners, i, NULL );
+				mlt_event entry = list->events[ i ];
 				if ( entry != NULL && entry->parent != NULL )
 				{
 					if ( entry->listener_data == listener_data && entry->listener == listener )
 						event = entry;
 				}
-				else if ( ( entry == NULL || entry->parent == NULL ) && first_null == -1 )
+				else if ( first_null == -1 )
 				{
 					first_null = i;
 				}
 			}
 
-			if ( event == NULL )
+			if ( event == NULL && first_null == -1 && list->count == list->size )
+			{
+				int size = list->size + 8;
+				mlt_event *entries = realloc( list->events, size * sizeof( mlt_event ) );
+				if ( entries != NULL )
+				{
+					list->events = entries;
+					list->size = size;
+				}
+			}
+
+			if ( event == NULL && ( first_null != -1 || list->count < list->size ) )
 			{
 				event = malloc( sizeof( struct mlt_event_struct ) );
 				if ( event != NULL )
@@ -256,22 +386,40 @@ mlt_event mlt_events_listen( mlt_properties self, void *listener_data, const cha
 #ifdef _MLT_EVENT_CHECKS_
 					events_created ++;
 #endif
-					sprintf( temp, "%d", first_null == -1 ? mlt_properties_count( listeners ) : first_null );
+					if ( first_null == -1 )
+						first_null = list->count ++;
+					else
+						mlt_event_close( list->events[ first_null ] );
 					event->parent = events;
+					event->list = list;
 					event->ref_count = 0;
 					event->block_count = 0;
 					event->listener = listener;
 					event->listener_data = listener_data;
-					mlt_properties_set_data( listeners, temp, event, 0, ( mlt_destructor )mlt_event_close, NULL );
+					list->events[ first_null ] = event;
+					atomic_fetch_add( &list->listening, 1 );
 					mlt_event_inc_ref( event );
 				}
 			}
-
 		}
+		pthread_mutex_unlock( &events->mutex );
 	}
 	return event;
 }
 
+/** Get an event list by index, including the reserved one.
+ *
+ * \private \memberof mlt_events_struct
+ * \param events an events object, which must be locked
+ * \param index -1 for "property-changed" or less than the count of other events
+ * \return a list of listeners
+ */
+
+static event_list *mlt_events_list( mlt_events events, int index )
+{
+	return index < 0 ? &events->property_changed : events->lists[ index ];
+}
+
 /** Block all events for a given listener_data.
  *
  * \public \memberof mlt_events_struct
@@ -285,21 +433,18 @@ void mlt_events_block( mlt_properties self, void *listener_data )
 	if ( events != NULL )
 	{
 		int i = 0, j = 0;
-		mlt_properties list = events->listeners;
-		for ( j = 0; j < mlt_properties_count( list ); j ++ )
+		pthread_mutex_lock( &events->mutex );
+		for ( j = -1; j < events->count; j ++ )
 		{
-			char *temp = mlt_properties_get_name( list, j );
-			if ( !strncmp( temp, "list:", 5 ) )
+			event_list *list = mlt_events_list( events, j );
+			for ( i = 0; i < list->count; i ++ )
 			{
-				mlt_properties listeners = mlt_properties_get_data( list, temp, NULL );
-				for ( i = 0; i < mlt_properties_count( listeners ); i ++ )
-				{
-					mlt_event entry = mlt_properties_get_data_at( listeners, i, NULL );
-					if ( entry != NULL && entry->listener_data == listener_data )
-						mlt_event_block( entry );
-				}
+				mlt_event entry = list->events[ i ];
+				if ( entry != NULL && entry->listener_data == listener_data )
+					mlt_event_block( entry );
 			}
 		}
+		pthread_mutex_unlock( &events->mutex );
 	}
 }
 
@@ -316,21 +461,18 @@ void mlt_events_unblock( mlt_properties self, void *listener_data )
 	if ( events != NULL )
 	{
 		int i = 0, j = 0;
-		mlt_properties list = events->listeners;
-		for ( j = 0; j < mlt_properties_count( list ); j ++ )
+		pthread_mutex_lock( &events->mutex );
+		for ( j = -1; j < events->count; j ++ )
 		{
-			char *temp = mlt_properties_get_name( list, j );
-			if ( !strncmp( temp, "list:", 5 ) )
+			event_list *list = mlt_events_list( events, j );
+			for ( i = 0; i < list->count; i ++ )
 			{
-				mlt_properties listeners = mlt_properties_get_data( list, temp, NULL );
-				for ( i = 0; i < mlt_properties_count( listeners ); i ++ )
-				{
-					mlt_event entry = mlt_properties_get_data_at( listeners, i, NULL );
-					if ( entry != NULL && entry->listener_data == listener_data )
-						mlt_event_unblock( entry );
-				}
+				mlt_event entry = list->events[ i ];
+				if ( entry != NULL && entry->listener_data == listener_data )
+					mlt_event_unblock( entry );
 			}
 		}
+		pthread_mutex_unlock( &events->mutex );
 	}
 }
 
@@ -347,22 +489,22 @@ void mlt_events_disconnect( mlt_properties self, void *listener_data )
 	if ( events != NULL )
 	{
 		int i = 0, j = 0;
-		mlt_properties list = events->listeners;
-		for ( j = 0; j < mlt_properties_count( list ); j ++ )
+		pthread_mutex_lock( &events->mutex );
+		for ( j = -1; j < events->count; j ++ )
 		{
-			char *temp = mlt_properties_get_name( list, j );
-			if ( !strncmp( temp, "list:", 5 ) )
+			event_list *list = mlt_events_list( events, j );
+			for ( i = 0; i < list->count; i ++ )
 			{
-				mlt_properties listeners = mlt_properties_get_data( list, temp, NULL );
-				for ( i = 0; i < mlt_properties_count( listeners ); i ++ )
+				mlt_event entry = list->events[ i ];
+				if ( entry != NULL && entry->listener_data == listener_data )
 				{
-					mlt_event entry = mlt_properties_get_data_at( listeners, i, NULL );
-					char *name = mlt_properties_get_name( listeners, i );
-					if ( entry != NULL && entry->listener_data == listener_data )
-						mlt_properties_set_data( listeners, name, NULL, 0, NULL, NULL );
+					list->events[ i ] = NULL;
+					mlt_event_detach( entry );
+					mlt_event_close( entry );
 				}
 			}
 		}
+		pthread_mutex_unlock( &events->mutex );
 	}
 }
 
@@ -434,7 +576,7 @@ void mlt_events_close_wait_for( mlt_properties self, mlt_event event )
 	if ( event != NULL )
 	{
 		condition_pair *pair = event->listener_data;
-		event->parent = NULL;
+		mlt_event_detach( event );
 		pthread_mutex_unlock( &pair->mutex );
 		pthread_mutex_destroy( &pair->mutex );
 		pthread_cond_destroy( &pair->cond );
@@ -451,10 +593,7 @@ void mlt_events_close_wait_for( mlt_properties self, mlt_event event )
 
 static mlt_events mlt_events_fetch( mlt_properties self )
 {
-	mlt_events events = NULL;
-	if ( self != NULL )
-		events = mlt_properties_get_data( self, "_events", NULL );
-	return events;
+	return self != NULL ? mlt_properties_get_events( self ) : NULL;
 }
 
 /** Close the events object.
@@ -467,7 +606,26 @@ static void mlt_events_close( mlt_events events )
 {
 	if ( events != NULL )
 	{
-		mlt_properties_close( events->listeners );
+		mlt_properties_set_events( events->owner, NULL );
+		for ( int j = -1; j < events->count; j ++ )
+		{
+			event_list *list = mlt_events_list( events, j );
+			for ( int i = 0; i < list->count; i ++ )
+			{
+				mlt_event entry = list->events[ i ];
+				if ( entry != NULL )
+				{
+					mlt_event_detach( entry );
+					mlt_event_close( entry );
+				}
+			}
+			free( list->events );
+			free( list->id );
+			if ( j >= 0 )
+				free( list );
+		}
+		free( events->lists );
+		pthread_mutex_destroy( &events->mutex );
 		free( events );
 	}
 }
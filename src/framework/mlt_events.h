@@ -51,6 +51,7 @@ typedef void ( *mlt_listener )( mlt_properties, void*, mlt_event_data );
 extern void mlt_events_init( mlt_properties self );
 extern int mlt_events_register( mlt_properties self, const char *id );
 extern int mlt_events_fire( mlt_properties self, const char *id, mlt_event_data );
+extern int mlt_events_has_listeners( mlt_properties self, const char *id );
 extern mlt_event mlt_events_listen( mlt_properties self, void *listener_data, const char *id, mlt_listener listener );
 extern void mlt_events_block( mlt_properties self, void *listener_data );
 extern void mlt_events_unblock( mlt_properties self, void *listener_data );
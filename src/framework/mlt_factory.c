@@ -69,6 +69,11 @@ static mlt_properties event_object = NULL;
 /** for tracking the unique_id set on each constructed service */
 static int unique_id = 0;
 
+/* Private to the framework and defined in mlt_frame.c.
+*/
+
+extern void mlt_frame_pool_close( );
+
 #if defined(_WIN32) || (defined(__APPLE__) && defined(RELOCATABLE))
 // Replacement for buggy dirname() on some systems.
 // https://github.com/mltframework/mlt/issues/285
@@ -542,6 +547,7 @@ void mlt_factory_close( )
 		}
 		free( mlt_directory );
 		mlt_directory = NULL;
+		mlt_frame_pool_close( );
 		mlt_pool_close( );
 	}
 }
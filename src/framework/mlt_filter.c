@@ -23,10 +23,16 @@
 #include "mlt_filter.h"
 #include "mlt_frame.h"
 #include "mlt_producer.h"
+#include "mlt_consumer.h"
+#include "mlt_factory.h"
+#include "mlt_profile.h"
+#include "mlt_slices.h"
+#include "mlt_log.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 static int filter_get_frame( mlt_service self, mlt_frame_ptr frame, int index );
 
@@ -371,6 +377,255 @@ static int filter_get_frame( mlt_service service, mlt_frame_ptr frame, int index
 	}
 }
 
+/** The minimum duration in seconds of a chunk analysed by mlt_filter_analyze() */
+#define ANALYSIS_MIN_CHUNK (30)
+
+/** The state shared by the jobs of mlt_filter_analyze().
+ */
+
+typedef struct
+{
+	mlt_filter filter;     /// the filter being analysed
+	mlt_profile profile;   /// the profile of the producer
+	char *xml;             /// the serialised producer from which each chunk creates its own
+	mlt_position first;    /// the first position to analyse
+	mlt_position length;   /// the number of frames to analyse
+	mlt_position overlap;  /// the number of frames fed before a chunk to prime the analysis
+	int audio_only;        /// whether the analysis does not need images
+	mlt_filter *chunks;    /// the filter instance that analysed each chunk
+	int error;             /// whether any chunk failed
+} analysis_job;
+
+/** Get frames from a producer and pass them through a filter.
+ *
+ * \private \memberof mlt_filter_s
+ * \param self a filter
+ * \param producer a producer
+ * \param first the first position to get
+ * \param last the last position to get
+ * \param audio_only whether to get only the audio of each frame
+ * \param process whether to process the frames with \p self or let the producer do it
+ */
+
+static void analyze_range( mlt_filter self, mlt_producer producer, mlt_position first, mlt_position last, int audio_only, int process )
+{
+	mlt_profile profile = mlt_service_profile( MLT_PRODUCER_SERVICE( producer ) );
+	double fps = mlt_profile_fps( profile );
+
+	for ( mlt_position position = first; position <= last; position++ )
+	{
+		mlt_frame frame = NULL;
+		mlt_producer_seek( producer, position );
+		if ( mlt_service_get_frame( MLT_PRODUCER_SERVICE( producer ), &frame, 0 ) || !frame )
+			break;
+		if ( process )
+			frame = mlt_filter_process( self, frame );
+
+		if ( !audio_only )
+		{
+			mlt_image_format format = mlt_image_yuv422;
+			int width = profile->width;
+			int height = profile->height;
+			uint8_t *image = NULL;
+			mlt_frame_get_image( frame, &image, &format, &width, &height, 0 );
+		}
+
+		mlt_audio_format format = mlt_audio_s16;
+		int frequency = 48000;
+		int channels = 2;
+		int samples = mlt_audio_calculate_frame_samples( fps, frequency, position );
+		void *buffer = NULL;
+		mlt_frame_get_audio( frame, &buffer, &format, &frequency, &channels, &samples );
+
+		mlt_frame_close( frame );
+	}
+}
+
+/** Analyse one chunk on a new instance of the producer and the filter.
+ *
+ * \private \memberof mlt_filter_s
+ * \param id the thread running the job
+ * \param index the chunk to analyse
+ * \param count the number of chunks
+ * \param cookie an analysis_job
+ * \return zero
+ */
+
+static int analyze_chunk( int id, int index, int count, void *cookie )
+{
+	analysis_job *job = cookie;
+	mlt_properties properties = MLT_FILTER_PROPERTIES( job->filter );
+	mlt_position first = job->first + job->length * index / count;
+	mlt_position last = job->first + job->length * ( index + 1 ) / count - 1;
+	mlt_position start = first - job->overlap < job->first ? job->first : first - job->overlap;
+	mlt_producer producer = mlt_factory_producer( job->profile, "xml-string", job->xml );
+	mlt_filter filter = mlt_factory_filter( job->profile, mlt_properties_get( properties, "mlt_service" ), NULL );
+
+	if ( producer && filter )
+	{
+		if ( job->audio_only )
+			mlt_properties_set_int( MLT_PRODUCER_PROPERTIES( producer ), "audio_only", 1 );
+
+		mlt_properties chunk_properties = MLT_FILTER_PROPERTIES( filter );
+		int n = mlt_properties_count( properties );
+		for ( int i = 0; i < n; i++ )
+		{
+			const char *name = mlt_properties_get_name( properties, i );
+			if ( name[0] != '_' && mlt_properties_get( properties, name ) )
+				mlt_properties_set( chunk_properties, name, mlt_properties_get( properties, name ) );
+		}
+		mlt_properties_set_position( chunk_properties, "_analysis_first", first - start );
+		mlt_filter_set_in_and_out( filter, start, last );
+		analyze_range( filter, producer, start, last, job->audio_only, 1 );
+		job->chunks[ index ] = filter;
+	}
+	else
+	{
+		mlt_filter_close( filter );
+		job->error = 1;
+	}
+	mlt_producer_close( producer );
+	return 0;
+}
+
+/** Serialise a producer without the filters from \p filter onwards.
+ *
+ * \private \memberof mlt_filter_s
+ * \param producer a producer
+ * \param filter a filter that may be attached to \p producer
+ * \return a string that must be freed, or NULL on error
+ */
+
+static char *serialise_producer( mlt_producer producer, mlt_filter filter )
+{
+	mlt_service service = MLT_PRODUCER_SERVICE( producer );
+	mlt_consumer consumer = mlt_factory_consumer( mlt_service_profile( service ), "xml", "string" );
+	char *result = NULL;
+
+	if ( consumer )
+	{
+		int count = mlt_service_filter_count( service );
+		int *disable = calloc( count + 1, sizeof( int ) );
+		int found = 0;
+
+		// Later filters would change what the analysis sees
+		for ( int i = 0; i < count; i++ )
+		{
+			mlt_properties properties = MLT_FILTER_PROPERTIES( mlt_service_filter( service, i ) );
+			found = found || mlt_service_filter( service, i ) == filter;
+			disable[ i ] = mlt_properties_get_int( properties, "disable" );
+			if ( found )
+				mlt_properties_set_int( properties, "disable", 1 );
+		}
+
+		mlt_properties_set_int( MLT_CONSUMER_PROPERTIES( consumer ), "no_meta", 1 );
+		mlt_consumer_connect( consumer, service );
+		mlt_consumer_start( consumer );
+		if ( mlt_properties_get( MLT_CONSUMER_PROPERTIES( consumer ), "string" ) )
+			result = strdup( mlt_properties_get( MLT_CONSUMER_PROPERTIES( consumer ), "string" ) );
+		mlt_consumer_close( consumer );
+
+		for ( int i = 0; i < count; i++ )
+			mlt_properties_set_int( MLT_FILTER_PROPERTIES( mlt_service_filter( service, i ) ), "disable", disable[ i ] );
+		free( disable );
+	}
+	return result;
+}
+
+/** Run the analysis pass of a filter over the output of a producer.
+ *
+ * Filters such as loudness gather their results while frames are played
+ * through them in order. This gets the frames from \p producer between the
+ * filter's in and out points (or over the producer's play time if the filter
+ * has no out point) and passes them through the filter, so that its results
+ * are stored on its properties just as if a consumer had played them.
+ *
+ * If the filter registers and listens to the "analysis-merge" event, the
+ * range is split into chunks that are analysed at the same time on new
+ * instances of the producer and filter, created from their serialisation
+ * and properties. Each chunk filter has \em _analysis_first set to the number
+ * of frames it gets before its chunk starts, and the frames it is given
+ * follow the ones of the previous chunk. When all are done, the event is
+ * fired on \p self with a properties list of the chunk filters, in order,
+ * and the listener must store the merged results. A filter may also set
+ * \em _analysis_overlap to the seconds of material to feed before each
+ * chunk to prime its state and \em _analysis_audio to skip getting images.
+ * Otherwise, or if the producer cannot be serialised, the analysis runs on
+ * \p self in order.
+ *
+ * Audio is requested at 48000 Hz in stereo and images in the profile size.
+ * \public \memberof mlt_filter_s
+ * \param self a filter
+ * \param producer the producer to which the filter is attached or whose output it analyses
+ * \param chunks the maximum number of chunks, or 0 to use the number of task threads
+ * \return true if there was an error
+ */
+
+int mlt_filter_analyze( mlt_filter self, mlt_producer producer, int chunks )
+{
+	if ( !self || !producer )
+		return 1;
+
+	mlt_properties properties = MLT_FILTER_PROPERTIES( self );
+	mlt_service service = MLT_PRODUCER_SERVICE( producer );
+	analysis_job job;
+	mlt_position last = mlt_filter_get_out( self );
+
+	memset( &job, 0, sizeof( job ) );
+	job.filter = self;
+	job.profile = mlt_service_profile( service );
+	job.first = mlt_filter_get_in( self );
+	if ( last <= 0 )
+		last = mlt_producer_get_playtime( producer ) - 1;
+	job.length = last - job.first + 1;
+	if ( job.length <= 0 || !job.profile )
+		return 1;
+	double fps = mlt_profile_fps( job.profile );
+	job.audio_only = mlt_properties_get_int( properties, "_analysis_audio" );
+	job.overlap = ceil( mlt_properties_get_double( properties, "_analysis_overlap" ) * fps );
+
+	// Decide on the number of chunks
+	if ( chunks <= 0 )
+		chunks = mlt_slices_count_tasks() + 1;
+	if ( chunks > job.length / ( ANALYSIS_MIN_CHUNK * fps ) )
+		chunks = job.length / ( ANALYSIS_MIN_CHUNK * fps );
+	if ( job.overlap > 0 && chunks > job.length / ( 4 * job.overlap ) )
+		chunks = job.length / ( 4 * job.overlap );
+
+	if ( chunks > 1 && mlt_events_has_listeners( properties, "analysis-merge" ) )
+		job.xml = serialise_producer( producer, self );
+
+	if ( job.xml )
+	{
+		mlt_properties list = mlt_properties_new();
+
+		job.chunks = calloc( chunks, sizeof( mlt_filter ) );
+		mlt_slices_run_tasks( chunks, analyze_chunk, &job );
+		for ( int i = 0; i < chunks; i++ )
+		{
+			char key[ 20 ];
+			snprintf( key, sizeof( key ), "%d", i );
+			mlt_properties_set_data( list, key, job.chunks[ i ], 0, ( mlt_destructor )mlt_filter_close, NULL );
+		}
+		if ( !job.error )
+			mlt_events_fire( properties, "analysis-merge", mlt_event_data_from_object( list ) );
+		else
+			mlt_log_warning( MLT_FILTER_SERVICE( self ), "%s: failed to analyse in chunks\n", __FUNCTION__ );
+		mlt_properties_close( list );
+		free( job.chunks );
+		free( job.xml );
+		if ( !job.error )
+			return 0;
+	}
+
+	// Analyse in order
+	int attached = 0;
+	for ( int i = 0; i < mlt_service_filter_count( service ); i++ )
+		attached = attached || mlt_service_filter( service, i ) == self;
+	analyze_range( self, producer, job.first, last, job.audio_only, !attached );
+	return 0;
+}
+
 /** Close and destroy the filter.
  *
  * \public \memberof mlt_filter_s
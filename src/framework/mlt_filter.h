@@ -34,6 +34,9 @@
  * \properties \em service a reference to the service to which this filter is attached.
  * \properties \em disable Set this to disable the filter while keeping it in the object model.
  * Currently this is not cleared when the filter is detached.
+ * \event \em analysis-merge Fired by mlt_filter_analyze() on a filter that registers it;
+ *   the event data is a properties list of the filters that analysed each chunk, in order,
+ *   whose results the listener must merge into the properties of the filter.
  */
 
 struct mlt_filter_s
@@ -68,6 +71,7 @@ extern mlt_position mlt_filter_get_length( mlt_filter self );
 extern mlt_position mlt_filter_get_length2( mlt_filter self, mlt_frame frame );
 extern mlt_position mlt_filter_get_position( mlt_filter self, mlt_frame frame );
 extern double mlt_filter_get_progress( mlt_filter self, mlt_frame frame );
+extern int mlt_filter_analyze( mlt_filter self, mlt_producer producer, int chunks );
 extern void mlt_filter_close( mlt_filter );
 
 #endif
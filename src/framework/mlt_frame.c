@@ -30,6 +30,183 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+
+// Closed frames can be recycled unless this is defined to 0. Recycling is
+// off unless the MLT_FRAME_POOL environment variable is set to 1, because a
+// frame used after it was closed, or a cache keyed on a frame's address, then
+// sees another frame.
+#ifndef USE_MLT_FRAME_POOL
+#define USE_MLT_FRAME_POOL 1
+#endif
+
+/** the maximum number of closed frames kept by each thread */
+#define FRAME_POOL_THREAD_SIZE 16
+
+/** the maximum number of closed frames shared between threads */
+#define FRAME_POOL_SHARED_SIZE 64
+
+#if USE_MLT_FRAME_POOL
+
+/** \brief Closed frames kept for reuse
+ *
+ * Frames are often closed by a different thread than the one that created
+ * them, for example when a consumer renders frames produced by its read ahead
+ * thread. Each thread therefore keeps a small free list of its own and spills
+ * into, or refills from, a list shared by all threads.
+ */
+
+typedef struct
+{
+	mlt_frame frames[ FRAME_POOL_SHARED_SIZE ];
+	int count;
+}
+frame_pool;
+
+static pthread_key_t pool_key;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static int pool_enabled = 0;
+static pthread_mutex_t shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static frame_pool shared_pool;
+
+static void frame_free( mlt_frame self )
+{
+	mlt_deque_close( self->stack_image );
+	mlt_deque_close( self->stack_audio );
+	mlt_deque_close( self->stack_service );
+	mlt_properties_close( &self->parent );
+	free( self );
+}
+
+static void pool_free( frame_pool *pool )
+{
+	while ( pool->count > 0 )
+		frame_free( pool->frames[ -- pool->count ] );
+}
+
+static void pool_thread_exit( void *arg )
+{
+	// Free the frames rather than spill them into the shared list, which
+	// might already have been drained by mlt_factory_close().
+	pool_free( arg );
+	free( arg );
+}
+
+static void pool_key_create( )
+{
+	const char *e = getenv( "MLT_FRAME_POOL" );
+	pool_enabled = e && atoi( e );
+	pthread_key_create( &pool_key, pool_thread_exit );
+}
+
+/** Determine whether closed frames are recycled.
+ *
+ * \private \memberof mlt_frame_s
+ * \return true if the MLT_FRAME_POOL environment variable was set to 1 when first checked
+ */
+
+static int pool_is_enabled( )
+{
+	pthread_once( &pool_once, pool_key_create );
+	return pool_enabled;
+}
+
+static frame_pool *pool_thread( )
+{
+	pthread_once( &pool_once, pool_key_create );
+	frame_pool *pool = pthread_getspecific( pool_key );
+	if ( pool == NULL )
+	{
+		pool = calloc( 1, sizeof( *pool ) );
+		if ( pool != NULL )
+			pthread_setspecific( pool_key, pool );
+	}
+	return pool;
+}
+
+/** Take a closed frame from the pool.
+ *
+ * \private \memberof mlt_frame_s
+ * \return a frame without properties and with empty stacks, or NULL if none are available
+ */
+
+static mlt_frame pool_get( )
+{
+	frame_pool *pool = pool_thread( );
+	if ( pool == NULL )
+		return NULL;
+
+	if ( pool->count == 0 )
+	{
+		// Refill half of the thread's list from the shared list
+		pthread_mutex_lock( &shared_mutex );
+		while ( shared_pool.count > 0 && pool->count < FRAME_POOL_THREAD_SIZE / 2 )
+			pool->frames[ pool->count ++ ] = shared_pool.frames[ -- shared_pool.count ];
+		pthread_mutex_unlock( &shared_mutex );
+	}
+	return pool->count > 0 ? pool->frames[ -- pool->count ] : NULL;
+}
+
+/** Return a closed frame to the pool or free it if the pool is full.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame whose properties have been reset
+ */
+
+static void pool_put( mlt_frame self )
+{
+	frame_pool *pool = pool_thread( );
+	if ( pool == NULL )
+	{
+		frame_free( self );
+		return;
+	}
+
+	if ( pool->count == FRAME_POOL_THREAD_SIZE )
+	{
+		// Spill half of the thread's list into the shared list
+		pthread_mutex_lock( &shared_mutex );
+		while ( pool->count > FRAME_POOL_THREAD_SIZE / 2 )
+		{
+			mlt_frame frame = pool->frames[ -- pool->count ];
+			if ( shared_pool.count < FRAME_POOL_SHARED_SIZE )
+				shared_pool.frames[ shared_pool.count ++ ] = frame;
+			else
+				frame_free( frame );
+		}
+		pthread_mutex_unlock( &shared_mutex );
+	}
+	pool->frames[ pool->count ++ ] = self;
+}
+
+#endif
+
+/** Free the closed frames kept for reuse.
+ *
+ * This frees the shared list and the list of the calling thread. The lists
+ * of other threads are freed when those threads exit.
+ * It is private to the framework and called by mlt_factory_close().
+ *
+ * \private \memberof mlt_frame_s
+ */
+
+void mlt_frame_pool_close( )
+{
+#if USE_MLT_FRAME_POOL
+	pthread_once( &pool_once, pool_key_create );
+	frame_pool *pool = pthread_getspecific( pool_key );
+	if ( pool != NULL )
+	{
+		pthread_setspecific( pool_key, NULL );
+		pool_free( pool );
+		free( pool );
+	}
+	pthread_mutex_lock( &shared_mutex );
+	while ( shared_pool.count > 0 )
+		frame_free( shared_pool.frames[ -- shared_pool.count ] );
+	pthread_mutex_unlock( &shared_mutex );
+#endif
+}
 
 /** Construct a frame object.
  *
@@ -40,16 +217,35 @@
 
 mlt_frame mlt_frame_init( mlt_service service )
 {
-	// Allocate a frame
-	mlt_frame self = calloc( 1, sizeof( struct mlt_frame_s ) );
+	mlt_frame self = NULL;
+
+#if USE_MLT_FRAME_POOL
+	// Reuse a closed frame, whose properties and stacks are already initialised
+	if ( pool_is_enabled( ) )
+		self = pool_get( );
+#endif
+
+	if ( self == NULL )
+	{
+		// Allocate a frame
+		self = calloc( 1, sizeof( struct mlt_frame_s ) );
+
+		if ( self != NULL )
+		{
+			// Initialise the properties
+			mlt_properties_init( &self->parent, self );
+
+			// Construct stacks for frames and methods
+			self->stack_image = mlt_deque_init( );
+			self->stack_audio = mlt_deque_init( );
+			self->stack_service = mlt_deque_init( );
+		}
+	}
 
 	if ( self != NULL )
 	{
 		mlt_profile profile = mlt_service_profile( service );
-
-		// Initialise the properties
 		mlt_properties properties = &self->parent;
-		mlt_properties_init( properties, self );
 
 		// Set default properties on the frame
 		mlt_properties_set_position( properties, "_position", 0.0 );
@@ -59,11 +255,6 @@ mlt_frame mlt_frame_init( mlt_service service )
 		mlt_properties_set_double( properties, "aspect_ratio", mlt_profile_sar( NULL ) );
 		mlt_properties_set_data( properties, "audio", NULL, 0, NULL, NULL );
 		mlt_properties_set_data( properties, "alpha", NULL, 0, NULL, NULL );
-
-		// Construct stacks for frames and methods
-		self->stack_image = mlt_deque_init( );
-		self->stack_audio = mlt_deque_init( );
-		self->stack_service = mlt_deque_init( );
 	}
 
 	return self;
@@ -136,6 +327,36 @@ int mlt_frame_set_aspect_ratio( mlt_frame self, double value )
 	return mlt_properties_set_double( MLT_FRAME_PROPERTIES( self ), "aspect_ratio", value );
 }
 
+/** Get the render quality requested for the frame.
+ *
+ * A real-time consumer that falls behind lowers the quality of the frames it
+ * would otherwise drop. Services may consult this in their get_image callbacks
+ * to choose cheaper algorithms.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \return the render quality, mlt_quality_full unless set
+ */
+
+mlt_quality mlt_frame_get_quality( mlt_frame self )
+{
+	int quality = mlt_properties_get_int( MLT_FRAME_PROPERTIES( self ), "consumer_quality" );
+	return CLAMP( quality, mlt_quality_full, mlt_quality_draft );
+}
+
+/** Set the render quality requested for the frame.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param quality the render quality
+ * \return true if error
+ */
+
+int mlt_frame_set_quality( mlt_frame self, mlt_quality quality )
+{
+	return mlt_properties_set_int( MLT_FRAME_PROPERTIES( self ), "consumer_quality", quality );
+}
+
 /** Get the time position of this frame.
  *
  * This position is not necessarily the position as the original
@@ -334,7 +555,14 @@ mlt_deque mlt_frame_service_stack( mlt_frame self )
 
 int mlt_frame_set_image( mlt_frame self, uint8_t *image, int size, mlt_destructor destroy )
 {
-	return mlt_properties_set_data( MLT_FRAME_PROPERTIES( self ), "image", image, size, destroy, NULL );
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	int error = mlt_properties_set_data( properties, "image", image, size, destroy, NULL );
+
+	// Drop the reference to a shared image that is no longer the image
+	void *shared = mlt_properties_get_data( properties, "_shared_image", NULL );
+	if ( shared && shared != image )
+		mlt_properties_set_data( properties, "_shared_image", NULL, 0, NULL, NULL );
+	return error;
 }
 
 /** Set a new alpha channel on the frame.
@@ -349,7 +577,366 @@ int mlt_frame_set_image( mlt_frame self, uint8_t *image, int size, mlt_destructo
 
 int mlt_frame_set_alpha( mlt_frame self, uint8_t *alpha, int size, mlt_destructor destroy )
 {
-	return mlt_properties_set_data( MLT_FRAME_PROPERTIES( self ), "alpha", alpha, size, destroy, NULL );
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	int error = mlt_properties_set_data( properties, "alpha", alpha, size, destroy, NULL );
+
+	// Drop the reference to a shared alpha channel that is no longer the alpha
+	void *shared = mlt_properties_get_data( properties, "_shared_alpha", NULL );
+	if ( shared && shared != alpha )
+		mlt_properties_set_data( properties, "_shared_alpha", NULL, 0, NULL, NULL );
+	return error;
+}
+
+/** Set the data of a frame to a shared buffer.
+ *
+ * The reference is held by a private property rather than by the data
+ * property itself, so the buffer outlives any direct replacement of the data
+ * property and its address can identify it as shared.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame
+ * \param name the name of the data property
+ * \param shared_name the name of the property that holds the reference
+ * \param data a buffer from mlt_image_shared_alloc()
+ * \param size the size of the data in bytes
+ * \return true if error
+ */
+
+static int set_shared( mlt_frame self, const char *name, const char *shared_name, void *data, int size )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	mlt_image_shared_ref( data );
+	mlt_properties_set_data( properties, shared_name, data, 0, mlt_image_shared_release, NULL );
+	return mlt_properties_set_data( properties, name, data, size, NULL, NULL );
+}
+
+/** Set a shared image on the frame.
+ *
+ * The frame takes its own reference on the buffer, so several frames can show
+ * the same pixels. When a writable image is requested from a frame whose image
+ * is still shared, mlt_frame_get_image() gives the frame a private copy first.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param image a buffer from mlt_image_shared_alloc()
+ * \param size the size of the image data in bytes
+ * \return true if error
+ * \see mlt_frame_share_image
+ */
+
+int mlt_frame_set_image_shared( mlt_frame self, uint8_t *image, int size )
+{
+	return set_shared( self, "image", "_shared_image", image, size );
+}
+
+/** Set a shared alpha channel on the frame.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param alpha a buffer from mlt_image_shared_alloc()
+ * \param size the size of the alpha channel in bytes
+ * \return true if error
+ * \see mlt_frame_set_image_shared
+ */
+
+int mlt_frame_set_alpha_shared( mlt_frame self, uint8_t *alpha, int size )
+{
+	return set_shared( self, "alpha", "_shared_alpha", alpha, size );
+}
+
+/** Get the shared buffer of a frame, converting its data to one if needed.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame
+ * \param name the name of the data property
+ * \param shared_name the name of the property that holds the reference
+ * \param size the size of the data in bytes, used when the property has none
+ * \return the shared buffer, or NULL if there is no data
+ */
+
+static void *get_shared( mlt_frame self, const char *name, const char *shared_name, int size )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	int data_size = 0;
+	void *data = mlt_properties_get_data( properties, name, &data_size );
+	if ( !data )
+		return NULL;
+	if ( data == mlt_properties_get_data( properties, shared_name, NULL ) )
+		return data;
+
+	// Copy the data once into a shared buffer that replaces it on the frame
+	size = data_size > 0 ? data_size : size;
+	void *shared = mlt_image_shared_alloc( size );
+	if ( !shared )
+		return NULL;
+	memcpy( shared, data, size );
+	set_shared( self, name, shared_name, shared, size );
+	mlt_image_shared_release( shared );
+	return shared;
+}
+
+/** Get the image of a frame as a shared buffer.
+ *
+ * If the image is not already shared, it is copied once into a shared buffer
+ * that replaces it on the frame. Any pointer previously obtained to the image
+ * is then invalid, so only use this on a frame that the caller owns, such as
+ * one held in a cache.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param[out] size the size of the image in bytes (optional)
+ * \return the shared image to pass to mlt_frame_set_image_shared(), or NULL if there is no image
+ */
+
+uint8_t *mlt_frame_share_image( mlt_frame self, int *size )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	uint8_t *image = get_shared( self, "image", "_shared_image",
+		mlt_image_format_size( mlt_properties_get_int( properties, "format" ),
+			mlt_properties_get_int( properties, "width" ), mlt_properties_get_int( properties, "height" ), NULL ) );
+	if ( size )
+		*size = mlt_image_shared_size( image );
+	return image;
+}
+
+/** Get the alpha channel of a frame as a shared buffer.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param[out] size the size of the alpha channel in bytes (optional)
+ * \return the shared alpha channel to pass to mlt_frame_set_alpha_shared(), or NULL if there is none
+ * \see mlt_frame_share_image
+ */
+
+uint8_t *mlt_frame_share_alpha( mlt_frame self, int *size )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	uint8_t *alpha = get_shared( self, "alpha", "_shared_alpha",
+		mlt_properties_get_int( properties, "width" ) * mlt_properties_get_int( properties, "height" ) );
+	if ( size )
+		*size = mlt_image_shared_size( alpha );
+	return alpha;
+}
+
+/** Give a frame a private copy of shared data that another frame also holds.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame
+ * \param name the name of the data property
+ * \param shared_name the name of the property that holds the reference
+ * \return the data, which is a copy if it was shared
+ */
+
+static void *unshare( mlt_frame self, const char *name, const char *shared_name )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	void *data = mlt_properties_get_data( properties, name, NULL );
+	if ( data && data == mlt_properties_get_data( properties, shared_name, NULL ) && mlt_image_shared_count( data ) > 1 )
+	{
+		int size = mlt_image_shared_size( data );
+		void *copy = mlt_pool_alloc( size );
+		memcpy( copy, data, size );
+		mlt_properties_set_data( properties, name, copy, size, mlt_pool_release, NULL );
+		mlt_properties_set_data( properties, shared_name, NULL, 0, NULL, NULL );
+		data = copy;
+	}
+	return data;
+}
+
+/** Record that the known facts about the image describe its current buffers.
+ *
+ * The facts are tied to the addresses of the image and alpha channel, so they
+ * are forgotten when either is replaced. They are also forgotten when the image
+ * is requested writable, since the caller may then change it, and when a filter
+ * that got the image from a deeper service returns without keeping them, since
+ * it may have changed the image or alpha channel in place.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame
+ * \param keep whether to keep the facts, otherwise they are forgotten
+ */
+
+static void remember_image( mlt_frame self, int keep )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	if ( !keep )
+	{
+		mlt_properties_set_int( properties, "_image_solid", 0 );
+		mlt_properties_set_int( properties, "_image_opacity", -1 );
+		mlt_properties_set( properties, "_image_content", NULL );
+	}
+	mlt_properties_set_data( properties, "_image_known", mlt_properties_get_data( properties, "image", NULL ), 0, NULL, NULL );
+	mlt_properties_set_data( properties, "_alpha_known", mlt_properties_get_data( properties, "alpha", NULL ), 0, NULL, NULL );
+}
+
+/** Determine if the known facts about the image still describe it.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame
+ * \return true if the facts are current
+ */
+
+static int image_is_known( mlt_frame self )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	void *image = mlt_properties_get_data( properties, "image", NULL );
+	return image && image == mlt_properties_get_data( properties, "_image_known", NULL )
+		&& mlt_properties_get_data( properties, "alpha", NULL ) == mlt_properties_get_data( properties, "_alpha_known", NULL );
+}
+
+/** Record that the service whose get_image is running vouches for the known facts.
+ *
+ * \private \memberof mlt_frame_s
+ * \param self a frame
+ */
+
+static void vouch_image( mlt_frame self )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	mlt_properties_set_int( properties, "_image_known_level", mlt_properties_get_int( properties, "_image_level" ) );
+}
+
+/** Declare that every pixel of the image of a frame has the same opacity.
+ *
+ * A producer or filter that knows this sets it from its get_image after setting
+ * the image and alpha channel, so a transition can skip blending. Use 255 for
+ * an image that is fully opaque, or 0 for one that is fully transparent,
+ * whether the alpha is in the alpha channel or the image.
+ *
+ * The declaration lasts until the image or alpha is replaced or requested
+ * writable, or until a filter that got the image through mlt_frame_get_image()
+ * returns without calling mlt_frame_keep_image_facts(). So a service that
+ * writes to the image need not clear it, and a service that wants to use it
+ * requests the image not writable first.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param opacity the alpha value of every pixel
+ * \see mlt_frame_get_image_opacity
+ */
+
+void mlt_frame_set_image_opacity( mlt_frame self, int opacity )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	remember_image( self, image_is_known( self ) );
+	vouch_image( self );
+	mlt_properties_set_int( properties, "_image_solid", 0 );
+	mlt_properties_set_int( properties, "_image_opacity", CLAMP( opacity, 0, 255 ) );
+}
+
+/** Get the known opacity of every pixel of the image of a frame.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \return the alpha value of every pixel, 255 if fully opaque, 0 if fully
+ * transparent, or -1 if not known
+ * \see mlt_frame_set_image_opacity
+ */
+
+int mlt_frame_get_image_opacity( mlt_frame self )
+{
+	if ( !image_is_known( self ) )
+		return -1;
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	return mlt_properties_get( properties, "_image_opacity" ) ? mlt_properties_get_int( properties, "_image_opacity" ) : -1;
+}
+
+/** Declare that every pixel of the image of a frame has the same colour.
+ *
+ * A producer or filter that knows this sets it from its get_image after setting
+ * the image and alpha channel, so a transition can fill instead of blend. It
+ * implies the opacity is the alpha of the colour. The declaration lasts as long
+ * as one made with mlt_frame_set_image_opacity(), which replaces it.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param color the colour of every pixel
+ * \see mlt_frame_get_image_solid
+ */
+
+void mlt_frame_set_image_solid( mlt_frame self, mlt_color color )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	remember_image( self, image_is_known( self ) );
+	vouch_image( self );
+	mlt_properties_set_int( properties, "_image_solid", 1 );
+	mlt_properties_set_color( properties, "_image_color", color );
+	mlt_properties_set_int( properties, "_image_opacity", color.a );
+}
+
+/** Determine if every pixel of the image of a frame is known to have the same colour.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param[out] color the colour of every pixel (optional)
+ * \return true if the image is known to be a solid colour
+ * \see mlt_frame_set_image_solid
+ */
+
+int mlt_frame_get_image_solid( mlt_frame self, mlt_color *color )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	int solid = image_is_known( self ) && mlt_properties_get_int( properties, "_image_solid" );
+	if ( solid && color )
+		*color = mlt_properties_get_color( properties, "_image_color" );
+	return solid;
+}
+
+/** Declare the region of the image of a frame outside of which it is fully transparent.
+ *
+ * A producer or filter that places a small graphic, such as a title, in a
+ * larger transparent image sets this so transitions can limit their work to the
+ * region. The image keeps its full size, so services that do not know about the
+ * region work as before. The declaration lasts as long as one made with
+ * mlt_frame_set_image_opacity().
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param rect the region in pixels of the image that may have content
+ * \see mlt_frame_get_image_content
+ */
+
+void mlt_frame_set_image_content( mlt_frame self, mlt_rect rect )
+{
+	remember_image( self, image_is_known( self ) );
+	vouch_image( self );
+	mlt_properties_set_rect( MLT_FRAME_PROPERTIES( self ), "_image_content", rect );
+}
+
+/** Get the region of the image of a frame outside of which it is known to be fully transparent.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \param[out] rect the region in pixels of the image that may have content
+ * \return true if the region is known
+ * \see mlt_frame_set_image_content
+ */
+
+int mlt_frame_get_image_content( mlt_frame self, mlt_rect *rect )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( self );
+	int known = image_is_known( self ) && mlt_properties_get( properties, "_image_content" );
+	if ( known && rect )
+		*rect = mlt_properties_get_rect( properties, "_image_content" );
+	return known;
+}
+
+/** Keep the known facts about the image of a frame past the get_image of the calling filter.
+ *
+ * A filter calls this from its get_image after getting the image, if it never
+ * changes the image or alpha channel in place. Replacing them is fine, since
+ * that forgets the facts anyway. Without this, the facts are forgotten when the
+ * filter returns, because the framework cannot tell whether it wrote to them.
+ *
+ * \public \memberof mlt_frame_s
+ * \param self a frame
+ * \see mlt_frame_set_image_opacity
+ */
+
+void mlt_frame_keep_image_facts( mlt_frame self )
+{
+	if ( image_is_known( self ) )
+		vouch_image( self );
 }
 
 /** Replace image stack with the information provided.
@@ -484,18 +1071,33 @@ int mlt_frame_get_image( mlt_frame self, uint8_t **buffer, mlt_image_format *for
 	mlt_get_image get_image = mlt_frame_pop_get_image( self );
 	mlt_image_format requested_format = *format;
 	int error = 0;
+	int known = 0;
 
 	if ( get_image )
 	{
+		// Count the nesting so the facts about the image are only kept by the services that vouch for them
+		int level = mlt_properties_get_int( properties, "_image_level" ) + 1;
 		mlt_properties_set_int( properties, "image_count", mlt_properties_get_int( properties, "image_count" ) - 1 );
+		mlt_properties_set_int( properties, "_image_level", level );
 		error = get_image( self, buffer, format, width, height, writable );
+		mlt_properties_set_int( properties, "_image_level", level - 1 );
+		if ( image_is_known( self ) && mlt_properties_get_int( properties, "_image_known_level" ) > level )
+			remember_image( self, 0 );
 		if ( !error && buffer && *buffer )
 		{
 			mlt_properties_set_int( properties, "width", *width );
 			mlt_properties_set_int( properties, "height", *height );
+
+			// Conversion keeps the content, so keep what is known about it
+			known = image_is_known( self );
 			if ( self->convert_image && requested_format != mlt_image_none )
 				self->convert_image( self, buffer, format, requested_format );
 			mlt_properties_set_int( properties, "format", *format );
+			if ( writable && *buffer == mlt_properties_get_data( properties, "image", NULL ) )
+			{
+				*buffer = unshare( self, "image", "_shared_image" );
+				unshare( self, "alpha", "_shared_alpha" );
+			}
 		}
 		else
 		{
@@ -508,17 +1110,34 @@ int mlt_frame_get_image( mlt_frame self, uint8_t **buffer, mlt_image_format *for
 		*buffer = mlt_properties_get_data( properties, "image", NULL );
 		*width = mlt_properties_get_int( properties, "width" );
 		*height = mlt_properties_get_int( properties, "height" );
+		known = image_is_known( self );
 		if ( self->convert_image && *buffer && requested_format != mlt_image_none )
 		{
 			self->convert_image( self, buffer, format, requested_format );
 			mlt_properties_set_int( properties, "format", *format );
 		}
+		if ( writable && *buffer == mlt_properties_get_data( properties, "image", NULL ) )
+		{
+			*buffer = unshare( self, "image", "_shared_image" );
+			unshare( self, "alpha", "_shared_alpha" );
+		}
 	}
 	else
 	{
 		error = generate_test_image( properties, buffer, format, width, height, writable );
 	}
 
+	// The caller may change a writable image, so forget what is known about it
+	if ( writable )
+	{
+		if ( mlt_properties_get_data( properties, "_image_known", NULL ) )
+			mlt_properties_set_data( properties, "_image_known", NULL, 0, NULL, NULL );
+	}
+	else if ( known )
+	{
+		remember_image( self, 1 );
+	}
+
 	return error;
 }
 
@@ -760,6 +1379,23 @@ void mlt_frame_close( mlt_frame self )
 {
 	if ( self != NULL && mlt_properties_dec_ref( MLT_FRAME_PROPERTIES( self ) ) <= 0 )
 	{
+#if USE_MLT_FRAME_POOL
+		if ( pool_is_enabled( ) )
+		{
+			while( mlt_deque_peek_back( self->stack_service ) )
+				mlt_service_close( mlt_deque_pop_back( self->stack_service ) );
+			while( mlt_deque_count( self->stack_image ) )
+				mlt_deque_pop_back( self->stack_image );
+			while( mlt_deque_count( self->stack_audio ) )
+				mlt_deque_pop_back( self->stack_audio );
+			mlt_properties_reset( &self->parent );
+			self->convert_image = NULL;
+			self->convert_audio = NULL;
+			self->is_processing = 0;
+			pool_put( self );
+			return;
+		}
+#endif
 		mlt_deque_close( self->stack_image );
 		mlt_deque_close( self->stack_audio );
 		while( mlt_deque_peek_back( self->stack_service ) )
@@ -893,22 +1529,37 @@ mlt_frame mlt_frame_clone( mlt_frame self, int is_deep )
 			int width = mlt_properties_get_int( properties, "width" );
 			int height = mlt_properties_get_int( properties, "height" );
 
-			if ( ! size )
-				size = mlt_image_format_size( mlt_properties_get_int( properties, "format" ),
-					width, height, NULL );
-			copy = mlt_pool_alloc( size );
-			memcpy( copy, data, size );
-			mlt_properties_set_data( new_props, "image", copy, size, mlt_pool_release, NULL );
+			// Share the pixels if they are already shared, else copy them into a shared buffer
+			// so that clones of the clone can share them.
+			if ( data == mlt_properties_get_data( properties, "_shared_image", NULL ) )
+			{
+				set_shared( new_frame, "image", "_shared_image", data, size );
+			}
+			else
+			{
+				if ( ! size )
+					size = mlt_image_format_size( mlt_properties_get_int( properties, "format" ),
+						width, height, NULL );
+				copy = mlt_image_shared_alloc( size );
+				memcpy( copy, data, size );
+				set_shared( new_frame, "image", "_shared_image", copy, size );
+				mlt_image_shared_release( copy );
+			}
 
 			data = mlt_properties_get_data( properties, "alpha", &size );
-			if ( data )
+			if ( data && data == mlt_properties_get_data( properties, "_shared_alpha", NULL ) )
+			{
+				set_shared( new_frame, "alpha", "_shared_alpha", data, size );
+			}
+			else if ( data )
 			{
 				if ( ! size )
 					size = width * height;
-				copy = mlt_pool_alloc( size );
+				copy = mlt_image_shared_alloc( size );
 				memcpy( copy, data, size );
-				mlt_properties_set_data( new_props, "alpha", copy, size, mlt_pool_release, NULL );
-			};
+				set_shared( new_frame, "alpha", "_shared_alpha", copy, size );
+				mlt_image_shared_release( copy );
+			}
 		}
 	}
 	else
@@ -53,6 +53,7 @@ typedef int ( *mlt_get_audio )( mlt_frame self, void **buffer, mlt_audio_format
  * \properties \em _position the position of the frame
  * \properties \em meta.* holds metadata
  * \properties \em hide set to 1 to hide the video, 2 to mute the audio
+ * \properties \em consumer_quality the render quality requested by a real-time consumer, see mlt_quality
  * \properties \em last_track a flag to indicate an end-of-tracks frame
  * \properties \em previous \em frame a reference to the unfiltered preceding frame
  * (no speed factor applied, only available when \em _need_previous_next is set on the producer)
@@ -110,11 +111,24 @@ extern int mlt_frame_is_test_card( mlt_frame self );
 extern int mlt_frame_is_test_audio( mlt_frame self );
 extern double mlt_frame_get_aspect_ratio( mlt_frame self );
 extern int mlt_frame_set_aspect_ratio( mlt_frame self, double value );
+extern mlt_quality mlt_frame_get_quality( mlt_frame self );
+extern int mlt_frame_set_quality( mlt_frame self, mlt_quality quality );
 extern mlt_position mlt_frame_get_position( mlt_frame self );
 extern mlt_position mlt_frame_original_position( mlt_frame self );
 extern int mlt_frame_set_position( mlt_frame self, mlt_position value );
 extern int mlt_frame_set_image( mlt_frame self, uint8_t *image, int size, mlt_destructor destroy );
 extern int mlt_frame_set_alpha( mlt_frame self, uint8_t *alpha, int size, mlt_destructor destroy );
+extern int mlt_frame_set_image_shared( mlt_frame self, uint8_t *image, int size );
+extern int mlt_frame_set_alpha_shared( mlt_frame self, uint8_t *alpha, int size );
+extern uint8_t *mlt_frame_share_image( mlt_frame self, int *size );
+extern uint8_t *mlt_frame_share_alpha( mlt_frame self, int *size );
+extern void mlt_frame_set_image_opacity( mlt_frame self, int opacity );
+extern int mlt_frame_get_image_opacity( mlt_frame self );
+extern void mlt_frame_set_image_solid( mlt_frame self, mlt_color color );
+extern int mlt_frame_get_image_solid( mlt_frame self, mlt_color *color );
+extern void mlt_frame_set_image_content( mlt_frame self, mlt_rect rect );
+extern int mlt_frame_get_image_content( mlt_frame self, mlt_rect *rect );
+extern void mlt_frame_keep_image_facts( mlt_frame self );
 extern void mlt_frame_replace_image( mlt_frame self, uint8_t *image, mlt_image_format format, int width, int height );
 extern int mlt_frame_get_image( mlt_frame self, uint8_t **buffer, mlt_image_format *format, int *width, int *height, int writable );
 extern uint8_t *mlt_frame_get_alpha( mlt_frame self );
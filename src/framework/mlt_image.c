@@ -23,9 +23,25 @@
 #include "mlt_image.h"
 
 #include "mlt_log.h"
+#include "mlt_slices.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+
+/** \brief the header that precedes a shared image buffer
+ *
+ * Aligned to 16 bytes so that the pixels keep the alignment of the pool.
+ */
+
+typedef struct __attribute__ ((aligned (16))) shared_header_s
+{
+	atomic_int references;
+	int size;
+}
+*shared_header;
+
+#define SHARED_HEADER( data ) ( (shared_header) ( (char*) ( data ) - sizeof( struct shared_header_s ) ) )
 
 /** Allocate a new Image object.
  *
@@ -334,6 +350,490 @@ void mlt_image_fill_opaque( mlt_image self )
 	}
 }
 
+/** \brief the work shared by the slices of a box blur */
+
+struct box_blur_desc
+{
+	const uint8_t *src;
+	uint8_t *dst;
+	int width;
+	int height;
+	int channels;
+	int left;
+	int right;
+	int top;
+	int bottom;
+	int normalise;
+	int first;
+	float scale;
+};
+
+static inline void box_blur_add( int32_t *sums, const uint8_t *line, int count )
+{
+	for ( int i = 0; i < count; i++ )
+		sums[i] += line[i];
+}
+
+static inline void box_blur_subtract( int32_t *sums, const uint8_t *line, int count )
+{
+	for ( int i = 0; i < count; i++ )
+		sums[i] -= line[i];
+}
+
+static inline void box_blur_slide( int32_t *sums, const uint8_t *leaving, const uint8_t *entering, int count )
+{
+	for ( int i = 0; i < count; i++ )
+		sums[i] += entering[i] - leaving[i];
+}
+
+/** Write a pixel of the result from the sums of its window.
+ *
+ * Dividing multiplies with the inverse of the count, which is exact for sums
+ * of 8-bit values while the count is below 4104, else \p inverse is 0.
+ */
+
+static inline void box_blur_put( const struct box_blur_desc *d, uint8_t *out, const int32_t *total, int count, uint64_t inverse, const int n )
+{
+	int c;
+	if ( !d->normalise )
+		for ( c = 0; c < n; c++ )
+			out[c] = total[c] * d->scale;
+	else if ( inverse )
+		for ( c = 0; c < n; c++ )
+			out[c] = ( (uint64_t) total[c] * inverse ) >> 32;
+	else
+		for ( c = 0; c < n; c++ )
+			out[c] = total[c] / count;
+}
+
+static inline uint64_t box_blur_inverse( int count )
+{
+	return count > 0 && count < 4096 ? ( ( UINT64_C(1) << 32 ) + count - 1 ) / count : 0;
+}
+
+/** Slide the window along a line of column sums and write one line of the result.
+ *
+ * \param d the blur
+ * \param sums the sums of the columns over the rows in the window
+ * \param out the line of the result
+ * \param rows the number of rows in the window
+ * \param n the number of channels, a constant where inlined so that the
+ * channels of a pixel are handled as one vector
+ */
+
+static inline void box_blur_line( const struct box_blur_desc *d, const int32_t *sums, uint8_t *out, int rows, const int n )
+{
+	int32_t total[4] = { 0, 0, 0, 0 };
+	int width = d->width;
+	int first = MAX( 1 - d->left, d->first );
+	int last = MIN( d->right, width - 1 );
+	// Between these the window has all its pixels and moves by one each time
+	int inside = MAX( d->left + d->first - 1, 0 );
+	int outside = width - 1 - d->right;
+	int count = 0;
+	uint64_t inverse = 0;
+	int x, c;
+
+	for ( x = first; x <= last; x++ )
+		for ( c = 0; c < n; c++ )
+			total[c] += sums[x * n + c];
+
+	x = 0;
+	while ( x < width )
+	{
+		if ( count != ( last - first + 1 ) * rows )
+		{
+			count = ( last - first + 1 ) * rows;
+			inverse = box_blur_inverse( count );
+		}
+
+		if ( x >= inside && x < outside )
+		{
+			const int32_t *leaving = sums + first * n;
+			const int32_t *entering = sums + ( last + 1 ) * n;
+			first += outside - x;
+			last += outside - x;
+			for ( ; x < outside; x++, out += n, leaving += n, entering += n )
+			{
+				box_blur_put( d, out, total, count, inverse, n );
+				for ( c = 0; c < n; c++ )
+					total[c] += entering[c] - leaving[c];
+			}
+			continue;
+		}
+
+		box_blur_put( d, out, total, count, inverse, n );
+
+		// Slide the window along a pixel
+		if ( x + 1 - d->left >= d->first )
+		{
+			for ( c = 0; c < n; c++ )
+				total[c] -= sums[first * n + c];
+			first++;
+		}
+		if ( x + 1 + d->right < width )
+		{
+			last++;
+			for ( c = 0; c < n; c++ )
+				total[c] += sums[last * n + c];
+		}
+		x++;
+		out += n;
+	}
+}
+
+static int box_blur_slice( int id, int index, int jobs, void *cookie )
+{
+	(void) id; // unused
+	const struct box_blur_desc *d = cookie;
+	int slice_height = ( d->height + jobs - 1 ) / jobs;
+	int slice_line_start = index * slice_height;
+	int line_size = d->width * d->channels;
+	int32_t *sums = mlt_pool_alloc( line_size * sizeof( *sums ) );
+	int first, last, y;
+
+	slice_height = MIN( slice_height, d->height - slice_line_start );
+	if ( !sums || slice_height <= 0 )
+	{
+		mlt_pool_release( sums );
+		return 0;
+	}
+
+	// Sum the columns over the rows in the window of the first line
+	memset( sums, 0, line_size * sizeof( *sums ) );
+	first = MAX( slice_line_start + 1 - d->top, d->first );
+	last = MIN( slice_line_start + d->bottom, d->height - 1 );
+	for ( y = first; y <= last; y++ )
+		box_blur_add( sums, d->src + y * line_size, line_size );
+
+	for ( y = slice_line_start; y < slice_line_start + slice_height; y++ )
+	{
+		uint8_t *out = d->dst + y * line_size;
+		int rows = last - first + 1;
+
+		switch ( d->channels )
+		{
+			case 1: box_blur_line( d, sums, out, rows, 1 ); break;
+			case 2: box_blur_line( d, sums, out, rows, 2 ); break;
+			case 3: box_blur_line( d, sums, out, rows, 3 ); break;
+			default: box_blur_line( d, sums, out, rows, 4 ); break;
+		}
+
+		// Slide the window down a row
+		int leaves = y + 1 - d->top >= d->first;
+		int enters = y + 1 + d->bottom < d->height;
+		if ( leaves && enters )
+			box_blur_slide( sums, d->src + first++ * line_size, d->src + ++last * line_size, line_size );
+		else if ( leaves )
+			box_blur_subtract( sums, d->src + first++ * line_size, line_size );
+		else if ( enters )
+			box_blur_add( sums, d->src + ++last * line_size, line_size );
+	}
+
+	mlt_pool_release( sums );
+	return 0;
+}
+
+/** Blur an image with a box filter.
+ *
+ * Each pixel becomes the sum of the pixels in its window, which runs from
+ * after the pixel \p left pixels before it to the pixel \p right pixels after
+ * it, and likewise from after the row \p top rows above it to the row
+ * \p bottom rows below it. When \p normalise is set, the pixels of the window
+ * that are outside the image are left out and the sum is divided by the
+ * number of pixels left. Otherwise the ends of the window are clamped to the
+ * image as with a summed-area table, so the first row and column only count
+ * once the window no longer reaches past them, and the sum is divided by the
+ * area of the whole window so that the edges fade.
+ *
+ * The sums are kept per column and slid along each row, so the cost does not
+ * depend on the size of the window, and the rows are split across the slices.
+ *
+ * \public \memberof mlt_image_s
+ * \param image the 8-bit image to blur in place, with no padding between rows
+ * \param width the width of the image
+ * \param height the height of the image
+ * \param channels the number of interleaved channels, 1 to 4
+ * \param left the extent of the window before a pixel
+ * \param right the extent of the window after a pixel
+ * \param top the extent of the window above a pixel
+ * \param bottom the extent of the window below a pixel
+ * \param normalise whether to divide by the pixels inside the image, which
+ * needs \p left and \p top to be at least 1 so that a window holds its pixel
+ * \return true on error
+ */
+
+int mlt_image_box_blur( uint8_t *image, int width, int height, int channels, int left, int right, int top, int bottom, int normalise )
+{
+	if ( !image || width <= 0 || height <= 0 || channels < 1 || channels > 4 ||
+		 left < 0 || right < 0 || top < 0 || bottom < 0 ||
+		 left + right < 1 || top + bottom < 1 || ( normalise && ( left < 1 || top < 1 ) ) )
+		return 1;
+
+	struct box_blur_desc desc;
+	int size = width * height * channels;
+	uint8_t *src = mlt_pool_alloc( size );
+	if ( !src )
+		return 1;
+	memcpy( src, image, size );
+
+	desc.src = src;
+	desc.dst = image;
+	desc.width = width;
+	desc.height = height;
+	desc.channels = channels;
+	desc.left = left;
+	desc.right = right;
+	desc.top = top;
+	desc.bottom = bottom;
+	desc.normalise = normalise;
+	desc.first = normalise ? 0 : 1;
+	desc.scale = 1.f / ( ( left + right ) * ( top + bottom ) );
+
+	// Each slice first sums the window of its first row, so keep the slices
+	// taller than the window.
+	int jobs = MIN( mlt_slices_count_normal(), height / ( top + bottom ) );
+	if ( jobs > 1 )
+		mlt_slices_run_normal( jobs, box_blur_slice, &desc );
+	else
+		box_blur_slice( 0, 0, 1, &desc );
+
+	mlt_pool_release( src );
+	return 0;
+}
+
+/** \brief the work shared by the slices of a lookup table map */
+
+struct apply_luts_desc
+{
+	uint8_t *image;
+	mlt_image_format format;
+	int width;
+	int height;
+	const uint8_t *luts[4];
+	int constant[4];
+	int tables[4][256];
+};
+
+static int apply_luts_slice( int id, int index, int jobs, void *cookie )
+{
+	(void) id; // unused
+	const struct apply_luts_desc *d = cookie;
+	int slice_height = ( d->height + jobs - 1 ) / jobs;
+	int first = index * slice_height;
+	int rows = MIN( slice_height, d->height - first );
+	int size = rows > 0 ? rows * d->width : 0;
+	const int *l0 = d->tables[0];
+	const int *l1 = d->tables[1];
+	const int *l2 = d->tables[2];
+	const int *l3 = d->luts[3] ? d->tables[3] : NULL;
+	uint8_t *p;
+	int i;
+
+	// Map all of the channels of a pixel in one pass, which is much quicker
+	// than a pass for each channel.
+	switch ( d->format )
+	{
+	case mlt_image_rgb:
+		p = d->image + first * d->width * 3;
+		for ( i = 0; i < size; i++, p += 3 )
+		{
+			p[0] = l0[p[0]];
+			p[1] = l1[p[1]];
+			p[2] = l2[p[2]];
+		}
+		break;
+	case mlt_image_rgba:
+		p = d->image + first * d->width * 4;
+		if ( l3 )
+		{
+			for ( i = 0; i < size; i++, p += 4 )
+			{
+				p[0] = l0[p[0]];
+				p[1] = l1[p[1]];
+				p[2] = l2[p[2]];
+				p[3] = l3[p[3]];
+			}
+		}
+		else
+		{
+			for ( i = 0; i < size; i++, p += 4 )
+			{
+				p[0] = l0[p[0]];
+				p[1] = l1[p[1]];
+				p[2] = l2[p[2]];
+			}
+		}
+		break;
+	case mlt_image_yuv422:
+		// U is in the even pixels and V in the odd ones, which also holds
+		// for rows of an odd width, so go a row at a time.
+		for ( ; rows > 0; rows--, first++ )
+		{
+			p = d->image + first * d->width * 2;
+			if ( !d->luts[1] && !d->luts[2] )
+			{
+				for ( i = 0; i < d->width; i++, p += 2 )
+					p[0] = l0[p[0]];
+				continue;
+			}
+			if ( !d->luts[0] && d->constant[1] >= 0 && d->constant[2] >= 0 )
+			{
+				// Storing the chroma of a tint needs no lookups.
+				uint8_t u = d->constant[1], v = d->constant[2];
+				for ( i = 0; i + 1 < d->width; i += 2, p += 4 )
+				{
+					p[1] = u;
+					p[3] = v;
+				}
+				if ( i < d->width )
+					p[1] = u;
+				continue;
+			}
+			for ( i = 0; i + 1 < d->width; i += 2, p += 4 )
+			{
+				p[0] = l0[p[0]];
+				p[1] = l1[p[1]];
+				p[2] = l0[p[2]];
+				p[3] = l2[p[3]];
+			}
+			if ( i < d->width )
+			{
+				p[0] = l0[p[0]];
+				p[1] = l1[p[1]];
+			}
+		}
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
+/** Map the channels of an image through 8-bit lookup tables.
+ *
+ * This is the pixel loop of the filters that map each channel on its own,
+ * such as gamma, greyscale or a colour grade, with the rows split across the
+ * slices.
+ *
+ * \public \memberof mlt_image_s
+ * \param image the image to map in place, with no padding between rows
+ * \param format mlt_image_rgb, mlt_image_rgba or mlt_image_yuv422
+ * \param width the width of the image
+ * \param height the height of the image
+ * \param luts the table of 256 entries for each channel, in the order R, G,
+ * B and A or Y, U and V, where NULL leaves a channel as it is
+ * \return true on error, such as an unsupported format
+ */
+
+int mlt_image_apply_luts( uint8_t *image, mlt_image_format format, int width, int height, const uint8_t *luts[4] )
+{
+	if ( !image || !luts || width <= 0 || height <= 0 ||
+		 ( format != mlt_image_rgb && format != mlt_image_rgba && format != mlt_image_yuv422 ) )
+		return 1;
+
+	struct apply_luts_desc desc;
+	int c;
+
+	desc.image = image;
+	desc.format = format;
+	desc.width = width;
+	desc.height = height;
+	// Widen the tables to int, which makes the lookups a few percent quicker.
+	for ( c = 0; c < 4; c++ )
+	{
+		int i = 1;
+		desc.luts[c] = luts[c];
+		while ( luts[c] && i < 256 && luts[c][i] == luts[c][0] )
+			i++;
+		desc.constant[c] = luts[c] && i == 256 ? luts[c][0] : -1;
+		for ( i = 0; i < 256; i++ )
+			desc.tables[c][i] = luts[c] ? luts[c][i] : i;
+	}
+
+	int jobs = MIN( mlt_slices_count_normal(), height );
+	if ( jobs > 1 )
+		mlt_slices_run_normal( jobs, apply_luts_slice, &desc );
+	else
+		apply_luts_slice( 0, 0, 1, &desc );
+
+	return 0;
+}
+
+/** Allocate a reference-counted buffer for image or alpha data.
+ *
+ * The buffer starts with one reference. Use it with
+ * mlt_frame_set_image_shared() to let several frames hold the same pixels;
+ * mlt_frame_get_image() copies it when a writable image is requested while
+ * it is shared.
+ *
+ * \public \memberof mlt_image_s
+ * \param size the number of bytes
+ * \return the buffer or NULL on error
+ */
+
+void *mlt_image_shared_alloc( int size )
+{
+	shared_header header = mlt_pool_alloc( sizeof( struct shared_header_s ) + size );
+	if ( !header )
+		return NULL;
+	atomic_init( &header->references, 1 );
+	header->size = size;
+	return (char*) header + sizeof( struct shared_header_s );
+}
+
+/** Add a reference to a shared buffer.
+ *
+ * \public \memberof mlt_image_s
+ * \param data a buffer from mlt_image_shared_alloc()
+ * \return \p data
+ */
+
+void *mlt_image_shared_ref( void *data )
+{
+	if ( data )
+		atomic_fetch_add( &SHARED_HEADER( data )->references, 1 );
+	return data;
+}
+
+/** Remove a reference from a shared buffer and free it with the last one.
+ *
+ * This is suitable as the destructor of a shared buffer.
+ *
+ * \public \memberof mlt_image_s
+ * \param data a buffer from mlt_image_shared_alloc()
+ */
+
+void mlt_image_shared_release( void *data )
+{
+	if ( data && atomic_fetch_sub( &SHARED_HEADER( data )->references, 1 ) == 1 )
+		mlt_pool_release( SHARED_HEADER( data ) );
+}
+
+/** Get the number of references to a shared buffer.
+ *
+ * \public \memberof mlt_image_s
+ * \param data a buffer from mlt_image_shared_alloc()
+ * \return the number of references
+ */
+
+int mlt_image_shared_count( void *data )
+{
+	return data ? atomic_load( &SHARED_HEADER( data )->references ) : 0;
+}
+
+/** Get the size of a shared buffer.
+ *
+ * \public \memberof mlt_image_s
+ * \param data a buffer from mlt_image_shared_alloc()
+ * \return the number of bytes requested when it was allocated
+ */
+
+int mlt_image_shared_size( void *data )
+{
+	return data ? SHARED_HEADER( data )->size : 0;
+}
+
 /** Get the number of bytes needed for an image.
   *
   * \public \memberof mlt_image_s
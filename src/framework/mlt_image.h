@@ -55,8 +55,15 @@ extern void mlt_image_alloc_alpha( mlt_image self );
 extern int mlt_image_calculate_size( mlt_image self );
 extern void mlt_image_fill_black( mlt_image self );
 extern void mlt_image_fill_opaque( mlt_image self );
+extern int mlt_image_box_blur( uint8_t *image, int width, int height, int channels, int left, int right, int top, int bottom, int normalise );
+extern int mlt_image_apply_luts( uint8_t *image, mlt_image_format format, int width, int height, const uint8_t *luts[4] );
 extern const char * mlt_image_format_name( mlt_image_format format );
 extern mlt_image_format mlt_image_format_id( const char * name );
+extern void *mlt_image_shared_alloc( int size );
+extern void *mlt_image_shared_ref( void *data );
+extern void mlt_image_shared_release( void *data );
+extern int mlt_image_shared_count( void *data );
+extern int mlt_image_shared_size( void *data );
 
 // Deprecated functions
 extern int mlt_image_format_size( mlt_image_format format, int width, int height, int *bpp );
@@ -59,6 +59,10 @@ typedef struct
 	int ref_count;
 	pthread_mutex_t mutex;
 	locale_t locale;
+	char *arena;
+	size_t arena_size;
+	size_t arena_used;
+	struct mlt_events_struct *events;
 }
 property_list;
 
@@ -435,8 +439,102 @@ void mlt_properties_mirror( mlt_properties self, mlt_properties that )
 	list->mirror = that;
 }
 
+static void fire_property_changed(mlt_properties self, const char *name)
+{
+	property_list *list = self->local;
+
+	// Most properties lists, including all frames, have no events at all
+	if ( list->events != NULL )
+		mlt_events_fire(self, "property-changed", mlt_event_data_from_string(name));
+}
+
+/** Get the events object of a properties list.
+ *
+ * This is private to the framework; use the functions of mlt_events_struct.
+ * \private \memberof mlt_properties_s
+ * \param self a properties list
+ * \return the events object or NULL if mlt_events_init() was not called
+ */
+
+struct mlt_events_struct *mlt_properties_get_events( mlt_properties self )
+{
+	return self->local ? ( ( property_list* )self->local )->events : NULL;
+}
+
+/** Set the events object of a properties list.
+ *
+ * This is private to the framework; the "_events" property owns the object.
+ * \private \memberof mlt_properties_s
+ * \param self a properties list
+ * \param events an events object or NULL
+ */
+
+void mlt_properties_set_events( mlt_properties self, struct mlt_events_struct *events )
+{
+	if ( self->local )
+		( ( property_list* )self->local )->events = events;
+}
+
+/** \brief Names of changed properties for which notification is deferred */
+
+typedef struct
+{
+	char **names;
+	int count;
+	int size;
+}
+changed_list;
+
+/** Remember that a property changed during a bulk update.
+ *
+ * \private \memberof mlt_properties_s
+ * \param changed a list of names
+ * \param name the name of a property that changed
+ */
+
+static void changed_add( changed_list *changed, const char *name )
+{
+	if ( changed->count == changed->size )
+	{
+		int size = changed->size + 32;
+		char **names = realloc( changed->names, size * sizeof( char* ) );
+		if ( names == NULL )
+			return;
+		changed->names = names;
+		changed->size = size;
+	}
+	changed->names[ changed->count ++ ] = strdup( name );
+}
+
+/** Fire "property-changed" for each property changed by a bulk update.
+ *
+ * \private \memberof mlt_properties_s
+ * \param self a properties list
+ * \param changed a list of names, which is emptied
+ */
+
+static void changed_fire( mlt_properties self, changed_list *changed )
+{
+	for ( int i = 0; i < changed->count; i ++ )
+	{
+		fire_property_changed( self, changed->names[ i ] );
+		free( changed->names[ i ] );
+	}
+	free( changed->names );
+	changed->names = NULL;
+	changed->count = changed->size = 0;
+}
+
+/* Forward declaration to private functions.
+*/
+
+static int set_string( mlt_properties self, const char *name, const char *value );
+static int pass_property( mlt_properties self, mlt_properties that, const char *name );
+
 /** Copy all serializable properties to another properties list.
  *
+ * The event "property-changed" is fired for each property after all of them
+ * have been set.
  * \public \memberof mlt_properties_s
  * \param self The properties to copy to
  * \param that The properties to copy from
@@ -446,6 +544,8 @@ void mlt_properties_mirror( mlt_properties self, mlt_properties that )
 int mlt_properties_inherit( mlt_properties self, mlt_properties that )
 {
 	if ( !self || !that ) return 1;
+	changed_list changed = { NULL, 0, 0 };
+	int notify = mlt_events_has_listeners( self, "property-changed" );
 
 	// Set "properties" first so preset overrides are reliable.
 	char *value = mlt_properties_get(that, "properties");
@@ -463,12 +563,18 @@ int mlt_properties_inherit( mlt_properties self, mlt_properties that )
 		{
 			char *name = mlt_properties_get_name( that, i );
 			if (name && strcmp("properties", name))
-				mlt_properties_set_string( self, name, value );
+			{
+				set_string( self, name, value );
+				if ( notify )
+					changed_add( &changed, name );
+			}
 		}
 	}
 
 	mlt_properties_unlock( that );
 
+	changed_fire( self, &changed );
+
 	return 0;
 }
 
@@ -477,6 +583,8 @@ int mlt_properties_inherit( mlt_properties self, mlt_properties that )
  * \warning The prefix is stripped from the name when it is set on the \p self properties list!
  * For example a property named "foo.bar" will match prefix "foo.", but the property
  * will be named simply "bar" on the receiving properties object.
+ * The event "property-changed" is fired for each property after all of them
+ * have been set.
  * \public \memberof mlt_properties_s
  * \param self the properties to copy to
  * \param that The properties to copy from
@@ -487,6 +595,8 @@ int mlt_properties_inherit( mlt_properties self, mlt_properties that )
 int mlt_properties_pass( mlt_properties self, mlt_properties that, const char *prefix )
 {
 	if ( !self || !that ) return 1;
+	changed_list changed = { NULL, 0, 0 };
+	int notify = mlt_events_has_listeners( self, "property-changed" );
 	int count = mlt_properties_count( that );
 	int length = strlen( prefix );
 	int i = 0;
@@ -497,9 +607,14 @@ int mlt_properties_pass( mlt_properties self, mlt_properties that, const char *p
 		{
 			char *value = mlt_properties_get_value( that, i );
 			if ( value != NULL )
-				mlt_properties_set_string( self, name + length, value );
+			{
+				set_string( self, name + length, value );
+				if ( notify )
+					changed_add( &changed, name + length );
+			}
 		}
 	}
+	changed_fire( self, &changed );
 	return 0;
 }
 
@@ -538,6 +653,40 @@ static inline mlt_property mlt_properties_find( mlt_properties self, const char
 	return value;
 }
 
+/** Copy a property name into the list's name arena, if there is room.
+ *
+ * \private \memberof mlt_properties_s
+ * \param list a property list
+ * \param name the name to copy
+ * \return the copy, which must be released with free_name()
+ */
+
+static char *copy_name( property_list *list, const char *name )
+{
+	size_t length = strlen( name ) + 1;
+	if ( list->arena_used + length <= list->arena_size )
+	{
+		char *result = list->arena + list->arena_used;
+		memcpy( result, name, length );
+		list->arena_used += length;
+		return result;
+	}
+	return strdup( name );
+}
+
+/** Release a property name obtained from copy_name().
+ *
+ * \private \memberof mlt_properties_s
+ * \param list a property list
+ * \param name the name to release
+ */
+
+static void free_name( property_list *list, char *name )
+{
+	if ( !list->arena || name < list->arena || name >= list->arena + list->arena_size )
+		free( name );
+}
+
 /** Add a new property.
  *
  * \private \memberof mlt_properties_s
@@ -560,11 +709,13 @@ static mlt_property mlt_properties_add( mlt_properties self, const char *name )
 		list->size += 50;
 		list->name = realloc( list->name, list->size * sizeof( const char * ) );
 		list->value = realloc( list->value, list->size * sizeof( mlt_property ) );
+		memset( list->value + list->count, 0, ( list->size - list->count ) * sizeof( mlt_property ) );
 	}
 
-	// Assign name/value pair
-	list->name[ list->count ] = strdup( name );
-	list->value[ list->count ] = mlt_property_init( );
+	// Assign name/value pair, reusing a property left over from mlt_properties_reset()
+	list->name[ list->count ] = copy_name( list, name );
+	if ( list->value[ list->count ] == NULL )
+		list->value[ list->count ] = mlt_property_init( );
 
 	// Assign to hash table
 	if ( list->hash[ key ] == 0 )
@@ -599,11 +750,6 @@ static mlt_property mlt_properties_fetch( mlt_properties self, const char *name
 	return property;
 }
 
-static void fire_property_changed(mlt_properties self, const char *name)
-{
-	mlt_events_fire(self, "property-changed", mlt_event_data_from_string(name));
-}
-
 /** Copy a property to another properties list.
  *
  * \public \memberof mlt_properties_s
@@ -614,19 +760,36 @@ static void fire_property_changed(mlt_properties self, const char *name)
  */
 
 void mlt_properties_pass_property( mlt_properties self, mlt_properties that, const char *name )
+{
+	if ( pass_property( self, that, name ) )
+		fire_property_changed(self, name);
+}
+
+/** Copy a property to another properties list without firing an event.
+ *
+ * \private \memberof mlt_properties_s
+ * \param self the properties to copy to
+ * \param that the properties to copy from
+ * \param name the name of the property to copy
+ * \return true if the property was copied
+ */
+
+static int pass_property( mlt_properties self, mlt_properties that, const char *name )
 {
 	// Make sure the source property isn't null.
 	mlt_property that_prop = mlt_properties_find( that, name );
 	if( that_prop == NULL )
-		return;
+		return 0;
 
 	mlt_property_pass( mlt_properties_fetch( self, name ), that_prop );
-	fire_property_changed(self, name);
+	return 1;
 }
 
 /** Copy all properties specified in a comma-separated list to another properties list.
  *
  * White space is also a delimiter.
+ * The event "property-changed" is fired once for each property copied after
+ * all of them have been set.
  * \public \memberof mlt_properties_s
  * \author Zach <zachary.drew@gmail.com>
  * \param self the properties to copy to
@@ -643,6 +806,8 @@ int mlt_properties_pass_list( mlt_properties self, mlt_properties that, const ch
 	char *ptr = props;
 	const char *delim = " ,\t\n";	// Any combination of spaces, commas, tabs, and newlines
 	int count, done = 0;
+	changed_list changed = { NULL, 0, 0 };
+	int notify = mlt_events_has_listeners( self, "property-changed" );
 
 	while( !done )
 	{
@@ -653,7 +818,15 @@ int mlt_properties_pass_list( mlt_properties self, mlt_properties that, const ch
 		else
 			ptr[count] = '\0';	// Make it a real string
 
-		mlt_properties_pass_property( self, that, ptr );
+		if ( pass_property( self, that, ptr ) && notify )
+		{
+			// Notify once for a name that is listed more than once
+			int i = 0;
+			while ( i < changed.count && strcmp( changed.names[ i ], ptr ) )
+				i ++;
+			if ( i == changed.count )
+				changed_add( &changed, ptr );
+		}
 
 		ptr += count + 1;
 		if ( !done )
@@ -662,6 +835,8 @@ int mlt_properties_pass_list( mlt_properties self, mlt_properties that, const ch
 
 	free( props );
 
+	changed_fire( self, &changed );
+
 	return 0;
 }
 
@@ -830,9 +1005,27 @@ int mlt_properties_set_or_default( mlt_properties self, const char *name, const
 
 int mlt_properties_set_string( mlt_properties self, const char *name, const char *value )
 {
-	int error = 1;
+	if ( !self || !name ) return 1;
 
-	if ( !self || !name ) return error;
+	int error = set_string( self, name, value );
+
+	fire_property_changed(self, name);
+
+	return error;
+}
+
+/** Set a property to a string without firing an event.
+ *
+ * \private \memberof mlt_properties_s
+ * \param self a properties list
+ * \param name the property to set
+ * \param value the property's new value
+ * \return true if error
+ */
+
+static int set_string( mlt_properties self, const char *name, const char *value )
+{
+	int error = 1;
 
 	// Fetch the property to work with
 	mlt_property property = mlt_properties_fetch( self, name );
@@ -855,8 +1048,6 @@ int mlt_properties_set_string( mlt_properties self, const char *name, const char
 			mlt_properties_preset( self, value );
 	}
 
-	fire_property_changed(self, name);
-
 	return error;
 }
 
@@ -1281,8 +1472,8 @@ int mlt_properties_rename( mlt_properties self, const char *source, const char *
 		{
 			if ( list->name[ i ] && !strcmp( list->name[ i ], source ) )
 			{
-				free( list->name[ i ] );
-				list->name[ i ] = strdup( dest );
+				free_name( list, list->name[ i ] );
+				list->name[ i ] = copy_name( list, dest );
 				list->hash[ generate_hash( dest ) ] = i + 1;
 				break;
 			}
@@ -1504,9 +1695,13 @@ void mlt_properties_close( mlt_properties self )
 			for ( index = list->count - 1; index >= 0; index -- )
 			{
 				mlt_property_close( list->value[ index ] );
-				free( list->name[ index ] );
+				free_name( list, list->name[ index ] );
 			}
 
+			// Clean up properties kept for reuse
+			for ( index = list->count; index < list->size && list->value[ index ]; index ++ )
+				mlt_property_close( list->value[ index ] );
+
 #if defined(__GLIBC__) || defined(__APPLE__)
 			// Cleanup locale
 			if ( list->locale )
@@ -1520,6 +1715,7 @@ void mlt_properties_close( mlt_properties self )
 			pthread_mutex_destroy( &list->mutex );
 			free( list->name );
 			free( list->value );
+			free( list->arena );
 			free( list );
 
 			// Free self now if self has no child
@@ -1529,6 +1725,63 @@ void mlt_properties_close( mlt_properties self )
 	}
 }
 
+/** Remove all of the properties while keeping their storage for reuse.
+ *
+ * This returns the object to the state following mlt_properties_init() -
+ * no properties, no mirror, the C numeric locale and a single reference -
+ * except that the property objects and the memory used for their names are
+ * kept to be reused by the properties that are set next. This is intended for
+ * objects that are recycled, such as frames, and the caller must hold the only
+ * reference to it.
+ * \public \memberof mlt_properties_s
+ * \param self a properties list
+ */
+
+void mlt_properties_reset( mlt_properties self )
+{
+	if ( self == NULL || self->local == NULL )
+		return;
+
+	property_list *list = self->local;
+	size_t names_size = 0;
+	int index;
+
+	// Clear values in the same order as mlt_properties_close()
+	for ( index = list->count - 1; index >= 0; index -- )
+	{
+		mlt_property_clear( list->value[ index ] );
+		names_size += strlen( list->name[ index ] ) + 1;
+		free_name( list, list->name[ index ] );
+	}
+
+	// Size the arena to hold all of the names seen in this round the next time
+	if ( names_size > list->arena_size )
+	{
+		free( list->arena );
+		list->arena_size = names_size + names_size / 4;
+		list->arena = malloc( list->arena_size );
+		if ( list->arena == NULL )
+			list->arena_size = 0;
+	}
+	list->arena_used = 0;
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+	if ( list->locale )
+		freelocale( list->locale );
+#else
+	free( list->locale );
+#endif
+	list->locale = NULL;
+
+	memset( list->hash, 0, sizeof( list->hash ) );
+	list->count = 0;
+	list->mirror = NULL;
+	list->events = NULL;
+	list->ref_count = 1;
+	self->close = NULL;
+	self->close_object = NULL;
+}
+
 /** Determine if the properties list is really just a sequence or ordered list.
  *
  * \public \memberof mlt_properties_s
@@ -33,6 +33,8 @@
 #include <string.h>
 #include <locale.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <float.h>
 #include <math.h>
 
@@ -64,39 +66,184 @@ struct mlt_property_s
 	/// Stores a bit pattern of types available for this property
 	mlt_property_type types;
 
-	/// Atomic type handling
-	int prop_int;
-	mlt_position prop_position;
-	double prop_double;
-	int64_t prop_int64;
+	/// The size of the binary data
+	int length;
 
-	/// String handling
+	/// The value as set, selected by the numeric or data bit in types
+	union
+	{
+		int prop_int;
+		mlt_position prop_position;
+		double prop_double;
+		int64_t prop_int64;
+		void *data;
+	};
+
+	/// String handling, also the cached string form of any other type
 	char *prop_string;
 
 	/// Generic type handling
-	void *data;
-	int length;
 	mlt_destructor destructor;
 	mlt_serialiser serialiser;
 
-	pthread_mutex_t mutex;
 	mlt_animation animation;
+
+	/// The thread holding the lock, with LOCK_WAITERS set if others wait for
+	/// it, and the number of times it has taken it
+	atomic_uintptr_t lock_owner;
+	int lock_depth;
 };
 
+/** Identifies the calling thread by the address of its own copy. */
+
+static _Thread_local int lock_thread;
+
+/** the bit of the lock owner that says threads are sleeping until it is released */
+#define LOCK_WAITERS ( ( uintptr_t )1 )
+
+/** the number of times to try for a lock before sleeping */
+#define LOCK_SPINS 100
+
+/** the number of mutexes shared by the properties that wait for a lock */
+#define LOCK_STRIPES 16
+
+/** \brief Where threads sleep until a property lock is released */
+
+static struct
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+}
+lock_stripes[ LOCK_STRIPES ];
+static pthread_once_t lock_stripes_once = PTHREAD_ONCE_INIT;
+
+static void lock_stripes_init( )
+{
+	int i;
+	for ( i = 0; i < LOCK_STRIPES; i++ )
+	{
+		pthread_mutex_init( &lock_stripes[i].mutex, NULL );
+		pthread_cond_init( &lock_stripes[i].cond, NULL );
+	}
+}
+
+static inline int lock_stripe( mlt_property self )
+{
+	return ( ( uintptr_t )self / sizeof( struct mlt_property_s ) ) % LOCK_STRIPES;
+}
+
+static inline int lock_try( mlt_property self, uintptr_t me )
+{
+	uintptr_t expected = 0;
+	return atomic_compare_exchange_weak_explicit( &self->lock_owner, &expected, me,
+		memory_order_acquire, memory_order_relaxed );
+}
+
+/** Sleep until a property lock can be taken.
+ *
+ * \private \memberof mlt_property_s
+ * \param self a property
+ * \param me the calling thread
+ */
+
+static void lock_wait( mlt_property self, uintptr_t me )
+{
+	int stripe = lock_stripe( self );
+	uintptr_t owner = atomic_load_explicit( &self->lock_owner, memory_order_relaxed );
+	pthread_once( &lock_stripes_once, lock_stripes_init );
+	pthread_mutex_lock( &lock_stripes[stripe].mutex );
+	for ( ;; )
+	{
+		if ( owner == 0 )
+		{
+			// Keep the waiters bit, since other threads may still be waiting.
+			if ( atomic_compare_exchange_weak_explicit( &self->lock_owner, &owner, me | LOCK_WAITERS,
+					memory_order_acquire, memory_order_relaxed ) )
+				break;
+		}
+		else if ( owner & LOCK_WAITERS ||
+				  atomic_compare_exchange_weak_explicit( &self->lock_owner, &owner, owner | LOCK_WAITERS,
+					memory_order_relaxed, memory_order_relaxed ) )
+		{
+			// The holder sees the bit when it releases the lock and then
+			// needs the stripe mutex to wake us, which we hold until we wait.
+			pthread_cond_wait( &lock_stripes[stripe].cond, &lock_stripes[stripe].mutex );
+			owner = atomic_load_explicit( &self->lock_owner, memory_order_relaxed );
+		}
+	}
+	pthread_mutex_unlock( &lock_stripes[stripe].mutex );
+}
+
+/** Wake the threads waiting for a property lock.
+ *
+ * \private \memberof mlt_property_s
+ * \param self a property
+ */
+
+static void lock_wake( mlt_property self )
+{
+	int stripe = lock_stripe( self );
+	pthread_mutex_lock( &lock_stripes[stripe].mutex );
+	pthread_cond_broadcast( &lock_stripes[stripe].cond );
+	pthread_mutex_unlock( &lock_stripes[stripe].mutex );
+}
+
+/** Lock a property.
+ *
+ * Properties are locked recursively and while another property is locked, for
+ * example an animation and its keyframes, so each needs a lock of its own.
+ * This one is much smaller than a pthread mutex and is rarely contended. A
+ * thread that cannot get it after a short spin sleeps on a mutex shared with
+ * other properties, so that it does not keep the holder from running.
+ * \private \memberof mlt_property_s
+ * \param self a property
+ */
+
+static inline void property_lock( mlt_property self )
+{
+	uintptr_t me = ( uintptr_t )&lock_thread;
+	int spins;
+
+	if ( ( atomic_load_explicit( &self->lock_owner, memory_order_relaxed ) & ~LOCK_WAITERS ) == me )
+	{
+		self->lock_depth ++;
+		return;
+	}
+	for ( spins = 0; spins < LOCK_SPINS; spins++ )
+	{
+		if ( lock_try( self, me ) )
+		{
+			self->lock_depth = 1;
+			return;
+		}
+	}
+
+	lock_wait( self, me );
+	self->lock_depth = 1;
+}
+
+/** Unlock a property.
+ *
+ * \private \memberof mlt_property_s
+ * \param self a property
+ */
+
+static inline void property_unlock( mlt_property self )
+{
+	if ( -- self->lock_depth == 0 )
+	{
+		if ( atomic_exchange_explicit( &self->lock_owner, 0, memory_order_release ) & LOCK_WAITERS )
+			lock_wake( self );
+	}
+}
+
 /** Construct a property and initialize it
  * \public \memberof mlt_property_s
  */
 
 mlt_property mlt_property_init( )
 {
-	mlt_property self = calloc( 1, sizeof( *self ) );
-	if ( self ) {
-		pthread_mutexattr_t attr;
-		pthread_mutexattr_init(&attr);
-		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-		pthread_mutex_init( &self->mutex, &attr );
-	}
-	return self;
+	return calloc( 1, sizeof( struct mlt_property_s ) );
 }
 
 /** Clear (0/null) a property.
@@ -120,12 +267,9 @@ static void clear_property( mlt_property self )
 
 	// Wipe stuff
 	self->types = 0;
-	self->prop_int = 0;
-	self->prop_position = 0;
-	self->prop_double = 0;
 	self->prop_int64 = 0;
-	self->prop_string = NULL;
 	self->data = NULL;
+	self->prop_string = NULL;
 	self->length = 0;
 	self->destructor = NULL;
 	self->serialiser = NULL;
@@ -141,9 +285,9 @@ static void clear_property( mlt_property self )
 
 void mlt_property_clear( mlt_property self )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 }
 
 /** Check if a property is cleared.
@@ -158,9 +302,9 @@ int mlt_property_is_clear( mlt_property self )
 	int result = 1;
 	if ( self )
 	{
-		pthread_mutex_lock( &self->mutex );
+		property_lock( self );
 		result = self->types == 0 && self->animation == NULL;
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 	}
 	return result;
 }
@@ -175,11 +319,11 @@ int mlt_property_is_clear( mlt_property self )
 
 int mlt_property_set_int( mlt_property self, int value )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
 	self->types = mlt_prop_int;
 	self->prop_int = value;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return 0;
 }
 
@@ -193,11 +337,11 @@ int mlt_property_set_int( mlt_property self, int value )
 
 int mlt_property_set_double( mlt_property self, double value )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
 	self->types = mlt_prop_double;
 	self->prop_double = value;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return 0;
 }
 
@@ -212,11 +356,11 @@ int mlt_property_set_double( mlt_property self, double value )
 
 int mlt_property_set_position( mlt_property self, mlt_position value )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
 	self->types = mlt_prop_position;
 	self->prop_position = value;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return 0;
 }
 
@@ -232,7 +376,7 @@ int mlt_property_set_position( mlt_property self, mlt_position value )
 
 int mlt_property_set_string( mlt_property self, const char *value )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( value != self->prop_string )
 	{
 		clear_property( self );
@@ -244,7 +388,7 @@ int mlt_property_set_string( mlt_property self, const char *value )
 	{
 		self->types = mlt_prop_string;
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return self->prop_string == NULL;
 }
 
@@ -258,11 +402,11 @@ int mlt_property_set_string( mlt_property self, const char *value )
 
 int mlt_property_set_int64( mlt_property self, int64_t value )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
 	self->types = mlt_prop_int64;
 	self->prop_int64 = value;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return 0;
 }
 
@@ -283,8 +427,8 @@ int mlt_property_set_int64( mlt_property self, int64_t value )
 
 int mlt_property_set_data( mlt_property self, void *value, int length, mlt_destructor destructor, mlt_serialiser serialiser )
 {
-	pthread_mutex_lock( &self->mutex );
-	if ( self->data == value )
+	property_lock( self );
+	if ( ( self->types & mlt_prop_data ) && self->data == value )
 		self->destructor = NULL;
 	clear_property( self );
 	self->types = mlt_prop_data;
@@ -292,7 +436,7 @@ int mlt_property_set_data( mlt_property self, void *value, int length, mlt_destr
 	self->length = length;
 	self->destructor = destructor;
 	self->serialiser = serialiser;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return 0;
 }
 
@@ -320,7 +464,7 @@ static int time_clock_to_frames( mlt_property self, const char *s, double fps, l
 	if ( locale )
 	{
 		// Protect damaging the global locale from a temporary locale on another thread.
-		pthread_mutex_lock( &self->mutex );
+		property_lock( self );
 
 		// Get the current locale
 		orig_localename = strdup( setlocale( LC_NUMERIC, NULL ) );
@@ -362,7 +506,7 @@ static int time_clock_to_frames( mlt_property self, const char *s, double fps, l
 		// Restore the current locale
 		setlocale( LC_NUMERIC, orig_localename );
 		free( orig_localename );
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 	}
 #endif
 
@@ -482,7 +626,7 @@ static int mlt_property_atoi( mlt_property self, double fps, locale_t locale )
 
 int mlt_property_get_int( mlt_property self, double fps, locale_t locale )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	int result = 0;
 	if ( self->types & mlt_prop_int )
 		result = self->prop_int;
@@ -501,7 +645,7 @@ int mlt_property_get_int( mlt_property self, double fps, locale_t locale )
 		if ( ( self->types & mlt_prop_string ) && self->prop_string )
 			result = mlt_property_atoi( self, fps, locale );
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return result;
 }
 
@@ -542,7 +686,7 @@ static double mlt_property_atof( mlt_property self, double fps, locale_t locale
 		char *orig_localename = NULL;
 		if ( locale ) {
 			// Protect damaging the global locale from a temporary locale on another thread.
-			pthread_mutex_lock( &self->mutex );
+			property_lock( self );
 
 			// Get the current locale
 			orig_localename = strdup( setlocale( LC_NUMERIC, NULL ) );
@@ -561,7 +705,7 @@ static double mlt_property_atof( mlt_property self, double fps, locale_t locale
 			// Restore the current locale
 			setlocale( LC_NUMERIC, orig_localename );
 			free( orig_localename );
-			pthread_mutex_unlock( &self->mutex );
+			property_unlock( self );
 		}
 #endif
 
@@ -581,7 +725,7 @@ static double mlt_property_atof( mlt_property self, double fps, locale_t locale
 double mlt_property_get_double( mlt_property self, double fps, locale_t locale )
 {
 	double result = 0.0;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->types & mlt_prop_double )
 		result = self->prop_double;
 	else if ( self->types & mlt_prop_int )
@@ -599,7 +743,7 @@ double mlt_property_get_double( mlt_property self, double fps, locale_t locale )
 		if ( ( self->types & mlt_prop_string ) && self->prop_string )
 			result = mlt_property_atof( self, fps, locale );
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return result;
 }
 
@@ -616,7 +760,7 @@ double mlt_property_get_double( mlt_property self, double fps, locale_t locale )
 mlt_position mlt_property_get_position( mlt_property self, double fps, locale_t locale )
 {
 	mlt_position result = 0;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->types & mlt_prop_position )
 		result = self->prop_position;
 	else if ( self->types & mlt_prop_int )
@@ -634,7 +778,7 @@ mlt_position mlt_property_get_position( mlt_property self, double fps, locale_t
 		if ( ( self->types & mlt_prop_string ) && self->prop_string )
 			result = ( mlt_position )mlt_property_atoi( self, fps, locale );
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return result;
 }
 
@@ -666,7 +810,7 @@ static inline int64_t mlt_property_atoll( const char *value )
 int64_t mlt_property_get_int64( mlt_property self )
 {
 	int64_t result = 0;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->types & mlt_prop_int64 )
 		result = self->prop_int64;
 	else if ( self->types & mlt_prop_int )
@@ -684,7 +828,7 @@ int64_t mlt_property_get_int64( mlt_property self )
 		if ( ( self->types & mlt_prop_string ) && self->prop_string )
 			result = mlt_property_atoll( self->prop_string );
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return result;
 }
 
@@ -703,7 +847,7 @@ int64_t mlt_property_get_int64( mlt_property self )
 char *mlt_property_get_string_tf( mlt_property self, mlt_time_format time_format )
 {
 	// Construct a string if need be
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->animation && self->serialiser )
 	{
 		if ( self->prop_string )
@@ -742,7 +886,7 @@ char *mlt_property_get_string_tf( mlt_property self, mlt_time_format time_format
 			self->prop_string = self->serialiser( self->data, self->length );
 		}
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 
 	// Return the string (may be NULL)
 	return self->prop_string;
@@ -790,7 +934,7 @@ char *mlt_property_get_string_l_tf( mlt_property self, locale_t locale, mlt_time
 		return mlt_property_get_string_tf( self, time_format );
 
 	// Construct a string if need be
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->animation && self->serialiser )
 	{
 		if ( self->prop_string )
@@ -851,7 +995,7 @@ char *mlt_property_get_string_l_tf( mlt_property self, locale_t locale, mlt_time
 		free( orig_localename );
 #endif
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 
 	// Return the string (may be NULL)
 	return self->prop_string;
@@ -895,9 +1039,9 @@ void *mlt_property_get_data( mlt_property self, int *length )
 		*length = self->length;
 
 	// Return the data (note: there is no conversion here)
-	pthread_mutex_lock( &self->mutex );
-	void* result = self->data;
-	pthread_mutex_unlock( &self->mutex );	
+	property_lock( self );
+	void* result = ( self->types & mlt_prop_data ) ? self->data : NULL;
+	property_unlock( self );
 	return result;
 }
 
@@ -910,7 +1054,6 @@ void *mlt_property_get_data( mlt_property self, int *length )
 void mlt_property_close( mlt_property self )
 {
 	clear_property( self );
-	pthread_mutex_destroy( &self->mutex );
 	free( self );
 }
 
@@ -925,7 +1068,7 @@ void mlt_property_close( mlt_property self )
  */
 void mlt_property_pass( mlt_property self, mlt_property that )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
 
 	self->types = that->types;
@@ -963,7 +1106,7 @@ void mlt_property_pass( mlt_property self, mlt_property that )
 		self->types = mlt_prop_string;
 		self->prop_string = that->serialiser( that->data, that->length );
 	}
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 }
 
 /** Convert frame count to a SMPTE timecode string.
@@ -1086,7 +1229,7 @@ char *mlt_property_get_time( mlt_property self, mlt_time_format format, double f
 #endif // _WIN32
 
 		// Protect damaging the global locale from a temporary locale on another thread.
-		pthread_mutex_lock( &self->mutex );
+		property_lock( self );
 
 		// Get the current locale
 		orig_localename = strdup( setlocale( LC_NUMERIC, NULL ) );
@@ -1098,7 +1241,7 @@ char *mlt_property_get_time( mlt_property self, mlt_time_format format, double f
 #endif // _WIN32
 	{
 		// Make sure we have a lock before accessing self->types
-		pthread_mutex_lock( &self->mutex );
+		property_lock( self );
 	}
 
 	// Convert number to string
@@ -1135,13 +1278,13 @@ char *mlt_property_get_time( mlt_property self, mlt_time_format format, double f
 	{
 		setlocale( LC_NUMERIC, orig_localename );
 		free( orig_localename );
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 	}
 	else
 #endif // _WIN32
 	{
 		// Make sure we have a lock before accessing self->types
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 	}
 
 	// Return the string (may be NULL)
@@ -1177,7 +1320,7 @@ static int is_property_numeric( mlt_property self, locale_t locale )
 		char *orig_localename = NULL;
 		if ( locale ) {
 			// Protect damaging the global locale from a temporary locale on another thread.
-			pthread_mutex_lock( &self->mutex );
+			property_lock( self );
 
 			// Get the current locale
 			orig_localename = strdup( setlocale( LC_NUMERIC, NULL ) );
@@ -1194,7 +1337,7 @@ static int is_property_numeric( mlt_property self, locale_t locale )
 			// Restore the current locale
 			setlocale( LC_NUMERIC, orig_localename );
 			free( orig_localename );
-			pthread_mutex_unlock( &self->mutex );
+			property_unlock( self );
 		}
 #endif
 
@@ -1377,7 +1520,7 @@ static void refresh_animation( mlt_property self, double fps, locale_t locale, i
 double mlt_property_anim_get_double( mlt_property self, double fps, locale_t locale, int position, int length )
 {
 	double result;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->animation || ( self->prop_string && strchr( self->prop_string, '=' ) ) )
 	{
 		struct mlt_animation_item_s item;
@@ -1385,14 +1528,14 @@ double mlt_property_anim_get_double( mlt_property self, double fps, locale_t loc
 
 		refresh_animation( self, fps, locale, length );
 		mlt_animation_get_item( self->animation, &item, position );
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_double( item.property, fps, locale );
 
 		mlt_property_close( item.property );
 	}
 	else
 	{
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_double( self, fps, locale );
 	}
 	return result;
@@ -1413,7 +1556,7 @@ double mlt_property_anim_get_double( mlt_property self, double fps, locale_t loc
 int mlt_property_anim_get_int( mlt_property self, double fps, locale_t locale, int position, int length )
 {
 	int result;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->animation || ( self->prop_string && strchr( self->prop_string, '=' ) ) )
 	{
 		struct mlt_animation_item_s item;
@@ -1421,14 +1564,14 @@ int mlt_property_anim_get_int( mlt_property self, double fps, locale_t locale, i
 
 		refresh_animation( self, fps, locale, length );
 		mlt_animation_get_item( self->animation, &item, position );
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_int( item.property, fps, locale );
 
 		mlt_property_close( item.property );
 	}
 	else
 	{
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_int( self, fps, locale );
 	}
 	return result;
@@ -1449,7 +1592,7 @@ int mlt_property_anim_get_int( mlt_property self, double fps, locale_t locale, i
 char* mlt_property_anim_get_string( mlt_property self, double fps, locale_t locale, int position, int length )
 {
 	char *result;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->animation || ( self->prop_string && strchr( self->prop_string, '=' ) ) )
 	{
 		struct mlt_animation_item_s item;
@@ -1461,9 +1604,9 @@ char* mlt_property_anim_get_string( mlt_property self, double fps, locale_t loca
 
 		free( self->prop_string );
 
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		self->prop_string = mlt_property_get_string_l( item.property, locale );
-		pthread_mutex_lock( &self->mutex );
+		property_lock( self );
 
 		if ( self->prop_string )
 			self->prop_string = strdup( self->prop_string );
@@ -1471,11 +1614,11 @@ char* mlt_property_anim_get_string( mlt_property self, double fps, locale_t loca
 
 		result = self->prop_string;
 		mlt_property_close( item.property );
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 	}
 	else
 	{
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_string_l( self, locale );
 	}
 	return result;
@@ -1506,11 +1649,11 @@ int mlt_property_anim_set_double( mlt_property self, double value, double fps, l
 	item.keyframe_type = keyframe_type;
 	mlt_property_set_double( item.property, value );
 
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	refresh_animation( self, fps, locale, length );
 	result = mlt_animation_insert( self->animation, &item );
 	mlt_animation_interpolate( self->animation );
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	mlt_property_close( item.property );
 
 	return result;
@@ -1541,11 +1684,11 @@ int mlt_property_anim_set_int( mlt_property self, int value, double fps, locale_
 	item.keyframe_type = keyframe_type;
 	mlt_property_set_int( item.property, value );
 
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	refresh_animation( self, fps, locale, length );
 	result = mlt_animation_insert( self->animation, &item );
 	mlt_animation_interpolate( self->animation );
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	mlt_property_close( item.property );
 
 	return result;
@@ -1577,11 +1720,11 @@ int mlt_property_anim_set_string( mlt_property self, const char *value, double f
 	item.keyframe_type = mlt_keyframe_discrete;
 	mlt_property_set_string( item.property, value );
 
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	refresh_animation( self, fps, locale, length );
 	result = mlt_animation_insert( self->animation, &item );
 	mlt_animation_interpolate( self->animation );
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	mlt_property_close( item.property );
 
 	return result;
@@ -1598,9 +1741,9 @@ int mlt_property_anim_set_string( mlt_property self, const char *value, double f
 
 mlt_animation mlt_property_get_animation( mlt_property self )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	mlt_animation result = self->animation;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return result;
 }
 
@@ -1641,7 +1784,7 @@ static char* serialise_mlt_rect( mlt_rect *rect, int length )
 
 int mlt_property_set_rect( mlt_property self, mlt_rect value )
 {
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	clear_property( self );
 	self->types = mlt_prop_rect | mlt_prop_data;
 	self->length = sizeof(value);
@@ -1649,7 +1792,7 @@ int mlt_property_set_rect( mlt_property self, mlt_rect value )
 	memcpy( self->data, &value, self->length );
 	self->destructor = free;
 	self->serialiser = (mlt_serialiser) serialise_mlt_rect;
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	return 0;
 }
 
@@ -1687,7 +1830,7 @@ mlt_rect mlt_property_get_rect( mlt_property self, locale_t locale )
 		char *orig_localename = NULL;
 		if ( locale ) {
 			// Protect damaging the global locale from a temporary locale on another thread.
-			pthread_mutex_lock( &self->mutex );
+			property_lock( self );
 
 			// Get the current locale
 			orig_localename = strdup( setlocale( LC_NUMERIC, NULL ) );
@@ -1740,7 +1883,7 @@ mlt_rect mlt_property_get_rect( mlt_property self, locale_t locale )
 			// Restore the current locale
 			setlocale( LC_NUMERIC, orig_localename );
 			free( orig_localename );
-			pthread_mutex_unlock( &self->mutex );
+			property_unlock( self );
 		}
 #endif
     }
@@ -1772,11 +1915,11 @@ int mlt_property_anim_set_rect( mlt_property self, mlt_rect value, double fps, l
 	item.keyframe_type = keyframe_type;
 	mlt_property_set_rect( item.property, value );
 
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	refresh_animation( self, fps, locale, length );
 	result = mlt_animation_insert( self->animation, &item );
 	mlt_animation_interpolate( self->animation );
-	pthread_mutex_unlock( &self->mutex );
+	property_unlock( self );
 	mlt_property_close( item.property );
 
 	return result;
@@ -1797,7 +1940,7 @@ int mlt_property_anim_set_rect( mlt_property self, mlt_rect value, double fps, l
 mlt_rect mlt_property_anim_get_rect( mlt_property self, double fps, locale_t locale, int position, int length )
 {
 	mlt_rect result;
-	pthread_mutex_lock( &self->mutex );
+	property_lock( self );
 	if ( self->animation || ( self->prop_string && strchr( self->prop_string, '=' ) ) )
 	{
 		struct mlt_animation_item_s item;
@@ -1806,14 +1949,14 @@ mlt_rect mlt_property_anim_get_rect( mlt_property self, double fps, locale_t loc
 
 		refresh_animation( self, fps, locale, length );
 		mlt_animation_get_item( self->animation, &item, position );
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_rect( item.property, locale );
 
 		mlt_property_close( item.property );
 	}
 	else
 	{
-		pthread_mutex_unlock( &self->mutex );
+		property_unlock( self );
 		result = mlt_property_get_rect( self, locale );
 	}
 	return result;
@@ -28,11 +28,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <dlfcn.h>
 #include <string.h>
 #include <limits.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 /** \brief Repository class
  *
@@ -50,10 +52,236 @@ struct mlt_repository_s
 	mlt_properties links;           /// a list of entry points for links
 	mlt_properties producers;       /// a list of entry points for producers
 	mlt_properties transitions;     /// a list of entry points for transitions
+	const char *loading;            /// the object file whose services are being registered
+	int lazy;                       /// whether services were registered from a cached manifest
+	pthread_mutex_t mutex;          /// serialises loading object files on demand
 };
 
+/** The first line of a manifest, which changes whenever its format does */
+#define MANIFEST_VERSION "MLT repository manifest 1"
+
+static mlt_properties get_service_list( mlt_repository self, mlt_service_type type );
+
+/** Load an object file and register its services.
+ *
+ * \private \memberof mlt_repository_s
+ * \param self a repository
+ * \param object_name the full path of the object file
+ * \return true if the object file is a module
+ */
+
+static int load_object( mlt_repository self, const char *object_name )
+{
+	int result = 0;
+
+	// Open the shared object
+	void *object = dlopen( object_name, RTLD_NOW );
+	if ( object != NULL )
+	{
+		// Get the registration function
+		mlt_repository_callback symbol_ptr = dlsym( object, "mlt_register" );
+
+		// Call the registration function
+		if ( symbol_ptr != NULL )
+		{
+			self->loading = object_name;
+			symbol_ptr( self );
+			self->loading = NULL;
+
+			// Register the object file for closure
+			mlt_properties_set_data( &self->parent, object_name, object, 0, ( mlt_destructor )dlclose, NULL );
+			result = 1;
+		}
+		else
+		{
+			dlclose( object );
+		}
+	}
+	else if ( strstr( object_name, "libmlt" ) )
+	{
+		mlt_log_warning( NULL, "%s: failed to dlopen %s\n  (%s)\n", __FUNCTION__, object_name, dlerror() );
+	}
+	return result;
+}
+
+/** Load the object file for a service that was registered from the manifest.
+ *
+ * \private \memberof mlt_repository_s
+ * \param self a repository
+ * \param properties the repository properties of a service
+ */
+
+static void load_service_object( mlt_repository self, mlt_properties properties )
+{
+	const char *object_name = mlt_properties_get( properties, "object" );
+	if ( object_name && !mlt_properties_get_data( properties, "symbol", NULL ) )
+	{
+		pthread_mutex_lock( &self->mutex );
+		if ( !mlt_properties_get_data( &self->parent, object_name, NULL ) )
+		{
+			mlt_log_debug( NULL, "%s: %s\n", __FUNCTION__, object_name );
+			load_object( self, object_name );
+		}
+		pthread_mutex_unlock( &self->mutex );
+	}
+}
+
+/** Get the file names in the module directory along with their size and time.
+ *
+ * \private \memberof mlt_repository_s
+ * \param directory the module directory
+ * \return a list of file names whose values are "<mtime> <size>"
+ */
+
+static mlt_properties stat_objects( const char *directory )
+{
+	mlt_properties dir = mlt_properties_new();
+	mlt_properties result = mlt_properties_new();
+	int count = mlt_properties_dir_list( dir, directory, NULL, 0 );
+	for ( int i = 0; i < count; i++ )
+	{
+		const char *object_name = mlt_properties_get_value( dir, i );
+		struct stat info;
+		if ( !stat( object_name, &info ) && S_ISREG( info.st_mode ) )
+		{
+			char value[ 64 ];
+			snprintf( value, sizeof( value ), "%lld %lld", ( long long )info.st_mtime, ( long long )info.st_size );
+			mlt_properties_set( result, object_name, value );
+		}
+	}
+	mlt_properties_close( dir );
+	return result;
+}
+
+/** Register the services listed in a manifest without loading their modules.
+ *
+ * The manifest is only used if it lists exactly the files in the module
+ * directory with their current size and modification time.
+ * \private \memberof mlt_repository_s
+ * \param self a repository
+ * \param objects the files in the module directory from stat_objects()
+ * \param filename the manifest file
+ * \return true if the manifest was used
+ */
+
+static int read_manifest( mlt_repository self, mlt_properties objects, const char *filename )
+{
+	FILE *file = mlt_fopen( filename, "r" );
+	if ( file == NULL )
+		return 0;
+
+	mlt_properties services = mlt_properties_new();
+	char line[ PATH_MAX + 128 ];
+	char object_name[ PATH_MAX ] = "";
+	int objects_count = 0;
+	int valid = fgets( line, sizeof( line ), file ) && !strncmp( line, MANIFEST_VERSION, strlen( MANIFEST_VERSION ) );
+
+	// Check the objects and collect the services
+	while ( valid && fgets( line, sizeof( line ), file ) )
+	{
+		line[ strcspn( line, "\r\n" ) ] = '\0';
+		if ( line[0] == 'M' && line[1] == ' ' )
+		{
+			long long mtime, size;
+			int offset = 0;
+			char value[ 64 ];
+			valid = sscanf( line + 2, "%lld %lld %n", &mtime, &size, &offset ) == 2 && offset > 0;
+			if ( valid )
+			{
+				snprintf( object_name, sizeof( object_name ), "%s", line + 2 + offset );
+				snprintf( value, sizeof( value ), "%lld %lld", mtime, size );
+				valid = mlt_properties_get( objects, object_name ) && !strcmp( mlt_properties_get( objects, object_name ), value );
+				objects_count ++;
+			}
+		}
+		else if ( line[0] == 'S' && line[1] == ' ' && object_name[0] )
+		{
+			char key[ 32 ];
+			snprintf( key, sizeof( key ), "%d", mlt_properties_count( services ) );
+			mlt_properties entry = mlt_properties_new();
+			mlt_properties_set( entry, "service", line + 2 );
+			mlt_properties_set( entry, "object", object_name );
+			mlt_properties_set_data( services, key, entry, 0, ( mlt_destructor )mlt_properties_close, NULL );
+		}
+		else
+		{
+			valid = 0;
+		}
+	}
+	fclose( file );
+	valid = valid && objects_count == mlt_properties_count( objects );
+
+	// Register the services
+	for ( int i = 0; valid && i < mlt_properties_count( services ); i++ )
+	{
+		mlt_properties entry = mlt_properties_get_data_at( services, i, NULL );
+		char *service = mlt_properties_get( entry, "service" );
+		char *id = strchr( service, ' ' );
+		if ( id )
+		{
+			*id++ = '\0';
+			self->loading = mlt_properties_get( entry, "object" );
+			mlt_repository_register( self, atoi( service ), id, NULL );
+			self->loading = NULL;
+		}
+	}
+	mlt_properties_close( services );
+	return valid;
+}
+
+/** Save the services registered from each module.
+ *
+ * \private \memberof mlt_repository_s
+ * \param self a repository
+ * \param objects the files in the module directory from stat_objects()
+ * \param filename the manifest file
+ */
+
+static void write_manifest( mlt_repository self, mlt_properties objects, const char *filename )
+{
+	static const mlt_service_type types[] = { mlt_service_consumer_type, mlt_service_filter_type,
+		mlt_service_link_type, mlt_service_producer_type, mlt_service_transition_type };
+	char *temp = calloc( 1, strlen( filename ) + 16 );
+	sprintf( temp, "%s.%d.tmp", filename, ( int )getpid() );
+	FILE *file = mlt_fopen( temp, "w" );
+	if ( file == NULL )
+	{
+		mlt_log_warning( NULL, "%s: failed to write %s\n", __FUNCTION__, filename );
+		free( temp );
+		return;
+	}
+
+	fprintf( file, "%s\n", MANIFEST_VERSION );
+	for ( int i = 0; i < mlt_properties_count( objects ); i++ )
+	{
+		const char *object_name = mlt_properties_get_name( objects, i );
+		fprintf( file, "M %s %s\n", mlt_properties_get_value( objects, i ), object_name );
+		for ( int t = 0; t < sizeof( types ) / sizeof( types[0] ); t++ )
+		{
+			mlt_properties list = get_service_list( self, types[t] );
+			for ( int j = 0; j < mlt_properties_count( list ); j++ )
+			{
+				mlt_properties properties = mlt_properties_get_data_at( list, j, NULL );
+				const char *object = mlt_properties_get( properties, "object" );
+				if ( object && !strcmp( object, object_name ) )
+					fprintf( file, "S %d %s\n", types[t], mlt_properties_get_name( list, j ) );
+			}
+		}
+	}
+	if ( fclose( file ) || rename( temp, filename ) )
+		remove( temp );
+	free( temp );
+}
+
 /** Construct a new repository.
  *
+ * If the environment variable MLT_REPOSITORY_CACHE names a file, the services
+ * registered by each module are saved to it after the modules are loaded.
+ * Later, if the modules in \p directory have not changed, the services are
+ * registered from that file and each module is only loaded when one of its
+ * services is first created or its metadata is requested. Delete the file
+ * when something other than the modules changes what they register, for
+ * example the plugins found by the frei0r, ladspa or avfilter modules.
  * \public \memberof mlt_repository_s
  * \param directory the full path of a directory from which to read modules
  * \return a new repository or NULL if failed
@@ -74,11 +302,15 @@ mlt_repository mlt_repository_init( const char *directory )
 	self->producers = mlt_properties_new();
 	self->transitions = mlt_properties_new();
 
+	pthread_mutex_init( &self->mutex, NULL );
+
 	// Get the directory list
 	mlt_properties dir = mlt_properties_new();
 	int count = mlt_properties_dir_list( dir, directory, NULL, 0 );
 	int i;
 	int plugin_count = 0;
+	const char *manifest = getenv( "MLT_REPOSITORY_CACHE" );
+	mlt_properties objects = NULL;
 
 #ifdef _WIN32
 	char *syspath = getenv("PATH");
@@ -98,42 +330,25 @@ mlt_repository mlt_repository_init( const char *directory )
 	free(newpath);
 #endif
 
-	// Iterate over files
-	for ( i = 0; i < count; i++ )
+	// Register services from the manifest, loading modules only when used
+	if ( manifest && manifest[0] )
 	{
-		int flags = RTLD_NOW;
-		const char *object_name = mlt_properties_get_value( dir, i);
-
-		// Open the shared object
-		void *object = dlopen( object_name, flags );
-		if ( object != NULL )
-		{
-			// Get the registration function
-			mlt_repository_callback symbol_ptr = dlsym( object, "mlt_register" );
-
-			// Call the registration function
-			if ( symbol_ptr != NULL )
-			{
-				symbol_ptr( self );
-
-				// Register the object file for closure
-				mlt_properties_set_data( &self->parent, object_name, object, 0, ( mlt_destructor )dlclose, NULL );
-				++plugin_count;
-			}
-			else
-			{
-				dlclose( object );
-			}
-		}
-		else if ( strstr( object_name, "libmlt" ) )
-		{
-			mlt_log_warning( NULL, "%s: failed to dlopen %s\n  (%s)\n", __FUNCTION__, object_name, dlerror() );
-		}
+		objects = stat_objects( directory );
+		self->lazy = read_manifest( self, objects, manifest );
+		if ( self->lazy )
+			plugin_count = mlt_properties_count( objects );
 	}
 
+	// Iterate over files
+	for ( i = 0; !self->lazy && i < count; i++ )
+		plugin_count += load_object( self, mlt_properties_get_value( dir, i ) );
+
 	if ( !plugin_count )
 		mlt_log_error( NULL, "%s: no plugins found in \"%s\"\n", __FUNCTION__, directory );
+	else if ( objects && !self->lazy )
+		write_manifest( self, objects, manifest );
 
+	mlt_properties_close( objects );
 	mlt_properties_close( dir );
 
 	return self;
@@ -166,27 +381,64 @@ static mlt_properties new_service( void *symbol )
 
 void mlt_repository_register( mlt_repository self, mlt_service_type service_type, const char *service, mlt_register_callback symbol )
 {
+	mlt_properties list = get_service_list( self, service_type );
+
+	if ( list == NULL )
+	{
+		mlt_log_error( NULL, "%s: Unable to register \"%s\"\n", __FUNCTION__, service );
+		return;
+	}
+
 	// Add the entry point to the corresponding service list
-	switch ( service_type )
+	if ( self->lazy && self->loading && symbol )
+	{
+		// A module is loading on demand: keep the entries of the manifest,
+		// which records the module that registered each service last.
+		mlt_properties properties = mlt_properties_get_data( list, service, NULL );
+		if ( properties )
+		{
+			const char *object_name = mlt_properties_get( properties, "object" );
+			if ( object_name && !strcmp( object_name, self->loading ) )
+				mlt_properties_set_data( properties, "symbol", symbol, 0, NULL, NULL );
+			return;
+		}
+	}
+
+	mlt_properties properties = new_service( symbol );
+	if ( self->loading )
+	{
+		mlt_properties_set( properties, "object", self->loading );
+		// Create these ahead of time so that loading the module only updates them
+		mlt_properties_set_data( properties, "metadata_cb", NULL, 0, NULL, NULL );
+		mlt_properties_set_data( properties, "metadata_cb_data", NULL, 0, NULL, NULL );
+	}
+	mlt_properties_set_data( list, service, properties, 0, ( mlt_destructor )mlt_properties_close, NULL );
+}
+
+/** Get the list of entry points for a service class.
+ *
+ * \private \memberof mlt_repository_s
+ * \param self a repository
+ * \param type a service class
+ * \return a properties list or NULL if error
+ */
+
+static mlt_properties get_service_list( mlt_repository self, mlt_service_type type )
+{
+	switch ( type )
 	{
 		case mlt_service_consumer_type:
-			mlt_properties_set_data( self->consumers, service, new_service( symbol ), 0, ( mlt_destructor )mlt_properties_close, NULL );
-			break;
+			return self->consumers;
 		case mlt_service_filter_type:
-			mlt_properties_set_data( self->filters, service, new_service( symbol ), 0, ( mlt_destructor )mlt_properties_close, NULL );
-			break;
+			return self->filters;
 		case mlt_service_link_type:
-			mlt_properties_set_data( self->links, service, new_service( symbol ), 0, ( mlt_destructor )mlt_properties_close, NULL );
-			break;
+			return self->links;
 		case mlt_service_producer_type:
-			mlt_properties_set_data( self->producers, service, new_service( symbol ), 0, ( mlt_destructor )mlt_properties_close, NULL );
-			break;
+			return self->producers;
 		case mlt_service_transition_type:
-			mlt_properties_set_data( self->transitions, service, new_service( symbol ), 0, ( mlt_destructor )mlt_properties_close, NULL );
-			break;
+			return self->transitions;
 		default:
-			mlt_log_error( NULL, "%s: Unable to register \"%s\"\n", __FUNCTION__, service );
-			break;
+			return NULL;
 	}
 }
 
@@ -201,30 +453,9 @@ void mlt_repository_register( mlt_repository self, mlt_service_type service_type
 
 static mlt_properties get_service_properties( mlt_repository self, mlt_service_type type, const char *service )
 {
-	mlt_properties service_properties = NULL;
-
 	// Get the entry point from the corresponding service list
-	switch ( type )
-	{
-		case mlt_service_consumer_type:
-			service_properties = mlt_properties_get_data( self->consumers, service, NULL );
-			break;
-		case mlt_service_filter_type:
-			service_properties = mlt_properties_get_data( self->filters, service, NULL );
-			break;
-		case mlt_service_link_type:
-			service_properties = mlt_properties_get_data( self->links, service, NULL );
-			break;
-		case mlt_service_producer_type:
-			service_properties = mlt_properties_get_data( self->producers, service, NULL );
-			break;
-		case mlt_service_transition_type:
-			service_properties = mlt_properties_get_data( self->transitions, service, NULL );
-			break;
-		default:
-			break;
-	}
-	return service_properties;
+	mlt_properties list = get_service_list( self, type );
+	return list ? mlt_properties_get_data( list, service, NULL ) : NULL;
 }
 
 /** Construct a new instance of a service.
@@ -242,6 +473,9 @@ void *mlt_repository_create( mlt_repository self, mlt_profile profile, mlt_servi
 	mlt_properties properties = get_service_properties( self, type, service );
 	if ( properties != NULL )
 	{
+		if ( self->lazy )
+			load_service_object( self, properties );
+
 		mlt_register_callback symbol_ptr = mlt_properties_get_data( properties, "symbol", NULL );
 
 		// Construct the service
@@ -263,6 +497,7 @@ void mlt_repository_close( mlt_repository self )
 	mlt_properties_close( self->producers );
 	mlt_properties_close( self->transitions );
 	mlt_properties_close( &self->parent );
+	pthread_mutex_destroy( &self->mutex );
 	free( self );
 }
 
@@ -342,6 +577,13 @@ mlt_properties mlt_repository_transitions( mlt_repository self )
 void mlt_repository_register_metadata( mlt_repository self, mlt_service_type type, const char *service, mlt_metadata_callback callback, void *callback_data )
 {
 	mlt_properties service_properties = get_service_properties( self, type, service );
+	if ( self->lazy && self->loading && service_properties )
+	{
+		// Do not replace the metadata of a service registered by another module
+		const char *object_name = mlt_properties_get( service_properties, "object" );
+		if ( object_name && strcmp( object_name, self->loading ) )
+			return;
+	}
 	mlt_properties_set_data( service_properties, "metadata_cb", callback, 0, NULL, NULL );
 	mlt_properties_set_data( service_properties, "metadata_cb_data", callback_data, 0, NULL, NULL );
 }
@@ -369,6 +611,9 @@ mlt_properties mlt_repository_metadata( mlt_repository self, mlt_service_type ty
 		metadata = mlt_properties_get_data( properties, "metadata", NULL );
 		if ( ! metadata )
 		{
+			if ( self->lazy )
+				load_service_object( self, properties );
+
 			// Not cached, so get the registered metadata callback function
 			mlt_metadata_callback callback = mlt_properties_get_data( properties, "metadata_cb", NULL );
 
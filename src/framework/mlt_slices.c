@@ -45,6 +45,7 @@ mlt_schedule_policy;
 
 static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
 static mlt_slices globals[mlt_policy_nb] = {NULL, NULL, NULL};
+static mlt_slices tasks = NULL;
 
 
 struct mlt_slices_runtime_s
@@ -260,15 +261,44 @@ static void mlt_slices_close( mlt_slices ctx )
 	free ( ctx );
 }
 
+/** Remove a runtime from the job list of a context.
+ *
+ * The context mutex must be held.
+ *
+ * \private \memberof mlt_slices_s
+ * \param ctx context pointer
+ * \param r the runtime to remove
+ */
+
+static void mlt_slices_detach( mlt_slices ctx, struct mlt_slices_runtime_s* r )
+{
+	struct mlt_slices_runtime_s *prev = NULL, *curr = ctx->head;
+
+	while ( curr && curr != r )
+	{
+		prev = curr;
+		curr = curr->next;
+	}
+	if ( !curr )
+		return;
+	if ( prev )
+		prev->next = r->next;
+	else
+		ctx->head = r->next;
+	if ( ctx->tail == r )
+		ctx->tail = prev;
+}
+
 /** Run sliced execution
  *
  * \private \memberof mlt_slices_s
  * \param ctx context pointer
  * \param jobs number of jobs to process
  * \param proc number of jobs to process
+ * \param help whether the calling thread also processes jobs
  */
 
-static void mlt_slices_run( mlt_slices ctx, int jobs, mlt_slices_proc proc, void* cookie )
+static void mlt_slices_run( mlt_slices ctx, int jobs, mlt_slices_proc proc, void* cookie, int help )
 {
 	struct mlt_slices_runtime_s runtime, *r = &runtime;
 
@@ -303,6 +333,16 @@ static void mlt_slices_run( mlt_slices ctx, int jobs, mlt_slices_proc proc, void
 	/* notify workers */
 	pthread_cond_broadcast( &ctx->cond_var_job );
 
+	/* process jobs not yet taken by the workers */
+	while ( help && r->curr < r->jobs )
+	{
+		int idx = r->curr++;
+		pthread_mutex_unlock( &ctx->cond_mutex );
+		r->proc( ctx->count, idx, r->jobs, r->cookie );
+		pthread_mutex_lock( &ctx->cond_mutex );
+		r->done++;
+	}
+
 	/* wait for end of task */
 	while( !ctx->f_exit && ( r->done < r->jobs ) )
 	{
@@ -310,6 +350,10 @@ static void mlt_slices_run( mlt_slices ctx, int jobs, mlt_slices_proc proc, void
 		mlt_log_debug( NULL, "%s:%d: ctx=[%p][%s] signalled\n", __FUNCTION__, __LINE__ , ctx, ctx->name );
 	}
 
+	/* a worker may not have come back to remove it */
+	if ( help )
+		mlt_slices_detach( ctx, r );
+
 	pthread_mutex_unlock( &ctx->cond_mutex);
 }
 
@@ -394,17 +438,69 @@ int mlt_slices_count_fifo()
 void mlt_slices_run_normal(int jobs, mlt_slices_proc proc, void *cookie)
 {
 	return mlt_slices_run( mlt_slices_get_global( mlt_policy_normal ),
-	   jobs, proc, cookie );
+	   jobs, proc, cookie, 0 );
 }
 
 void mlt_slices_run_rr(int jobs, mlt_slices_proc proc, void *cookie)
 {
 	return mlt_slices_run( mlt_slices_get_global( mlt_policy_rr ),
-	   jobs, proc, cookie );
+	   jobs, proc, cookie, 0 );
 }
 
 void mlt_slices_run_fifo(int jobs, mlt_slices_proc proc, void *cookie)
 {
 	return mlt_slices_run( mlt_slices_get_global( mlt_policy_fifo ),
-	   jobs, proc, cookie );
+	   jobs, proc, cookie, 0 );
+}
+
+/** Get the shared context used to run tasks.
+ *
+ * \private \memberof mlt_slices_s
+ * \return the context pointer
+ */
+
+static mlt_slices mlt_slices_get_tasks()
+{
+	pthread_mutex_lock( &g_lock );
+	if ( !tasks )
+	{
+		tasks = mlt_slices_init( 0, SCHED_OTHER, -1 );
+		mlt_factory_register_for_clean_up( tasks, (mlt_destructor) mlt_slices_close );
+	}
+	pthread_mutex_unlock( &g_lock );
+
+	return tasks;
+}
+
+/** Get the number of threads that run tasks, not including the caller.
+ *
+ * \public \memberof mlt_slices_s
+ * \return the number of task threads
+ */
+
+int mlt_slices_count_tasks()
+{
+	mlt_slices slices = mlt_slices_get_tasks();
+	if (slices)
+		return slices->count;
+	else
+		return 0;
+}
+
+/** Run coarse-grained tasks in parallel.
+ *
+ * Unlike the slice functions, tasks run on a separate set of threads, and
+ * the calling thread also takes jobs until none are left. So, a task may
+ * itself use slices or run tasks without risking a deadlock. The \p id passed
+ * to \p proc is mlt_slices_count_tasks() when run by the calling thread.
+ *
+ * \public \memberof mlt_slices_s
+ * \param jobs the number of jobs to process
+ * \param proc the function to run for each job
+ * \param cookie an opaque pointer passed to \p proc
+ */
+
+void mlt_slices_run_tasks( int jobs, mlt_slices_proc proc, void *cookie )
+{
+	mlt_slices_run( mlt_slices_get_tasks(), jobs, proc, cookie, 1 );
 }
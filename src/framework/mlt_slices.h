@@ -46,4 +46,8 @@ extern void mlt_slices_run_rr( int jobs, mlt_slices_proc proc, void* cookie );
 
 extern void mlt_slices_run_fifo( int jobs, mlt_slices_proc proc, void* cookie );
 
+extern int mlt_slices_count_tasks();
+
+extern void mlt_slices_run_tasks( int jobs, mlt_slices_proc proc, void* cookie );
+
 #endif
@@ -26,6 +26,7 @@
 #include "mlt_field.h"
 #include "mlt_log.h"
 #include "mlt_transition.h"
+#include "mlt_slices.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -351,6 +352,81 @@ mlt_producer mlt_tractor_get_track( mlt_tractor self, int index )
 	return mlt_multitrack_track( mlt_tractor_multitrack( self ), index );
 }
 
+/** The track frames to render concurrently for one tractor frame.
+ */
+
+typedef struct
+{
+	int count;
+	int width;
+	int height;
+	int frequency;
+	int channels;
+	int samples;
+	mlt_frame frames[];
+}
+parallel_tracks;
+
+static int render_image_task( int id, int index, int count, void *cookie )
+{
+	parallel_tracks *tracks = cookie;
+	uint8_t *image = NULL;
+	mlt_image_format format = mlt_properties_get_int( MLT_FRAME_PROPERTIES( tracks->frames[ index ] ), "_parallel_image_format" );
+	int width = tracks->width;
+	int height = tracks->height;
+	mlt_frame_get_image( tracks->frames[ index ], &image, &format, &width, &height, 0 );
+	return 0;
+}
+
+static int render_audio_task( int id, int index, int count, void *cookie )
+{
+	parallel_tracks *tracks = cookie;
+	void *audio = NULL;
+	mlt_audio_format format = mlt_properties_get_int( MLT_FRAME_PROPERTIES( tracks->frames[ index ] ), "_parallel_audio_format" );
+	int frequency = tracks->frequency;
+	int channels = tracks->channels;
+	int samples = tracks->samples;
+	mlt_frame_get_audio( tracks->frames[ index ], &audio, &format, &frequency, &channels, &samples );
+	return 0;
+}
+
+/** Collect the track frames that only feed a transition whose output is \p output.
+ *
+ * Such a frame is not read by anything else until the transition runs, and
+ * the transition has declared that it requests the frame in a fixed format,
+ * at the size or sample count the tractor output was requested. So, they can
+ * all be rendered concurrently before the compositing starts.
+ *
+ * \private \memberof mlt_tractor_s
+ * \param frame_properties the properties of the tractor's output frame
+ * \param name the name of the property in which to store the list
+ * \param frames all of the track frames
+ * \param count the number of track frames
+ * \param output the track frame the tractor pulls image or audio from
+ * \param type 1 for image, 2 for audio
+ */
+
+static void collect_parallel_tracks( mlt_properties frame_properties, const char *name, mlt_frame *frames, int count, mlt_frame output, int type )
+{
+	parallel_tracks *tracks = calloc( 1, sizeof( parallel_tracks ) + count * sizeof( mlt_frame ) );
+	int i;
+
+	if ( !tracks )
+		return;
+	for ( i = 0; i < count; i++ )
+	{
+		mlt_properties properties = MLT_FRAME_PROPERTIES( frames[ i ] );
+		int blank = type == 1 ? mlt_frame_is_test_card( frames[ i ] ) : mlt_frame_is_test_audio( frames[ i ] );
+		if ( !blank && !( mlt_properties_get_int( properties, "_transition_a" ) & type ) &&
+			 mlt_properties_get_data( properties, type == 1 ? "_parallel_image_a" : "_parallel_audio_a", NULL ) == output )
+			tracks->frames[ tracks->count++ ] = frames[ i ];
+	}
+	if ( tracks->count > 1 )
+		mlt_properties_set_data( frame_properties, name, tracks, 0, free, NULL );
+	else
+		free( tracks );
+}
+
 static int producer_get_image( mlt_frame self, uint8_t **buffer, mlt_image_format *format, int *width, int *height, int writable )
 {
 	uint8_t *data = NULL;
@@ -363,11 +439,20 @@ static int producer_get_image( mlt_frame self, uint8_t **buffer, mlt_image_forma
 	mlt_properties_set_int( frame_properties, "distort", mlt_properties_get_int( properties, "distort" ) );
 	mlt_properties_set_int( frame_properties, "consumer_deinterlace", mlt_properties_get_int( properties, "consumer_deinterlace" ) );
 	mlt_properties_set( frame_properties, "deinterlace_method", mlt_properties_get( properties, "deinterlace_method" ) );
+	mlt_properties_set_int( frame_properties, "consumer_quality", mlt_properties_get_int( properties, "consumer_quality" ) );
 	mlt_properties_set_int( frame_properties, "consumer_tff", mlt_properties_get_int( properties, "consumer_tff" ) );
 	mlt_properties_set( frame_properties, "consumer_color_trc", mlt_properties_get( properties, "consumer_color_trc" ) );
 	// WebVfx uses this to setup a consumer-stopping event handler.
 	mlt_properties_set_data( frame_properties, "consumer", mlt_properties_get_data( properties, "consumer", NULL ), 0, NULL, NULL );
 
+	parallel_tracks *tracks = mlt_properties_get_data( properties, "_parallel_images", NULL );
+	if ( tracks )
+	{
+		tracks->width = *width;
+		tracks->height = *height;
+		mlt_slices_run_tasks( tracks->count, render_image_task, tracks );
+	}
+
 	mlt_frame_get_image( frame, buffer, format, width, height, writable );
 	mlt_frame_set_image( self, *buffer, 0, NULL );
 
@@ -417,6 +502,16 @@ static int producer_get_audio( mlt_frame self, void **buffer, mlt_audio_format *
 	mlt_properties frame_properties = MLT_FRAME_PROPERTIES( frame );
 	mlt_properties_set( frame_properties, "consumer_channel_layout", mlt_properties_get( properties, "consumer_channel_layout" ) );
 	mlt_properties_set( frame_properties, "producer_consumer_fps", mlt_properties_get( properties, "producer_consumer_fps" ) );
+
+	parallel_tracks *tracks = mlt_properties_get_data( properties, "_parallel_audio", NULL );
+	if ( tracks )
+	{
+		tracks->frequency = *frequency;
+		tracks->channels = *channels;
+		tracks->samples = *samples;
+		mlt_slices_run_tasks( tracks->count, render_audio_task, tracks );
+	}
+
 	mlt_frame_get_audio( frame, buffer, format, frequency, channels, samples );
 	mlt_frame_set_audio( self, *buffer, *format, mlt_audio_format_size( *format, *samples, *channels ), NULL );
 	mlt_properties_set_int( properties, "audio_frequency", *frequency );
@@ -580,6 +675,25 @@ static int producer_get_frame( mlt_producer parent, mlt_frame_ptr frame, int tra
 				mlt_properties_set_data( frame_properties, "_producer", mlt_frame_get_original_producer( first_video ), 0, NULL, NULL );
 			}
 
+			// Find the track frames that can be rendered concurrently
+			if ( mlt_properties_get_int( properties, "parallel_tracks" ) && count > 2 )
+			{
+				mlt_frame *frames = malloc( count * sizeof( mlt_frame ) );
+				if ( frames )
+				{
+					for ( i = 0; i < count; i++ )
+					{
+						snprintf( label, sizeof(label), "mlt_tractor %s_%d", id, i );
+						frames[ i ] = mlt_properties_get_data( frame_properties, label, NULL );
+					}
+					if ( video != NULL )
+						collect_parallel_tracks( frame_properties, "_parallel_images", frames, count, video, 1 );
+					if ( audio != NULL )
+						collect_parallel_tracks( frame_properties, "_parallel_audio", frames, count, audio, 2 );
+					free( frames );
+				}
+			}
+
 			mlt_frame_set_position( *frame, mlt_producer_frame( parent ) );
 			mlt_properties_set_int( MLT_FRAME_PROPERTIES( *frame ), "test_audio", audio == NULL );
 			mlt_properties_set_int( MLT_FRAME_PROPERTIES( *frame ), "test_image", video == NULL );
@@ -34,6 +34,8 @@
  * \properties \em multitrack holds a reference to the mulitrack object that a tractor manages
  * \properties \em field holds a reference to the field object that a tractor manages
  * \properties \em producer holds a reference to an encapsulated producer
+ * \properties \em parallel_tracks set to 1 to render the images and audio of tracks
+ * that are only consumed by a transition concurrently before compositing them
  */
 
 struct mlt_tractor_s
@@ -338,7 +338,10 @@ static int get_image_a( mlt_frame a_frame, uint8_t **image, mlt_image_format *fo
 	if ( mlt_frame_get_aspect_ratio( a_frame ) == 0.0 )
 		mlt_frame_set_aspect_ratio( a_frame, mlt_profile_sar( mlt_service_profile( MLT_TRANSITION_SERVICE(self) ) ) );
 
-	return mlt_frame_get_image( a_frame, image, format, width, height, writable );
+	// Only properties are changed here, so the facts about the image still hold
+	int error = mlt_frame_get_image( a_frame, image, format, width, height, writable );
+	mlt_frame_keep_image_facts( a_frame );
+	return error;
 }
 
 static int get_image_b( mlt_frame b_frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable )
@@ -362,9 +365,12 @@ static int get_image_b( mlt_frame b_frame, uint8_t **image, mlt_image_format *fo
 		mlt_frame_set_aspect_ratio( b_frame, mlt_profile_sar( mlt_service_profile( MLT_TRANSITION_SERVICE(self) ) ) );
 
 	mlt_properties_pass_list( b_props, a_props,
-		"consumer_deinterlace, deinterlace_method, consumer_tff, consumer_color_trc, consumer_channel_layout" );
+		"consumer_deinterlace, deinterlace_method, consumer_tff, consumer_color_trc, consumer_channel_layout, consumer_quality" );
 
-	return mlt_frame_get_image( b_frame, image, format, width, height, writable );
+	// Only properties are changed here, so the facts about the image still hold
+	int error = mlt_frame_get_image( b_frame, image, format, width, height, writable );
+	mlt_frame_keep_image_facts( b_frame );
+	return error;
 }
 
 /** Get a frame from a transition.
@@ -514,9 +520,24 @@ static int transition_get_frame( mlt_service service, mlt_frame_ptr frame, int i
 
 					// We need to ensure that the tractor doesn't consider this frame for output
 					if ( *frame == a_frame_ptr )
+					{
 						b_hide |= type;
+
+						// Let a tractor know whether it can render the b frame ahead of the transition
+						int b_format = mlt_properties_get_int( properties, "_parallel_b_format" );
+						if ( b_format && ( type == 1 || type == 2 ) )
+						{
+							mlt_properties b_props = MLT_FRAME_PROPERTIES( b_frame_ptr );
+							mlt_properties_set_data( b_props, type == 1 ? "_parallel_image_a" : "_parallel_audio_a", a_frame_ptr, 0, NULL, NULL );
+							mlt_properties_set_int( b_props, type == 1 ? "_parallel_image_format" : "_parallel_audio_format", b_format );
+						}
+						mlt_properties_set_int( MLT_FRAME_PROPERTIES( a_frame_ptr ), "_transition_a",
+							mlt_properties_get_int( MLT_FRAME_PROPERTIES( a_frame_ptr ), "_transition_a" ) | type );
+					}
 					else
+					{
 						a_hide |= type;
+					}
 
 					mlt_properties_set_int( MLT_FRAME_PROPERTIES( a_frame_ptr ), "hide", a_hide );
 					mlt_properties_set_int( MLT_FRAME_PROPERTIES( b_frame_ptr ), "hide", b_hide );
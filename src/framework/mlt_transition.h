@@ -35,6 +35,8 @@
  * \properties \em accepts_blanks a flag to indicate if the transition should accept blank frames
  * \properties \em always_active a flag to indicate that the in and out points do not apply
  * \properties \em _transition_type 1 for video, 2 for audio, 3 for both audio and video
+ * \properties \em _parallel_b_format the image or audio format in which the transition requests the B frame
+ * without otherwise changing it and as its own output was requested; this allows a tractor to render it early
  * \properties \em disable Set this to disable the transition while keeping it in the object model.
  */
 
@@ -141,6 +141,16 @@ typedef enum {
 }
 mlt_keyframe_type;
 
+/** The render quality requested for a frame, from best to cheapest */
+
+typedef enum
+{
+	mlt_quality_full = 0, /**< use the normal algorithms */
+	mlt_quality_reduced,  /**< use cheaper algorithms where the difference is hard to see */
+	mlt_quality_draft     /**< use the cheapest algorithms that keep the picture recognizable */
+}
+mlt_quality;
+
 /** The relative time qualifiers */
 
 typedef enum
@@ -21,6 +21,7 @@
 #include <string.h>
 #include "MltFilter.h"
 #include "MltProfile.h"
+#include "MltProducer.h"
 using namespace Mlt;
 
 Filter::Filter()
@@ -161,3 +162,8 @@ void Filter::process( Frame &frame )
 {
 	mlt_filter_process( get_filter( ), frame.get_frame() );
 }
+
+int Filter::analyze( Producer &producer, int chunks )
+{
+	return mlt_filter_analyze( get_filter( ), producer.get_producer( ), chunks );
+}
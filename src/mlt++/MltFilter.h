@@ -31,6 +31,7 @@ namespace Mlt
 	class Service;
 	class Profile;
 	class Frame;
+	class Producer;
 
 	class MLTPP_DECLSPEC Filter : public Service
 	{
@@ -58,6 +59,7 @@ namespace Mlt
 			int get_position( Frame &frame );
 			double get_progress( Frame &frame );
 			void process( Frame &frame );
+			int analyze( Producer &producer, int chunks = 0 );
 	};
 }
 
@@ -417,6 +417,18 @@ static mlt_properties avfilter_metadata( mlt_service_type type, const char *id,
 			snprintf( key, 20, "%d", i++ );
 			mlt_properties_set( values, key, "producer" );
 		}
+		if ( avfilter_pad_get_type( f->inputs, 0 ) == AVMEDIA_TYPE_VIDEO ) {
+			mlt_properties p = mlt_properties_new();
+			char key[20];
+			snprintf( key, 20, "%d", mlt_properties_count( params ) );
+			mlt_properties_set_data( params, key, p, 0, (mlt_destructor) mlt_properties_close, NULL );
+			mlt_properties_set( p, "identifier", "skip_quality" );
+			mlt_properties_set( p, "description", "Skip the filter when a real-time consumer lowers the render quality to this level (1 reduced, 2 draft) or below, 0 to never skip" );
+			mlt_properties_set( p, "type", "integer" );
+			mlt_properties_set_int( p, "minimum", 0 );
+			mlt_properties_set_int( p, "maximum", 2 );
+			mlt_properties_set_int( p, "default", 0 );
+		}
 	}
 
 	return metadata;
@@ -685,6 +685,11 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 
 	mlt_frame_get_image( frame, image, format, width, height, 0 );
 
+	// The filter graph cannot switch to a cheaper algorithm, so it may be skipped instead.
+	int skip_quality = mlt_properties_get_int( MLT_FILTER_PROPERTIES(filter), "skip_quality" );
+	if ( skip_quality > mlt_quality_full && mlt_frame_get_quality( frame ) >= skip_quality )
+		return 0;
+
 	mlt_service_lock( MLT_FILTER_SERVICE( filter ) );
 
 	if( pdata->reset || pdata->format != *format || pdata->width != *width || pdata->height != *height )
@@ -76,6 +76,7 @@
 #define MAX_AUDIO_FRAME_SIZE (192000) // 1 second of 48khz 32bit audio
 #define IMAGE_ALIGN (1)
 #define VFR_THRESHOLD (3) // The minimum number of video frames with differing durations to be considered VFR.
+#define KEYFRAME_INDEX_MAGIC "MLTKIDX1"
 
 struct producer_avformat_s
 {
@@ -121,6 +122,8 @@ struct producer_avformat_s
 	pthread_mutex_t open_mutex;
 	int is_mutex_init;
 	AVRational video_time_base;
+	int64_t *keyframes;        // sorted PTS of the video key frames
+	int keyframe_count;
 	mlt_frame last_good_frame; // for video error concealment
 	int last_good_position;    // for video error concealment
 #ifdef AVFILTER
@@ -131,6 +134,9 @@ struct producer_avformat_s
 	int autorotate;
 	int is_audio_synchronizing;
 	int video_send_result;
+	int audio_only;                  // video is set up only when an image is requested
+	AVFormatContext *audio_only_context; // the context whose video streams are discarded
+	atomic_int frames_without_image;
 #if USE_HWACCEL
 	struct {
 		int pix_fmt;
@@ -1123,6 +1129,198 @@ static void find_first_pts( producer_avformat self, int video_index )
 	av_seek_frame( context, -1, 0, AVSEEK_FLAG_BACKWARD );
 }
 
+typedef struct
+{
+	char magic[8];
+	int64_t file_size;
+	int64_t duration;
+	int32_t stream_index;
+	int32_t codec_id;
+	int32_t time_base_num;
+	int32_t time_base_den;
+	int64_t count;
+} keyframe_index_header;
+
+static char *keyframe_index_file( producer_avformat self )
+{
+	mlt_properties properties = MLT_PRODUCER_PROPERTIES( self->parent );
+	const char *file = mlt_properties_get( properties, "keyframe_index_file" );
+	const char *resource = mlt_properties_get( properties, "resource" );
+
+	if ( file && strcmp( file, "" ) )
+		return strdup( file );
+	// Only put a sidecar next to local files
+	if ( resource && !strstr( resource, "://" ) && !strchr( resource, '?' ) && strncmp( resource, "avformat", 8 ) )
+	{
+		char *result = malloc( strlen( resource ) + 8 );
+		sprintf( result, "%s.mltidx", resource );
+		return result;
+	}
+	return NULL;
+}
+
+static void keyframe_index_header_init( producer_avformat self, keyframe_index_header *header )
+{
+	AVFormatContext *context = self->video_format;
+	AVStream *stream = context->streams[ self->video_index ];
+
+	memset( header, 0, sizeof( *header ) );
+	memcpy( header->magic, KEYFRAME_INDEX_MAGIC, sizeof( header->magic ) );
+	header->file_size = context->pb ? avio_size( context->pb ) : -1;
+	header->duration = context->duration;
+	header->stream_index = self->video_index;
+	header->codec_id = stream->codecpar->codec_id;
+	header->time_base_num = stream->time_base.num;
+	header->time_base_den = stream->time_base.den;
+	header->count = self->keyframe_count;
+}
+
+static int keyframe_index_load( producer_avformat self, const char *filename )
+{
+	keyframe_index_header expected, header;
+	FILE *file = filename ? mlt_fopen( filename, "rb" ) : NULL;
+	int error = 1;
+
+	if ( file )
+	{
+		keyframe_index_header_init( self, &expected );
+		if ( fread( &header, sizeof( header ), 1, file ) == 1 && header.count > 0 && header.count < INT_MAX / sizeof( int64_t ) )
+		{
+			expected.count = header.count;
+			if ( !memcmp( &header, &expected, sizeof( header ) ) )
+			{
+				self->keyframes = malloc( header.count * sizeof( int64_t ) );
+				if ( self->keyframes && fread( self->keyframes, sizeof( int64_t ), header.count, file ) == header.count )
+				{
+					self->keyframe_count = header.count;
+					error = 0;
+				}
+				else
+				{
+					free( self->keyframes );
+					self->keyframes = NULL;
+				}
+			}
+		}
+		fclose( file );
+	}
+	return error;
+}
+
+static void keyframe_index_save( producer_avformat self, const char *filename )
+{
+	keyframe_index_header header;
+	FILE *file = filename ? mlt_fopen( filename, "wb" ) : NULL;
+
+	if ( file )
+	{
+		keyframe_index_header_init( self, &header );
+		if ( fwrite( &header, sizeof( header ), 1, file ) != 1 ||
+			 fwrite( self->keyframes, sizeof( int64_t ), self->keyframe_count, file ) != self->keyframe_count )
+		{
+			fclose( file );
+			remove( filename );
+			return;
+		}
+		fclose( file );
+	}
+}
+
+static int compare_pts( const void *a, const void *b )
+{
+	int64_t x = *( const int64_t* ) a;
+	int64_t y = *( const int64_t* ) b;
+	return x < y ? -1 : x > y;
+}
+
+/** Build the key frame index by scanning the video packets without decoding.
+ *
+ * The index is read from, or written to, a sidecar file when possible.
+ */
+
+static void keyframe_index_build( producer_avformat self )
+{
+	AVFormatContext *context = self->video_format;
+	char *filename = keyframe_index_file( self );
+	AVPacket pkt;
+	int size = 0;
+	unsigned int i;
+
+	if ( keyframe_index_load( self, filename ) )
+	{
+		enum AVDiscard *discard = calloc( context->nb_streams, sizeof( *discard ) );
+
+		for ( i = 0; discard && i < context->nb_streams; i++ )
+		{
+			discard[i] = context->streams[i]->discard;
+			if ( (int) i != self->video_index )
+				context->streams[i]->discard = AVDISCARD_ALL;
+		}
+		av_seek_frame( context, -1, 0, AVSEEK_FLAG_BACKWARD );
+		av_init_packet( &pkt );
+		while ( av_read_frame( context, &pkt ) >= 0 )
+		{
+			if ( pkt.stream_index == self->video_index && ( pkt.flags & AV_PKT_FLAG_KEY ) )
+			{
+				int64_t pts = pkt.pts != AV_NOPTS_VALUE ? pkt.pts : pkt.dts;
+				if ( pts != AV_NOPTS_VALUE )
+				{
+					if ( self->keyframe_count == size )
+					{
+						size = size ? size * 2 : 256;
+						self->keyframes = realloc( self->keyframes, size * sizeof( int64_t ) );
+					}
+					self->keyframes[ self->keyframe_count++ ] = pts;
+				}
+			}
+			av_packet_unref( &pkt );
+		}
+		for ( i = 0; discard && i < context->nb_streams; i++ )
+			context->streams[i]->discard = discard[i];
+		free( discard );
+		av_seek_frame( context, -1, 0, AVSEEK_FLAG_BACKWARD );
+
+		if ( self->keyframe_count > 0 )
+		{
+			qsort( self->keyframes, self->keyframe_count, sizeof( int64_t ), compare_pts );
+			keyframe_index_save( self, filename );
+		}
+		mlt_log_verbose( MLT_PRODUCER_SERVICE( self->parent ), "indexed %d key frames\n", self->keyframe_count );
+	}
+	free( filename );
+}
+
+/** Find the last key frame at or before a timestamp.
+ *
+ * \return the key frame PTS or the first key frame if the timestamp precedes all of them
+ */
+
+static int64_t keyframe_before( producer_avformat self, int64_t timestamp )
+{
+	int lo = 0, hi = self->keyframe_count - 1;
+	while ( lo < hi )
+	{
+		int mid = ( lo + hi + 1 ) / 2;
+		if ( self->keyframes[ mid ] <= timestamp )
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return self->keyframes[ lo ];
+}
+
+static int64_t position_to_timestamp( producer_avformat self, AVFormatContext *context, int64_t req_position, double source_fps )
+{
+	int64_t timestamp = req_position / ( av_q2d( self->video_time_base ) * source_fps );
+	if ( req_position <= 0 )
+		timestamp = 0;
+	else if ( self->first_pts != AV_NOPTS_VALUE )
+		timestamp += self->first_pts;
+	else if ( context->start_time != AV_NOPTS_VALUE )
+		timestamp += context->start_time;
+	return timestamp;
+}
+
 static int seek_video( producer_avformat self, mlt_position position,
 	int64_t req_position, int preseek )
 {
@@ -1150,25 +1348,40 @@ static int seek_video( producer_avformat self, mlt_position position,
 		double source_fps = mlt_properties_get_double( properties, "meta.media.frame_rate_num" ) /
 			mlt_properties_get_double( properties, "meta.media.frame_rate_den" );
 	
+		if ( !self->keyframes && self->last_position == POSITION_INITIAL &&
+			 mlt_properties_get_int( properties, "keyframe_index" ) )
+			keyframe_index_build( self );
+
 		if ( self->first_pts == AV_NOPTS_VALUE && self->last_position == POSITION_INITIAL )
 			find_first_pts( self, self->video_index );
 
+		int must_seek = position < self->video_expected || position - self->video_expected >= seek_threshold || self->last_position < 0;
+		int64_t keyframe = AV_NOPTS_VALUE;
+
+		if ( self->keyframes )
+		{
+			// With an index, decode forward only while no key frame lies between here and there
+			int64_t half_frame = 0.5 / ( av_q2d( self->video_time_base ) * source_fps );
+			keyframe = keyframe_before( self, position_to_timestamp( self, context, req_position, source_fps ) + half_frame );
+			if ( position > self->video_expected && self->last_position >= 0 )
+			{
+				int64_t expected = ( int64_t )( self->video_expected / mlt_producer_get_fps( producer ) * source_fps + 0.5 );
+				must_seek = keyframe > position_to_timestamp( self, context, expected, source_fps ) + half_frame;
+			}
+		}
+
 		if ( self->video_frame && position + 1 == self->video_expected )
 		{
 			// We're paused - use last image
 			paused = 1;
 		}
-		else if ( position < self->video_expected || position - self->video_expected >= seek_threshold || self->last_position < 0 )
+		else if ( must_seek )
 		{
 			// Calculate the timestamp for the requested frame
-			int64_t timestamp = req_position / ( av_q2d( self->video_time_base ) * source_fps );
-			if ( req_position <= 0 )
-				timestamp = 0;
-			else if ( self->first_pts != AV_NOPTS_VALUE )
-				timestamp += self->first_pts;
-			else if ( context->start_time != AV_NOPTS_VALUE )
-				timestamp += context->start_time;
-			if ( preseek && av_q2d( self->video_time_base ) != 0 )
+			int64_t timestamp = position_to_timestamp( self, context, req_position, source_fps );
+			if ( keyframe != AV_NOPTS_VALUE )
+				timestamp = keyframe;
+			else if ( preseek && av_q2d( self->video_time_base ) != 0 )
 				timestamp -= 2 / av_q2d( self->video_time_base );
 			if ( timestamp < 0 )
 				timestamp = 0;
@@ -1661,6 +1874,8 @@ static int producer_get_image( mlt_frame frame, uint8_t **buffer, mlt_image_form
 	int got_picture = 0;
 	int image_size = 0;
 
+	self->frames_without_image = 0;
+
 	pthread_mutex_lock( &self->video_mutex );
 	mlt_service_lock( MLT_PRODUCER_SERVICE( producer ) );
 	mlt_log_timings_begin();
@@ -2036,6 +2251,11 @@ static int producer_get_image( mlt_frame frame, uint8_t **buffer, mlt_image_form
 	if ( image_size > 0 )
 	{
 		mlt_properties_set_int( frame_properties, "format", *format );
+
+		// A picture without alpha is opaque, which lets transitions skip what it covers
+		const AVPixFmtDescriptor *pix_desc = codec_params ? av_pix_fmt_desc_get( codec_params->format ) : NULL;
+		if ( !alpha && pix_desc && !( pix_desc->flags & AV_PIX_FMT_FLAG_ALPHA ) )
+			mlt_frame_set_image_opacity( frame, 255 );
 		// Cache the image for rapid repeated access.
 		if ( self->image_cache ) {
 			if (is_album_art) {
@@ -2484,7 +2704,7 @@ static int seek_audio( producer_avformat self, mlt_position position, double tim
 			int video_index = self->video_index;
 			if ( video_index == -1 )
 				video_index = first_video_index( self );
-			if ( self->first_pts == AV_NOPTS_VALUE && video_index >= 0 )
+			if ( self->first_pts == AV_NOPTS_VALUE && video_index >= 0 && !self->audio_only )
 				find_first_pts( self, video_index );
 		}
 
@@ -2503,8 +2723,16 @@ static int seek_audio( producer_avformat self, mlt_position position, double tim
 			if ( timestamp < 0 )
 				timestamp = 0;
 
+			// The default stream may be discarded when only reading audio
+			int stream_index = -1;
+			if ( self->audio_only && self->audio_index >= 0 && self->audio_index < (int) context->nb_streams )
+			{
+				stream_index = self->audio_index;
+				timestamp = av_rescale_q( timestamp, AV_TIME_BASE_Q, context->streams[ stream_index ]->time_base );
+			}
+
 			// Set to the real timecode
-			if ( av_seek_frame( context, -1, timestamp, AVSEEK_FLAG_BACKWARD ) != 0 )
+			if ( av_seek_frame( context, stream_index, timestamp, AVSEEK_FLAG_BACKWARD ) != 0 )
 				paused = 1;
 
 			// Clear the usage in the audio buffer
@@ -2777,7 +3005,8 @@ static int producer_get_audio( mlt_frame frame, void **buffer, mlt_audio_format
 				ret = av_read_frame( context, &pkt );
 				if ( ret >= 0 && !self->seekable && pkt.stream_index == self->video_index )
 				{
-					mlt_deque_push_back( self->vpackets, av_packet_clone(&pkt) );
+					if ( !self->audio_only )
+						mlt_deque_push_back( self->vpackets, av_packet_clone(&pkt) );
 				}
 				else if ( ret < 0 )
 				{
@@ -2810,7 +3039,7 @@ static int producer_get_audio( mlt_frame frame, void **buffer, mlt_audio_format
 				ret = decode_audio( self, &ignore[index], &pkt, *samples, real_timecode, fps );
 			}
 
-			if ( self->seekable || index != self->video_index )
+			if ( self->seekable || index != self->video_index || self->audio_only )
 				av_packet_unref( &pkt );
 		}
 		self->is_audio_synchronizing = 0;
@@ -3055,6 +3284,92 @@ static void producer_set_up_audio( producer_avformat self, mlt_frame frame )
 	}
 }
 
+/** Enter or leave the audio-only mode.
+ *
+ * While only audio is read, the video codec and (for seekable files) the
+ * video format context are closed, and the video streams are discarded at
+ * the demuxer of the context used for audio.
+ */
+
+static void set_audio_only( producer_avformat self, int audio_only )
+{
+	unsigned int i;
+
+	pthread_mutex_lock( &self->video_mutex );
+	if ( audio_only )
+	{
+		pthread_mutex_lock( &self->open_mutex );
+		if ( self->video_codec )
+			avcodec_close( self->video_codec );
+		self->video_codec = NULL;
+		av_frame_unref( self->video_frame );
+		if ( self->seekable && self->video_format && self->video_format != self->audio_format )
+			avformat_close_input( &self->video_format );
+		pthread_mutex_unlock( &self->open_mutex );
+	}
+	pthread_mutex_lock( &self->packets_mutex );
+	self->audio_only = audio_only;
+	self->last_position = POSITION_INVALID;
+	self->audio_only_context = audio_only ? self->audio_format : NULL;
+	if ( self->audio_format )
+	{
+		AVFormatContext *context = self->audio_format;
+		for ( i = 0; i < context->nb_streams; i++ )
+			if ( context->streams[i]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO )
+				context->streams[i]->discard = audio_only ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+	}
+	if ( audio_only && self->vpackets )
+	{
+		AVPacket *pkt;
+		while ( ( pkt = mlt_deque_pop_back( self->vpackets ) ) )
+			av_packet_free( &pkt );
+	}
+	pthread_mutex_unlock( &self->packets_mutex );
+	pthread_mutex_unlock( &self->video_mutex );
+}
+
+/** Set up the video when an image is finally requested from an audio-only frame.
+ *
+ * The video streams must be read again first, since a non-seekable source
+ * shares its context with the audio and would otherwise never see a video
+ * packet.
+ */
+
+static int producer_get_image_deferred( mlt_frame frame, uint8_t **buffer, mlt_image_format *format, int *width, int *height, int writable )
+{
+	producer_avformat self = mlt_frame_pop_service( frame );
+	self->frames_without_image = 0;
+	if ( self->audio_only )
+		set_audio_only( self, 0 );
+	producer_set_up_video( self, frame );
+	return mlt_frame_get_image( frame, buffer, format, width, height, writable );
+}
+
+/** Determine whether to skip setting up the video for the next frame.
+ *
+ * This is forced with the audio_only property or, when audio_only_threshold
+ * is set, happens after that many frames without an image request. Only seekable
+ * sources switch automatically, because a live stream that skipped its video
+ * would have to wait for the next key frame once an image is requested.
+ */
+
+static int use_audio_only( producer_avformat self )
+{
+	mlt_properties properties = MLT_PRODUCER_PROPERTIES( self->parent );
+	int threshold = mlt_properties_get_int( properties, "audio_only_threshold" );
+	int audio_only = self->is_mutex_init && self->audio_index != -1 && mlt_properties_get_int( properties, "video_index" ) != -1 &&
+		( mlt_properties_get_int( properties, "audio_only" ) ||
+		  ( threshold > 0 && self->seekable && atomic_fetch_add( &self->frames_without_image, 1 ) >= threshold ) );
+
+	// Also catch up after the file was reopened
+	if ( audio_only != self->audio_only || ( audio_only && self->audio_format != self->audio_only_context ) )
+	{
+		mlt_log_verbose( MLT_PRODUCER_SERVICE( self->parent ), "%s audio-only mode\n", audio_only ? "entering" : "leaving" );
+		set_audio_only( self, audio_only );
+	}
+	return audio_only;
+}
+
 /** Our get frame implementation.
 */
 
@@ -3093,7 +3408,15 @@ static int producer_get_frame( mlt_producer producer, mlt_frame_ptr frame, int i
 	mlt_frame_set_position( *frame, mlt_producer_position( producer ) );
 
 	// Set up the video
-	producer_set_up_video( self, *frame );
+	if ( use_audio_only( self ) )
+	{
+		mlt_frame_push_service( *frame, self );
+		mlt_frame_push_get_image( *frame, producer_get_image_deferred );
+	}
+	else
+	{
+		producer_set_up_video( self, *frame );
+	}
 
 	// Set up the audio
 	producer_set_up_audio( self, *frame );
@@ -3150,6 +3473,7 @@ static void producer_avformat_close( producer_avformat self )
 
 	// Cleanup caches.
 	mlt_cache_close( self->image_cache );
+	free( self->keyframes );
 	if ( self->last_good_frame )
 		mlt_frame_close( self->last_good_frame );
 
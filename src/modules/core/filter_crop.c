@@ -72,8 +72,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 		mlt_properties_set_int( properties, "rescale_height", mlt_properties_get_int( properties, "crop.original_height" ) );
 	}
 
-	// Now get the image
+	// Now get the image; cropping replaces it, so what is known about it stays true until then
 	error = mlt_frame_get_image( frame, image, format, width, height, writable );
+	mlt_frame_keep_image_facts( frame );
 
 	int owidth  = *width - left - right;
 	int oheight = *height - top - bottom;
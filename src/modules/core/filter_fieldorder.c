@@ -29,8 +29,9 @@ static int get_image( mlt_frame frame, uint8_t **image, mlt_image_format *format
 	// Get the properties from the frame
 	mlt_properties properties = MLT_FRAME_PROPERTIES( frame );
 
-	// Get the input image, width and height
+	// Get the input image, width and height; changes replace it, so keep what is known about it
 	int error = mlt_frame_get_image( frame, image, format, width, height, writable );
+	mlt_frame_keep_image_facts( frame );
 
 	if ( !error && *image )
 	{
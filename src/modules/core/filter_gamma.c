@@ -44,22 +44,16 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 
 		if ( gamma != 1.0 )
 		{
-			uint8_t *p = *image;
-			uint8_t *q = *image + *width * *height * 2;
-
 			// Calculate the look up table
 			double exp = 1 / gamma;
 			uint8_t lookup[ 256 ];
+			const uint8_t *luts[ 4 ] = { lookup, NULL, NULL, NULL };
 			int i;
 
 			for( i = 0; i < 256; i ++ )
 				lookup[ i ] = ( uint8_t )( pow( ( double )i / 255.0, exp ) * 255 );
 
-			while ( p != q )
-			{
-				*p = lookup[ *p ];
-				p += 2;
-			}
+			mlt_image_apply_luts( *image, *format, *width, *height, luts );
 		}
 	}
 
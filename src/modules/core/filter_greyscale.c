@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /** Do it :-).
 */
@@ -32,10 +33,11 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	int error = mlt_frame_get_image( frame, image, format, width, height, 1 );
 	if ( error == 0 )
 	{
-		uint8_t *p = *image;
-		uint8_t *q = *image + *width * *height * 2;
-		while ( p ++ != q )
-			*p ++ = 128;
+		// Map every chroma value to grey.
+		uint8_t grey[ 256 ];
+		const uint8_t *luts[ 4 ] = { NULL, grey, grey, NULL };
+		memset( grey, 128, sizeof( grey ) );
+		mlt_image_apply_luts( *image, *format, *width, *height, luts );
 	}
 	return error;
 }
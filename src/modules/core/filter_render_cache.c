@@ -0,0 +1,1047 @@
+/*
+ * filter_render_cache.c -- cache rendered timeline segments by content
+ * Copyright (C) 2026 Meltytech, LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <framework/mlt.h>
+
+#include <ctype.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#define MAX_SEGMENTS (64)
+#define MAX_DEPTH (32)
+
+/* A segment is the set of services that contribute to one frame of the
+ * owning tractor or playlist. Its hash covers the services and their
+ * positions relative to each other, so the same material renders to the
+ * same key wherever it sits on the timeline.
+ */
+
+typedef struct
+{
+	uint64_t hash;
+	mlt_position position;
+	int timed;
+} element;
+
+typedef struct
+{
+	element *elements;
+	int count;
+	int size;
+	int clips;
+} element_list;
+
+typedef struct
+{
+	uint64_t hash;
+	mlt_cache images;
+	mlt_cache audio;
+	int64_t used;
+} segment;
+
+typedef struct
+{
+	pthread_mutex_t mutex;
+	segment segments[ MAX_SEGMENTS ];
+	mlt_properties results;
+	int64_t clock;
+	int sequence;
+	char *directory;
+	int64_t disk_used;
+} private_data;
+
+typedef struct
+{
+	char *name;
+	time_t time;
+	int64_t size;
+} cache_file;
+
+typedef struct
+{
+	char magic[4];
+	int32_t request_format, request_width, request_height;
+	int32_t format, width, height;
+	int32_t image_size, alpha_size;
+	int32_t progressive, top_field_first, colorspace, full_luma, color_trc;
+	double aspect_ratio;
+} image_header;
+
+typedef struct
+{
+	char magic[4];
+	int32_t request_format, request_frequency, request_channels, request_samples;
+	int32_t format, frequency, channels, samples;
+	int32_t size;
+} audio_header;
+
+static const char *image_properties[] = { "progressive", "top_field_first", "colorspace", "full_luma", "color_trc", NULL };
+
+static uint64_t hash_bytes( uint64_t hash, const void *data, size_t size )
+{
+	const uint8_t *p = data;
+	while ( size-- )
+	{
+		hash ^= *p++;
+		hash *= UINT64_C(0x100000001b3);
+	}
+	return hash;
+}
+
+static uint64_t hash_string( uint64_t hash, const char *s )
+{
+	return hash_bytes( hash, s ? s : "", s ? strlen( s ) + 1 : 1 );
+}
+
+/** Get the names of the properties that a service reports results in.
+ *
+ * These are the parameters its metadata marks read-only, which it sets while
+ * rendering, such as the levels of a meter. The lists are kept per kind of
+ * service for the life of the filter.
+ */
+
+static mlt_properties result_properties( mlt_filter filter, mlt_service service )
+{
+	private_data *pdata = filter->child;
+	const char *id = mlt_properties_get( MLT_SERVICE_PROPERTIES( service ), "mlt_service" );
+	mlt_service_type type = mlt_service_identify( service );
+	mlt_properties results;
+	char key[256];
+
+	if ( !id )
+		return NULL;
+	if ( type != mlt_service_filter_type && type != mlt_service_transition_type && type != mlt_service_link_type )
+		type = mlt_service_producer_type;
+	snprintf( key, sizeof( key ), "%d:%s", type, id );
+
+	pthread_mutex_lock( &pdata->mutex );
+	results = mlt_properties_get_data( pdata->results, key, NULL );
+	if ( !results )
+	{
+		mlt_properties metadata = mlt_repository_metadata( mlt_factory_repository(), type, id );
+		mlt_properties parameters = metadata ? mlt_properties_get_data( metadata, "parameters", NULL ) : NULL;
+		int i;
+
+		results = mlt_properties_new();
+		for ( i = 0; i < mlt_properties_count( parameters ); i++ )
+		{
+			mlt_properties parameter = mlt_properties_get_data( parameters, mlt_properties_get_name( parameters, i ), NULL );
+			const char *identifier = mlt_properties_get( parameter, "identifier" );
+			const char *readonly = mlt_properties_get( parameter, "readonly" );
+			if ( identifier && readonly && !strcmp( readonly, "yes" ) )
+				mlt_properties_set_int( results, identifier, 1 );
+		}
+		mlt_properties_set_data( pdata->results, key, results, 0, ( mlt_destructor )mlt_properties_close, NULL );
+	}
+	pthread_mutex_unlock( &pdata->mutex );
+
+	return results;
+}
+
+/** Hash the properties of a service that describe what it renders.
+ *
+ * Private properties and the results it reports are left out.
+ */
+
+static uint64_t hash_properties( mlt_filter filter, uint64_t hash, mlt_service service )
+{
+	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
+	mlt_properties results = result_properties( filter, service );
+	int i, n = mlt_properties_count( properties );
+	for ( i = 0; i < n; i++ )
+	{
+		const char *name = mlt_properties_get_name( properties, i );
+		if ( name && name[0] != '_' && !mlt_properties_get_int( results, name ) )
+		{
+			hash = hash_string( hash, name );
+			hash = hash_string( hash, mlt_properties_get( properties, name ) );
+		}
+	}
+	return hash;
+}
+
+static uint64_t hash_filter( mlt_filter self, mlt_filter filter )
+{
+	return hash_properties( self, UINT64_C(0xcbf29ce484222325), MLT_FILTER_SERVICE( filter ) );
+}
+
+/** Hash the properties of a service and of every service it draws on.
+ *
+ * This covers the filters attached to them and the services nested inside a
+ * playlist, tractor or chain. It depends only on what they render, not on
+ * where they are in memory, so it stays the same across sessions and can
+ * name the files on disk.
+ */
+
+static uint64_t graph_hash( mlt_filter filter, mlt_service service, int depth )
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	uint64_t child;
+	int i;
+
+	if ( !service || depth > MAX_DEPTH )
+		return hash;
+
+	hash = hash_properties( filter, hash, service );
+
+	for ( i = 0; i < mlt_service_filter_count( service ); i++ )
+	{
+		child = graph_hash( filter, MLT_FILTER_SERVICE( mlt_service_filter( service, i ) ), depth + 1 );
+		hash = hash_bytes( hash, &child, sizeof( child ) );
+	}
+
+	switch ( mlt_service_identify( service ) )
+	{
+	case mlt_service_producer_type:
+	case mlt_service_playlist_type:
+	case mlt_service_tractor_type:
+	case mlt_service_multitrack_type:
+	case mlt_service_chain_type:
+	case mlt_service_link_type:
+		// A cut may carry the resource of its parent, so check it first
+		if ( mlt_producer_is_cut( MLT_PRODUCER( service ) ) )
+		{
+			child = graph_hash( filter, MLT_PRODUCER_SERVICE( mlt_producer_cut_parent( MLT_PRODUCER( service ) ) ), depth + 1 );
+			hash = hash_bytes( hash, &child, sizeof( child ) );
+		}
+		else if ( mlt_service_identify( service ) == mlt_service_playlist_type )
+		{
+			mlt_playlist playlist = MLT_PLAYLIST( service );
+			for ( i = 0; i < mlt_playlist_count( playlist ); i++ )
+			{
+				child = graph_hash( filter, MLT_PRODUCER_SERVICE( mlt_playlist_get_clip( playlist, i ) ), depth + 1 );
+				hash = hash_bytes( hash, &child, sizeof( child ) );
+			}
+		}
+		else if ( mlt_service_identify( service ) == mlt_service_tractor_type )
+		{
+			// The field chain ends at the multitrack
+			child = graph_hash( filter, MLT_TRACTOR( service )->producer, depth + 1 );
+			hash = hash_bytes( hash, &child, sizeof( child ) );
+		}
+		else if ( mlt_service_identify( service ) == mlt_service_multitrack_type )
+		{
+			mlt_multitrack multitrack = MLT_MULTITRACK( service );
+			for ( i = 0; i < mlt_multitrack_count( multitrack ); i++ )
+			{
+				child = graph_hash( filter, MLT_PRODUCER_SERVICE( mlt_multitrack_track( multitrack, i ) ), depth + 1 );
+				hash = hash_bytes( hash, &child, sizeof( child ) );
+			}
+		}
+		else if ( mlt_service_identify( service ) == mlt_service_chain_type )
+		{
+			mlt_chain chain = MLT_CHAIN( service );
+			child = graph_hash( filter, MLT_PRODUCER_SERVICE( mlt_chain_get_source( chain ) ), depth + 1 );
+			hash = hash_bytes( hash, &child, sizeof( child ) );
+			for ( i = 0; i < mlt_chain_link_count( chain ); i++ )
+			{
+				child = graph_hash( filter, MLT_LINK_SERVICE( mlt_chain_link( chain, i ) ), depth + 1 );
+				hash = hash_bytes( hash, &child, sizeof( child ) );
+			}
+		}
+		break;
+	case mlt_service_filter_type:
+	case mlt_service_transition_type:
+		// Services planted in the field of a tractor are connected to the next
+		child = graph_hash( filter, mlt_service_producer( service ), depth + 1 );
+		hash = hash_bytes( hash, &child, sizeof( child ) );
+		break;
+	default:
+		break;
+	}
+	return hash;
+}
+
+/** Hash a producer by what it renders.
+ *
+ * The producer is locked so that it is not changed half way. Nothing is
+ * written to it or to the services it draws on.
+ */
+
+static uint64_t hash_producer( mlt_filter filter, mlt_producer producer )
+{
+	mlt_service service = MLT_PRODUCER_SERVICE( producer );
+	uint64_t hash;
+
+	mlt_service_lock( service );
+	hash = graph_hash( filter, service, 0 );
+	mlt_service_unlock( service );
+
+	return hash;
+}
+
+static void add_element( element_list *list, uint64_t hash, mlt_position position, int timed )
+{
+	if ( list->count == list->size )
+	{
+		list->size += 16;
+		list->elements = realloc( list->elements, list->size * sizeof( element ) );
+	}
+	list->elements[ list->count ].hash = hash;
+	list->elements[ list->count ].position = position;
+	list->elements[ list->count ].timed = timed;
+	list->count ++;
+}
+
+static int is_active( mlt_properties properties, mlt_position position )
+{
+	mlt_position in = mlt_properties_get_position( properties, "in" );
+	mlt_position out = mlt_properties_get_position( properties, "out" );
+	return !mlt_properties_get_int( properties, "disable" ) &&
+		( mlt_properties_get_int( properties, "always_active" ) || ( in == 0 && out == 0 ) ||
+		  ( position >= in && ( out == 0 || position <= out ) ) );
+}
+
+static void add_filters( mlt_filter self, element_list *list, mlt_service service, mlt_position position, int limit )
+{
+	int i;
+	for ( i = 0; i < limit; i++ )
+	{
+		mlt_filter filter = mlt_service_filter( service, i );
+		mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
+		if ( filter && is_active( properties, position ) )
+			add_element( list, hash_filter( self, filter ), position - mlt_filter_get_in( filter ), 1 );
+	}
+}
+
+static void add_track( mlt_filter filter, element_list *list, mlt_producer track, mlt_position position, int limit )
+{
+	mlt_properties properties = MLT_PRODUCER_PROPERTIES( track );
+
+	add_element( list, hash_string( UINT64_C(0xcbf29ce484222325), mlt_properties_get( properties, "hide" ) ), 0, 0 );
+	add_filters( filter, list, MLT_PRODUCER_SERVICE( track ), position, limit );
+
+	if ( mlt_service_identify( MLT_PRODUCER_SERVICE( track ) ) == mlt_service_playlist_type )
+	{
+		mlt_playlist playlist = ( mlt_playlist ) track;
+		mlt_playlist_clip_info info;
+		int index = mlt_playlist_get_clip_index_at( playlist, position );
+
+		if ( index < mlt_playlist_count( playlist ) && !mlt_playlist_is_blank( playlist, index )
+			&& !mlt_playlist_get_clip_info( playlist, &info, index ) && info.cut )
+		{
+			add_element( list, hash_producer( filter, info.cut ), info.frame_in + position - info.start, 1 );
+			list->clips ++;
+		}
+		else
+		{
+			add_element( list, hash_string( UINT64_C(0xcbf29ce484222325), "blank" ), 0, 0 );
+		}
+	}
+	else
+	{
+		add_element( list, hash_producer( filter, track ), position, 1 );
+		list->clips ++;
+	}
+}
+
+static void add_tractor( mlt_filter filter, element_list *list, mlt_tractor tractor, mlt_position position )
+{
+	mlt_multitrack multitrack = mlt_tractor_multitrack( tractor );
+	mlt_service service = tractor->producer;
+	int i;
+
+	for ( i = 0; i < mlt_multitrack_count( multitrack ); i++ )
+	{
+		mlt_producer track = mlt_multitrack_track( multitrack, i );
+		if ( track )
+			add_track( filter, list, track, position, mlt_service_filter_count( MLT_PRODUCER_SERVICE( track ) ) );
+	}
+
+	// Transitions and filters planted in the field
+	while ( service && mlt_service_identify( service ) != mlt_service_multitrack_type )
+	{
+		mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
+		mlt_service_type type = mlt_service_identify( service );
+		if ( ( type == mlt_service_transition_type || type == mlt_service_filter_type ) && is_active( properties, position ) )
+			add_element( list, hash_properties( filter, UINT64_C(0xcbf29ce484222325), service ),
+				position - mlt_properties_get_position( properties, "in" ), 1 );
+		service = mlt_service_producer( service );
+	}
+}
+
+/** Compute the key of the segment that renders the owner at a position.
+ *
+ * \return true if the segment cannot be cached
+ */
+
+static int segment_key( mlt_filter filter, mlt_position position, uint64_t *hash, mlt_position *origin )
+{
+	mlt_profile profile = mlt_service_profile( MLT_FILTER_SERVICE( filter ) );
+	mlt_service owner = mlt_properties_get_data( MLT_FILTER_PROPERTIES( filter ), "service", NULL );
+	element_list list = { NULL, 0, 0, 0 };
+	int limit = 0;
+	int i;
+
+	if ( !owner || !profile )
+		return 1;
+
+	while ( limit < mlt_service_filter_count( owner ) && mlt_service_filter( owner, limit ) != filter )
+		limit ++;
+
+	switch ( mlt_service_identify( owner ) )
+	{
+	case mlt_service_tractor_type:
+		add_tractor( filter, &list, MLT_TRACTOR( owner ), position );
+		add_filters( filter, &list, owner, position, limit );
+		break;
+	case mlt_service_playlist_type:
+		add_track( filter, &list, MLT_PRODUCER( owner ), position, limit );
+		break;
+	default:
+		break;
+	}
+
+	if ( list.clips > 0 )
+	{
+		char profile_text[128];
+		*hash = UINT64_C(0xcbf29ce484222325);
+		*origin = 0;
+		snprintf( profile_text, sizeof( profile_text ), "%d %d %d %d %d %d %d %d", profile->width, profile->height,
+			profile->frame_rate_num, profile->frame_rate_den, profile->sample_aspect_num, profile->sample_aspect_den,
+			profile->progressive, profile->colorspace );
+		*hash = hash_string( *hash, profile_text );
+		for ( i = 0; i < list.count; i++ )
+		{
+			if ( list.elements[ i ].timed )
+			{
+				*origin = list.elements[ i ].position;
+				break;
+			}
+		}
+		for ( i = 0; i < list.count; i++ )
+		{
+			int64_t offset = list.elements[ i ].timed ? list.elements[ i ].position - *origin : INT64_MIN;
+			*hash = hash_bytes( *hash, &list.elements[ i ].hash, sizeof( uint64_t ) );
+			*hash = hash_bytes( *hash, &offset, sizeof( offset ) );
+		}
+	}
+	free( list.elements );
+
+	return list.clips == 0;
+}
+
+/** Find or make the in-memory segment for a hash.
+ *
+ * The caller must hold the mutex.
+ */
+
+static segment *get_segment( mlt_filter filter, uint64_t hash )
+{
+	private_data *pdata = filter->child;
+	mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
+	int frames = mlt_properties_get_int( properties, "frames" );
+	int count = mlt_properties_get_int( properties, "segments" );
+	segment *result = NULL;
+	int i;
+
+	if ( frames <= 0 || count <= 0 )
+		return NULL;
+	count = count > MAX_SEGMENTS ? MAX_SEGMENTS : count;
+
+	for ( i = 0; i < count; i++ )
+	{
+		segment *s = &pdata->segments[ i ];
+		if ( s->images && s->hash == hash )
+		{
+			result = s;
+			break;
+		}
+		if ( !result || ( result->images && ( !s->images || s->used < result->used ) ) )
+			result = s;
+	}
+	if ( !result->images || result->hash != hash )
+	{
+		mlt_cache_close( result->images );
+		mlt_cache_close( result->audio );
+		result->hash = hash;
+		result->images = mlt_cache_init();
+		result->audio = mlt_cache_init();
+		mlt_cache_set_size( result->images, frames );
+		mlt_cache_set_size( result->audio, frames );
+	}
+	result->used = ++pdata->clock;
+
+	return result;
+}
+
+static char *file_name( mlt_filter filter, uint64_t hash, mlt_position position, const char *kind )
+{
+	const char *directory = mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "resource" );
+	char *name = NULL;
+
+	if ( directory && strcmp( directory, "" ) )
+	{
+		size_t size = strlen( directory ) + 48;
+		name = malloc( size );
+		snprintf( name, size, "%s/%016" PRIx64 "-%d.%s", directory, hash, position, kind );
+	}
+	return name;
+}
+
+/** Determine if a file in the directory is one that the filter writes.
+ */
+
+static int is_cache_file( const char *name )
+{
+	size_t length = strlen( name );
+	int i;
+
+	if ( length < 24 || name[16] != '-' )
+		return 0;
+	for ( i = 0; i < 16; i++ )
+		if ( !isxdigit( ( unsigned char ) name[ i ] ) )
+			return 0;
+	return !strcmp( name + length - 6, ".image" ) || !strcmp( name + length - 6, ".audio" );
+}
+
+/** Find the cache files in a directory.
+ *
+ * \param directory the directory
+ * \param[out] files the files found, or NULL to only add up their sizes
+ * \param[out] count the number of files found
+ * \return the total size of the files in bytes
+ */
+
+static int64_t list_files( const char *directory, cache_file **files, int *count )
+{
+	DIR *dir = opendir( directory );
+	struct dirent *entry;
+	int64_t total = 0;
+	int size = 0;
+
+	if ( files )
+	{
+		*files = NULL;
+		*count = 0;
+	}
+	if ( !dir )
+		return 0;
+	while ( ( entry = readdir( dir ) ) )
+	{
+		struct stat info;
+		size_t path_size;
+		char *path;
+
+		if ( !is_cache_file( entry->d_name ) )
+			continue;
+		path_size = strlen( directory ) + strlen( entry->d_name ) + 2;
+		path = malloc( path_size );
+		snprintf( path, path_size, "%s/%s", directory, entry->d_name );
+		if ( stat( path, &info ) )
+		{
+			free( path );
+			continue;
+		}
+		total += info.st_size;
+		if ( files )
+		{
+			if ( *count == size )
+			{
+				size += 256;
+				*files = realloc( *files, size * sizeof( cache_file ) );
+			}
+			( *files )[ *count ].name = path;
+			( *files )[ *count ].time = info.st_mtime;
+			( *files )[ *count ].size = info.st_size;
+			( *count ) ++;
+		}
+		else
+		{
+			free( path );
+		}
+	}
+	closedir( dir );
+	return total;
+}
+
+static int compare_files( const void *a, const void *b )
+{
+	const cache_file *x = a;
+	const cache_file *y = b;
+	return x->time < y->time ? -1 : x->time > y->time ? 1 : strcmp( x->name, y->name );
+}
+
+/** Remove the least recently used files once the directory outgrows disk_size.
+ *
+ * The directory is listed once to find its size, which is then kept up to
+ * date with the files written here. It is only listed again to remove files,
+ * which also accounts for files written by other processes.
+ */
+
+static void trim_directory( mlt_filter filter, const char *directory, int64_t written )
+{
+	private_data *pdata = filter->child;
+	int64_t limit = mlt_properties_get_int64( MLT_FILTER_PROPERTIES( filter ), "disk_size" ) * 1024 * 1024;
+
+	if ( limit <= 0 )
+		return;
+
+	pthread_mutex_lock( &pdata->mutex );
+	if ( !pdata->directory || strcmp( pdata->directory, directory ) )
+	{
+		free( pdata->directory );
+		pdata->directory = strdup( directory );
+		pdata->disk_used = list_files( directory, NULL, NULL );
+	}
+	else
+	{
+		pdata->disk_used += written;
+	}
+	if ( pdata->disk_used > limit )
+	{
+		cache_file *files = NULL;
+		int count = 0;
+		int i;
+
+		pdata->disk_used = list_files( directory, &files, &count );
+		qsort( files, count, sizeof( cache_file ), compare_files );
+
+		// Leave some room so that the next few writes do not list it again
+		for ( i = 0; i < count && pdata->disk_used > limit - limit / 10; i++ )
+			if ( !remove( files[ i ].name ) )
+				pdata->disk_used -= files[ i ].size;
+		for ( i = 0; i < count; i++ )
+			free( files[ i ].name );
+		free( files );
+	}
+	pthread_mutex_unlock( &pdata->mutex );
+}
+
+static void write_file( mlt_filter filter, const char *name, const void *header, size_t header_size,
+	const void *data, size_t size, const void *extra, size_t extra_size )
+{
+	private_data *pdata = filter->child;
+	size_t tmp_size = strlen( name ) + 32;
+	char *tmp = malloc( tmp_size );
+	FILE *file;
+	int sequence;
+
+	pthread_mutex_lock( &pdata->mutex );
+	sequence = ++pdata->sequence;
+	pthread_mutex_unlock( &pdata->mutex );
+
+	snprintf( tmp, tmp_size, "%s.%d-%d.tmp", name, ( int ) getpid(), sequence );
+	file = fopen( tmp, "wb" );
+	if ( file )
+	{
+		int error = fwrite( header, header_size, 1, file ) != 1
+			|| ( size && fwrite( data, size, 1, file ) != 1 )
+			|| ( extra_size && fwrite( extra, extra_size, 1, file ) != 1 );
+		error |= fclose( file );
+		if ( error || rename( tmp, name ) )
+		{
+			remove( tmp );
+			mlt_log_warning( MLT_FILTER_SERVICE( filter ), "failed to write %s\n", name );
+		}
+		else
+		{
+			trim_directory( filter, mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "resource" ),
+				header_size + size + extra_size );
+		}
+	}
+	free( tmp );
+}
+
+/** Read a cache file whose header matches a request.
+ *
+ * \return the payload in a pool buffer, or NULL if there is no usable file
+ */
+
+static void *read_file( const char *name, void *header, size_t header_size, int (*check)( void*, void* ), void *request, int *size )
+{
+	FILE *file = fopen( name, "rb" );
+	uint8_t *data = NULL;
+
+	if ( file )
+	{
+		if ( fread( header, header_size, 1, file ) == 1 && ( *size = check( header, request ) ) > 0 )
+		{
+			data = mlt_pool_alloc( *size );
+			if ( data && fread( data, *size, 1, file ) != 1 )
+			{
+				mlt_pool_release( data );
+				data = NULL;
+			}
+		}
+		fclose( file );
+
+		// Mark the file as recently used for trim_directory()
+		if ( data )
+			utime( name, NULL );
+	}
+	return data;
+}
+
+static int check_image( void *data, void *request )
+{
+	image_header *header = data;
+	image_header *want = request;
+	if ( !memcmp( header->magic, "MLTi", 4 )
+		&& header->request_format == want->request_format
+		&& header->request_width == want->request_width
+		&& header->request_height == want->request_height
+		&& header->image_size > 0 && header->alpha_size >= 0 )
+		return header->image_size + header->alpha_size;
+	return 0;
+}
+
+static int check_audio( void *data, void *request )
+{
+	audio_header *header = data;
+	audio_header *want = request;
+	if ( !memcmp( header->magic, "MLTa", 4 )
+		&& header->request_format == want->request_format
+		&& header->request_frequency == want->request_frequency
+		&& header->request_channels == want->request_channels
+		&& header->request_samples == want->request_samples
+		&& header->size > 0 )
+		return header->size;
+	return 0;
+}
+
+static int get_image( mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable )
+{
+	mlt_filter filter = mlt_frame_pop_service( frame );
+	private_data *pdata = filter->child;
+	mlt_properties frame_properties = MLT_FRAME_PROPERTIES( frame );
+	uint64_t hash = ( uint64_t ) mlt_properties_get_int64( frame_properties, "render_cache.hash" );
+	mlt_position position = mlt_properties_get_position( frame_properties, "render_cache.position" );
+	mlt_image_format request_format = *format;
+	int request_width = *width;
+	int request_height = *height;
+	mlt_frame cached = NULL;
+	segment *s;
+	int error;
+	int i;
+
+	// Look in memory first
+	pthread_mutex_lock( &pdata->mutex );
+	s = get_segment( filter, hash );
+	if ( s )
+		cached = mlt_cache_get_frame( s->images, position );
+	pthread_mutex_unlock( &pdata->mutex );
+
+	if ( cached )
+	{
+		mlt_properties properties = MLT_FRAME_PROPERTIES( cached );
+		if ( mlt_properties_get_int( properties, "render_cache.format" ) == request_format
+			&& mlt_properties_get_int( properties, "render_cache.width" ) == request_width
+			&& mlt_properties_get_int( properties, "render_cache.height" ) == request_height )
+		{
+			// Share the cached buffers, which are copied if requested writable
+			int size = 0;
+			uint8_t *data = mlt_properties_get_data( properties, "image", &size );
+			*format = mlt_properties_get_int( properties, "format" );
+			*width = mlt_properties_get_int( properties, "width" );
+			*height = mlt_properties_get_int( properties, "height" );
+			*image = data;
+			mlt_frame_set_image_shared( frame, data, size );
+			data = mlt_properties_get_data( properties, "alpha", &size );
+			if ( data && size )
+				mlt_frame_set_alpha_shared( frame, data, size );
+			for ( i = 0; image_properties[ i ]; i++ )
+				if ( mlt_properties_get( properties, image_properties[ i ] ) )
+					mlt_properties_set_int( frame_properties, image_properties[ i ], mlt_properties_get_int( properties, image_properties[ i ] ) );
+			mlt_properties_set_double( frame_properties, "aspect_ratio", mlt_properties_get_double( properties, "aspect_ratio" ) );
+			mlt_frame_close( cached );
+			return 0;
+		}
+		mlt_frame_close( cached );
+	}
+
+	// Then on disk
+	char *name = file_name( filter, hash, position, "image" );
+	if ( name )
+	{
+		image_header header;
+		image_header want = { .magic = "MLTi", .request_format = request_format,
+			.request_width = request_width, .request_height = request_height };
+		int size = 0;
+		uint8_t *data = read_file( name, &header, sizeof( header ), check_image, &want, &size );
+
+		if ( data )
+		{
+			*format = header.format;
+			*width = header.width;
+			*height = header.height;
+			*image = data;
+			mlt_frame_set_image( frame, *image, size, mlt_pool_release );
+			if ( header.alpha_size )
+			{
+				uint8_t *alpha = mlt_pool_alloc( header.alpha_size );
+				memcpy( alpha, data + header.image_size, header.alpha_size );
+				mlt_frame_set_alpha( frame, alpha, header.alpha_size, mlt_pool_release );
+			}
+			mlt_properties_set_int( frame_properties, "progressive", header.progressive );
+			mlt_properties_set_int( frame_properties, "top_field_first", header.top_field_first );
+			mlt_properties_set_int( frame_properties, "colorspace", header.colorspace );
+			mlt_properties_set_int( frame_properties, "full_luma", header.full_luma );
+			mlt_properties_set_int( frame_properties, "color_trc", header.color_trc );
+			mlt_properties_set_double( frame_properties, "aspect_ratio", header.aspect_ratio );
+			free( name );
+			return 0;
+		}
+	}
+
+	// Render it and remember the result
+	error = mlt_frame_get_image( frame, image, format, width, height, writable );
+	if ( !error && *image )
+	{
+		int size = mlt_image_format_size( *format, *width, *height, NULL );
+		int alpha_size = 0;
+		uint8_t *alpha = mlt_properties_get_data( frame_properties, "alpha", &alpha_size );
+		if ( !alpha )
+			alpha_size = 0;
+		else if ( !alpha_size )
+			alpha_size = *width * *height;
+
+		pthread_mutex_lock( &pdata->mutex );
+		s = get_segment( filter, hash );
+		if ( s )
+		{
+			// Keep the buffers as shared ones so that a hit need not copy them
+			mlt_frame carrier = mlt_frame_init( NULL );
+			mlt_properties properties = MLT_FRAME_PROPERTIES( carrier );
+			int shared_size = 0;
+			uint8_t *shared = mlt_frame_share_image( frame, &shared_size );
+			mlt_properties_set_position( properties, "original_position", position );
+			if ( shared )
+			{
+				*image = shared;
+				mlt_frame_set_image_shared( carrier, shared, shared_size );
+			}
+			if ( alpha_size && ( shared = mlt_frame_share_alpha( frame, &shared_size ) ) )
+			{
+				alpha = shared;
+				mlt_frame_set_alpha_shared( carrier, alpha, shared_size );
+			}
+			mlt_properties_set_int( properties, "format", *format );
+			mlt_properties_set_int( properties, "width", *width );
+			mlt_properties_set_int( properties, "height", *height );
+			mlt_properties_set_int( properties, "render_cache.format", request_format );
+			mlt_properties_set_int( properties, "render_cache.width", request_width );
+			mlt_properties_set_int( properties, "render_cache.height", request_height );
+			for ( i = 0; image_properties[ i ]; i++ )
+				if ( mlt_properties_get( frame_properties, image_properties[ i ] ) )
+					mlt_properties_set_int( properties, image_properties[ i ], mlt_properties_get_int( frame_properties, image_properties[ i ] ) );
+			mlt_properties_set_double( properties, "aspect_ratio", mlt_frame_get_aspect_ratio( frame ) );
+			mlt_cache_put_frame( s->images, carrier );
+			mlt_frame_close( carrier );
+		}
+		pthread_mutex_unlock( &pdata->mutex );
+
+		if ( name )
+		{
+			image_header header = { "MLTi", request_format, request_width, request_height,
+				*format, *width, *height, size, alpha_size,
+				mlt_properties_get_int( frame_properties, "progressive" ),
+				mlt_properties_get_int( frame_properties, "top_field_first" ),
+				mlt_properties_get_int( frame_properties, "colorspace" ),
+				mlt_properties_get_int( frame_properties, "full_luma" ),
+				mlt_properties_get_int( frame_properties, "color_trc" ),
+				mlt_frame_get_aspect_ratio( frame ) };
+			write_file( filter, name, &header, sizeof( header ), *image, size, alpha, alpha_size );
+		}
+	}
+	free( name );
+
+	return error;
+}
+
+static int get_audio( mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples )
+{
+	mlt_filter filter = mlt_frame_pop_audio( frame );
+	private_data *pdata = filter->child;
+	mlt_properties frame_properties = MLT_FRAME_PROPERTIES( frame );
+	uint64_t hash = ( uint64_t ) mlt_properties_get_int64( frame_properties, "render_cache.hash" );
+	mlt_position position = mlt_properties_get_position( frame_properties, "render_cache.position" );
+	audio_header want = { .magic = "MLTa", .request_format = *format, .request_frequency = *frequency,
+		.request_channels = *channels, .request_samples = *samples };
+	mlt_frame cached = NULL;
+	segment *s;
+	int error;
+
+	pthread_mutex_lock( &pdata->mutex );
+	s = get_segment( filter, hash );
+	if ( s )
+		cached = mlt_cache_get_frame( s->audio, position );
+	pthread_mutex_unlock( &pdata->mutex );
+
+	if ( cached )
+	{
+		mlt_properties properties = MLT_FRAME_PROPERTIES( cached );
+		if ( mlt_properties_get_int( properties, "render_cache.format" ) == want.request_format
+			&& mlt_properties_get_int( properties, "render_cache.frequency" ) == want.request_frequency
+			&& mlt_properties_get_int( properties, "render_cache.channels" ) == want.request_channels
+			&& mlt_properties_get_int( properties, "render_cache.samples" ) == want.request_samples )
+		{
+			int size = 0;
+			void *data = mlt_properties_get_data( properties, "audio", &size );
+			*format = mlt_properties_get_int( properties, "audio_format" );
+			*frequency = mlt_properties_get_int( properties, "audio_frequency" );
+			*channels = mlt_properties_get_int( properties, "audio_channels" );
+			*samples = mlt_properties_get_int( properties, "audio_samples" );
+			*buffer = mlt_pool_alloc( size );
+			memcpy( *buffer, data, size );
+			mlt_frame_set_audio( frame, *buffer, *format, size, mlt_pool_release );
+			mlt_frame_close( cached );
+			return 0;
+		}
+		mlt_frame_close( cached );
+	}
+
+	char *name = file_name( filter, hash, position, "audio" );
+	if ( name )
+	{
+		audio_header header;
+		int size = 0;
+		void *data = read_file( name, &header, sizeof( header ), check_audio, &want, &size );
+
+		if ( data )
+		{
+			*format = header.format;
+			*frequency = header.frequency;
+			*channels = header.channels;
+			*samples = header.samples;
+			*buffer = data;
+			mlt_frame_set_audio( frame, *buffer, *format, size, mlt_pool_release );
+			free( name );
+			return 0;
+		}
+	}
+
+	error = mlt_frame_get_audio( frame, buffer, format, frequency, channels, samples );
+	if ( !error && *buffer )
+	{
+		int size = mlt_audio_format_size( *format, *samples, *channels );
+
+		pthread_mutex_lock( &pdata->mutex );
+		s = get_segment( filter, hash );
+		if ( s )
+		{
+			mlt_frame carrier = mlt_frame_init( NULL );
+			mlt_properties properties = MLT_FRAME_PROPERTIES( carrier );
+			mlt_properties_set_position( properties, "original_position", position );
+			mlt_properties_set_data( properties, "audio", *buffer, size, NULL, NULL );
+			mlt_properties_set_int( properties, "audio_format", *format );
+			mlt_properties_set_int( properties, "audio_frequency", *frequency );
+			mlt_properties_set_int( properties, "audio_channels", *channels );
+			mlt_properties_set_int( properties, "audio_samples", *samples );
+			mlt_properties_set_int( properties, "render_cache.format", want.request_format );
+			mlt_properties_set_int( properties, "render_cache.frequency", want.request_frequency );
+			mlt_properties_set_int( properties, "render_cache.channels", want.request_channels );
+			mlt_properties_set_int( properties, "render_cache.samples", want.request_samples );
+			mlt_cache_put_frame( s->audio, carrier );
+			mlt_frame_close( carrier );
+		}
+		pthread_mutex_unlock( &pdata->mutex );
+
+		if ( name )
+		{
+			audio_header header = { "MLTa", want.request_format, want.request_frequency, want.request_channels,
+				want.request_samples, *format, *frequency, *channels, *samples, size };
+			write_file( filter, name, &header, sizeof( header ), *buffer, size, NULL, 0 );
+		}
+	}
+	free( name );
+
+	return error;
+}
+
+/** Filter processing.
+*/
+
+static mlt_frame process( mlt_filter filter, mlt_frame frame )
+{
+	uint64_t hash = 0;
+	mlt_position origin = 0;
+
+	if ( !segment_key( filter, mlt_frame_get_position( frame ), &hash, &origin ) )
+	{
+		mlt_properties properties = MLT_FRAME_PROPERTIES( frame );
+		mlt_properties_set_int64( properties, "render_cache.hash", ( int64_t ) hash );
+		mlt_properties_set_position( properties, "render_cache.position", origin );
+		mlt_frame_push_service( frame, filter );
+		mlt_frame_push_get_image( frame, get_image );
+		mlt_frame_push_audio( frame, filter );
+		mlt_frame_push_audio( frame, get_audio );
+	}
+	return frame;
+}
+
+static void filter_close( mlt_filter filter )
+{
+	private_data *pdata = filter->child;
+	int i;
+
+	if ( pdata )
+	{
+		for ( i = 0; i < MAX_SEGMENTS; i++ )
+		{
+			mlt_cache_close( pdata->segments[ i ].images );
+			mlt_cache_close( pdata->segments[ i ].audio );
+		}
+		mlt_properties_close( pdata->results );
+		pthread_mutex_destroy( &pdata->mutex );
+		free( pdata->directory );
+		free( pdata );
+	}
+	filter->child = NULL;
+	filter->close = NULL;
+	filter->parent.close = NULL;
+	mlt_service_close( &filter->parent );
+}
+
+/** Constructor for the filter.
+*/
+
+mlt_filter filter_render_cache_init( mlt_profile profile, mlt_service_type type, const char *id, char *arg )
+{
+	mlt_filter filter = mlt_filter_new();
+	private_data *pdata = calloc( 1, sizeof( private_data ) );
+
+	if ( filter && pdata )
+	{
+		mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
+		pthread_mutex_init( &pdata->mutex, NULL );
+		pdata->results = mlt_properties_new();
+		mlt_properties_set( properties, "resource", arg );
+		mlt_properties_set_int( properties, "frames", 25 );
+		mlt_properties_set_int( properties, "segments", 4 );
+		mlt_properties_set_int( properties, "disk_size", 2048 );
+		filter->child = pdata;
+		filter->close = filter_close;
+		filter->process = process;
+	}
+	else
+	{
+		mlt_filter_close( filter );
+		free( pdata );
+		filter = NULL;
+	}
+	return filter;
+}
@@ -187,6 +187,13 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 			interps = mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "interpolation" );
 			mlt_properties_set( properties, "rescale.interp", interps );
 		}
+
+		// Use the cheapest interpolation when a real-time consumer is behind
+		if ( mlt_frame_get_quality( frame ) > mlt_quality_full && strcmp( interps, "none" ) )
+		{
+			mlt_properties_set( properties, "rescale.interp", "nearest" );
+			interps = mlt_properties_get( properties, "rescale.interp" );
+		}
 	
 		// If meta.media.width/height exist, we want that as minimum information
 		if ( mlt_properties_get_int( properties, "meta.media.width" ) )
@@ -217,8 +224,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 		if ( scaler_method == filter_scale )
 			*format = mlt_image_yuv422;
 
-		// Get the image as requested
+		// Get the image as requested; scaling replaces it, so keep what is known about it
 		mlt_frame_get_image( frame, image, format, &iwidth, &iheight, writable );
+		mlt_frame_keep_image_facts( frame );
 
 		// Get rescale interpretation again, in case the producer wishes to override scaling
 		interps = mlt_properties_get( properties, "rescale.interp" );
@@ -228,6 +236,13 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 			mlt_log_debug( MLT_FILTER_SERVICE( filter ), "%dx%d -> %dx%d (%s) %s\n",
 				iwidth, iheight, owidth, oheight, mlt_image_format_name( *format ), interps );
 
+			// Note what is known about the image before scaling replaces it
+			mlt_rect content;
+			int has_content = mlt_frame_get_image_content( frame, &content );
+			int opacity = mlt_frame_get_image_opacity( frame );
+			mlt_color color;
+			int solid = mlt_frame_get_image_solid( frame, &color );
+
 			// If valid colorspace
 			if ( *format == mlt_image_yuv422 || *format == mlt_image_rgb ||
 			     *format == mlt_image_rgba )
@@ -247,6 +262,24 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 			mlt_properties_get_data( properties, "alpha", &alpha_size );
 			if ( alpha_size > 0 && alpha_size != ( owidth * oheight ) && alpha_size != ( owidth * ( oheight + 1 ) ) )
 				scale_alpha( frame, iwidth, iheight, owidth, oheight );
+
+			// Scale the region with content, widened by the reach of the interpolation
+			if ( has_content && *width == owidth && *height == oheight )
+			{
+				double sx = (double) owidth / iwidth;
+				double sy = (double) oheight / iheight;
+				content.x = floor( content.x * sx ) - 4;
+				content.y = floor( content.y * sy ) - 4;
+				content.w = ceil( content.w * sx ) + 8;
+				content.h = ceil( content.h * sy ) + 8;
+				mlt_frame_set_image_content( frame, content );
+			}
+
+			// Scaling an image of uniform colour or opacity keeps it uniform
+			if ( solid )
+				mlt_frame_set_image_solid( frame, color );
+			else if ( opacity >= 0 )
+				mlt_frame_set_image_opacity( frame, opacity );
 		}
 		else
 		{
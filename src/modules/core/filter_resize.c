@@ -150,6 +150,9 @@ static uint8_t *frame_resize_image( mlt_frame frame, int owidth, int oheight, ml
 	if ( iwidth < owidth || iheight < oheight )
 	{
 		uint8_t alpha_value = mlt_properties_get_int( properties, "resize_alpha" );
+		mlt_rect content = { 0, 0, iwidth, iheight, 1.0 };
+		mlt_frame_get_image_content( frame, &content );
+
 		// Create the output image
 		uint8_t *output = mlt_pool_alloc( owidth * ( oheight + 1 ) * bpp );
 
@@ -160,11 +163,24 @@ static uint8_t *frame_resize_image( mlt_frame frame, int owidth, int oheight, ml
 		mlt_frame_set_image( frame, output, owidth * ( oheight + 1 ) * bpp, mlt_pool_release );
 
 		// We should resize the alpha too
+		int transparent = alpha_value == 0 && format == mlt_image_rgba;
 		if ( format != mlt_image_rgba && alpha && alpha_size >= iwidth * iheight )
 		{
 			alpha = resize_alpha( alpha, owidth, oheight, iwidth, iheight, alpha_value );
 			if ( alpha )
 				mlt_frame_set_alpha( frame, alpha, owidth * oheight, mlt_pool_release );
+			transparent = alpha && alpha_value == 0;
+		}
+
+		// Tell transitions that the padding is transparent, placing the content as resize_image() does
+		if ( transparent && iwidth <= owidth && iheight <= oheight )
+		{
+			int offset_x = ( owidth - iwidth ) / 2;
+			if ( bpp == 2 )
+				offset_x -= offset_x % 2;
+			content.x += offset_x;
+			content.y += ( oheight - iheight ) / 2;
+			mlt_frame_set_image_content( frame, content );
 		}
 
 		// Return the output
@@ -220,7 +236,11 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	// Hmmm...
 	char *rescale = mlt_properties_get( properties, "rescale.interp" );
 	if ( rescale != NULL && !strcmp( rescale, "none" ) )
-		return mlt_frame_get_image( frame, image, format, width, height, writable );
+	{
+		error = mlt_frame_get_image( frame, image, format, width, height, writable );
+		mlt_frame_keep_image_facts( frame );
+		return error;
+	}
 
 	if ( mlt_properties_get_int( properties, "distort" ) == 0 )
 	{
@@ -280,6 +300,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	}
 	error = mlt_frame_get_image( frame, image, format, &owidth, &oheight, writable );
 
+	// Padding replaces the image, so what is known about it stays true until then
+	mlt_frame_keep_image_facts( frame );
+
 	if ( error == 0 && *image && *format != mlt_image_yuv420p )
 	{
 		*image = frame_resize_image( frame, *width, *height, *format );
@@ -109,19 +109,17 @@ static int producer_get_image( mlt_frame frame, uint8_t **buffer, mlt_image_form
 		int i = *width * *height + 1;
 		int bpp;
 
-		// Allocate the image
+		// Allocate the image, which is shared by all the frames until it changes
 		size = mlt_image_format_size( *format, *width, *height, &bpp );
-		uint8_t *p = image = mlt_pool_alloc( size );
+		uint8_t *p = image = mlt_image_shared_alloc( size );
 
 		// Update the producer
-		mlt_properties_set_data( producer_props, "image", image, size, mlt_pool_release, NULL );
+		mlt_properties_set_data( producer_props, "image", image, size, mlt_image_shared_release, NULL );
 		mlt_properties_set_int( producer_props, "_width", *width );
 		mlt_properties_set_int( producer_props, "_height", *height );
 		mlt_properties_set_int( producer_props, "_format", *format );
 		mlt_properties_set( producer_props, "_resource", now );
 
-		mlt_service_unlock( MLT_PRODUCER_SERVICE( producer ) );
-
 		switch ( *format )
 		{
 		case mlt_image_yuv420p:
@@ -188,35 +186,37 @@ static int producer_get_image( mlt_frame frame, uint8_t **buffer, mlt_image_form
 			mlt_log_error( MLT_PRODUCER_SERVICE( producer ),
 				"invalid image format %s\n", mlt_image_format_name( *format ) );
 		}
-	}
-	else
-	{
-		mlt_service_unlock( MLT_PRODUCER_SERVICE( producer ) );
+
+		// Create the alpha channel
+		uint8_t *alpha = NULL;
+		int alpha_size = 0;
+		if ( color.a < 255 || *format == mlt_image_rgba )
+		{
+			alpha_size = *width * *height;
+			alpha = mlt_image_shared_alloc( alpha_size );
+			if ( alpha )
+				memset( alpha, color.a, alpha_size );
+			else
+				alpha_size = 0;
+		}
+		mlt_properties_set_data( producer_props, "alpha", alpha, alpha_size, mlt_image_shared_release, NULL );
 	}
 
-	// Create the alpha channel
+	// Share our image and alpha with the frame; they are copied only if a filter writes to them
 	int alpha_size = 0;
-	uint8_t *alpha = NULL;
-
-	// Initialise the alpha
-	if (color.a < 255 || *format == mlt_image_rgba) {
-		alpha_size = *width * *height;
-		alpha = mlt_pool_alloc( alpha_size );
-		if ( alpha )
-			memset( alpha, color.a, alpha_size );
-		else
-			alpha_size = 0;
+	uint8_t *alpha = mlt_properties_get_data( producer_props, "alpha", &alpha_size );
+	if ( buffer && image && size > 0 )
+	{
+		*buffer = image;
+		mlt_frame_set_image_shared( frame, image, size );
 	}
+	if ( alpha )
+		mlt_frame_set_alpha_shared( frame, alpha, alpha_size );
+	if ( *format != mlt_image_movit && *format != mlt_image_opengl_texture )
+		mlt_frame_set_image_solid( frame, color );
 
-	// Clone our image
-	if (buffer && image && size > 0) {
-		*buffer = mlt_pool_alloc( size );
-		memcpy( *buffer, image, size );
-	}
+	mlt_service_unlock( MLT_PRODUCER_SERVICE( producer ) );
 
-	// Now update properties so we free the copy after
-	mlt_frame_set_image( frame, *buffer, size, mlt_pool_release );
-	mlt_frame_set_alpha( frame, alpha, alpha_size, mlt_pool_release );
 	mlt_properties_set_double( properties, "aspect_ratio", mlt_properties_get_double( producer_props, "aspect_ratio" ) );
 	mlt_properties_set_int( properties, "meta.media.width", *width );
 	mlt_properties_set_int( properties, "meta.media.height", *height );
@@ -113,10 +113,9 @@ static int producer_get_image( mlt_frame frame, uint8_t **buffer, mlt_image_form
 	// Set the values obtained on the frame
 	if ( *buffer != NULL )
 	{
-		uint8_t *image = mlt_pool_alloc( size );
-		memcpy( image, *buffer, size );
-		*buffer = image;
-		mlt_frame_set_image( frame, *buffer, size, mlt_pool_release );
+		// Share the held image; it is copied only if a filter writes to it
+		*buffer = mlt_frame_share_image( real_frame, &size );
+		mlt_frame_set_image_shared( frame, *buffer, size );
 	}
 	else
 	{
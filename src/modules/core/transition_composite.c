@@ -214,6 +214,22 @@ static void composite_line_yuv_xor( uint8_t *dest, uint8_t *src, int width, uint
 	}
 }
 
+/** Fill a destination line with a source line of one opaque colour, as composite_line_yuv() would at full weight
+*/
+
+static void composite_line_yuv_fill( uint8_t *dest, uint8_t *src, int width, uint8_t *alpha_b, uint8_t *alpha_a, int weight, uint16_t *luma, int soft, uint32_t step )
+{
+	uint8_t pair[ 4 ] = { src[ 0 ], src[ 1 ], width > 1 ? src[ 2 ] : 0, width > 1 ? src[ 3 ] : 0 };
+	register int j;
+
+	for ( j = 0; j < width - 1; j += 2 )
+		memcpy( dest + j * 2, pair, 4 );
+	if ( width % 2 )
+		memcpy( dest + j * 2, pair, 2 );
+	if ( alpha_a )
+		memset( alpha_a, 255, width );
+}
+
 struct sliced_composite_desc
 {
 	int height_src;
@@ -262,7 +278,7 @@ static int sliced_composite_proc( int id, int idx, int jobs, void* cookie )
 /** Composite function.
 */
 
-static int composite_yuv( uint8_t *p_dest, int width_dest, int height_dest, uint8_t *p_src, int width_src, int height_src, uint8_t *alpha_b, uint8_t *alpha_a, const struct geometry_s *geometry, int field, uint16_t *p_luma, double softness, composite_line_fn line_fn, int sliced )
+static int composite_yuv( uint8_t *p_dest, int width_dest, int height_dest, uint8_t *p_src, int width_src, int height_src, uint8_t *alpha_b, uint8_t *alpha_a, const struct geometry_s *geometry, int field, uint16_t *p_luma, double softness, composite_line_fn line_fn, int sliced, const mlt_rect *content )
 {
 	int ret = 0;
 	int i;
@@ -330,6 +346,25 @@ static int composite_yuv( uint8_t *p_dest, int width_dest, int height_dest, uint
 	if ( y + height_src > height_dest )
 		height_src = height_dest - y;
 
+	// crop overlay to where it is not transparent, by even amounts to keep the chroma and field alignment
+	if ( content && x_src >= 0 && y_src >= 0 )
+	{
+		int left = MAX( x_src, (int) floor( content->x ) ) - x_src;
+		int top = MAX( y_src, (int) floor( content->y ) ) - y_src;
+		int right = MIN( x_src + width_src, (int) ceil( content->x + content->w ) ) - x_src;
+		int bottom = MIN( y_src + height_src, (int) ceil( content->y + content->h ) ) - y_src;
+		left -= left % 2;
+		top -= top % 2;
+		if ( right <= left || bottom <= top )
+			return ret;
+		x += left;
+		x_src += left;
+		width_src = right - left;
+		y += top;
+		y_src += top;
+		height_src = bottom - top;
+	}
+
 	// offset pointer into overlay buffer based on cropping
 	p_src += x_src * bpp + y_src * stride_src;
 
@@ -622,7 +657,7 @@ static uint16_t* get_luma( mlt_transition self, mlt_properties properties, int w
 /** Get the properly sized image from b_frame.
 */
 
-static int get_b_frame_image( mlt_transition self, mlt_frame b_frame, uint8_t **image, int *width, int *height, struct geometry_s *geometry )
+static int get_b_frame_image( mlt_transition self, mlt_frame b_frame, uint8_t **image, int *width, int *height, struct geometry_s *geometry, int writable )
 {
 	int error = 0;
 	mlt_image_format format = mlt_image_yuv422;
@@ -745,7 +780,7 @@ static int get_b_frame_image( mlt_transition self, mlt_frame b_frame, uint8_t **
 // fprintf(stderr, "%s: scaled %dx%d norm %dx%d resize %dx%d\n", __FILE__,
 // geometry->sw, geometry->sh, geometry->nw, geometry->nh, *width, *height);
 
-	error = mlt_frame_get_image( b_frame, image, &format, width, height, 1 );
+	error = mlt_frame_get_image( b_frame, image, &format, width, height, writable );
 
 	// composite_yuv uses geometry->sw to determine source stride, which
 	// should equal the image width if not using crop property.
@@ -862,6 +897,30 @@ static void composite_calculate( mlt_transition self, struct geometry_s *result,
 /** Get the image.
 */
 
+/** Determine if the b frame fills the whole a frame in both fields with nothing to mix.
+*/
+
+static int covers_frame( mlt_transition self, struct geometry_s *result, double next_field_position, mlt_properties a_props )
+{
+	mlt_properties properties = MLT_TRANSITION_PROPERTIES( self );
+	struct geometry_s next = *result;
+	int covers = result->item.x == 0 && result->item.y == 0 && result->item.w == result->nw && result->item.h == result->nh &&
+		result->item.o == 100 && !mlt_properties_get_int( properties, "titles" ) &&
+		!mlt_properties_get( properties, "crop" ) && !mlt_properties_get_int( properties, "crop_to_fill" ) &&
+		!mlt_properties_get( properties, "operator" ) && !mlt_properties_get( properties, "luma" ) &&
+		!mlt_properties_get( properties, "alpha_a" ) && !mlt_properties_get( properties, "alpha_b" );
+
+	// The geometry can change between fields
+	if ( covers && !mlt_properties_get_int( a_props, "consumer_deinterlace" ) && !mlt_properties_get_int( properties, "progressive" ) )
+	{
+		mlt_service_lock( MLT_TRANSITION_SERVICE( self ) );
+		composite_calculate( self, &next, next_field_position );
+		mlt_service_unlock( MLT_TRANSITION_SERVICE( self ) );
+		covers = next.item.x == 0 && next.item.y == 0 && next.item.w == next.nw && next.item.h == next.nh && next.item.o == 100;
+	}
+	return covers;
+}
+
 static int transition_get_image( mlt_frame a_frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable )
 {
 	// Get the b frame from the stack
@@ -944,10 +1003,28 @@ static int transition_get_image( mlt_frame a_frame, uint8_t **image, mlt_image_f
 			return 0;
 		}
 
+		// Optimisation - a b frame known to be opaque that covers the whole a frame hides it,
+		// so use its image without fetching the a frame image
+		if ( a_frame != b_frame && *width > 0 && *height > 0 && covers_frame( self, &result, position + delta * length, a_props ) )
+		{
+			double aspect_ratio = mlt_frame_get_aspect_ratio( b_frame );
+			mlt_image_format format_b = mlt_image_yuv422;
+			if ( get_b_frame_image( self, b_frame, &image_b, &width_b, &height_b, &result, 0 ) &&
+				 width_b == *width && height_b == *height && mlt_frame_get_image_opacity( b_frame ) == 255 &&
+				 !mlt_frame_get_image( b_frame, &image_b, &format_b, &width_b, &height_b, 1 ) )
+			{
+				*image = image_b;
+				if ( !mlt_frame_is_test_card( a_frame ) )
+					mlt_frame_replace_image( a_frame, image_b, *format, *width, *height );
+				mlt_properties_set_double( a_props, "aspect_ratio", aspect_ratio );
+				return 0;
+			}
+		}
+
 		if ( a_frame == b_frame )
 		{
 			double aspect_ratio = mlt_frame_get_aspect_ratio( b_frame );
-			get_b_frame_image( self, b_frame, &image_b, &width_b, &height_b, &result );
+			get_b_frame_image( self, b_frame, &image_b, &width_b, &height_b, &result, 1 );
 			alpha_b = mlt_frame_get_alpha( b_frame );
 			mlt_properties_set_double( a_props, "aspect_ratio", aspect_ratio );
 		}
@@ -975,20 +1052,27 @@ static int transition_get_image( mlt_frame a_frame, uint8_t **image, mlt_image_f
 		}
 
 		// Special case for titling...
+		mlt_quality quality = mlt_frame_get_quality( a_frame );
 		if ( mlt_properties_get_int( properties, "titles" ) )
 		{
-			if ( mlt_properties_get( b_props, "rescale.interp" ) == NULL )
+			// Leave the scaling to the consumer when it is behind
+			if ( mlt_properties_get( b_props, "rescale.interp" ) == NULL && quality == mlt_quality_full )
 				mlt_properties_set( b_props, "rescale.interp", "hyper" );
 			width_b = mlt_properties_get_int( a_props, "dest_width" );
 			height_b = mlt_properties_get_int( a_props, "dest_height" );
 		}
 
 		if ( *image != image_b && ( image_b ||
-			get_b_frame_image( self, b_frame, &image_b, &width_b, &height_b, &result ) ) )
+			get_b_frame_image( self, b_frame, &image_b, &width_b, &height_b, &result, mlt_properties_get( properties, "alpha_b" ) != NULL ) ) &&
+			// Optimisation - nothing to composite if the b frame is known to be transparent
+			!( mlt_frame_get_image_opacity( b_frame ) == 0 && !mlt_properties_get( properties, "operator" ) &&
+			   !mlt_properties_get( properties, "alpha_a" ) && !mlt_properties_get( properties, "alpha_b" ) ) )
 		{
+			// Composite both fields in one pass in draft quality
 			int progressive = 
 					mlt_properties_get_int( a_props, "consumer_deinterlace" ) ||
-					mlt_properties_get_int( properties, "progressive" );
+					mlt_properties_get_int( properties, "progressive" ) ||
+					quality == mlt_quality_draft;
 			int top_field_first = mlt_properties_get_int( a_props, "top_field_first" );
 			int field;
 			int sliced = mlt_properties_get_int( properties, "sliced_composite" );
@@ -1014,6 +1098,17 @@ static int transition_get_image( mlt_frame a_frame, uint8_t **image, mlt_image_f
 					line_fn = composite_line_yuv_xor;
 			}
 
+			// A b frame known to be one opaque colour can be filled instead of blended at full opacity
+			mlt_color color;
+			int solid = line_fn == composite_line_yuv && !luma_bitmap &&
+				!mlt_properties_get( properties, "alpha_a" ) && !mlt_properties_get( properties, "alpha_b" ) &&
+				mlt_frame_get_image_solid( b_frame, &color ) && color.a == 255;
+
+			// Only the normal operator leaves the a frame as it is where the b frame is transparent
+			mlt_rect content;
+			int has_content = line_fn == composite_line_yuv && alpha_b && !mlt_properties_get( properties, "alpha_b" ) &&
+				!mlt_properties_get( properties, "crop" ) && mlt_frame_get_image_content( b_frame, &content );
+
 			// Allow the user to completely obliterate the alpha channels from both frames
 			if ( mlt_properties_get( properties, "alpha_a" ) && alpha_a )
 				memset( alpha_a, mlt_properties_get_int( properties, "alpha_a" ), *width * *height );
@@ -1071,7 +1166,8 @@ static int transition_get_image( mlt_frame a_frame, uint8_t **image, mlt_image_f
 
 				// Composite the b_frame on the a_frame
 				mlt_log_timings_begin()
-				composite_yuv( *image, *width, *height, image_b, width_b, height_b, alpha_b, alpha_a, &result, field_id, luma_bitmap, luma_softness, line_fn, sliced );
+				composite_yuv( *image, *width, *height, image_b, width_b, height_b, alpha_b, alpha_a, &result, field_id, luma_bitmap, luma_softness,
+					solid && result.item.o == 100 ? composite_line_yuv_fill : line_fn, sliced, has_content ? &content : NULL );
 				mlt_log_timings_end( NULL, "composite_yuv" )
 			}
 		}
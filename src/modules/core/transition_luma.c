@@ -38,6 +38,16 @@ static inline int is_opaque( uint8_t *alpha_channel, int width, int height )
 	return 1;
 }
 
+/** Determine if a frame is opaque, using its known opacity (or -1) before scanning the alpha.
+*/
+
+static int frame_is_opaque( int opacity, uint8_t *alpha_channel, int width, int height )
+{
+	if ( opacity >= 0 )
+		return opacity == 255;
+	return !alpha_channel || is_opaque( alpha_channel, width, height );
+}
+
 static inline float calculate_mix( float weight, float alpha )
 {
 	return weight * alpha / 255.f;
@@ -117,12 +127,38 @@ static inline int dissolve_yuv( mlt_frame frame, mlt_frame that, float weight, i
 
 	if ( mlt_properties_get( &frame->parent, "distort" ) )
 		mlt_properties_set( &that->parent, "distort", mlt_properties_get( &frame->parent, "distort" ) );
+	// The opacity and colour are only known before the image is requested writable
+	mlt_frame_get_image( frame, &p_dest, &format, &width, &height, 0 );
+	int opacity_dst = mlt_frame_get_image_opacity( frame );
+	mlt_color color_dst, color_src;
+	int solid_dst = mlt_frame_get_image_solid( frame, &color_dst ) && color_dst.a == 255;
 	mlt_frame_get_image( frame, &p_dest, &format, &width, &height, 1 );
 	alpha_dst = mlt_frame_get_alpha( frame );
 	mlt_frame_get_image( that, &p_src, &format, &width_src, &height_src, 0 );
 	alpha_src = mlt_frame_get_alpha( that );
-	int is_translucent = ( alpha_dst && !is_opaque(alpha_dst, width, height) )
-	                  || ( alpha_src && !is_opaque(alpha_src, width_src, height_src) );
+	int is_translucent = !frame_is_opaque( opacity_dst, alpha_dst, width, height )
+	                  || !frame_is_opaque( mlt_frame_get_image_opacity( that ), alpha_src, width_src, height_src );
+
+	// Mixing two opaque colours gives one colour, so mix a run of pixels the way each line
+	// would be mixed and fill with it
+	if ( solid_dst && width >= 8 && width_src == width && height_src == height &&
+	     mlt_frame_get_image_solid( that, &color_src ) && color_src.a == 255 )
+	{
+		uint8_t run_dst[ 16 ], run_src[ 16 ], run_alpha_dst[ 8 ], run_alpha_src[ 8 ];
+		for ( i = 0; i < 16; i ++ )
+		{
+			run_dst[ i ] = p_dest[ i % 4 ];
+			run_src[ i ] = p_src[ i % 4 ];
+		}
+		memset( run_alpha_dst, 255, sizeof( run_alpha_dst ) );
+		memset( run_alpha_src, 255, sizeof( run_alpha_src ) );
+		composite_line_yuv( run_dst, run_src, 8, alpha_src ? run_alpha_src : NULL, alpha_dst ? run_alpha_dst : NULL, mix, NULL, 0, 0 );
+		for ( i = 0; i < width * height / 2; i ++ )
+			memcpy( p_dest + i * 4, run_dst, 4 );
+		if ( width * height % 2 )
+			memcpy( p_dest + width * height * 2 - 2, run_dst, 2 );
+		return ret;
+	}
 
 	// Pick the lesser of two evils ;-)
 	width_src = width_src > width ? width : width_src;
@@ -204,6 +240,9 @@ static void luma_composite( mlt_frame a_frame, mlt_frame b_frame, int luma_width
 
 	if ( mlt_properties_get( &a_frame->parent, "distort" ) )
 		mlt_properties_set( &b_frame->parent, "distort", mlt_properties_get( &a_frame->parent, "distort" ) );
+	// The opacity is only known before the image is requested writable
+	mlt_frame_get_image( a_frame, &p_dest, &format_dest, &width_dest, &height_dest, 0 );
+	int opacity_dest = mlt_frame_get_image_opacity( a_frame );
 	mlt_frame_get_image( a_frame, &p_dest, &format_dest, &width_dest, &height_dest, 1 );
 	alpha_dest = mlt_frame_get_alpha( a_frame );
 	mlt_frame_get_image( b_frame, &p_src, &format_src, &width_src, &height_src, 0 );
@@ -212,8 +251,8 @@ static void luma_composite( mlt_frame a_frame, mlt_frame b_frame, int luma_width
 	if ( *width == 0 || *height == 0 )
 		return;
 
-	int is_translucent = ( alpha_dest && !is_opaque(alpha_dest, width_dest, height_dest) )
-	                  || ( alpha_src  && !is_opaque(alpha_src,  width_src,  height_src ) );
+	int is_translucent = !frame_is_opaque( opacity_dest, alpha_dest, width_dest, height_dest )
+	                  || !frame_is_opaque( mlt_frame_get_image_opacity( b_frame ), alpha_src, width_src, height_src );
 
 	// Pick the lesser of two evils ;-)
 	width_src = width_src > width_dest ? width_dest : width_src;
@@ -20,6 +20,7 @@
 #include <framework/mlt_transition.h>
 #include <framework/mlt_frame.h>
 #include <framework/mlt_log.h>
+#include <framework/mlt_pool.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,38 +31,51 @@
 #define MAX_SAMPLES  (192000)
 #define SAMPLE_BYTES(samples, channels) ((samples) * (channels) * sizeof(float))
 #define MAX_BYTES    SAMPLE_BYTES( MAX_SAMPLES, MAX_CHANNELS )
+#define MAX_INPUTS   (64)
+#define BLOCK_SAMPLES (256)
 
 typedef struct transition_mix_s
 {
 	mlt_transition parent;
-	float src_buffer[MAX_SAMPLES *  MAX_CHANNELS];
-	float dest_buffer[MAX_SAMPLES * MAX_CHANNELS];
+	float *src_buffer;
+	float *dest_buffer;
 	int src_buffer_count;
 	int dest_buffer_count;
 	mlt_position previous_frame_a;
 	mlt_position previous_frame_b;
 } *transition_mix;
 
+/** The audio of one frame to mix and the transition that mixes it in.
+ */
+
+typedef struct
+{
+	mlt_transition transition;
+	mlt_frame frame;
+	float *buffer;
+	int frequency;
+	int channels;
+	int samples;
+} mix_input;
+
+static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples );
+
 static void mix_audio( double weight_start, double weight_end, float *buffer_a,
 	float *buffer_b, int channels_a, int channels_b, int channels_out, int samples )
 {
 	int i, j;
-	double a, b, v;
 
 	// Compute a smooth ramp over start to end
-	double mix = weight_start;
-	double mix_step = ( weight_end - weight_start ) / samples;
+	float mix_start = weight_start;
+	float mix_step = ( weight_end - weight_start ) / samples;
 
 	for ( i = 0; i < samples; i++ )
 	{
+		float mix = mix_start + mix_step * i;
+		float *a = buffer_a + i * channels_a;
+		const float *b = buffer_b + i * channels_b;
 		for ( j = 0; j < channels_out; j++ )
-		{
-			a = (double) buffer_a[ i * channels_a + j ];
-			b = (double) buffer_b[ i * channels_b + j ];
-			v = mix * b + (1.0 - mix) * a;
-			buffer_a[ i * channels_a + j ] = v;
-		}
-		mix += mix_step;
+			a[j] = mix * b[j] + ( 1.0f - mix ) * a[j];
 	}
 }
 
@@ -69,21 +83,18 @@ static void sum_audio( double weight_start, double weight_end, float *buffer_a,
 	float *buffer_b, int channels_a, int channels_b, int channels_out, int samples )
 {
 	int i, j;
-	double a, b;
 
 	// Compute a smooth ramp over start to end
-	double mix = weight_start;
-	double mix_step = ( weight_end - weight_start ) / samples;
+	float mix_start = weight_start;
+	float mix_step = ( weight_end - weight_start ) / samples;
 
 	for ( i = 0; i < samples; i++ )
 	{
+		float mix = mix_start + mix_step * i;
+		float *a = buffer_a + i * channels_a;
+		const float *b = buffer_b + i * channels_b;
 		for ( j = 0; j < channels_out; j++ )
-		{
-			a = (double) buffer_a[ i * channels_a + j ];
-			b = (double) buffer_b[ i * channels_b + j ];
-			buffer_a[ i * channels_a + j ] = mix * b + a;
-		}
-		mix += mix_step;
+			a[j] += mix * b[j];
 	}
 }
 
@@ -113,33 +124,184 @@ static void combine_audio( double weight, float *buffer_a, float *buffer_b,
 	}
 }
 
-/** Get the audio.
-*/
+/** Mix a block of frames with a gain for each frame of each input.
+ *
+ * The output may be the same buffer as \p a. Inlining this with a constant
+ * channel count lets the compiler vectorise it.
+ */
 
-static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples )
+static inline void mix_block( float *out, const float *a, const float *b,
+	const float *gain_a, const float *gain_b, int channels, int samples )
 {
-	int error = 0;
+	int i, j;
 
-	// Get the b frame from the stack
-	mlt_frame frame_b = mlt_frame_pop_audio( frame_a );
+	for ( i = 0; i < samples; i++ )
+		for ( j = 0; j < channels; j++ )
+			out[ i * channels + j ] = a[ i * channels + j ] * gain_a[i] + b[ i * channels + j ] * gain_b[i];
+}
 
-	// Get the effect
-	mlt_transition transition = mlt_frame_pop_audio( frame_a );
+static int is_combine( mlt_transition transition )
+{
+	return mlt_properties_get_int( MLT_TRANSITION_PROPERTIES( transition ), "combine" );
+}
+
+/** Get the mix levels that the transition put on the b frame.
+ */
 
-	// Get the properties of the b frame
+static void get_mix_levels( mlt_transition transition, mlt_frame frame_b, double *mix_start, double *mix_end )
+{
 	mlt_properties b_props = MLT_FRAME_PROPERTIES( frame_b );
+	double level = mlt_properties_get_int( MLT_TRANSITION_PROPERTIES( transition ), "sum" ) ? 1.0 : 0.5;
+
+	*mix_start = *mix_end = level;
+	if ( mlt_properties_get( b_props, "audio.previous_mix" ) )
+		*mix_start = mlt_properties_get_double( b_props, "audio.previous_mix" );
+	if ( mlt_properties_get( b_props, "audio.mix" ) )
+		*mix_end = mlt_properties_get_double( b_props, "audio.mix" );
+	if ( mlt_properties_get_int( b_props, "audio.reverse" ) )
+	{
+		*mix_start = 1.0 - *mix_start;
+		*mix_end = 1.0 - *mix_end;
+	}
+}
 
-	transition_mix self = transition->child;
-	float *buffer_b, *buffer_a;
-	int frequency_b = *frequency, frequency_a = *frequency;
-	int channels_b = *channels, channels_a = *channels;
-	int samples_b = *samples, samples_a = *samples;
+/** Get the 32-bit float audio of an input, silenced if the frame asks for it.
+ */
 
-	// We can only mix interleaved 32-bit float.
-	*format = mlt_audio_f32le;
-	// Get the audio from our producers
-	mlt_frame_get_audio( frame_b, (void**) &buffer_b, format, &frequency_b, &channels_b, &samples_b );
-	mlt_frame_get_audio( frame_a, (void**) &buffer_a, format, &frequency_a, &channels_a, &samples_a );
+static void get_input_audio( mix_input *input, int frequency, int channels, int samples )
+{
+	mlt_properties properties = MLT_FRAME_PROPERTIES( input->frame );
+	mlt_audio_format format = mlt_audio_f32le;
+
+	input->buffer = NULL;
+	input->frequency = frequency;
+	input->channels = channels;
+	input->samples = samples;
+	mlt_frame_get_audio( input->frame, (void**) &input->buffer, &format, &input->frequency, &input->channels, &input->samples );
+
+	// I do not recall what these silent_audio properties are about.
+	int silent = mlt_properties_get_int( properties, "silent_audio" );
+	mlt_properties_set_int( properties, "silent_audio", 0 );
+	if ( silent && input->buffer )
+		memset( input->buffer, 0, SAMPLE_BYTES( input->samples, input->channels ) );
+}
+
+/** Determine whether the mix of a stack of transitions needs none of their buffered samples.
+ *
+ * This is the usual case of tracks that all give the requested number of
+ * samples, and then the mix is the same as one transition at a time.
+ */
+
+static int can_mix_directly( mix_input *inputs, int count, mix_input *a )
+{
+	int i;
+
+	if ( !a->buffer || a->channels < 1 || a->channels > MAX_CHANNELS )
+		return 0;
+	for ( i = 0; i < count; i++ )
+	{
+		transition_mix self = inputs[i].transition->child;
+		if ( !inputs[i].buffer || inputs[i].buffer == a->buffer || inputs[i].channels != a->channels ||
+			 inputs[i].samples != a->samples || self->src_buffer_count || self->dest_buffer_count ||
+			 is_combine( inputs[i].transition ) )
+			return 0;
+	}
+	return 1;
+}
+
+/** Mix all of the inputs into a new buffer for the A frame in one pass.
+ *
+ * The innermost transition, the last input, mixes first. Each block of frames
+ * stays in the cache while every input is added to it.
+ */
+
+static int mix_directly( mix_input *inputs, int count, mix_input *a )
+{
+	int channels = a->channels;
+	int samples = a->samples;
+	int size = SAMPLE_BYTES( samples, channels );
+	float *out = mlt_pool_alloc( size );
+	float mix_start[ MAX_INPUTS ], mix_step[ MAX_INPUTS ];
+	float gain_a[ BLOCK_SAMPLES ], gain_b[ BLOCK_SAMPLES ];
+	int sum[ MAX_INPUTS ];
+	int i, j, offset;
+
+	if ( !out )
+		return 1;
+
+	for ( i = 0; i < count; i++ )
+	{
+		double start, end;
+		get_mix_levels( inputs[i].transition, inputs[i].frame, &start, &end );
+		mix_start[i] = start;
+		mix_step[i] = samples > 0 ? ( end - start ) / samples : 0.0;
+		sum[i] = mlt_properties_get_int( MLT_TRANSITION_PROPERTIES( inputs[i].transition ), "sum" );
+	}
+
+	for ( offset = 0; offset < samples; offset += BLOCK_SAMPLES )
+	{
+		int n = MIN( BLOCK_SAMPLES, samples - offset );
+		float *dest = out + offset * channels;
+
+		for ( i = count - 1; i >= 0; i-- )
+		{
+			const float *src = i == count - 1 ? a->buffer + offset * channels : dest;
+			const float *b = inputs[i].buffer + offset * channels;
+
+			for ( j = 0; j < n; j++ )
+				gain_b[j] = mix_start[i] + mix_step[i] * ( offset + j );
+			if ( sum[i] )
+				for ( j = 0; j < n; j++ )
+					gain_a[j] = 1.0f;
+			else
+				for ( j = 0; j < n; j++ )
+					gain_a[j] = 1.0f - gain_b[j];
+
+			switch ( channels )
+			{
+			case 1:
+				mix_block( dest, src, b, gain_a, gain_b, 1, n );
+				break;
+			case 2:
+				mix_block( dest, src, b, gain_a, gain_b, 2, n );
+				break;
+			default:
+				mix_block( dest, src, b, gain_a, gain_b, channels, n );
+				break;
+			}
+		}
+	}
+
+	mlt_frame_set_audio( a->frame, out, mlt_audio_f32le, size, mlt_pool_release );
+	a->buffer = out;
+
+	for ( i = 0; i < count; i++ )
+	{
+		transition_mix self = inputs[i].transition->child;
+		self->previous_frame_a = mlt_frame_get_position( a->frame );
+		self->previous_frame_b = mlt_frame_get_position( inputs[i].frame );
+	}
+	return 0;
+}
+
+/** Mix the audio of one transition, buffering samples when the frames differ in length.
+ *
+ * \param input the b frame and its transition
+ * \param a the audio of the a frame, which receives the mixed audio
+ * \return true on error
+ */
+
+static int mix_buffered( mix_input *input, mix_input *a )
+{
+	mlt_transition transition = input->transition;
+	transition_mix self = transition->child;
+	mlt_frame frame_a = a->frame;
+	mlt_frame frame_b = input->frame;
+	mlt_properties b_props = MLT_FRAME_PROPERTIES( frame_b );
+	float *buffer_a = a->buffer, *buffer_b = input->buffer;
+	int channels_a = a->channels, channels_b = input->channels;
+	int samples_a = a->samples, samples_b = input->samples;
+	int samples, channels;
 
 	// Prevent dividing by zero.
 	if ( !channels_a || !channels_b || !buffer_a || !buffer_b )
@@ -147,22 +309,17 @@ static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_for
 
 	if ( buffer_b == buffer_a )
 	{
-		*samples = samples_b;
-		*channels = channels_b;
-		*buffer = buffer_b;
-		*frequency = frequency_b;
-		return error;
+		*a = *input;
+		a->frame = frame_a;
+		return 0;
 	}
 
-	// I do not recall what these silent_audio properties are about.
-	int silent = mlt_properties_get_int( MLT_FRAME_PROPERTIES( frame_a ), "silent_audio" );
-	mlt_properties_set_int( MLT_FRAME_PROPERTIES( frame_a ), "silent_audio", 0 );
-	if ( silent )
-		memset( buffer_a, 0, samples_a * channels_a * sizeof( float ) );
-	silent = mlt_properties_get_int( b_props, "silent_audio" );
-	mlt_properties_set_int( b_props, "silent_audio", 0 );
-	if ( silent )
-		memset( buffer_b, 0, samples_b * channels_b * sizeof( float ) );
+	if ( !self->src_buffer )
+		self->src_buffer = malloc( MAX_BYTES );
+	if ( !self->dest_buffer )
+		self->dest_buffer = malloc( MAX_BYTES );
+	if ( !self->src_buffer || !self->dest_buffer )
+		return 1;
 
 	// At this point we have two frames of audio with possibly differing sample
 	// counts. How to reconcile this?
@@ -171,15 +328,13 @@ static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_for
 	// The simple and stupid way to deal with different sample counts was to
 	// use the lesser of the two. This sounds good. You can #define SIMPLE_AND_STUPID
 	// and hear what it sounds like.
-	*samples = MIN(samples_a, samples_b);
-	*channels = MIN( MIN( channels_b, channels_a ), MAX_CHANNELS );
-	*frequency = frequency_a;
+	a->samples = MIN(samples_a, samples_b);
+	a->channels = MIN( MIN( channels_b, channels_a ), MAX_CHANNELS );
 	// Note this direct call to sum_audio() skips ramping and the alternative
 	// mixing methods.
-	sum_audio( 1, 1, buffer_a, buffer_b, channels_a, channels_b, *channels, *samples );
-	*buffer = buffer_a;
+	sum_audio( 1, 1, buffer_a, buffer_b, channels_a, channels_b, a->channels, a->samples );
 
-	return error;
+	return 0;
 #endif
 
 	// However, the simple and stupid approach drops samples. Over time, this
@@ -188,9 +343,8 @@ static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_for
 	// next iteration.
 
 	// determine number of samples to process
-	*samples = MIN( self->src_buffer_count + samples_b, self->dest_buffer_count + samples_a );
-	*channels = MIN( MIN( channels_b, channels_a ), MAX_CHANNELS );
-	*frequency = frequency_a;
+	samples = MIN( self->src_buffer_count + samples_b, self->dest_buffer_count + samples_a );
+	channels = MIN( MIN( channels_b, channels_a ), MAX_CHANNELS );
 
 	// Prevent src buffer overflow by discarding oldest samples.
 	samples_b = MIN( samples_b, MAX_SAMPLES * MAX_CHANNELS / channels_b );
@@ -235,47 +389,30 @@ static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_for
 	buffer_a = self->dest_buffer;
 
 	// Do the mixing.
-	if ( mlt_properties_get_int( MLT_TRANSITION_PROPERTIES(transition), "sum" ) )
-	{
-		double mix_start = 1.0, mix_end = 1.0;
-		if ( mlt_properties_get( b_props, "audio.previous_mix" ) )
-			mix_start = mlt_properties_get_double( b_props, "audio.previous_mix" );
-		if ( mlt_properties_get( b_props, "audio.mix" ) )
-			mix_end = mlt_properties_get_double( b_props, "audio.mix" );
-		if ( mlt_properties_get_int( b_props, "audio.reverse" ) )
-		{
-			mix_start = 1.0 - mix_start;
-			mix_end = 1.0 - mix_end;
-		}
-		sum_audio( mix_start, mix_end, buffer_a, buffer_b, channels_a, channels_b, *channels, *samples );
-	}
-	else if ( mlt_properties_get_int( MLT_TRANSITION_PROPERTIES(transition), "combine" ) )
+	if ( is_combine( transition ) )
 	{
 		double weight = 1.0;
 		if ( mlt_properties_get_int( MLT_FRAME_PROPERTIES( frame_a ), "meta.mixdown" ) )
 			weight = 1.0 - mlt_properties_get_double( MLT_FRAME_PROPERTIES( frame_a ), "meta.volume" );
-		combine_audio( weight, buffer_a, buffer_b, channels_a, channels_b, *channels, *samples );
+		combine_audio( weight, buffer_a, buffer_b, channels_a, channels_b, channels, samples );
 	}
 	else
 	{
-		double mix_start = 0.5, mix_end = 0.5;
-		if ( mlt_properties_get( b_props, "audio.previous_mix" ) )
-			mix_start = mlt_properties_get_double( b_props, "audio.previous_mix" );
-		if ( mlt_properties_get( b_props, "audio.mix" ) )
-			mix_end = mlt_properties_get_double( b_props, "audio.mix" );
-		if ( mlt_properties_get_int( b_props, "audio.reverse" ) )
-		{
-			mix_start = 1.0 - mix_start;
-			mix_end = 1.0 - mix_end;
-		}
-		mix_audio( mix_start, mix_end, buffer_a, buffer_b, channels_a, channels_b, *channels, *samples );
+		double mix_start, mix_end;
+		get_mix_levels( transition, frame_b, &mix_start, &mix_end );
+		if ( mlt_properties_get_int( MLT_TRANSITION_PROPERTIES(transition), "sum" ) )
+			sum_audio( mix_start, mix_end, buffer_a, buffer_b, channels_a, channels_b, channels, samples );
+		else
+			mix_audio( mix_start, mix_end, buffer_a, buffer_b, channels_a, channels_b, channels, samples );
 	}
 
 	// Copy the audio from the dest buffer into the frame.
-	bytes = SAMPLE_BYTES( *samples, *channels );
-	*buffer = mlt_pool_alloc( bytes );
-	memcpy( *buffer, buffer_a, bytes );
-	mlt_frame_set_audio( frame_a, *buffer, *format, bytes, mlt_pool_release );
+	bytes = SAMPLE_BYTES( samples, channels );
+	a->buffer = mlt_pool_alloc( bytes );
+	memcpy( a->buffer, buffer_a, bytes );
+	mlt_frame_set_audio( frame_a, a->buffer, mlt_audio_f32le, bytes, mlt_pool_release );
+	a->samples = samples;
+	a->channels = channels;
 
 	if ( mlt_properties_get_int( b_props, "_speed" ) == 0 )
 	{
@@ -289,13 +426,13 @@ static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_for
 		// the buffer. This part provides a time-based buffer limit.
 
 		// Determine the maximum amount of latency permitted in the buffer.
-		int max_latency = CLAMP( *frequency / 1000, 0, MAX_SAMPLES ); // samples in 1ms
+		int max_latency = CLAMP( a->frequency / 1000, 0, MAX_SAMPLES ); // samples in 1ms
 		// samples_b becomes the new target src buffer count.
-		samples_b = CLAMP( self->src_buffer_count - *samples, 0, max_latency );
+		samples_b = CLAMP( self->src_buffer_count - samples, 0, max_latency );
 		// samples_b becomes the number of samples to consume: difference between actual and the target.
 		samples_b = self->src_buffer_count - samples_b;
 		// samples_a becomes the new target dest buffer count.
-		samples_a = CLAMP( self->dest_buffer_count - *samples, 0, max_latency );
+		samples_a = CLAMP( self->dest_buffer_count - samples, 0, max_latency );
 		// samples_a becomes the number of samples to consume: difference between actual and the target.
 		samples_a = self->dest_buffer_count - samples_a;
 	}
@@ -313,6 +450,76 @@ static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_for
 			SAMPLE_BYTES( self->dest_buffer_count, channels_a ));
 	}
 
+	return 0;
+}
+
+/** Determine whether the A frame has another mix, which is not combine, next on its audio stack.
+ */
+
+static int has_stacked_mix( mlt_frame frame_a )
+{
+	mlt_deque stack = MLT_FRAME_AUDIO_STACK( frame_a );
+	int count = mlt_deque_count( stack );
+
+	return count >= 3 && mlt_deque_peek( stack, count - 1 ) == (void*) transition_get_audio &&
+		!is_combine( mlt_deque_peek( stack, count - 3 ) );
+}
+
+/** Get the audio.
+ *
+ * When several mix transitions share the A frame, as when every track of a
+ * tractor mixes into the first one, the transition whose audio is requested
+ * takes the others off the stack of the A frame and mixes all of the tracks
+ * together.
+*/
+
+static int transition_get_audio( mlt_frame frame_a, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples )
+{
+	mix_input inputs[ MAX_INPUTS ];
+	mix_input a;
+	int count = 0;
+	int error = 0;
+	int i;
+
+	// Get the b frame and the effect from the stack
+	inputs[ count ].frame = mlt_frame_pop_audio( frame_a );
+	inputs[ count++ ].transition = mlt_frame_pop_audio( frame_a );
+
+	// Take the mixes below this one too
+	if ( !is_combine( inputs[0].transition ) )
+	{
+		while ( count < MAX_INPUTS && has_stacked_mix( frame_a ) )
+		{
+			mlt_frame_pop_audio( frame_a );
+			inputs[ count ].frame = mlt_frame_pop_audio( frame_a );
+			inputs[ count++ ].transition = mlt_frame_pop_audio( frame_a );
+		}
+	}
+
+	// We can only mix interleaved 32-bit float.
+	*format = mlt_audio_f32le;
+
+	// Get the audio from our producers
+	for ( i = 0; i < count; i++ )
+		get_input_audio( &inputs[i], *frequency, *channels, *samples );
+	a.transition = NULL;
+	a.frame = frame_a;
+	get_input_audio( &a, *frequency, *channels, *samples );
+
+	if ( can_mix_directly( inputs, count, &a ) )
+		error = mix_directly( inputs, count, &a );
+	else
+		for ( i = count - 1; i >= 0 && !error; i-- )
+			error = mix_buffered( &inputs[i], &a );
+
+	if ( !error )
+	{
+		*buffer = a.buffer;
+		*frequency = a.frequency;
+		*channels = a.channels;
+		*samples = a.samples;
+	}
+
 	return error;
 }
 
@@ -412,7 +619,10 @@ static mlt_frame transition_process( mlt_transition transition, mlt_frame a_fram
 
 static void transition_close( mlt_transition transition )
 {
-	free( transition->child );
+	transition_mix self = transition->child;
+	free( self->src_buffer );
+	free( self->dest_buffer );
+	free( self );
 	transition->close = NULL;
 	mlt_transition_close( transition );
 }
@@ -437,6 +647,7 @@ mlt_transition transition_mix_init( mlt_profile profile, mlt_service_type type,
 		}
 		// Inform apps and framework that this is an audio only transition
 		mlt_properties_set_int( MLT_TRANSITION_PROPERTIES( transition ), "_transition_type", 2 );
+		mlt_properties_set_int( MLT_TRANSITION_PROPERTIES( transition ), "_parallel_b_format", mlt_audio_f32le );
 	} else {
 		if ( transition )
 			mlt_transition_close( transition );
@@ -306,6 +306,7 @@ static void* load_lib(mlt_profile profile, mlt_service_type type , void* handle,
 				f0r_init();
 				properties = MLT_TRANSITION_PROPERTIES( transition );
 				mlt_properties_set_int(properties, "_transition_type", 1 );
+				mlt_properties_set_int(properties, "_parallel_b_format", mlt_image_rgba );
 
 				ret = transition;
 			}
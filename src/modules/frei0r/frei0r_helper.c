@@ -21,9 +21,8 @@
 #include <frei0r.h>
 #include <string.h>
 #include <stdlib.h>
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include <pthread.h>
+#include <stdatomic.h>
 
 const char *CAIROBLEND_MODE_PROPERTY = "frei0r.cairoblend.mode";
 
@@ -78,6 +77,184 @@ static int f0r_update2_slice( int id, int index, int count, void *context )
 	return 0;
 }
 
+/** The maximum number of plugin instances a service keeps in its pool. */
+#define POOL_CAPACITY (32)
+
+enum pool_slot_state
+{
+	SLOT_EMPTY = 0,
+	SLOT_IDLE,
+	SLOT_BUSY
+};
+
+typedef struct
+{
+	atomic_int state;
+	atomic_int key;      /// width and height of the instance packed into one int
+	f0r_instance_t instance;
+} pool_slot;
+
+typedef struct pool_waiter_s
+{
+	mlt_position position;
+	struct pool_waiter_s *next;
+} pool_waiter;
+
+/** A bounded pool of frei0r plugin instances.
+ *
+ * Instances are checked out for the duration of one frame (all slices of the
+ * frame share it) and returned afterwards. Checkout for thread safe plugins
+ * scans the slots with atomic operations only; the mutex is only taken when
+ * every slot is busy. Plugins that are not thread safe get a single instance
+ * that is handed out in frame position order to the threads waiting for it.
+ */
+typedef struct
+{
+	pool_slot slots[POOL_CAPACITY];
+	int size;
+	int ordered;
+	atomic_int waiters;
+	pool_waiter *queue;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	f0r_instance_t (*f0r_construct) (unsigned int, unsigned int);
+	void (*f0r_destruct) (f0r_instance_t);
+} instance_pool;
+
+static int pool_key( int width, int height )
+{
+	return ( width << 16 ) | ( height & 0xffff );
+}
+
+static instance_pool *pool_new( mlt_properties properties )
+{
+	instance_pool *pool = calloc( 1, sizeof( *pool ) );
+	if ( pool )
+	{
+		int size = mlt_properties_get_int( properties, "instances" );
+		pool->ordered = mlt_properties_get_int( properties, "_not_thread_safe" );
+		if ( pool->ordered )
+			size = 1;
+		else if ( size <= 0 )
+			size = mlt_slices_count_normal();
+		pool->size = CLAMP( size, 1, POOL_CAPACITY );
+		pool->f0r_construct = mlt_properties_get_data( properties, "f0r_construct", NULL );
+		pool->f0r_destruct = mlt_properties_get_data( properties, "f0r_destruct", NULL );
+		pthread_mutex_init( &pool->mutex, NULL );
+		pthread_cond_init( &pool->cond, NULL );
+	}
+	return pool;
+}
+
+static void pool_close( instance_pool *pool )
+{
+	int i;
+	for ( i = 0; i < POOL_CAPACITY; i++ )
+		if ( pool->slots[i].instance && pool->f0r_destruct )
+			pool->f0r_destruct( pool->slots[i].instance );
+	pthread_mutex_destroy( &pool->mutex );
+	pthread_cond_destroy( &pool->cond );
+	free( pool );
+}
+
+static int pool_try_acquire( instance_pool *pool, int width, int height, pool_slot **result )
+{
+	int key = pool_key( width, height );
+	int have_key = 0;
+	int i;
+
+	// Prefer an idle instance of the same size.
+	for ( i = 0; i < pool->size; i++ )
+	{
+		pool_slot *slot = &pool->slots[i];
+		int expected = SLOT_IDLE;
+		if ( atomic_load( &slot->key ) == key )
+		{
+			if ( atomic_compare_exchange_strong( &slot->state, &expected, SLOT_BUSY ) )
+			{
+				*result = slot;
+				return 1;
+			}
+			have_key = 1;
+		}
+	}
+	// Then an unused slot, and finally an idle instance of another size to replace
+	// unless one of the right size is about to be returned.
+	for ( i = 0; i < pool->size; i++ )
+	{
+		pool_slot *slot = &pool->slots[i];
+		int expected = SLOT_EMPTY;
+		if ( atomic_compare_exchange_strong( &slot->state, &expected, SLOT_BUSY ) )
+		{
+			*result = slot;
+			return 1;
+		}
+	}
+	for ( i = 0; !have_key && i < pool->size; i++ )
+	{
+		pool_slot *slot = &pool->slots[i];
+		int expected = SLOT_IDLE;
+		if ( atomic_compare_exchange_strong( &slot->state, &expected, SLOT_BUSY ) )
+		{
+			*result = slot;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static pool_slot *pool_acquire( instance_pool *pool, int width, int height, mlt_position position )
+{
+	pool_slot *slot = NULL;
+
+	if ( pool->ordered || !pool_try_acquire( pool, width, height, &slot ) )
+	{
+		pool_waiter self = { position, NULL };
+		pthread_mutex_lock( &pool->mutex );
+		if ( pool->ordered )
+		{
+			// Keep the waiters sorted by position so that stateful plugins see frames in order.
+			pool_waiter **p = &pool->queue;
+			while ( *p && (*p)->position <= position )
+				p = &(*p)->next;
+			self.next = *p;
+			*p = &self;
+		}
+		atomic_fetch_add( &pool->waiters, 1 );
+		while ( ( pool->ordered && pool->queue != &self ) || !pool_try_acquire( pool, width, height, &slot ) )
+			pthread_cond_wait( &pool->cond, &pool->mutex );
+		atomic_fetch_sub( &pool->waiters, 1 );
+		if ( pool->ordered )
+		{
+			pool->queue = self.next;
+			// Let the next waiter in line see that it is now at the head.
+			pthread_cond_broadcast( &pool->cond );
+		}
+		pthread_mutex_unlock( &pool->mutex );
+	}
+
+	// Construct the instance on first use or replace one of a different size.
+	if ( atomic_load( &slot->key ) != pool_key( width, height ) || !slot->instance )
+	{
+		if ( slot->instance )
+			pool->f0r_destruct( slot->instance );
+		slot->instance = pool->f0r_construct( width, height );
+		atomic_store( &slot->key, pool_key( width, height ) );
+	}
+	return slot;
+}
+
+static void pool_release( instance_pool *pool, pool_slot *slot )
+{
+	atomic_store( &slot->state, slot->instance ? SLOT_IDLE : SLOT_EMPTY );
+	if ( atomic_load( &pool->waiters ) > 0 )
+	{
+		pthread_mutex_lock( &pool->mutex );
+		pthread_cond_broadcast( &pool->cond );
+		pthread_mutex_unlock( &pool->mutex );
+	}
+}
+
 int process_frei0r_item( mlt_service service, mlt_position position, double time,
 	int length, mlt_frame frame, uint8_t **image, int *width, int *height )
 {
@@ -102,7 +279,6 @@ int process_frei0r_item( mlt_service service, mlt_position position, double time
 	                     const uint32_t* inframe2, const uint32_t* inframe3, uint32_t* outframe)
 			= mlt_properties_get_data(prop, "f0r_update2", NULL);
 	mlt_service_type type = mlt_service_identify(service);
-	int not_thread_safe = mlt_properties_get_int(prop, "_not_thread_safe");
 	int slice_count = mlt_properties_get(prop, "threads") ? mlt_properties_get_int(prop, "threads") : -1;
 	const char *service_name = mlt_properties_get(prop, "mlt_service");
 	int is_cairoblend = service_name && !strcmp("frei0r.cairoblend", service_name);
@@ -121,28 +297,28 @@ int process_frei0r_item( mlt_service service, mlt_position position, double time
 	}
 	int slice_height = *height / slice_count;
 
-	// Use width and height in the frei0r instance key
-	char ctorname[1024] = "";
-	if (not_thread_safe)
-		sprintf(ctorname, "ctor-%dx%d", *width, slice_height);
-	else
-#ifdef _WIN32
-		sprintf(ctorname, "ctor-%dx%d-%lu", *width, slice_height, GetCurrentThreadId());
-#else
-		sprintf(ctorname, "ctor-%dx%d-%p", *width, slice_height, (void*) pthread_self());
-#endif
-
-	mlt_service_lock(service);
+	instance_pool *pool = mlt_properties_get_data(prop, "_instance_pool", NULL);
+	if (!pool) {
+		mlt_service_lock(service);
+		pool = mlt_properties_get_data(prop, "_instance_pool", NULL);
+		if (!pool) {
+			pool = pool_new(prop);
+			mlt_properties_set_data(prop, "_instance_pool", pool, 0, NULL, NULL);
+		}
+		mlt_service_unlock(service);
+	}
+	if (!pool) {
+		return -1;
+	}
 
-	f0r_instance_t inst = mlt_properties_get_data(prop, ctorname, NULL);
+	// Check out an instance of this frame's size for the duration of the frame
+	pool_slot *slot = pool_acquire(pool, *width, slice_height, position);
+	f0r_instance_t inst = slot->instance;
 	if (!inst) {
-		inst = f0r_construct(*width, slice_height);
-		mlt_properties_set_data(prop, ctorname, inst, 0, NULL, NULL);
+		pool_release(pool, slot);
+		return -1;
 	}
 
-	if (!not_thread_safe && slice_count == 1)
-		mlt_service_unlock(service);
-
 	f0r_plugin_info_t info;
 	memset(&info, 0, sizeof(info));
 	if (f0r_get_plugin_info) {
@@ -229,6 +405,7 @@ int process_frei0r_item( mlt_service service, mlt_position position, double time
 	int video_area = *width * *height;
 	uint32_t *result = mlt_pool_alloc(video_area * sizeof(uint32_t));
 	uint32_t *extra = NULL;
+	uint32_t *scratch = NULL;
 	uint32_t *source[2] = { (uint32_t*) image[0], (uint32_t*) image[1] };
 	uint32_t *dest = result;
 
@@ -238,7 +415,9 @@ int process_frei0r_item( mlt_service service, mlt_position position, double time
 		} else {
 			rgba_bgra(image[0], (uint8_t*) result, *width, *height);
 			source[0] = result;
-			dest = (uint32_t*) image[0];
+			// The input image may be shared with other frames, so render elsewhere
+			scratch = mlt_pool_alloc(video_area * sizeof(uint32_t));
+			dest = scratch;
 			if (type == mlt_service_transition_type && f0r_update2) {
 				extra = mlt_pool_alloc(video_area * sizeof(uint32_t));
 				rgba_bgra(image[1], (uint8_t*) extra, *width, *height);
@@ -292,8 +471,7 @@ int process_frei0r_item( mlt_service service, mlt_position position, double time
 			f0r_update2(inst, time, source[0], source[1], NULL, dest);
 		}
 	}
-	if (not_thread_safe || slice_count != 1)
-		mlt_service_unlock(service);
+	pool_release(pool, slot);
 	if (info.color_model == F0R_COLOR_MODEL_BGRA8888) {
 		rgba_bgra((uint8_t*) dest, (uint8_t*) result, *width, *height);
 	}
@@ -301,27 +479,26 @@ int process_frei0r_item( mlt_service service, mlt_position position, double time
 	mlt_frame_set_image(frame, (uint8_t*) result, video_area * sizeof(uint32_t), mlt_pool_release);
 	if (extra)
 		mlt_pool_release(extra);
+	if (scratch)
+		mlt_pool_release(scratch);
 
 	return 0;
 }
 
 void destruct (mlt_properties prop ) {
 
-	void (*f0r_destruct) (f0r_instance_t instance) = mlt_properties_get_data(prop, "f0r_destruct", NULL);
 	void (*f0r_deinit) (void) = mlt_properties_get_data(prop, "f0r_deinit", NULL);
-	int i = 0;
+	instance_pool *pool = mlt_properties_get_data(prop, "_instance_pool", NULL);
+
+	// Instances must be destroyed before the plugin is deinitialized and unloaded
+	if (pool) {
+		pool_close(pool);
+		mlt_properties_set_data(prop, "_instance_pool", NULL, 0, NULL, NULL);
+	}
 
 	if (f0r_deinit)
 		f0r_deinit();
 
-	for (i=0; i < mlt_properties_count(prop); i++) {
-		if (strstr(mlt_properties_get_name(prop, i), "ctor-")) {
-			void * inst = mlt_properties_get_data(prop, mlt_properties_get_name(prop, i), NULL);
-			if (inst) {
-				f0r_destruct((f0r_instance_t) inst);
-			}
-		}
-	}
 	void (*dlclose) (void*) = mlt_properties_get_data(prop, "_dlclose", NULL);
 	void *handle = mlt_properties_get_data(prop, "_dlclose_handle", NULL);
 
@@ -90,6 +90,7 @@ int producer_get_frame( mlt_producer producer, mlt_frame_ptr frame, int index )
 
 void producer_close( mlt_producer producer )
 {
+	destruct( MLT_PRODUCER_PROPERTIES( producer ) );
 	producer->close = NULL;
 	mlt_producer_close( producer );
 	free( producer );
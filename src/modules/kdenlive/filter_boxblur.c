@@ -20,6 +20,7 @@
 
 #include <framework/mlt_filter.h>
 #include <framework/mlt_frame.h>
+#include <framework/mlt_image.h>
 #include <framework/mlt_profile.h>
 
 #include <stdio.h>
@@ -27,67 +28,6 @@
 #include <math.h>
 
 
-static void PreCompute(uint8_t *image, int32_t *rgba, int width, int height)
-{
-	register int x, y, z;
-	int32_t pts[4];
-	
-	for (y = 0; y < height; y++)
-	{
-		for (x = 0; x < width; x++)
-		{
-			pts[0] = image[0];
-			pts[1] = image[1];
-			pts[2] = image[2];
-			pts[3] = image[3];
-			for (z = 0; z < 4; z++)
-			{
-				if (x > 0) pts[z] += rgba[-4];
-				if (y > 0) pts[z] += rgba[width * -4];
-				if (x>0 && y>0) pts[z] -= rgba[(width + 1) * -4];
-				*rgba++ = pts[z];
-			}
-			image += 4;
-		}
-	}
-}
-
-static inline int32_t GetRGBA(int32_t *rgba, unsigned int w, unsigned int h, unsigned int x, int offsetx, unsigned int y, int offsety, unsigned int z)
-{
-	int xtheo = x + offsetx;
-	int ytheo = y + offsety;
-	return rgba[4 * (CLAMP(xtheo, 0, w-1) + CLAMP(ytheo, 0, h-1) * w) + z];
-}
-
-static void DoBoxBlur(uint8_t *image, int32_t *rgba, unsigned int width, unsigned int height, unsigned int boxw, unsigned int boxh)
-{
-	register int x, y;
-	float mul = 1.f / ((boxw*2) * (boxh*2));
-
-	for (y = 0; y < height; y++)
-	{
-		for (x = 0; x < width; x++)
-		{
-			*image++ = (GetRGBA(rgba, width, height, x, +boxw, y, +boxh, 0)
-			          + GetRGBA(rgba, width, height, x, -boxw, y, -boxh, 0)
-			          - GetRGBA(rgba, width, height, x, -boxw, y, +boxh, 0)
-			          - GetRGBA(rgba, width, height, x, +boxw, y, -boxh, 0)) * mul;
-			*image++ = (GetRGBA(rgba, width, height, x, +boxw, y, +boxh, 1)
-			          + GetRGBA(rgba, width, height, x, -boxw, y, -boxh, 1)
-			          - GetRGBA(rgba, width, height, x, -boxw, y, +boxh, 1)
-			          - GetRGBA(rgba, width, height, x, +boxw, y, -boxh, 1)) * mul;
-			*image++ = (GetRGBA(rgba, width, height, x, +boxw, y, +boxh, 2)
-			          + GetRGBA(rgba, width, height, x, -boxw, y, -boxh, 2)
-			          - GetRGBA(rgba, width, height, x, -boxw, y, +boxh, 2)
-			          - GetRGBA(rgba, width, height, x, +boxw, y, -boxh, 2)) * mul;
-			*image++ = (GetRGBA(rgba, width, height, x, +boxw, y, +boxh, 3)
-			          + GetRGBA(rgba, width, height, x, -boxw, y, -boxh, 3)
-			          - GetRGBA(rgba, width, height, x, -boxw, y, +boxh, 3)
-			          - GetRGBA(rgba, width, height, x, +boxw, y, -boxh, 3)) * mul;
-		}
-	}
-}
-
 static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable )
 {
 	int error = 0;
@@ -136,11 +76,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 			boxw *= mlt_profile_scale_width(profile, *width);
 			boxh *= mlt_profile_scale_height(profile, *height);
 			if (boxw || boxh) {
-				int size = mlt_image_format_size( *format, *width, *height, NULL );
-				int32_t *rgba = mlt_pool_alloc( 4 * size );
-				PreCompute( *image, rgba, *width, *height );
-				DoBoxBlur( *image, rgba, *width, *height, MAX(1, boxw), MAX(1, boxh) );
-				mlt_pool_release( rgba );
+				boxw = MAX(1, boxw);
+				boxh = MAX(1, boxh);
+				mlt_image_box_blur( *image, *width, *height, 4, boxw, boxw, boxh, boxh, 0 );
 			}
 		}
 	}
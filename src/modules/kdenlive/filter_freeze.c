@@ -73,24 +73,20 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 
 		// Get frozen image
 		uint8_t *buffer = NULL;
-		int error = mlt_frame_get_image( freeze_frame, &buffer, format, width, height, 1 );
-		mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
-
-		// Copy it to current frame
-		int size = mlt_image_format_size( *format, *width, *height, NULL );
-		uint8_t *image_copy = mlt_pool_alloc( size );
-		memcpy( image_copy, buffer, size );
-		*image = image_copy;
-		mlt_frame_set_image( frame, *image, size, mlt_pool_release );
+		int error = mlt_frame_get_image( freeze_frame, &buffer, format, width, height, 0 );
 
-		uint8_t *alpha_buffer = mlt_frame_get_alpha( freeze_frame );
-		if ( alpha_buffer )
+		// Share it with the current frame; it is copied only if a filter writes to it
+		if ( !error && buffer )
 		{
-			int alphasize = *width * *height;
-			uint8_t *alpha_copy = mlt_pool_alloc( alphasize );
-			memcpy( alpha_copy, alpha_buffer, alphasize );
-			mlt_frame_set_alpha( frame, alpha_copy, alphasize, mlt_pool_release );
+			int size = 0;
+			*image = mlt_frame_share_image( freeze_frame, &size );
+			mlt_frame_set_image_shared( frame, *image, size );
+
+			uint8_t *alpha_buffer = mlt_frame_share_alpha( freeze_frame, &size );
+			if ( alpha_buffer )
+				mlt_frame_set_alpha_shared( frame, alpha_buffer, size );
 		}
+		mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
 		return error;
 	}
 
@@ -116,16 +116,10 @@ static int framebuffer_get_image( mlt_frame frame, uint8_t **image, mlt_image_fo
 	}
 
 	if ( output && first_position != -1 ) {
-		// Using the cached frame
-		uint8_t *image_copy = mlt_pool_alloc( size );
-		memcpy( image_copy, output, size );
-		uint8_t *alpha_copy = mlt_pool_alloc( alphasize );
-		memcpy( alpha_copy, output_alpha, alphasize );
-
-		// Set the output image
-		*image = image_copy;
-		mlt_frame_set_image( frame, image_copy, size, mlt_pool_release );
-		mlt_frame_set_alpha( frame, alpha_copy, alphasize, mlt_pool_release );
+		// Share the cached frame; it is copied only if a filter writes to it
+		*image = output;
+		mlt_frame_set_image_shared( frame, output, size );
+		mlt_frame_set_alpha_shared( frame, output_alpha, alphasize );
 
 		*width = mlt_properties_get_int( properties, "_output_width" );
 		*height = mlt_properties_get_int( properties, "_output_height" );
@@ -168,10 +162,11 @@ static int framebuffer_get_image( mlt_frame frame, uint8_t **image, mlt_image_fo
 			mlt_service_unlock( MLT_PRODUCER_SERVICE( producer ) );
 			return error;
 		}
-		output = mlt_pool_alloc( size );
+		output = mlt_image_shared_alloc( size );
 		memcpy( output, first_image, size );
 		// Let someone else clean up
-		mlt_properties_set_data( properties, "output_buffer", output, size, mlt_pool_release, NULL ); 
+		mlt_properties_set_data( properties, "output_buffer", output, size, mlt_image_shared_release, NULL );
+		first_image = output;
 		mlt_properties_set_int( properties, "_output_width", *width );
 		mlt_properties_set_int( properties, "_output_height", *height );
 		mlt_properties_set_int( properties, "_output_format", *format );
@@ -187,23 +182,36 @@ static int framebuffer_get_image( mlt_frame frame, uint8_t **image, mlt_image_fo
 			memset( first_alpha, 255, alphasize );
 			mlt_frame_set_alpha( first_frame, first_alpha, alphasize, mlt_pool_release );
 		}
-		output_alpha = mlt_pool_alloc( alphasize );
+		output_alpha = mlt_image_shared_alloc( alphasize );
 		memcpy( output_alpha, first_alpha, alphasize );
-		mlt_properties_set_data( properties, "output_alpha", output_alpha, alphasize, mlt_pool_release, NULL );
+		mlt_properties_set_data( properties, "output_alpha", output_alpha, alphasize, mlt_image_shared_release, NULL );
+		first_alpha = output_alpha;
 	}
 
-	mlt_service_unlock( MLT_PRODUCER_SERVICE( producer ) );
-
-	// Create a copy
-	uint8_t *image_copy = mlt_pool_alloc( size );
-	memcpy( image_copy, first_image, size );
-	uint8_t *alpha_copy = mlt_pool_alloc( alphasize );
-	memcpy( alpha_copy, first_alpha, alphasize );
+	// Share the cached output, else create a copy
+	if ( first_image == output )
+	{
+		mlt_frame_set_image_shared( frame, output, size );
+	}
+	else
+	{
+		uint8_t *image_copy = mlt_pool_alloc( size );
+		memcpy( image_copy, first_image, size );
+		mlt_frame_set_image( frame, image_copy, size, mlt_pool_release );
+	}
+	if ( first_alpha == output_alpha )
+	{
+		mlt_frame_set_alpha_shared( frame, output_alpha, alphasize );
+	}
+	else
+	{
+		uint8_t *alpha_copy = mlt_pool_alloc( alphasize );
+		memcpy( alpha_copy, first_alpha, alphasize );
+		mlt_frame_set_alpha( frame, alpha_copy, alphasize, mlt_pool_release );
+	}
+	*image = mlt_properties_get_data( frame_properties, "image", NULL );
 
-	// Set the output image
-	*image = image_copy;
-	mlt_frame_set_image( frame, image_copy, size, mlt_pool_release );
-	mlt_frame_set_alpha( frame, alpha_copy, alphasize, mlt_pool_release );
+	mlt_service_unlock( MLT_PRODUCER_SERVICE( producer ) );
 
 	return 0;
 }
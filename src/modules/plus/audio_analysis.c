@@ -0,0 +1,173 @@
+/*
+ * audio_analysis.c -- share the analysis of the audio of a frame between meters
+ * Copyright (C) 2026 Meltytech, LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "audio_analysis.h"
+#include <framework/mlt_pool.h>
+#include <math.h>
+#include <string.h>
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/** Hash samples to notice when a filter changed them in place.
+ *
+ * Four independent lanes keep the multiplies from waiting on each other.
+ */
+
+static uint64_t hash_samples( const float *buffer, size_t count )
+{
+	const uint32_t *p = (const uint32_t*) buffer;
+	uint64_t h0 = FNV_OFFSET, h1 = FNV_OFFSET, h2 = FNV_OFFSET, h3 = FNV_OFFSET;
+	size_t i = 0;
+
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		h0 = ( h0 ^ p[i] ) * FNV_PRIME;
+		h1 = ( h1 ^ p[i + 1] ) * FNV_PRIME;
+		h2 = ( h2 ^ p[i + 2] ) * FNV_PRIME;
+		h3 = ( h3 ^ p[i + 3] ) * FNV_PRIME;
+	}
+	for ( ; i < count; i++ )
+		h0 = ( h0 ^ p[i] ) * FNV_PRIME;
+	return ( ( ( h0 * FNV_PRIME ) ^ h1 ) * FNV_PRIME ^ h2 ) * FNV_PRIME ^ h3;
+}
+
+#ifdef USE_INTERNAL_LIBEBUR128
+
+static void weigher_close( void *data )
+{
+	ebur128_state *state = data;
+	ebur128_destroy( &state );
+}
+
+/** Get the ebur128 state of a filter that keeps the K-weighting filter running between frames.
+ */
+
+static ebur128_state *get_weigher( mlt_filter filter, int frequency, int channels, int true_peak )
+{
+	mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
+	ebur128_state *weigher = mlt_properties_get_data( properties, "_audio_weigher", NULL );
+
+	// Keep measuring the true peak once asked so that the filter state is not lost again
+	if ( weigher && ( weigher->mode & EBUR128_MODE_TRUE_PEAK ) == EBUR128_MODE_TRUE_PEAK )
+		true_peak = 1;
+	if ( !weigher || weigher->channels != channels || weigher->samplerate != frequency ||
+		 ( true_peak && ( weigher->mode & EBUR128_MODE_TRUE_PEAK ) != EBUR128_MODE_TRUE_PEAK ) )
+	{
+		weigher = ebur128_init( channels, frequency, true_peak ? EBUR128_MODE_TRUE_PEAK : EBUR128_MODE_SAMPLE_PEAK );
+		mlt_properties_set_data( properties, "_audio_weigher", weigher, 0, weigher_close, NULL );
+	}
+	return weigher;
+}
+
+#endif
+
+/** Get the analysis of the audio of a frame, analysing it if no other filter has.
+ *
+ * \param filter the filter that asks, which keeps the K-weighting filter state
+ * \param frame the frame with the audio
+ * \param buffer the samples, with channels interleaved
+ * \param frequency the sample rate
+ * \param channels the number of channels
+ * \param samples the number of samples per channel
+ * \param mode the ebur128 mode of the state of the filter, to know which peaks it needs
+ * \return the analysis, which the frame owns
+ */
+
+audio_analysis audio_analysis_get( mlt_filter filter, mlt_frame frame, float *buffer, int frequency, int channels, int samples, int mode )
+{
+	mlt_properties frame_properties = MLT_FRAME_PROPERTIES( frame );
+	audio_analysis analysis = mlt_properties_get_data( frame_properties, "_audio_analysis", NULL );
+	size_t count = (size_t) samples * channels;
+	uint64_t hash = hash_samples( buffer, count );
+	int true_peak = ( mode & EBUR128_MODE_TRUE_PEAK ) == EBUR128_MODE_TRUE_PEAK;
+	int size = sizeof( *analysis ) + 2 * channels * sizeof( double );
+	int c, s;
+
+	// Reuse the analysis of another filter, even without a true peak that this one
+	// needs, since analysing again here would skip frames in the filter state.
+	if ( analysis && analysis->buffer == buffer && analysis->frequency == frequency &&
+		 analysis->channels == channels && analysis->samples == samples && analysis->hash == hash )
+		return analysis;
+
+#ifdef USE_INTERNAL_LIBEBUR128
+	size += count * sizeof( double );
+#endif
+	analysis = mlt_pool_alloc( size );
+	if ( !analysis )
+		return NULL;
+	memset( analysis, 0, size );
+	analysis->buffer = buffer;
+	analysis->frequency = frequency;
+	analysis->channels = channels;
+	analysis->samples = samples;
+	analysis->hash = hash;
+	analysis->peak = (double*) ( analysis + 1 );
+
+	for ( s = 0; s < samples; s++ )
+	{
+		const float *p = buffer + s * channels;
+		for ( c = 0; c < channels; c++ )
+		{
+			double sample = fabs( (double) p[c] );
+			if ( sample > analysis->peak[c] )
+				analysis->peak[c] = sample;
+		}
+	}
+
+#ifdef USE_INTERNAL_LIBEBUR128
+	ebur128_state *weigher = get_weigher( filter, frequency, channels, true_peak );
+	if ( weigher )
+	{
+		analysis->weighted = analysis->peak + 2 * channels;
+		ebur128_weight_frames_float( weigher, buffer, samples, analysis->weighted );
+		if ( ( weigher->mode & EBUR128_MODE_TRUE_PEAK ) == EBUR128_MODE_TRUE_PEAK )
+		{
+			analysis->true_peak = analysis->peak + channels;
+			for ( c = 0; c < channels; c++ )
+				ebur128_prev_true_peak( weigher, c, &analysis->true_peak[c] );
+		}
+	}
+#else
+	(void) true_peak;
+#endif
+
+	mlt_properties_set_data( frame_properties, "_audio_analysis", analysis, size, mlt_pool_release, NULL );
+	return analysis;
+}
+
+/** Add the audio of an analysis to an ebur128 state.
+ *
+ * This reuses the K-weighted samples and peaks when they suit the state,
+ * and otherwise adds the samples as ebur128_add_frames_float() does.
+ *
+ * \param state an ebur128 state with the default channel map
+ * \param analysis the analysis from audio_analysis_get()
+ * \return an ebur128 error code
+ */
+
+int audio_analysis_add_frames( ebur128_state *state, audio_analysis analysis )
+{
+#ifdef USE_INTERNAL_LIBEBUR128
+	if ( analysis->weighted && analysis->channels == state->channels && analysis->frequency == state->samplerate &&
+		 ( analysis->true_peak || ( state->mode & EBUR128_MODE_TRUE_PEAK ) != EBUR128_MODE_TRUE_PEAK ) )
+		return ebur128_add_weighted_frames( state, analysis->weighted, analysis->samples, analysis->peak, analysis->true_peak );
+#endif
+	return ebur128_add_frames_float( state, analysis->buffer, analysis->samples );
+}
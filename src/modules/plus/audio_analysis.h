@@ -0,0 +1,58 @@
+/*
+ * audio_analysis.h -- share the analysis of the audio of a frame between meters
+ * Copyright (C) 2026 Meltytech, LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _AUDIO_ANALYSIS_H_
+#define _AUDIO_ANALYSIS_H_
+
+#include <framework/mlt_filter.h>
+#include <framework/mlt_frame.h>
+#include <ebur128.h>
+#include <stdint.h>
+
+/** The analysis of the 32-bit float audio of a frame.
+ *
+ * The loudness_meter and dynamic_loudness filters each keep their own ebur128
+ * state for their own gating and history. When several of them measure the
+ * same audio, the first to get the analysis of a frame filters the samples
+ * with the K-weighting filter and finds the peaks, and the others reuse that.
+ * The loudness and audiolevel filters still do their own analysis.
+ *
+ * The analysis is kept on the frame and is only reused while the audio has the
+ * same buffer, format and samples, so a filter between the meters that changes
+ * the audio causes a new analysis.
+ */
+
+typedef struct audio_analysis_s
+{
+	float *buffer;       /**< the samples analysed, with channels interleaved */
+	int frequency;       /**< the sample rate */
+	int channels;        /**< the number of channels */
+	int samples;         /**< the number of samples per channel */
+	double *peak;        /**< the sample peak of each channel */
+	double *true_peak;   /**< the true peak of each channel, or NULL if not measured */
+	double *weighted;    /**< the K-weighted samples, or NULL with a system libebur128 */
+	uint64_t hash;       /**< \private a hash of the samples */
+} *audio_analysis;
+
+/* Call these with the filter locked. The ebur128 states given to
+ * audio_analysis_add_frames() must use the default channel map. */
+extern audio_analysis audio_analysis_get( mlt_filter filter, mlt_frame frame, float *buffer, int frequency, int channels, int samples, int mode );
+extern int audio_analysis_add_frames( ebur128_state *state, audio_analysis analysis );
+
+#endif
@@ -7,6 +7,7 @@
 #include <math.h> /* You may have to define _USE_MATH_DEFINES if you use MSVC */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* This can be replaced by any BSD-like queue implementation. */
 #include <sys/queue.h>
@@ -25,17 +26,18 @@ struct ebur128_dq_entry {
 
 #define ALMOST_ZERO 0.000001
 
+#define INTERP_MAX_FACTOR 4
+
 typedef struct {              // Data structure for polyphase FIR interpolator
   unsigned int factor;        // Interpolation factor of the interpolator
   unsigned int taps;          // Taps (prefer odd to increase zero coeffs)
   unsigned int channels;      // Number of channels
   unsigned int delay;         // Size of delay buffer
-  struct {
-    unsigned int count;       // Number of coefficients in this subfilter
-    unsigned int* index;      // Delay index of corresponding filter coeff
-    double* coeff;            // List of subfilter coefficients
-  }* filter;                  // List of subfilters (one for each factor)
-  float** z;                  // List of delay buffers (one for each channel)
+  double* coeff;              // Coefficients of all subfilters by delay index,
+                              // coeff[index * INTERP_MAX_FACTOR + subfilter],
+                              // zero if unused
+  float** z;                  // List of delay buffers (one for each channel),
+                              // stored twice so that the taps never wrap around
   unsigned int zi;            // Current delay buffer index
 } interpolator;
 
@@ -58,8 +60,11 @@ struct ebur128_state_internal {
   double b[5];
   /** BS.1770 filter coefficients (denominator). */
   double a[5];
-  /** BS.1770 filter state. */
-  double v[5][5];
+  /** BS.1770 filter state, four rows of one value per channel, so that all
+   *  channels of a frame are filtered together. */
+  double* v;
+  /** The energy of each channel in a gating block. */
+  double* channel_sum;
   /** Linked list of block energies. */
   struct ebur128_double_queue block_list;
   unsigned long block_list_max;
@@ -107,16 +112,13 @@ static interpolator* interp_create(unsigned int taps, unsigned int factor, unsig
   interp->delay = (interp->taps + interp->factor - 1) / interp->factor;
 
   // Initialize the filter memory
-  // One subfilter per interpolation factor.
-  interp->filter = calloc(interp->factor, sizeof(*interp->filter));
-  for (j = 0; j < interp->factor; j++) {
-    interp->filter[j].index = calloc(interp->delay, sizeof(unsigned int));
-    interp->filter[j].coeff = calloc(interp->delay, sizeof(double));
-  }
+  // One coefficient per subfilter for each delay index, so that all the
+  // subfilters are applied together.
+  interp->coeff = calloc(interp->delay * INTERP_MAX_FACTOR, sizeof(double));
   // One delay buffer per channel.
   interp->z = calloc(interp->channels, sizeof(float*));
   for (j = 0; j < interp->channels; j++) {
-    interp->z[j] = calloc( interp->delay, sizeof(float) );
+    interp->z[j] = calloc( 2 * interp->delay, sizeof(float) );
   }
 
   // Calculate the filter coefficients
@@ -132,10 +134,7 @@ static interpolator* interp_create(unsigned int taps, unsigned int factor, unsig
 
     if (fabs(c) > ALMOST_ZERO) { // Ignore any zero coeffs.
       // Put the coefficient into the correct subfilter
-      unsigned int f = j % interp->factor;
-      unsigned int t = interp->filter[f].count++;
-      interp->filter[f].coeff[t] = c;
-      interp->filter[f].index[t] = j / interp->factor;
+      interp->coeff[j / interp->factor * INTERP_MAX_FACTOR + j % interp->factor] = c;
     }
   }
   return interp;
@@ -144,11 +143,7 @@ static interpolator* interp_create(unsigned int taps, unsigned int factor, unsig
 static void interp_destroy(interpolator* interp) {
   unsigned int j = 0;
   if (!interp) return;
-  for (j = 0; j < interp->factor; j++) {
-    free(interp->filter[j].index);
-    free(interp->filter[j].coeff);
-  }
-  free(interp->filter);
+  free(interp->coeff);
   for (j = 0; j < interp->channels; j++) {
     free(interp->z[j]);
   }
@@ -160,27 +155,30 @@ static void interp_process(interpolator* interp, size_t frames, float* in, float
   size_t frame = 0;
   unsigned int chan = 0;
   unsigned int f = 0;
-  unsigned int t = 0;
+  unsigned int d = 0;
   unsigned int out_stride = interp->channels * interp->factor;
-  float* outp = 0;
-  double acc = 0;
-  double c = 0;
+  const double* coeff = interp->coeff;
+  double acc[INTERP_MAX_FACTOR];
   for (frame = 0; frame < frames; frame++) {
     for (chan = 0; chan < interp->channels; chan++) {
-      // Add sample to delay buffer
-      interp->z[chan][interp->zi] = *in++;
-      // Apply coefficients
-      outp = out + chan;
-      for (f = 0; f < interp->factor; f++) {
-        acc = 0.0;
-        for (t = 0; t < interp->filter[f].count; t++) {
-          int i = (int)interp->zi - (int)interp->filter[f].index[t];
-          if (i < 0) i += interp->delay;
-          c = interp->filter[f].coeff[t];
-          acc += interp->z[chan][i] * c;
+      // Add sample to delay buffer and its copy
+      float* z = interp->z[chan];
+      z[interp->zi] = z[interp->zi + interp->delay] = *in++;
+      // Apply the coefficients of every subfilter for each delayed sample;
+      // the subfilters are independent and always as many, so this
+      // vectorises. A smaller factor leaves the extra coefficients zero.
+      z += interp->zi + interp->delay;
+      for (f = 0; f < INTERP_MAX_FACTOR; f++) {
+        acc[f] = 0.0;
+      }
+      for (d = 0; d < interp->delay; d++) {
+        double sample = z[-(int) d];
+        for (f = 0; f < INTERP_MAX_FACTOR; f++) {
+          acc[f] += sample * coeff[d * INTERP_MAX_FACTOR + f];
         }
-        *outp = (float)acc;
-        outp += interp->channels;
+      }
+      for (f = 0; f < interp->factor; f++) {
+        out[f * interp->channels + chan] = (float) acc[f];
       }
     }
     out += out_stride;
@@ -190,7 +188,7 @@ static void interp_process(interpolator* interp, size_t frames, float* in, float
 }
 
 static void ebur128_init_filter(ebur128_state* st) {
-  int i, j;
+  size_t i;
 
   double f0 = 1681.974450955533;
   double G  =    3.999843853973347;
@@ -236,10 +234,8 @@ static void ebur128_init_filter(ebur128_state* st) {
   st->d->a[3] = pa[1] * ra[2] + pa[2] * ra[1];
   st->d->a[4] = pa[2] * ra[2];
 
-  for (i = 0; i < 5; ++i) {
-    for (j = 0; j < 5; ++j) {
-      st->d->v[i][j] = 0.0;
-    }
+  for (i = 0; i < 4 * st->channels; ++i) {
+    st->d->v[i] = 0.0;
   }
 }
 
@@ -278,7 +274,7 @@ static int ebur128_init_resampler(ebur128_state* st) {
   int errcode = EBUR128_SUCCESS;
 
   if (st->samplerate < 96000) {
-    st->d->interp = interp_create(49, 4, st->channels);
+    st->d->interp = interp_create(49, INTERP_MAX_FACTOR, st->channels);
     CHECK_ERROR(!st->d->interp, EBUR128_ERROR_NOMEM, exit)
   } else if (st->samplerate < 192000) {
     st->d->interp = interp_create(49, 2, st->channels);
@@ -358,6 +354,10 @@ ebur128_state* ebur128_init(unsigned int channels,
   CHECK_ERROR(!st->d->true_peak, 0, free_prev_sample_peak)
   st->d->prev_true_peak = (double*) malloc(channels * sizeof(double));
   CHECK_ERROR(!st->d->prev_true_peak, 0, free_true_peak)
+  st->d->v = (double*) malloc(4 * channels * sizeof(double));
+  CHECK_ERROR(!st->d->v, 0, free_prev_true_peak)
+  st->d->channel_sum = (double*) malloc(channels * sizeof(double));
+  CHECK_ERROR(!st->d->channel_sum, 0, free_filter_state)
   for (i = 0; i < channels; ++i) {
     st->d->sample_peak[i] = 0.0;
     st->d->prev_sample_peak[i] = 0.0;
@@ -375,7 +375,7 @@ ebur128_state* ebur128_init(unsigned int channels,
   } else if ((mode & EBUR128_MODE_M) == EBUR128_MODE_M) {
     st->d->window = 400;
   } else {
-    goto free_prev_true_peak;
+    goto free_channel_sum;
   }
   st->d->audio_data_frames = st->samplerate * st->d->window / 1000;
   if (st->d->audio_data_frames % st->d->samples_in_100ms) {
@@ -387,9 +387,9 @@ ebur128_state* ebur128_init(unsigned int channels,
   st->d->audio_data = (double*) malloc(st->d->audio_data_frames *
                                        st->channels *
                                        sizeof(double));
-  CHECK_ERROR(!st->d->audio_data, 0, free_true_peak)
+  CHECK_ERROR(!st->d->audio_data, 0, free_channel_sum)
   for (j = 0; j < st->d->audio_data_frames * st->channels; ++j) {
-    st->d->audio_data[i] = 0.0;
+    st->d->audio_data[j] = 0.0;
   }
 
   ebur128_init_filter(st);
@@ -449,6 +449,10 @@ free_block_energy_histogram:
   free(st->d->block_energy_histogram);
 free_audio_data:
   free(st->d->audio_data);
+free_channel_sum:
+  free(st->d->channel_sum);
+free_filter_state:
+  free(st->d->v);
 free_prev_true_peak:
   free(st->d->prev_true_peak);
 free_true_peak:
@@ -477,6 +481,8 @@ void ebur128_destroy(ebur128_state** st) {
   free((*st)->d->prev_sample_peak);
   free((*st)->d->true_peak);
   free((*st)->d->prev_true_peak);
+  free((*st)->d->v);
+  free((*st)->d->channel_sum);
   while (!STAILQ_EMPTY(&(*st)->d->block_list)) {
     entry = STAILQ_FIRST(&(*st)->d->block_list);
     STAILQ_REMOVE_HEAD(&(*st)->d->block_list, entries);
@@ -495,21 +501,19 @@ void ebur128_destroy(ebur128_state** st) {
 
 static void ebur128_check_true_peak(ebur128_state* st, size_t frames) {
   size_t c, i;
-  interp_process(st->d->interp, frames, 
+  /* Only the frames just interpolated; the rest of the buffer is stale. */
+  size_t output_frames = frames * st->d->interp->factor;
+  const float* output = st->d->resampler_buffer_output;
+  double* peak = st->d->prev_true_peak;
+  interp_process(st->d->interp, frames,
                  st->d->resampler_buffer_input,
                  st->d->resampler_buffer_output);
-  for (c = 0; c < st->channels; ++c) {
-    for (i = 0; i < st->d->resampler_buffer_output_frames; ++i) {
-      if (st->d->resampler_buffer_output[i * st->channels + c] >
-                                                         st->d->prev_true_peak[c]) {
-        st->d->prev_true_peak[c] =
-            st->d->resampler_buffer_output[i * st->channels + c];
-      } else if (-st->d->resampler_buffer_output[i * st->channels + c] >
-                                                         st->d->prev_true_peak[c]) {
-        st->d->prev_true_peak[c] =
-           -st->d->resampler_buffer_output[i * st->channels + c];
-      }
+  for (i = 0; i < output_frames; ++i) {
+    for (c = 0; c < st->channels; ++c) {
+      double sample = fabs(output[c]);
+      if (sample > peak[c]) peak[c] = sample;
     }
+    output += st->channels;
   }
 }
 
@@ -525,10 +529,8 @@ static void ebur128_check_true_peak(ebur128_state* st, size_t frames) {
 #define TURN_ON_FTZ
 #define TURN_OFF_FTZ
 #define FLUSH_MANUALLY \
-    st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-    st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-    st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-    st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1];
+    for (c = 0; c < 4 * channels; ++c) \
+      st->d->v[c] = fabs(st->d->v[c]) < DBL_MIN ? 0.0 : st->d->v[c];
 #endif
 
 #define EBUR128_FILTER(type, min_scale, max_scale)                             \
@@ -537,57 +539,58 @@ static void ebur128_filter_##type(ebur128_state* st, const type* src,          \
   static double scaling_factor = -((double) min_scale) > (double) max_scale ?  \
                                  -((double) min_scale) : (double) max_scale;   \
   double* audio_data = st->d->audio_data + st->d->audio_data_index;            \
+  size_t channels = st->channels;                                              \
+  /* Channels after the last one used need not be filtered */                  \
+  size_t used = channels;                                                      \
+  /* The state of each delay of the filter, one value per channel */           \
+  double* v1 = st->d->v;                                                       \
+  double* v2 = v1 + channels;                                                  \
+  double* v3 = v2 + channels;                                                  \
+  double* v4 = v3 + channels;                                                  \
+  const double* a = st->d->a;                                                  \
+  const double* b = st->d->b;                                                  \
   size_t i, c;                                                                 \
                                                                                \
+  while (used > 0 && st->d->channel_map[used - 1] == EBUR128_UNUSED) {         \
+    --used;                                                                    \
+  }                                                                            \
+                                                                               \
   TURN_ON_FTZ                                                                  \
                                                                                \
   if ((st->mode & EBUR128_MODE_SAMPLE_PEAK) == EBUR128_MODE_SAMPLE_PEAK) {     \
-    for (c = 0; c < st->channels; ++c) {                                       \
-      double max = 0.0;                                                        \
-      for (i = 0; i < frames; ++i) {                                           \
-        if (src[i * st->channels + c] > max) {                                 \
-          max =        src[i * st->channels + c];                              \
-        } else if (-src[i * st->channels + c] > max) {                         \
-          max = -1.0 * src[i * st->channels + c];                              \
-        }                                                                      \
+    double* peak = st->d->prev_sample_peak;                                    \
+    for (i = 0; i < frames; ++i) {                                             \
+      for (c = 0; c < channels; ++c) {                                         \
+        double sample = fabs((double) src[i * channels + c]) / scaling_factor; \
+        if (sample > peak[c]) peak[c] = sample;                                \
       }                                                                        \
-      max /= scaling_factor;                                                   \
-      if (max > st->d->prev_sample_peak[c]) st->d->prev_sample_peak[c] = max;  \
     }                                                                          \
   }                                                                            \
   if ((st->mode & EBUR128_MODE_TRUE_PEAK) == EBUR128_MODE_TRUE_PEAK &&         \
       st->d->interp) {                                                         \
-    for (c = 0; c < st->channels; ++c) {                                       \
-      for (i = 0; i < frames; ++i) {                                           \
-        st->d->resampler_buffer_input[i * st->channels + c] =                  \
-                      (float) (src[i * st->channels + c] / scaling_factor);    \
-      }                                                                        \
+    for (i = 0; i < frames * channels; ++i) {                                  \
+      st->d->resampler_buffer_input[i] = (float) (src[i] / scaling_factor);    \
     }                                                                          \
     ebur128_check_true_peak(st, frames);                                       \
   }                                                                            \
-  for (c = 0; c < st->channels; ++c) {                                         \
-    int ci = st->d->channel_map[c] - 1;                                        \
-    if (ci < 0) continue;                                                      \
-    else if (ci == EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */               \
-    for (i = 0; i < frames; ++i) {                                             \
-      st->d->v[ci][0] = (double) (src[i * st->channels + c] / scaling_factor)  \
-                   - st->d->a[1] * st->d->v[ci][1]                             \
-                   - st->d->a[2] * st->d->v[ci][2]                             \
-                   - st->d->a[3] * st->d->v[ci][3]                             \
-                   - st->d->a[4] * st->d->v[ci][4];                            \
-      audio_data[i * st->channels + c] =                                       \
-                     st->d->b[0] * st->d->v[ci][0]                             \
-                   + st->d->b[1] * st->d->v[ci][1]                             \
-                   + st->d->b[2] * st->d->v[ci][2]                             \
-                   + st->d->b[3] * st->d->v[ci][3]                             \
-                   + st->d->b[4] * st->d->v[ci][4];                            \
-      st->d->v[ci][4] = st->d->v[ci][3];                                       \
-      st->d->v[ci][3] = st->d->v[ci][2];                                       \
-      st->d->v[ci][2] = st->d->v[ci][1];                                       \
-      st->d->v[ci][1] = st->d->v[ci][0];                                       \
+  /* Filter all the channels of a frame together, which the compiler can       \
+   * vectorise, instead of one channel after another. Unused channels          \
+   * among them are filtered too but ignored when calculating the energy. */   \
+  for (i = 0; i < frames; ++i) {                                               \
+    const type* in = src + i * channels;                                       \
+    double* out = audio_data + i * channels;                                   \
+    for (c = 0; c < used; ++c) {                                               \
+      double v0 = (double) (in[c] / scaling_factor)                            \
+                - a[1] * v1[c] - a[2] * v2[c] - a[3] * v3[c] - a[4] * v4[c];   \
+      out[c] = b[0] * v0                                                       \
+             + b[1] * v1[c] + b[2] * v2[c] + b[3] * v3[c] + b[4] * v4[c];      \
+      v4[c] = v3[c];                                                           \
+      v3[c] = v2[c];                                                           \
+      v2[c] = v1[c];                                                           \
+      v1[c] = v0;                                                              \
     }                                                                          \
-    FLUSH_MANUALLY                                                             \
   }                                                                            \
+  FLUSH_MANUALLY                                                               \
   TURN_OFF_FTZ                                                                 \
 }
 EBUR128_FILTER(short, SHRT_MIN, SHRT_MAX)
@@ -616,34 +619,61 @@ static size_t find_histogram_index(double energy) {
   return index_min;
 }
 
+/** The number of channels whose energy is summed together. */
+#define SUM_CHANNELS 4
+
+/* Add the energy of some frames of the filtered audio to each channel.
+ * Each sum is a chain of dependent additions, so several channels are summed
+ * together to overlap their chains. Each channel still adds its frames in the
+ * same order, so the result is unchanged. */
+static void ebur128_sum_frames(ebur128_state* st, size_t first, size_t last,
+                               double* channel_sum) {
+  size_t channels = st->channels;
+  size_t i, c, k;
+  for (c = 0; c + SUM_CHANNELS <= channels; c += SUM_CHANNELS) {
+    const double* data = st->d->audio_data + c;
+    double sum[SUM_CHANNELS];
+    for (k = 0; k < SUM_CHANNELS; ++k) {
+      sum[k] = channel_sum[c + k];
+    }
+    for (i = first; i < last; ++i) {
+      for (k = 0; k < SUM_CHANNELS; ++k) {
+        sum[k] += data[i * channels + k] * data[i * channels + k];
+      }
+    }
+    for (k = 0; k < SUM_CHANNELS; ++k) {
+      channel_sum[c + k] = sum[k];
+    }
+  }
+  for (; c < channels; ++c) {
+    const double* data = st->d->audio_data + c;
+    double sum = channel_sum[c];
+    for (i = first; i < last; ++i) {
+      sum += data[i * channels] * data[i * channels];
+    }
+    channel_sum[c] = sum;
+  }
+}
+
 static int ebur128_calc_gating_block(ebur128_state* st, size_t frames_per_block,
                                      double* optional_output) {
-  size_t i, c;
+  size_t c;
   double sum = 0.0;
   double channel_sum;
+  size_t index = st->d->audio_data_index / st->channels;
+  for (c = 0; c < st->channels; ++c) {
+    st->d->channel_sum[c] = 0.0;
+  }
+  if (index < frames_per_block) {
+    ebur128_sum_frames(st, 0, index, st->d->channel_sum);
+    ebur128_sum_frames(st, st->d->audio_data_frames - (frames_per_block - index),
+                       st->d->audio_data_frames, st->d->channel_sum);
+  } else {
+    ebur128_sum_frames(st, index - frames_per_block, index, st->d->channel_sum);
+  }
   for (c = 0; c < st->channels; ++c) {
     if (st->d->channel_map[c] == EBUR128_UNUSED) continue;
-    channel_sum = 0.0;
-    if (st->d->audio_data_index < frames_per_block * st->channels) {
-      for (i = 0; i < st->d->audio_data_index / st->channels; ++i) {
-        channel_sum += st->d->audio_data[i * st->channels + c] *
-                       st->d->audio_data[i * st->channels + c];
-      }
-      for (i = st->d->audio_data_frames -
-              (frames_per_block -
-               st->d->audio_data_index / st->channels);
-           i < st->d->audio_data_frames; ++i) {
-        channel_sum += st->d->audio_data[i * st->channels + c] *
-                       st->d->audio_data[i * st->channels + c];
-      }
-    } else {
-      for (i = st->d->audio_data_index / st->channels - frames_per_block;
-           i < st->d->audio_data_index / st->channels;
-           ++i) {
-        channel_sum += st->d->audio_data[i * st->channels + c] *
-                       st->d->audio_data[i * st->channels + c];
-      }
-    }
+    channel_sum = st->d->channel_sum[c];
     if (st->d->channel_map[c] == EBUR128_Mp110 ||
         st->d->channel_map[c] == EBUR128_Mm110 ||
         st->d->channel_map[c] == EBUR128_Mp060 ||
@@ -718,6 +748,8 @@ int ebur128_change_parameters(ebur128_state* st,
     free(st->d->prev_sample_peak); st->d->prev_sample_peak = NULL;
     free(st->d->true_peak);   st->d->true_peak = NULL;
     free(st->d->prev_true_peak); st->d->prev_true_peak = NULL;
+    free(st->d->v);           st->d->v = NULL;
+    free(st->d->channel_sum); st->d->channel_sum = NULL;
     st->channels = channels;
 
     errcode = ebur128_init_channel_map(st);
@@ -731,12 +763,19 @@ int ebur128_change_parameters(ebur128_state* st,
     CHECK_ERROR(!st->d->true_peak, EBUR128_ERROR_NOMEM, exit)
     st->d->prev_true_peak = (double*) malloc(channels * sizeof(double));
     CHECK_ERROR(!st->d->prev_true_peak, EBUR128_ERROR_NOMEM, exit)
+    st->d->v = (double*) malloc(4 * channels * sizeof(double));
+    CHECK_ERROR(!st->d->v, EBUR128_ERROR_NOMEM, exit)
+    st->d->channel_sum = (double*) malloc(channels * sizeof(double));
+    CHECK_ERROR(!st->d->channel_sum, EBUR128_ERROR_NOMEM, exit)
     for (i = 0; i < channels; ++i) {
       st->d->sample_peak[i] = 0.0;
       st->d->prev_sample_peak[i] = 0.0;
       st->d->true_peak[i] = 0.0;
       st->d->prev_true_peak[i] = 0.0;
     }
+    for (i = 0; i < 4 * channels; ++i) {
+      st->d->v[i] = 0.0;
+    }
   }
   if (samplerate != st->samplerate) {
     st->samplerate = samplerate;
@@ -925,13 +964,88 @@ EBUR128_ADD_FRAMES(int)
 EBUR128_ADD_FRAMES(float)
 EBUR128_ADD_FRAMES(double)
 
+/* Frames already weighted by ebur128_weight_frames_float(). */
+typedef double weighted;
+
+static void ebur128_filter_weighted(ebur128_state* st, const weighted* src,
+                                    size_t frames) {
+  memcpy(st->d->audio_data + st->d->audio_data_index, src,
+         frames * st->channels * sizeof(double));
+}
+
+static int ebur128_add_frames_weighted(ebur128_state* st, const weighted* src,
+                                       size_t frames);
+EBUR128_ADD_FRAMES(weighted)
+
+int ebur128_weight_frames_float(ebur128_state* st, const float* src,
+                                size_t frames, double* weighted) {
+  double* audio_data = st->d->audio_data;
+  size_t audio_data_index = st->d->audio_data_index;
+  /* The resampler buffer holds at most 400ms of frames */
+  size_t chunk = st->d->samples_in_100ms * 4;
+  unsigned int c = 0;
+  for (c = 0; c < st->channels; c++) {
+    st->d->prev_sample_peak[c] = 0.0;
+    st->d->prev_true_peak[c] = 0.0;
+  }
+  /* Filter into the caller's buffer instead of the ring buffer */
+  st->d->audio_data = weighted;
+  st->d->audio_data_index = 0;
+  while (frames > 0) {
+    size_t n = frames < chunk ? frames : chunk;
+    ebur128_filter_float(st, src, n);
+    src += n * st->channels;
+    st->d->audio_data_index += n * st->channels;
+    frames -= n;
+  }
+  st->d->audio_data = audio_data;
+  st->d->audio_data_index = audio_data_index;
+  for (c = 0; c < st->channels; c++) {
+    if (st->d->prev_sample_peak[c] > st->d->sample_peak[c]) {
+      st->d->sample_peak[c] = st->d->prev_sample_peak[c];
+    }
+    if (st->d->prev_true_peak[c] > st->d->true_peak[c]) {
+      st->d->true_peak[c] = st->d->prev_true_peak[c];
+    }
+  }
+  return EBUR128_SUCCESS;
+}
+
+int ebur128_add_weighted_frames(ebur128_state* st, const double* weighted,
+                                size_t frames, const double* sample_peak,
+                                const double* true_peak) {
+  unsigned int c = 0;
+  int errcode;
+  if (((st->mode & EBUR128_MODE_SAMPLE_PEAK) == EBUR128_MODE_SAMPLE_PEAK &&
+       !sample_peak) ||
+      ((st->mode & EBUR128_MODE_TRUE_PEAK) == EBUR128_MODE_TRUE_PEAK &&
+       !true_peak)) {
+    return EBUR128_ERROR_INVALID_MODE;
+  }
+  errcode = ebur128_add_frames_weighted(st, weighted, frames);
+  if (errcode) return errcode;
+  for (c = 0; c < st->channels; c++) {
+    if ((st->mode & EBUR128_MODE_SAMPLE_PEAK) == EBUR128_MODE_SAMPLE_PEAK) {
+      st->d->prev_sample_peak[c] = sample_peak[c];
+      if (st->d->prev_sample_peak[c] > st->d->sample_peak[c]) {
+        st->d->sample_peak[c] = st->d->prev_sample_peak[c];
+      }
+    }
+    if ((st->mode & EBUR128_MODE_TRUE_PEAK) == EBUR128_MODE_TRUE_PEAK) {
+      st->d->prev_true_peak[c] = true_peak[c];
+      if (st->d->prev_true_peak[c] > st->d->true_peak[c]) {
+        st->d->true_peak[c] = st->d->prev_true_peak[c];
+      }
+    }
+  }
+  return EBUR128_SUCCESS;
+}
+
 static int ebur128_calc_relative_threshold(ebur128_state* st,
                                            size_t* above_thresh_counter,
                                            double* relative_threshold) {
   struct ebur128_dq_entry* it;
   size_t i;
-  *relative_threshold = 0.0;
-  *above_thresh_counter = 0;
 
   if (st->d->use_histogram) {
     for (i = 0; i < 1000; ++i) {
@@ -946,11 +1060,6 @@ static int ebur128_calc_relative_threshold(ebur128_state* st,
     }
   }
 
-  if (*above_thresh_counter != 0) {
-    *relative_threshold /= (double) *above_thresh_counter;
-    *relative_threshold *= relative_gate_factor;
-  }
-
   return EBUR128_SUCCESS;
 }
 
@@ -977,6 +1086,9 @@ static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
     return EBUR128_SUCCESS;
   }
 
+  relative_threshold /= (double) above_thresh_counter;
+  relative_threshold *= relative_gate_factor;
+
   above_thresh_counter = 0;
   if (relative_threshold < histogram_energy_boundaries[0]) {
     start_index = 0;
@@ -1013,8 +1125,8 @@ static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
 }
 
 int ebur128_relative_threshold(ebur128_state* st, double* out) {
-  double relative_threshold;
-  size_t above_thresh_counter;
+  double relative_threshold = 0.0;
+  size_t above_thresh_counter = 0;
 
   if (st && (st->mode & EBUR128_MODE_I) != EBUR128_MODE_I)
     return EBUR128_ERROR_INVALID_MODE;
@@ -1026,6 +1138,9 @@ int ebur128_relative_threshold(ebur128_state* st, double* out) {
       return EBUR128_SUCCESS;
   }
 
+  relative_threshold /= (double) above_thresh_counter;
+  relative_threshold *= relative_gate_factor;
+
   *out = ebur128_energy_to_loudness(relative_threshold);
   return EBUR128_SUCCESS;
 }
@@ -232,6 +232,48 @@ int ebur128_add_frames_double(ebur128_state* st,
                              const double* src,
                              size_t frames);
 
+/** \brief Filter frames for other states without adding them to this one.
+ *
+ *  Applies the K-weighting filter of \p st to \p src and keeps the sample
+ *  and true peaks of the frames as ebur128_add_frames_float() does, so that
+ *  several states measuring the same audio can share the work with
+ *  ebur128_add_weighted_frames(). The frames are not added to the loudness
+ *  of \p st. This is an addition of MLT to the bundled library.
+ *
+ *  @param st library state that keeps the filter state between calls.
+ *  @param src array of source frames. Channels must be interleaved.
+ *  @param frames number of frames. Not number of samples!
+ *  @param weighted array to receive frames * channels filtered samples.
+ *  @return
+ *    - EBUR128_SUCCESS on success.
+ */
+int ebur128_weight_frames_float(ebur128_state* st,
+                                const float* src,
+                                size_t frames,
+                                double* weighted);
+
+/** \brief Add frames filtered by ebur128_weight_frames_float().
+ *
+ *  The frames must come from a state with the same channels, sample rate
+ *  and channel map. This is an addition of MLT to the bundled library.
+ *
+ *  @param st library state.
+ *  @param weighted array of filtered frames.
+ *  @param frames number of frames. Not number of samples!
+ *  @param sample_peak the sample peak of each channel of the frames.
+ *  @param true_peak the true peak of each channel of the frames, may be
+ *         NULL if \p st does not measure it.
+ *  @return
+ *    - EBUR128_SUCCESS on success.
+ *    - EBUR128_ERROR_NOMEM on memory allocation error.
+ *    - EBUR128_ERROR_INVALID_MODE if a peak that \p st measures is NULL.
+ */
+int ebur128_add_weighted_frames(ebur128_state* st,
+                                const double* weighted,
+                                size_t frames,
+                                const double* sample_peak,
+                                const double* true_peak);
+
 /** \brief Get global integrated loudness in LUFS.
  *
  *  @param st library state.
@@ -55,8 +55,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 
 	RGB2UV_601_SCALED( r, g, b, u, v );
 
+	// The alpha channel is changed in place, so it must not be shared
 	*format = mlt_image_yuv422;
-	if ( mlt_frame_get_image( frame, image, format, width, height, writable ) == 0 )
+	if ( mlt_frame_get_image( frame, image, format, width, height, 1 ) == 0 )
 	{
 		uint8_t *alpha = mlt_frame_get_alpha( frame );
 		if ( !alpha )
@@ -53,7 +53,7 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	RGB2UV_601_SCALED( r, g, b, u, v );
 
 	*format = mlt_image_yuv422;
-	if ( mlt_frame_get_image( frame, image, format, width, height, writable ) == 0 )
+	if ( mlt_frame_get_image( frame, image, format, width, height, 1 ) == 0 )
 	{
 		uint8_t alpha = 0;
 		uint8_t *p = *image;
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <math.h>
 #include <ebur128.h>
+#include "audio_analysis.h"
 
 typedef struct
 {
@@ -75,7 +76,7 @@ static void check_for_reset( mlt_filter filter, int channels, int frequency )
 	}
 }
 
-static void analyze_audio( mlt_filter filter, void* buffer, int samples, int frequency )
+static void analyze_audio( mlt_filter filter, mlt_frame frame, void* buffer, int samples, int frequency, int channels )
 {
 	mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
 	private_data* pdata = (private_data*)filter->child;
@@ -84,7 +85,12 @@ static void analyze_audio( mlt_filter filter, void* buffer, int samples, int fre
 	mlt_profile profile = mlt_service_profile( MLT_FILTER_SERVICE(filter) );
 	double fps = mlt_profile_fps( profile );
 
-	ebur128_add_frames_float( pdata->r128, buffer, samples );
+	// Share the filtering with other meters on this audio
+	audio_analysis analysis = audio_analysis_get( filter, frame, buffer, frequency, channels, samples, pdata->r128->mode );
+	if ( analysis )
+		audio_analysis_add_frames( pdata->r128, analysis );
+	else
+		ebur128_add_frames_float( pdata->r128, buffer, samples );
 
 	if( pdata->time_elapsed_ms < 400 )
 	{
@@ -157,7 +163,7 @@ static int filter_get_audio( mlt_frame frame, void **buffer, mlt_audio_format *f
 	if( o_pos != pdata->prev_o_pos )
 	{
 		// Only analyze the audio is the producer is not paused.
-		analyze_audio( filter, *buffer, *samples, *frequency );
+		analyze_audio( filter, frame, *buffer, *samples, *frequency, *channels );
 	}
 
 	double start_coeff = pdata->start_gain > -90.0 ? pow(10.0, pdata->start_gain / 20.0) : 0.0;
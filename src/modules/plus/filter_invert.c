@@ -19,6 +19,7 @@
 
 #include <framework/mlt_filter.h>
 #include <framework/mlt_frame.h>
+#include <framework/mlt_slices.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,6 +31,38 @@ static inline int clamp( int v, int l, int u )
 	return v < l ? l : ( v > u ? u : v );
 }
 
+/** \brief the work shared by the slices of an inversion */
+
+struct invert_desc
+{
+	uint8_t *image;
+	int width;
+	int height;
+};
+
+/** Invert a slice of rows of a yuv422 image.
+*/
+
+static int invert_slice( int id, int index, int jobs, void *cookie )
+{
+	(void) id; // unused
+	struct invert_desc *d = cookie;
+	int slice_height = ( d->height + jobs - 1 ) / jobs;
+	int first = index * slice_height;
+	int rows = MIN( slice_height, d->height - first );
+	uint8_t *p = d->image + first * d->width * 2;
+	uint8_t *q = p + ( rows > 0 ? rows * d->width * 2 : 0 );
+
+	while ( p != q )
+	{
+		*p = clamp( 251 - *p, 16, 235 );
+		p ++;
+		*p = clamp( 256 - *p, 16, 240 );
+		p ++;
+	}
+	return 0;
+}
+
 /** Do it :-).
 */
 
@@ -45,15 +78,13 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	// Only process if we have no error and a valid colour space
 	if ( error == 0 )
 	{
-		uint8_t *p = *image;
-		uint8_t *q = *image + *width * *height * 2;
-		uint8_t *r = *image;
-
-		while ( p != q )
-		{
-			*p ++ = clamp( 251 - *r ++, 16, 235 );
-			*p ++ = clamp( 256 - *r ++, 16, 240 );
-		}
+		// The arithmetic is quicker than a lookup table, so only split the rows.
+		struct invert_desc desc = { *image, *width, *height };
+		int jobs = MIN( mlt_slices_count_normal(), *height );
+		if ( jobs > 1 )
+			mlt_slices_run_normal( jobs, invert_slice, &desc );
+		else
+			invert_slice( 0, 0, 1, &desc );
 
 		if ( mask )
 		{
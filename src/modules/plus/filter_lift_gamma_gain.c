@@ -110,11 +110,10 @@ static void refresh_lut( mlt_filter filter, mlt_frame frame )
 static void apply_lut( mlt_filter filter, uint8_t* image, mlt_image_format format, int width, int height )
 {
 	private_data* self = (private_data*)filter->child;
-	uint8_t* rlut = malloc( sizeof(self->rlut) );
-	uint8_t* glut = malloc( sizeof(self->glut) );
-	uint8_t* blut = malloc( sizeof(self->blut) );
-	int total = width * height + 1;
-	uint8_t* sample = image;
+	uint8_t rlut[256];
+	uint8_t glut[256];
+	uint8_t blut[256];
+	const uint8_t* luts[4] = { rlut, glut, blut, NULL };
 
 	// Copy the LUT so that we can be frame-thread safe.
 	mlt_service_lock( MLT_FILTER_SERVICE( filter ) );
@@ -123,38 +122,9 @@ static void apply_lut( mlt_filter filter, uint8_t* image, mlt_image_format forma
 	memcpy( blut, self->blut, sizeof(self->blut) );
 	mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
 
-	switch( format )
-	{
-	case mlt_image_rgb:
-		while( --total )
-		{
-			*sample = rlut[ *sample ];
-			sample++;
-			*sample = glut[ *sample ];
-			sample++;
-			*sample = blut[ *sample ];
-			sample++;
-		}
-		break;
-	case mlt_image_rgba:
-		while( --total )
-		{
-			*sample = rlut[ *sample ];
-			sample++;
-			*sample = glut[ *sample ];
-			sample++;
-			*sample = blut[ *sample ];
-			sample++;
-			sample++; // Skip alpha
-		}
-		break;
-	default:
+	// The alpha of rgba is left as it is.
+	if ( mlt_image_apply_luts( image, format, width, height, luts ) )
 		mlt_log_error( MLT_FILTER_SERVICE( filter ), "Invalid image format: %s\n", mlt_image_format_name( format ) );
-		break;
-	}
-	free( rlut );
-	free( glut );
-	free( blut );
 }
 
 static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable )
@@ -89,6 +89,37 @@ static void init_apply_data( mlt_filter filter )
 	}
 }
 
+static void store_results( mlt_filter filter, ebur128_state** states, size_t count )
+{
+	mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
+	double loudness = 0.0;
+	double range = 0.0;
+	double tmpPeak = 0.0;
+	double peak = 0.0;
+	size_t i = 0;
+	unsigned int c = 0;
+	char result[MAX_RESULT_SIZE];
+	ebur128_loudness_global_multiple( states, count, &loudness );
+	ebur128_loudness_range_multiple( states, count, &range );
+
+	for ( i = 0; i < count; i++ )
+	{
+		for ( c = 0; c < states[i]->channels; c++ )
+		{
+			ebur128_sample_peak( states[i], c, &tmpPeak );
+			if( tmpPeak > peak )
+			{
+				peak = tmpPeak;
+			}
+		}
+	}
+
+	snprintf( result, MAX_RESULT_SIZE, "L: %lf\tR: %lf\tP %lf", loudness, range, peak );
+	result[ MAX_RESULT_SIZE - 1 ] = '\0';
+	mlt_log_info( MLT_FILTER_SERVICE( filter ), "Stored results: %s\n", result );
+	mlt_properties_set( properties, "results", result );
+}
+
 static void analyze( mlt_filter filter, mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples )
 {
 	private_data* private = (private_data*)filter->child;
@@ -113,30 +144,12 @@ static void analyze( mlt_filter filter, mlt_frame frame, void **buffer, mlt_audi
 
 		if ( pos + 1 == mlt_filter_get_length2( filter, frame ) )
 		{
-			mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
-			double loudness = 0.0;
-			double range = 0.0;
-			double tmpPeak = 0.0;
-			double peak = 0.0;
-			int i = 0;
-			char result[MAX_RESULT_SIZE];
-			ebur128_loudness_global( private->analyze->state, &loudness );
-			ebur128_loudness_range( private->analyze->state, &range );
-
-			for ( i = 0; i < *channels; i++ )
+			// A chunk of mlt_filter_analyze() keeps its state to be merged
+			if ( !mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "_analysis_first" ) )
 			{
-				ebur128_sample_peak( private->analyze->state, i, &tmpPeak );
-				if( tmpPeak > peak )
-				{
-					peak = tmpPeak;
-				}
+				store_results( filter, &private->analyze->state, 1 );
+				destroy_analyze_data( filter );
 			}
-
-			snprintf( result, MAX_RESULT_SIZE, "L: %lf\tR: %lf\tP %lf", loudness, range, peak );
-			result[ MAX_RESULT_SIZE - 1 ] = '\0';
-			mlt_log_info( MLT_FILTER_SERVICE( filter ), "Stored results: %s\n", result );
-			mlt_properties_set( properties, "results", result );
-			destroy_analyze_data( filter );
 		}
 
 		private->last_position = pos;
@@ -169,6 +182,36 @@ static void apply( mlt_filter filter, mlt_frame frame, void **buffer, mlt_audio_
 	}
 }
 
+/** Merge the analysis of the chunks from mlt_filter_analyze().
+*/
+
+static void analysis_merge( mlt_properties owner, mlt_filter filter, mlt_event_data event_data )
+{
+	mlt_properties chunks = mlt_event_data_to_object( event_data );
+	int count = mlt_properties_count( chunks );
+	ebur128_state** states = calloc( count, sizeof( ebur128_state* ) );
+	int i = 0;
+
+	for ( i = 0; i < count; i++ )
+	{
+		mlt_filter chunk = mlt_properties_get_data_at( chunks, i, NULL );
+		private_data* private = chunk ? (private_data*)chunk->child : NULL;
+		if ( !private || !private->analyze )
+		{
+			mlt_log_error( MLT_FILTER_SERVICE( filter ), "Analysis Failed: Missing chunk %d\n", i );
+			break;
+		}
+		states[i] = private->analyze->state;
+	}
+	if ( count > 0 && i == count )
+	{
+		mlt_service_lock( MLT_FILTER_SERVICE( filter ) );
+		store_results( filter, states, count );
+		mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
+	}
+	free( states );
+}
+
 /** Get the audio.
 */
 
@@ -242,6 +285,14 @@ mlt_filter filter_loudness_init( mlt_profile profile, mlt_service_type type, con
 		mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
 		mlt_properties_set( properties, "program", "-23.0" );
 
+		// Let mlt_filter_analyze() analyse chunks in parallel. Priming each
+		// chunk with 300 ms of the previous one recovers the 400 ms gating
+		// blocks that straddle the boundary.
+		mlt_properties_set_int( properties, "_analysis_audio", 1 );
+		mlt_properties_set_double( properties, "_analysis_overlap", 0.3 );
+		mlt_events_register( properties, "analysis-merge" );
+		mlt_events_listen( properties, filter, "analysis-merge", (mlt_listener) analysis_merge );
+
 		data->analyze = NULL;
 
 		filter->close = filter_close;
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <math.h>
 #include <ebur128.h>
+#include "audio_analysis.h"
 
 typedef struct
 {
@@ -109,14 +110,19 @@ static void check_for_reset( mlt_filter filter, int channels, int frequency )
 	}
 }
 
-static void analyze_audio( mlt_filter filter, void* buffer, int samples )
+static void analyze_audio( mlt_filter filter, mlt_frame frame, void* buffer, int frequency, int channels, int samples )
 {
 	mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
 	private_data* pdata = (private_data*)filter->child;
 	int result = -1;
 	double loudness = 0.0;
 
-	ebur128_add_frames_float( pdata->r128, buffer, samples );
+	// Share the filtering and peaks with other meters on this audio
+	audio_analysis analysis = audio_analysis_get( filter, frame, buffer, frequency, channels, samples, pdata->r128->mode );
+	if ( analysis )
+		audio_analysis_add_frames( pdata->r128, analysis );
+	else
+		ebur128_add_frames_float( pdata->r128, buffer, samples );
 
 	if( mlt_properties_get_int( MLT_FILTER_PROPERTIES(filter), "calc_program" ) )
 	{
@@ -221,7 +227,7 @@ static int filter_get_audio( mlt_frame frame, void **buffer, mlt_audio_format *f
 	if( pos != pdata->prev_pos )
 	{
 		// Only analyze the audio if the producer is not paused.
-		analyze_audio( filter, *buffer, *samples );
+		analyze_audio( filter, frame, *buffer, *frequency, *channels, *samples );
 	}
 
 	pdata->prev_pos = pos;
@@ -29,7 +29,7 @@
 
 /** Fill channel lut with integers parsed from property string.
 */
-static void fill_channel_lut(int lut[], char* channel_table_str)
+static void fill_channel_lut(uint8_t lut[], char* channel_table_str)
 {
 	mlt_tokeniser tokeniser = mlt_tokeniser_init();
 	mlt_tokeniser_parse_new( tokeniser, channel_table_str, ";" );
@@ -43,7 +43,7 @@ static void fill_channel_lut(int lut[], char* channel_table_str)
 		for( i = 0; i < 256; i++ )
 		{
 			val = atoi(tokeniser->tokens[i]);
-			lut[i] = val;
+			lut[i] = (uint8_t) val;
 		}
 	}
 	else
@@ -66,7 +66,7 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	mlt_filter filter = mlt_frame_pop_service( frame );
 
 	*format = mlt_image_rgb;
-	int error = mlt_frame_get_image( frame, image, format, width, height, 0 );
+	int error = mlt_frame_get_image( frame, image, format, width, height, 1 );
 
 	// Only process if we have no error and a valid colour space
 	if ( error == 0 )
@@ -74,27 +74,20 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 
 		// Create lut tables from properties for each RGB channel
 		char* r_str = mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "R_table" );
-		int r_lut[256];
+		uint8_t r_lut[256];
 		fill_channel_lut( r_lut, r_str );
 
 		char* g_str = mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "G_table" );
-		int g_lut[256];
+		uint8_t g_lut[256];
 		fill_channel_lut( g_lut, g_str );
 
 		char* b_str = mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "B_table" );
-		int b_lut[256];
+		uint8_t b_lut[256];
 		fill_channel_lut( b_lut, b_str );
 
 		// Apply look-up tables into image
-		int i = *width * *height + 1;
-		uint8_t *p = *image;
-		uint8_t *r = *image;
-		while ( --i )
-		{
-			*p ++ = r_lut[ *r ++ ];
-			*p ++ = g_lut[ *r ++ ];
-			*p ++ = b_lut[ *r ++ ];
-		}
+		const uint8_t *luts[4] = { r_lut, g_lut, b_lut, NULL };
+		mlt_image_apply_luts( *image, *format, *width, *height, luts );
 	}
 
 	return error;
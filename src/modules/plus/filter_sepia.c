@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 /** Do it :-).
 */
@@ -42,34 +43,17 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	// Only process if we have no error and a valid colour space
 	if ( error == 0 && *image )
 	{
-		// We modify the whole image
-		uint8_t *p = *image;
-		int h = *height;
-		int uneven = *width % 2;
-		int w = ( *width - uneven ) / 2;
-		int t;
-
 		// Get u and v values
 		int u = mlt_properties_anim_get_int( properties, "u", position, length );
 		int v = mlt_properties_anim_get_int( properties, "v", position, length );
 
-		// Loop through image
-		while( h -- )
-		{
-			t = w;
-			while( t -- )
-			{
-				p ++;
-				*p ++ = u;
-				p ++;
-				*p ++ = v;
-			}
-			if ( uneven )
-			{
-				p ++;
-				*p ++ = u;
-			}
-		}
+		// Map every chroma value to the tint
+		uint8_t u_lut[ 256 ];
+		uint8_t v_lut[ 256 ];
+		const uint8_t *luts[ 4 ] = { NULL, u_lut, v_lut, NULL };
+		memset( u_lut, (uint8_t) u, sizeof( u_lut ) );
+		memset( v_lut, (uint8_t) v, sizeof( v_lut ) );
+		mlt_image_apply_luts( *image, *format, *width, *height, luts );
 	}
 
 	return error;
@@ -24,6 +24,66 @@
 #include <framework/mlt_factory.h>
 #include <framework/mlt_frame.h>
 #include <framework/mlt_producer.h>
+#include <framework/mlt_slices.h>
+
+/** \brief the work shared by the slices of a threshold */
+
+struct threshold_desc
+{
+	uint8_t *image;
+	const uint8_t *alpha;
+	int width;
+	int height;
+	int midpoint;
+	int use_alpha;
+	uint8_t A;
+	uint8_t B;
+};
+
+/** Threshold the luma, or the alpha when asked, of a slice of rows and make it grey.
+*/
+
+static int threshold_slice( int id, int index, int jobs, void *cookie )
+{
+	(void) id; // unused
+	struct threshold_desc *d = cookie;
+	int slice_height = ( d->height + jobs - 1 ) / jobs;
+	int first = index * slice_height;
+	int rows = MIN( slice_height, d->height - first );
+	int size = rows > 0 ? rows * d->width : 0;
+	uint8_t *p = d->image + first * d->width * 2;
+	const uint8_t *alpha = d->alpha ? d->alpha + first * d->width : NULL;
+	int midpoint = d->midpoint;
+	uint8_t A = d->A;
+	uint8_t B = d->B;
+	int i;
+
+	if ( !d->use_alpha )
+	{
+		for ( i = 0; i < size; i ++ )
+		{
+			p[ 2 * i ] = p[ 2 * i ] < midpoint? A : B;
+			p[ 2 * i + 1 ] = 128;
+		}
+	}
+	else if ( alpha )
+	{
+		for ( i = 0; i < size; i ++ )
+		{
+			p[ 2 * i ] = alpha[ i ] < midpoint? A : B;
+			p[ 2 * i + 1 ] = 128;
+		}
+	}
+	else
+	{
+		for ( i = 0; i < size; i ++ )
+		{
+			p[ 2 * i ] = B;
+			p[ 2 * i + 1 ] = 128;
+		}
+	}
+	return 0;
+}
 
 /** Get the images and apply the luminance of the mask to the alpha of the frame.
 */
@@ -34,7 +94,7 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 
 	// Render the frame
 	*format = mlt_image_yuv422;
-	if ( mlt_frame_get_image( frame, image, format, width, height, writable ) == 0 )
+	if ( mlt_frame_get_image( frame, image, format, width, height, 1 ) == 0 )
 	{
 		mlt_properties properties = mlt_filter_properties(filter);
 		mlt_position position = mlt_filter_get_position(filter, frame);
@@ -45,45 +105,21 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 		int full_luma = mlt_properties_get_int(MLT_FRAME_PROPERTIES(frame), "full_luma");
 		uint8_t white = full_luma? 255 : 235;
 		uint8_t black = full_luma? 0 : 16;
-		uint8_t *p = *image;
-		uint8_t A = invert? white : black;
-		uint8_t B = invert? black : white;
-		int size = *width * *height + 1;
+		struct threshold_desc desc;
+		int jobs = MIN( mlt_slices_count_normal(), *height );
 
-		if ( !use_alpha )
-		{
-			while (--size)
-			{
-				if ( *p < midpoint )
-					*p ++ = A;
-				else
-					*p ++ = B;
-				*p ++ = 128;
-			}
-		}
+		desc.image = *image;
+		desc.alpha = use_alpha? mlt_frame_get_alpha( frame ) : NULL;
+		desc.width = *width;
+		desc.height = *height;
+		desc.midpoint = midpoint;
+		desc.use_alpha = use_alpha;
+		desc.A = invert? white : black;
+		desc.B = invert? black : white;
+		if ( jobs > 1 )
+			mlt_slices_run_normal( jobs, threshold_slice, &desc );
 		else
-		{
-			uint8_t *alpha = mlt_frame_get_alpha( frame );
-			if ( alpha )
-			{
-				while (--size)
-				{
-					if ( *alpha ++ < midpoint )
-						*p ++ = A;
-					else
-						*p ++ = B;
-					*p ++ = 128;
-				}
-			}
-			else
-			{
-				while (--size)
-				{
-					*p ++ = B;
-					*p ++ = 128;
-				}
-			}
-		}
+			threshold_slice( 0, 0, 1, &desc );
 	}
 
 	return 0;
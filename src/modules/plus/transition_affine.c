@@ -321,28 +321,70 @@ struct sliced_desc
 	double x_offset, y_offset;
 	int b_alpha;
 	double minima, xmax, ymax;
+	int left, top, right, bottom;
 };
 
+// Limit the output to the pixels that map into a region of the b image
+static void affine_bounds( struct sliced_desc *desc, double x0, double y0, double x1, double y1 )
+{
+	double (*m)[3] = desc->affine.matrix;
+	double det = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+	double corners[4][2] = { { x0, y0 }, { x1, y0 }, { x0, y1 }, { x1, y1 } };
+	double min_x = DBL_MAX, min_y = DBL_MAX, max_x = -DBL_MAX, max_y = -DBL_MAX;
+	int i;
+
+	desc->left = 0;
+	desc->top = 0;
+	desc->right = desc->a_width;
+	desc->bottom = desc->a_height;
+	if ( x1 < x0 || y1 < y0 )
+	{
+		desc->right = 0;
+		desc->bottom = 0;
+		return;
+	}
+	if ( fabs( det ) < 1e-9 )
+		return;
+
+	for ( i = 0; i < 4; i ++ )
+	{
+		// Invert the mapping of sliced_proc() for this corner
+		double u = ( corners[i][0] - desc->x_offset ) * desc->dz - m[0][2];
+		double v = ( corners[i][1] - desc->y_offset ) * desc->dz - m[1][2];
+		double x = ( m[1][1] * u - m[0][1] * v ) / det - desc->lower_x;
+		double y = ( m[0][0] * v - m[1][0] * u ) / det - desc->lower_y;
+		min_x = MIN( min_x, x );
+		max_x = MAX( max_x, x );
+		min_y = MIN( min_y, y );
+		max_y = MAX( max_y, y );
+	}
+
+	// Widen by a pixel for rounding
+	desc->left = CLAMP( floor( min_x ) - 1, 0, desc->a_width );
+	desc->top = CLAMP( floor( min_y ) - 1, 0, desc->a_height );
+	desc->right = CLAMP( ceil( max_x ) + 2, desc->left, desc->a_width );
+	desc->bottom = CLAMP( ceil( max_y ) + 2, desc->top, desc->a_height );
+}
+
 static int sliced_proc( int id, int index, int jobs, void* cookie )
 {
 	(void) id; // unused
 	struct sliced_desc ctx = *((struct sliced_desc*) cookie);
 	int height_slice = (ctx.a_height + jobs / 2) / jobs;
-	int starty = height_slice * index;
+	int starty = MAX(height_slice * index, ctx.top);
+	int endy = MIN(height_slice * (index + 1), ctx.bottom);
 	double x, y;
 	double dx, dy;
 	int i, j;
 
-	ctx.a_image += (index * height_slice) * (ctx.a_width * 4);
-	for (i = 0, y = ctx.lower_y; i < ctx.a_height; i++, y++) {
-		if (i >= starty && i < (starty + height_slice)) {
-			for (j = 0, x = ctx.lower_x; j < ctx.a_width; j++, x++) {
-				dx = MapX( ctx.affine.matrix, x, y ) / ctx.dz + ctx.x_offset;
-				dy = MapY( ctx.affine.matrix, x, y ) / ctx.dz + ctx.y_offset;
-				if (dx >= ctx.minima && dx <= ctx.xmax && dy >= ctx.minima && dy <= ctx.ymax)
-					ctx.interp(ctx.b_image, ctx.b_width, ctx.b_height, dx, dy, ctx.mix, ctx.a_image, ctx.b_alpha);
-				ctx.a_image += 4;
-			}
+	for (i = starty, y = ctx.lower_y + starty; i < endy; i++, y++) {
+		uint8_t *a_image = ctx.a_image + (i * ctx.a_width + ctx.left) * 4;
+		for (j = ctx.left, x = ctx.lower_x + ctx.left; j < ctx.right; j++, x++) {
+			dx = MapX( ctx.affine.matrix, x, y ) / ctx.dz + ctx.x_offset;
+			dy = MapY( ctx.affine.matrix, x, y ) / ctx.dz + ctx.y_offset;
+			if (dx >= ctx.minima && dx <= ctx.xmax && dy >= ctx.minima && dy <= ctx.ymax)
+				ctx.interp(ctx.b_image, ctx.b_width, ctx.b_height, dx, dy, ctx.mix, a_image, ctx.b_alpha);
+			a_image += 4;
 		}
 	}
 	return 0;
@@ -652,6 +694,15 @@ static int transition_get_image( mlt_frame a_frame, uint8_t **image, mlt_image_f
 		}
 		free( interps );
 
+		// Only touch the pixels that map into the b image, or into the region of it with content,
+		// unless the transparent pixels of the b image set the alpha
+		mlt_rect content;
+		if ( !desc.b_alpha && mlt_frame_get_image_content( b_frame, &content ) )
+			affine_bounds( &desc, MAX( desc.minima, floor( content.x ) - 2 ), MAX( desc.minima, floor( content.y ) - 2 ),
+				MIN( desc.xmax, ceil( content.x + content.w ) + 2 ), MIN( desc.ymax, ceil( content.y + content.h ) + 2 ) );
+		else
+			affine_bounds( &desc, desc.minima, desc.minima, desc.xmax, desc.ymax );
+
 		// Do the transform with interpolation
 		if (threads == 1)
 			sliced_proc(0, 0, 1, &desc);
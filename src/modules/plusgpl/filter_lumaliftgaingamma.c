@@ -88,7 +88,7 @@ static double lut_value( double value, double lift, double gain, double gamma )
 	return value;
 }
 
-static void fill_lgg_lut(int lgg_lut[], double lift, double gain, double gamma)
+static void fill_lgg_lut(uint8_t lgg_lut[], double lift, double gain, double gamma)
 {
 	int i;
 	double val;
@@ -110,7 +110,7 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 	mlt_position length = mlt_filter_get_length2( filter, frame );
 
 	*format = mlt_image_rgb;
-	int error = mlt_frame_get_image( frame, image, format, width, height, 0 );
+	int error = mlt_frame_get_image( frame, image, format, width, height, 1 );
 
 	// Only process if we have no error and a valid colour space
 	if ( error == 0 )
@@ -124,19 +124,12 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 		gamma = clamp( gamma, -1.0, 1.0 );
 
 		// Build lut
-		int lgg_lut[256];
+		uint8_t lgg_lut[256];
 		fill_lgg_lut( lgg_lut, lift, gain, gamma);
 
 		// Filter
-		int i = *width * *height + 1;
-		uint8_t *p = *image;
-		uint8_t *r = *image;
-		while ( --i )
-		{
-			*p ++ = lgg_lut[ *r ++ ];
-			*p ++ = lgg_lut[ *r ++ ];
-			*p ++ = lgg_lut[ *r ++ ];
-		}
+		const uint8_t *luts[4] = { lgg_lut, lgg_lut, lgg_lut, NULL };
+		mlt_image_apply_luts( *image, *format, *width, *height, luts );
 	}
 
 	return error;
@@ -20,7 +20,9 @@
 
 #include <framework/mlt_filter.h>
 #include <framework/mlt_frame.h>
+#include <framework/mlt_image.h>
 #include <framework/mlt_profile.h>
+#include <framework/mlt_slices.h>
 
 #include "cJSON.h"
 
@@ -45,6 +47,59 @@ typedef struct BPointF
     struct PointF h2;
 } BPointF;
 
+/** A keyframe of the spline, parsed once for all frames */
+typedef struct Keyframe
+{
+    mlt_position position;
+    int count;
+    BPointF *points;
+} Keyframe;
+
+/** The parsed spline: a single keyframe when it is not animated */
+typedef struct Spline
+{
+    int count;
+    Keyframe *keyframes;
+} Spline;
+
+/** The mask rasterised last, which frames with the same shape reuse */
+typedef struct Mask
+{
+    BPointF *points;
+    int count;
+    int width;
+    int height;
+    int invert;
+    int antialias;
+    int feather;
+    int feather_passes;
+    uint8_t *map;
+} Mask;
+
+/** An edge of the polygon for the scanline rasteriser */
+typedef struct Edge
+{
+    double x, y;      // the vertex where the edge starts
+    double dx, dy;    // the distance to the vertex where it ends
+    double y2;        // the row of the vertex where it ends
+    int top, bottom;  // the first and last rows that the edge may cross
+} Edge;
+
+/** The polygon to fill and the map to fill it into, shared by the slices */
+typedef struct FillDesc
+{
+    Edge *edges;
+    int count;
+    int width;
+    int height;
+    int invert;
+    int antialias;
+    uint8_t *map;
+} FillDesc;
+
+/** The number of sub-scanlines sampled per row when antialiasing */
+#define SUBSCANLINES 4
+
 enum MODES { MODE_RGB, MODE_ALPHA, MODE_LUMA };
 const char *MODESTR[3] = { "rgb", "alpha", "luma" };
 
@@ -87,12 +142,6 @@ static inline void lerpHalf( const PointF *a, const PointF *b, PointF *result )
     result->y = ( a->y + b->y ) * .5;
 }
 
-/** Helper for using qsort with an array of integers. */
-int ncompare( const void *a, const void *b )
-{
-    return *(const int*)a - *(const int*)b;
-}
-
 /** Turns a json array with two children into a point (x, y tuple). */
 static void jsonGetPoint( cJSON *json, PointF *point )
 {
@@ -134,65 +183,109 @@ static int json2BCurves( cJSON *array, BPointF **points )
     return i;
 }
 
-/** Blurs \param src horizontally. \See function blur. */
-static void blurHorizontal( uint8_t *src, uint8_t *dst, int width, int height, int radius)
+static void freeSpline( Spline *spline )
 {
-    int x, y, kx, yOff, total, amount, amountInit;
-    amountInit = radius * 2 + 1;
-    for (y = 0; y < height; ++y)
+    int i;
+    for ( i = 0; i < spline->count; i++ )
+        mlt_pool_release( spline->keyframes[i].points );
+    free( spline->keyframes );
+    free( spline );
+}
+
+/**
+ * Parses the json of the spline into its keyframes.
+ * \param string the value of the property "spline"
+ * \return the spline, without keyframes if \param string is not valid
+ */
+static Spline *parseSpline( const char *string )
+{
+    Spline *spline = calloc( 1, sizeof( Spline ) );
+    cJSON *root = cJSON_Parse( string );
+
+    if ( spline && root && root->type == cJSON_Array )
     {
-        total = 0;
-        yOff = y * width;
-        // Process entire window for first pixel
-        int size = MIN(radius + 1, width);
-        for ( kx = 0; kx < size; ++kx )
-            total += src[yOff + kx];
-        dst[yOff] = total / ( radius + 1 );
-        // Subsequent pixels just update window total
-        for ( x = 1; x < width; ++x )
+        /*
+         * constant
+         */
+        spline->keyframes = calloc( 1, sizeof( Keyframe ) );
+        if ( spline->keyframes )
         {
-            amount = amountInit;
-            // Subtract pixel leaving window
-            if ( x - radius - 1 >= 0 )
-                total -= src[yOff + x - radius - 1];
-            else
-                amount -= radius - x;
-            // Add pixel entering window
-            if ( x + radius < width )
-                total += src[yOff + x + radius];
-            else
-                amount -= radius - width + x;
-            dst[yOff + x] = total / amount;
+            spline->count = 1;
+            spline->keyframes[0].count = json2BCurves( root, &spline->keyframes[0].points );
         }
     }
+    else if ( spline && root && root->type == cJSON_Object )
+    {
+        /*
+         * keyframes
+         */
+        cJSON *keyframe;
+        int count = cJSON_GetArraySize( root );
+        spline->keyframes = calloc( count, sizeof( Keyframe ) );
+        for ( keyframe = root->child; spline->keyframes && keyframe && spline->count < count; keyframe = keyframe->next )
+        {
+            Keyframe *k = &spline->keyframes[spline->count++];
+            k->position = atoi( keyframe->string );
+            k->count = json2BCurves( keyframe, &k->points );
+        }
+    }
+
+    cJSON_Delete( root );
+    return spline;
 }
 
-/** Blurs \param src vertically. \See function blur. */
-static void blurVertical( uint8_t *src, uint8_t *dst, int width, int height, int radius)
+/**
+ * Determines the Bézier points of the spline at a time.
+ * \param spline the parsed spline
+ * \param time the position of the frame
+ * \param points will be allocated and filled with the points
+ * \return the number of points, or -1 if the spline has no keyframes
+ */
+static int splinePoints( Spline *spline, mlt_position time, BPointF **points )
 {
-    int x, y, ky, total, amount, amountInit;
-    amountInit = radius * 2 + 1;
-    for (x = 0; x < width; ++x)
+    Keyframe *keyframe, *keyframeOld;
+    int i, count;
+
+    if ( !spline->count )
+        return -1;
+
+    keyframe = keyframeOld = spline->keyframes;
+    while ( keyframe->position < time && keyframe + 1 < spline->keyframes + spline->count )
     {
-        total = 0;
-        int size = MIN(radius + 1, height);
-        for ( ky = 0; ky < size; ++ky )
-            total += src[x + ky * width];
-        dst[x] = total / ( radius + 1 );
-        for ( y = 1; y < height; ++y )
+        keyframeOld = keyframe;
+        keyframe++;
+    }
+
+    if ( keyframeOld->position >= keyframe->position || time >= keyframe->position )
+    {
+        // keyframes in wrong order or before first / after last keyframe
+        count = keyframe->count;
+        *points = mlt_pool_alloc( count * sizeof( BPointF ) );
+        if ( *points )
+            memcpy( *points, keyframe->points, count * sizeof( BPointF ) );
+    }
+    else
+    {
+        /*
+         * pos1 < time < pos2
+         */
+
+        BPointF *p1 = keyframeOld->points, *p2 = keyframe->points;
+
+        // range 0-1
+        double position = ( time - keyframeOld->position ) / (double)( keyframe->position - keyframeOld->position );
+
+        count = MIN( keyframeOld->count, keyframe->count );  // additional points are ignored
+        *points = mlt_pool_alloc( count * sizeof( BPointF ) );
+        for ( i = 0; *points && i < count; i++ )
         {
-            amount = amountInit;
-            if ( y - radius - 1 >= 0 )
-                total -= src[( y - radius - 1 ) * width + x];
-            else
-                amount -= radius - y;
-            if ( y + radius < height )
-                total += src[( y + radius ) * width + x];
-            else
-                amount -= radius - height + y;
-            dst[y * width + x] = total / amount;
+            lerp( &(p1[i].h1), &(p2[i].h1), &((*points)[i].h1), position );
+            lerp( &(p1[i].p), &(p2[i].p), &((*points)[i].p), position );
+            lerp( &(p1[i].h2), &(p2[i].h2), &((*points)[i].h2), position );
         }
     }
+
+    return *points ? count : -1;
 }
 
 /**
@@ -205,19 +298,174 @@ static void blurVertical( uint8_t *src, uint8_t *dst, int width, int height, int
  */
 static void blur( uint8_t *map, int width, int height, int radius, int passes )
 {
-    uint8_t *src = mlt_pool_alloc( width * height );
-    uint8_t *tmp = mlt_pool_alloc( width * height );
-
     int i;
     for ( i = 0; i < passes; ++i )
     {
-        memcpy( src, map, width * height );
-        blurHorizontal( src, tmp, width, height, radius );
-        blurVertical( tmp, map, width, height, radius );
+        mlt_image_box_blur( map, width, height, 1, radius + 1, radius, 1, 0, 1 );
+        mlt_image_box_blur( map, width, height, 1, 1, 0, radius + 1, radius, 1 );
+    }
+}
+
+static int edgeCompare( const void *a, const void *b )
+{
+    return ( (const Edge*) a )->top - ( (const Edge*) b )->top;
+}
+
+/** Whether \param edge crosses the scanline at \param y, as a vertex counts for the edge below it. */
+static inline int edgeCrosses( const Edge *edge, double y )
+{
+    return ( edge->y > y ) != ( edge->y2 > y );
+}
+
+static inline double edgeX( const Edge *edge, double y )
+{
+    return edge->x + ( y - edge->y ) / edge->dy * edge->dx;
+}
+
+/** Fills a row of the map, setting the pixels between pairs of nodes. */
+static void fillRow( const FillDesc *desc, Edge **active, int actives, int *nodes, int y )
+{
+    uint8_t *row = desc->map + desc->width * y;
+    int value = !desc->invert * 255;
+    int count = 0, i, j;
+
+    memset( row, desc->invert * 255, desc->width );
+
+    /*
+     * Build a list of nodes.
+     * nodes are located at the borders of the polygon
+     * and therefore indicate a move from in to out or vice versa
+     */
+    for ( i = 0; i < actives; i++ )
+    {
+        if ( edgeCrosses( active[i], y ) )
+        {
+            int x = (int) edgeX( active[i], y );
+            for ( j = count++; j > 0 && nodes[j - 1] > x; j-- )
+                nodes[j] = nodes[j - 1];
+            nodes[j] = x;
+        }
+    }
+
+    // Set map values for points between the node pairs to 1
+    for ( i = 0; i + 1 < count; i += 2 )
+    {
+        if ( nodes[i] >= desc->width )
+            break;
+
+        if ( nodes[i + 1] > 0 )
+        {
+            int from = MAX( 0, nodes[i] );
+            int to = MIN( nodes[i + 1], desc->width );
+            memset( row + from, value, to - from );
+        }
+    }
+}
+
+/**
+ * Fills a row of the map with the coverage of each pixel by the polygon.
+ * Each of SUBSCANLINES scanlines through the row adds the exact horizontal
+ * coverage of its spans, in 256ths of a pixel. Pixels covered all along a
+ * span are added to \param spans as a difference, so long spans cost the same
+ * as short ones.
+ */
+static void fillRowAntialiased( const FillDesc *desc, Edge **active, int actives, double *nodes, int32_t *cover, int32_t *spans, int y )
+{
+    uint8_t *row = desc->map + desc->width * y;
+    int width = desc->width;
+    int32_t full = SUBSCANLINES * 256;
+    int32_t total = 0;
+    int k, i, j, x;
+
+    memset( cover, 0, width * sizeof( *cover ) );
+    memset( spans, 0, ( width + 1 ) * sizeof( *spans ) );
+
+    for ( k = 0; k < SUBSCANLINES; k++ )
+    {
+        double scanline = y + ( k + 0.5 ) / SUBSCANLINES;
+        int count = 0;
+
+        for ( i = 0; i < actives; i++ )
+        {
+            if ( edgeCrosses( active[i], scanline ) )
+            {
+                double nodeX = edgeX( active[i], scanline );
+                for ( j = count++; j > 0 && nodes[j - 1] > nodeX; j-- )
+                    nodes[j] = nodes[j - 1];
+                nodes[j] = nodeX;
+            }
+        }
+
+        for ( i = 0; i + 1 < count; i += 2 )
+        {
+            double from = MAX( 0.0, nodes[i] );
+            double to = MIN( nodes[i + 1], (double) width );
+            if ( from >= to )
+                continue;
+
+            int first = (int) from;
+            int last = (int) to;
+            if ( first == last )
+            {
+                cover[first] += ( to - from ) * 256 + 0.5;
+                continue;
+            }
+            cover[first] += ( first + 1 - from ) * 256 + 0.5;
+            spans[first + 1] += 256;
+            spans[last] -= 256;
+            if ( last < width )
+                cover[last] += ( to - last ) * 256 + 0.5;
+        }
+    }
+
+    for ( x = 0; x < width; x++ )
+    {
+        total += spans[x];
+        int32_t coverage = MIN( cover[x] + total, full );
+        int value = ( coverage * 255 + full / 2 ) / full;
+        row[x] = desc->invert ? 255 - value : value;
+    }
+}
+
+static int fillSlice( int id, int index, int jobs, void *cookie )
+{
+    (void) id; // unused
+    FillDesc *desc = cookie;
+    int slice_height = ( desc->height + jobs - 1 ) / jobs;
+    int slice_line_start = index * slice_height;
+    int slice_line_end = MIN( slice_line_start + slice_height, desc->height );
+    int count = desc->count;
+    Edge **active = mlt_pool_alloc( ( count + 1 ) * sizeof( Edge* ) );
+    int *nodes = mlt_pool_alloc( ( count + 1 ) * sizeof( int ) );
+    double *subNodes = desc->antialias ? mlt_pool_alloc( ( count + 1 ) * sizeof( double ) ) : NULL;
+    int32_t *cover = desc->antialias ? mlt_pool_alloc( ( 2 * desc->width + 1 ) * sizeof( int32_t ) ) : NULL;
+    int next = 0, actives = 0, y, i, j;
+
+    if ( active && nodes && ( !desc->antialias || ( subNodes && cover ) ) )
+    {
+        for ( y = slice_line_start; y < slice_line_end; y++ )
+        {
+            // Update the active edges, which are sorted by the row they start on
+            for ( i = 0, j = 0; i < actives; i++ )
+                if ( active[i]->bottom >= y )
+                    active[j++] = active[i];
+            actives = j;
+            for ( ; next < count && desc->edges[next].top <= y; next++ )
+                if ( desc->edges[next].bottom >= y )
+                    active[actives++] = &desc->edges[next];
+
+            if ( desc->antialias )
+                fillRowAntialiased( desc, active, actives, subNodes, cover, cover + desc->width, y );
+            else
+                fillRow( desc, active, actives, nodes, y );
+        }
     }
 
-    mlt_pool_release(src);
-    mlt_pool_release(tmp);
+    mlt_pool_release( active );
+    mlt_pool_release( nodes );
+    mlt_pool_release( subNodes );
+    mlt_pool_release( cover );
+    return 0;
 }
 
 /**
@@ -226,46 +474,61 @@ static void blur( uint8_t *map, int width, int height, int radius, int passes )
  * \param count number of vertices
  * \param with x range
  * \param height y range
- * \param value value identifying points in the polygon
+ * \param invert whether to fill the outside of the polygon
+ * \param antialias whether to set the pixels on the border to how much of them the polygon covers
  * \param map array of integers of the dimension width * height.
  *            The map entries belonging to the points in the polygon will be set to \param set * 255 the others to !set * 255.
+ *
+ * The edges are sorted by the row where they start, and each row only looks
+ * at the edges that are active on it. The rows are split across the slices.
  */
-static void fillMap( PointF *vertices, int count, int width, int height, int invert, uint8_t *map )
+static void fillMap( PointF *vertices, int count, int width, int height, int invert, int antialias, uint8_t *map )
 {
-    int nodes, nodeX[1024], pixelY, i, j, value;
+    FillDesc desc;
+    Edge *edges = mlt_pool_alloc( count * sizeof( Edge ) );
+    int edgeCount = 0, i, j;
 
-    value = !invert * 255;
-    memset( map, invert * 255, width * height );
-
-    // Loop through the rows of the image
-    for ( pixelY = 0; pixelY < height; pixelY++ )
+    if ( !edges )
     {
-        /*
-         * Build a list of nodes.
-         * nodes are located at the borders of the polygon
-         * and therefore indicate a move from in to out or vice versa
-         */
-        nodes = 0;
-        for ( i = 0, j = count - 1; i < count; j = i++ )
-            if ( (vertices[i].y > (double)pixelY) != (vertices[j].y > (double)pixelY) )
-                nodeX[nodes++] = (int)(vertices[i].x + (pixelY - vertices[i].y) / (vertices[j].y - vertices[i].y) * (vertices[j].x - vertices[i].x) );
-
-        qsort( nodeX, nodes, sizeof( int ), ncompare );
-
-        // Set map values for points between the node pairs to 1
-        for ( i = 0; i < nodes; i += 2 )
-        {
-            if ( nodeX[i] >= width )
-                break;
+        memset( map, invert * 255, width * height );
+        return;
+    }
 
-            if ( nodeX[i+1] > 0 )
-            {
-                nodeX[i] = MAX( 0, nodeX[i] );
-                nodeX[i+1] = MIN( nodeX[i+1], width );
-                memset( map + width * pixelY + nodeX[i], value, nodeX[i+1] - nodeX[i] );
-            }
-        }
+    for ( i = 0, j = count - 1; i < count; j = i++ )
+    {
+        double top = MIN( vertices[i].y, vertices[j].y );
+        double bottom = MAX( vertices[i].y, vertices[j].y );
+
+        // Horizontal edges never cross a scanline
+        if ( !( top < bottom ) || bottom < 0 || top >= height )
+            continue;
+
+        Edge *edge = &edges[edgeCount++];
+        edge->x = vertices[i].x;
+        edge->y = vertices[i].y;
+        edge->dx = vertices[j].x - vertices[i].x;
+        edge->dy = vertices[j].y - vertices[i].y;
+        edge->y2 = vertices[j].y;
+        edge->top = (int) MAX( 0.0, floor( top ) );
+        edge->bottom = (int) MIN( height - 1.0, floor( bottom ) );
     }
+    qsort( edges, edgeCount, sizeof( Edge ), edgeCompare );
+
+    desc.edges = edges;
+    desc.count = edgeCount;
+    desc.width = width;
+    desc.height = height;
+    desc.invert = invert;
+    desc.antialias = antialias;
+    desc.map = map;
+
+    int jobs = MIN( mlt_slices_count_normal(), height / 16 );
+    if ( jobs > 1 )
+        mlt_slices_run_normal( jobs, fillSlice, &desc );
+    else
+        fillSlice( 0, 0, 1, &desc );
+
+    mlt_pool_release( edges );
 }
 
 /** Determines the point in the middle of the Bézier curve (t = 0.5) defined by \param p1 and \param p2
@@ -318,64 +581,150 @@ static void curvePoints( BPointF p1, BPointF p2, PointF **points, int *count, in
     (*points)[*(count)++] = p2.p;
 }
 
+static void freeMask( Mask *mask )
+{
+    mlt_pool_release( mask->points );
+    mlt_image_shared_release( mask->map );
+    free( mask );
+}
+
+/**
+ * Gets the mask for the shape of a frame, rasterising it unless it is the
+ * same as the last one.
+ * \param filter the filter, which keeps the last mask
+ * \param unique the properties of the filter for the frame
+ * \param bpoints the Bézier points of the shape, in the range 0-1
+ * \param bcount the number of Bézier points
+ * \param mode the mode of the frame
+ * \param width the width of the image
+ * \param height the height of the image
+ * \return a shared buffer with the mask to release with mlt_image_shared_release(), or NULL
+ */
+static uint8_t *getMask( mlt_filter filter, mlt_properties unique, BPointF *bpoints, int bcount, int mode, int width, int height )
+{
+    mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
+    int invert = mlt_properties_get_int( unique, "invert" );
+    int antialias = mlt_properties_get_int( unique, "antialias" );
+    int feather = mlt_properties_get_int( unique, "feather" );
+    int passes = mlt_properties_get_int( unique, "feather_passes" );
+    uint8_t *map = NULL;
+    Mask *mask;
+
+    if ( bcount <= 0 )
+        return NULL;
+
+    if ( feather && mode != MODE_RGB )
+    {
+        // Adapt feathering to consumer scaling
+        mlt_profile profile = mlt_service_profile( MLT_FILTER_SERVICE( filter ) );
+        double scale_width = mlt_profile_scale_width( profile, width );
+        feather = MAX( 1, (int) ( feather * scale_width ) );
+    }
+    else
+    {
+        feather = passes = 0;
+    }
+
+    mlt_service_lock( MLT_FILTER_SERVICE( filter ) );
+    mask = mlt_properties_get_data( properties, "_mask", NULL );
+    if ( mask && mask->count == bcount && mask->width == width && mask->height == height &&
+         mask->invert == invert && mask->antialias == antialias &&
+         mask->feather == feather && mask->feather_passes == passes &&
+         !memcmp( mask->points, bpoints, bcount * sizeof( BPointF ) ) )
+        map = mlt_image_shared_ref( mask->map );
+    mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
+    if ( map )
+        return map;
+
+    // map to image dimensions
+    BPointF *scaled = mlt_pool_alloc( bcount * sizeof( BPointF ) );
+    struct PointF *points;
+    int count = 0, size = 1, i, j;
+    if ( !scaled )
+        return NULL;
+    for ( i = 0; i < bcount; i++ )
+    {
+        scaled[i].h1.x = bpoints[i].h1.x * width;
+        scaled[i].p.x  = bpoints[i].p.x * width;
+        scaled[i].h2.x = bpoints[i].h2.x * width;
+        scaled[i].h1.y = bpoints[i].h1.y * height;
+        scaled[i].p.y  = bpoints[i].p.y * height;
+        scaled[i].h2.y = bpoints[i].h2.y * height;
+    }
+
+    points = mlt_pool_alloc( size * sizeof( struct PointF ) );
+    for ( i = 0; i < bcount; i++ )
+    {
+        j = (i + 1) % bcount;
+        curvePoints( scaled[i], scaled[j], &points, &count, &size );
+    }
+    mlt_pool_release( scaled );
+
+    if ( count )
+        map = mlt_image_shared_alloc( width * height );
+    if ( map )
+    {
+        fillMap( points, count, width, height, invert, antialias, map );
+        if ( feather )
+            blur( map, width, height, feather, passes );
+    }
+    mlt_pool_release( points );
+    if ( !map )
+        return NULL;
+
+    // Keep the mask for the next frames with the same shape
+    mask = calloc( 1, sizeof( Mask ) );
+    if ( mask )
+        mask->points = mlt_pool_alloc( bcount * sizeof( BPointF ) );
+    if ( mask && mask->points )
+    {
+        memcpy( mask->points, bpoints, bcount * sizeof( BPointF ) );
+        mask->count = bcount;
+        mask->width = width;
+        mask->height = height;
+        mask->invert = invert;
+        mask->antialias = antialias;
+        mask->feather = feather;
+        mask->feather_passes = passes;
+        mask->map = mlt_image_shared_ref( map );
+        mlt_service_lock( MLT_FILTER_SERVICE( filter ) );
+        mlt_properties_set_data( properties, "_mask", mask, 0, (mlt_destructor) freeMask, NULL );
+        mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
+    }
+    else
+    {
+        free( mask );
+    }
+
+    return map;
+}
+
 /** Do it :-).
 */
 static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable )
 {
     mlt_properties unique = mlt_frame_pop_service( frame );
+    mlt_filter filter = mlt_frame_pop_service( frame );
 
     int mode = mlt_properties_get_int( unique, "mode" );
 
-    // Get the image
+    // Get the image, which every mode changes in place
     if ( mode == MODE_RGB )
         *format = mlt_image_rgb;
-    int error = mlt_frame_get_image( frame, image, format, width, height, writable );
+    int error = mlt_frame_get_image( frame, image, format, width, height, 1 );
 
     // Only process if we have no error and a valid colour space
     if ( !error )
     {
         BPointF *bpoints;
-        struct PointF *points;
-        int bcount, length, count, size, i, j;
+        int bcount, length, size, i;
         bpoints = mlt_properties_get_data( unique, "points", &length );
         bcount = length / sizeof( BPointF );
 
-        for ( i = 0; i < bcount; i++ )
-        {
-            // map to image dimensions
-            bpoints[i].h1.x *= *width;
-            bpoints[i].p.x  *= *width;
-            bpoints[i].h2.x *= *width;
-            bpoints[i].h1.y *= *height;
-            bpoints[i].p.y  *= *height;
-            bpoints[i].h2.y *= *height;
-        }
-
-        count = 0;
-        size = 1;
-        points = mlt_pool_alloc( size * sizeof( struct PointF ) );
-        for ( i = 0; i < bcount; i++ )
-        {
-            j = (i + 1) % bcount;
-            curvePoints( bpoints[i], bpoints[j], &points, &count, &size );
-        }
-
-        if ( count )
+        uint8_t *map = getMask( filter, unique, bpoints, bcount, mode, *width, *height );
+        if ( map )
         {
             length = *width * *height;
-            uint8_t *map = mlt_pool_alloc( length );
-            int invert = mlt_properties_get_int( unique, "invert" );
-            fillMap( points, count, *width, *height, invert, map );
-
-            int feather = mlt_properties_get_int( unique, "feather" );
-            if ( feather && mode != MODE_RGB )
-            {
-                // Adapt feathering to consumer scaling
-                mlt_profile profile = mlt_service_profile( MLT_FILTER_SERVICE( (mlt_filter) unique ) );
-                double scale_width = mlt_profile_scale_width( profile, *width );
-                feather = MAX( 1, (int) ( feather * scale_width ) );
-                blur( map, *width, *height, feather, mlt_properties_get_int( unique, "feather_passes" ) );
-            }
 
             int bpp;
             size = mlt_image_format_size( *format, *width, *height, &bpp );
@@ -505,10 +854,8 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
                 break;
             }
 
-            mlt_pool_release( map );
+            mlt_image_shared_release( map );
         }
-
-        mlt_pool_release( points );
     }
 
     return error;
@@ -519,92 +866,25 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 static mlt_frame filter_process( mlt_filter filter, mlt_frame frame )
 {
     mlt_properties properties = MLT_FILTER_PROPERTIES( filter );
-    int splineIsDirty = mlt_properties_get_int( properties, "_spline_is_dirty" );
     char *modeStr = mlt_properties_get( properties, "mode" );
-    cJSON *root = mlt_properties_get_data( properties, "_spline_parsed", NULL );
+    BPointF *points;
+    int count;
 
-    if ( splineIsDirty || root == NULL )
+    mlt_service_lock( MLT_FILTER_SERVICE( filter ) );
+    Spline *spline = mlt_properties_get_data( properties, "_spline_parsed", NULL );
+    if ( mlt_properties_get_int( properties, "_spline_is_dirty" ) || spline == NULL )
     {
         // we need to (re-)parse
-        char *spline = mlt_properties_get( properties, "spline" );
-        root = cJSON_Parse( spline );
-        mlt_properties_set_data( properties, "_spline_parsed", root, 0, (mlt_destructor)cJSON_Delete, NULL );
+        spline = parseSpline( mlt_properties_get( properties, "spline" ) );
+        mlt_properties_set_data( properties, "_spline_parsed", spline, 0, (mlt_destructor)freeSpline, NULL );
         mlt_properties_set_int( properties, "_spline_is_dirty", 0 );
     }
+    count = spline ? splinePoints( spline, mlt_frame_get_position( frame ), &points ) : -1;
+    mlt_service_unlock( MLT_FILTER_SERVICE( filter ) );
 
-    if ( root == NULL )
+    if ( count < 0 )
         return frame;
 
-    BPointF *points;
-    int count, i;
-
-    if ( root->type == cJSON_Array )
-    {
-        /*
-         * constant
-         */
-        count = json2BCurves( root, &points );
-    }
-    else if ( root->type == cJSON_Object )
-    {
-        /*
-         * keyframes
-         */
-
-        mlt_position time, pos1, pos2;
-        time = mlt_frame_get_position( frame );
-
-        cJSON *keyframe = root->child;
-        cJSON *keyframeOld = keyframe;
-
-        if ( !keyframe )
-            return frame;
-
-        while ( atoi( keyframe->string ) < time && keyframe->next )
-        {
-            keyframeOld = keyframe;
-            keyframe = keyframe->next;
-        }
-
-        pos1 = atoi( keyframeOld->string );
-        pos2 = atoi( keyframe->string );
-
-        if ( pos1 >= pos2 || time >= pos2 )
-        {
-            // keyframes in wrong order or before first / after last keyframe
-            count = json2BCurves( keyframe, &points );
-        }
-        else
-        {
-            /*
-             * pos1 < time < pos2
-             */
-
-            BPointF *p1, *p2;
-            int c1 = json2BCurves( keyframeOld, &p1 );
-            int c2 = json2BCurves( keyframe, &p2 );
-
-            // range 0-1
-            double position = ( time - pos1 ) / (double)( pos2 - pos1 );
-
-            count = MIN( c1, c2 );  // additional points are ignored
-            points = mlt_pool_alloc( count * sizeof( BPointF ) );
-            for ( i = 0; i < count; i++ )
-            {
-                lerp( &(p1[i].h1), &(p2[i].h1), &(points[i].h1), position );
-                lerp( &(p1[i].p), &(p2[i].p), &(points[i].p), position );
-                lerp( &(p1[i].h2), &(p2[i].h2), &(points[i].h2), position );
-            }
-
-            mlt_pool_release( p1 );
-            mlt_pool_release( p2 );
-        }
-    }
-    else
-    {
-        return frame;
-    }
-
     mlt_properties unique = mlt_frame_unique_properties( frame, MLT_FILTER_SERVICE( filter ) );
     mlt_properties_set_data( unique, "points", points, count * sizeof( BPointF ), (mlt_destructor)mlt_pool_release, NULL );
     mlt_properties_set_int( unique, "mode", stringValue( modeStr, MODESTR, 3 ) );
@@ -612,6 +892,8 @@ static mlt_frame filter_process( mlt_filter filter, mlt_frame frame )
     mlt_properties_set_int( unique, "invert", mlt_properties_get_int( properties, "invert" ) );
     mlt_properties_set_int( unique, "feather", mlt_properties_get_int( properties, "feather" ) );
     mlt_properties_set_int( unique, "feather_passes", mlt_properties_get_int( properties, "feather_passes" ) );
+    mlt_properties_set_int( unique, "antialias", mlt_properties_get_int( properties, "antialias" ) );
+    mlt_frame_push_service( frame, filter );
     mlt_frame_push_service( frame, unique );
     mlt_frame_push_get_image( frame, filter_get_image );
 
@@ -632,6 +914,7 @@ mlt_filter filter_rotoscoping_init( mlt_profile profile, mlt_service_type type,
                 mlt_properties_set_int( properties, "invert", 0 );
                 mlt_properties_set_int( properties, "feather", 0 );
                 mlt_properties_set_int( properties, "feather_passes", 1 );
+                mlt_properties_set_int( properties, "antialias", 0 );
                 if ( arg )
                     mlt_properties_set( properties, "spline", arg );
 
@@ -20,12 +20,28 @@
 #include <QApplication>
 #include <QLocale>
 #include <QImage>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QGlyphRun>
+#include <QHash>
+#include <QMutex>
+#include <QPainterPath>
+#include <QRawFont>
+#include <QTextLayout>
 
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
 #include <X11/Xlib.h>
 #include <cstdlib>
 #endif
 
+#define MAX_CACHED_LINES  (256)
+#define MAX_CACHED_GLYPHS (4096)
+
+// The outlines of text shared by all of the text services in this module
+static QMutex g_text_mutex;
+static QHash<QPair<QString, QString>, QPainterPath> g_line_paths;
+static QHash<QPair<QString, quint32>, QPainterPath> g_glyph_paths;
+
 bool createQApplicationIfNeeded(mlt_service service)
 {
 	if (!qApp) {
@@ -126,3 +142,126 @@ int create_image( mlt_frame frame, uint8_t **image, mlt_image_format *image_form
 
 	return error;
 }
+
+static QString raw_font_key( const QRawFont& font )
+{
+	return QStringLiteral("%1|%2|%3|%4|%5|%6").arg( font.familyName(), font.styleName() )
+		.arg( font.pixelSize() ).arg( font.weight() ).arg( int(font.style()) ).arg( int(font.hintingPreference()) );
+}
+
+/** Get a key for everything about a font that changes the layout of a line.
+ *
+ * QFont::key() leaves out the letter and word spacing, among others, which
+ * kdenlivetitle sets, and the overline.
+ */
+
+static QString line_font_key( const QFont& font )
+{
+	return font.key()
+		+ QLatin1Char('|') + QString::number( int(font.letterSpacingType()) )
+		+ QLatin1Char('|') + QString::number( font.letterSpacing() )
+		+ QLatin1Char('|') + QString::number( font.wordSpacing() )
+		+ QLatin1Char('|') + QString::number( int(font.capitalization()) )
+		+ QLatin1Char('|') + QString::number( font.stretch() )
+		+ QLatin1Char('|') + QString::number( int(font.kerning()) )
+		+ QLatin1Char('|') + QString::number( int(font.hintingPreference()) )
+		+ QLatin1Char('|') + QString::number( int(font.styleStrategy()) )
+		+ QLatin1Char('|') + QString::number( int(font.overline()) );
+}
+
+static QPainterPath get_glyph_path( const QRawFont& font, const QString& font_key, quint32 index )
+{
+	QPair<QString, quint32> key( font_key, index );
+	QPainterPath path;
+
+	g_text_mutex.lock();
+	QHash<QPair<QString, quint32>, QPainterPath>::const_iterator i = g_glyph_paths.constFind( key );
+	bool found = i != g_glyph_paths.constEnd();
+	if ( found )
+		path = i.value();
+	g_text_mutex.unlock();
+
+	if ( !found )
+	{
+		path = font.pathForGlyph( index );
+		g_text_mutex.lock();
+		if ( g_glyph_paths.size() >= MAX_CACHED_GLYPHS )
+			g_glyph_paths.clear();
+		g_glyph_paths.insert( key, path );
+		g_text_mutex.unlock();
+	}
+	return path;
+}
+
+/** Get the outline of a line of text with its baseline at 0.
+ *
+ * The text is shaped as QPainterPath::addText() does it, but the outline of
+ * each glyph is only taken from the font once. So, when a few characters of a
+ * line change, as in a timecode, this only joins the cached glyphs again. A line
+ * that does not change is cached as a whole. The underline, overline and
+ * strike out lines are added where QPainterPath::addText() puts them.
+ */
+
+static QPainterPath get_line_path( const QFont& font, const QString& text )
+{
+	QPair<QString, QString> key( line_font_key( font ), text );
+	QPainterPath path;
+
+	g_text_mutex.lock();
+	QHash<QPair<QString, QString>, QPainterPath>::const_iterator i = g_line_paths.constFind( key );
+	bool found = i != g_line_paths.constEnd();
+	if ( found )
+		path = i.value();
+	g_text_mutex.unlock();
+	if ( found )
+		return path;
+
+	QTextLayout layout( text, font );
+	layout.setCacheEnabled( true );
+	layout.beginLayout();
+	QTextLine line = layout.createLine();
+	layout.endLayout();
+	if ( !line.isValid() )
+		return path;
+
+	qreal ascent = line.ascent();
+	foreach ( const QGlyphRun& run, layout.glyphRuns() )
+	{
+		QRawFont raw_font = run.rawFont();
+		QString font_key = raw_font_key( raw_font );
+		QVector<quint32> glyphs = run.glyphIndexes();
+		QVector<QPointF> positions = run.positions();
+		for ( int j = 0; j < glyphs.size(); j++ )
+		{
+			QPainterPath glyph = get_glyph_path( raw_font, font_key, glyphs[j] );
+			path.addPath( glyph.translated( positions[j].x(), positions[j].y() - ascent ) );
+		}
+	}
+	if ( font.underline() || font.overline() || font.strikeOut() )
+	{
+		QFontMetricsF metrics( font );
+		qreal width = line.naturalTextWidth();
+		qreal thickness = metrics.lineWidth();
+		if ( font.underline() )
+			path.addRect( 0, metrics.underlinePos(), width, thickness );
+		if ( font.overline() )
+			path.addRect( 0, -metrics.overlinePos(), width, thickness );
+		if ( font.strikeOut() )
+			path.addRect( 0, -metrics.strikeOutPos(), width, thickness );
+	}
+
+	g_text_mutex.lock();
+	if ( g_line_paths.size() >= MAX_CACHED_LINES )
+		g_line_paths.clear();
+	g_line_paths.insert( key, path );
+	g_text_mutex.unlock();
+	return path;
+}
+
+/** Add a line of text to a path like QPainterPath::addText() using cached glyph outlines.
+ */
+
+void add_text_path( QPainterPath* path, double x, double y, const QFont& font, const QString& text )
+{
+	path->addPath( get_line_path( font, text ).translated( x, y ) );
+}
@@ -109,7 +109,7 @@ static QRectF get_text_path( QPainterPath* qpath, mlt_properties filter_properti
 				x += width - line_width;
 				break;
 		}
-		qpath->addText( x, y, font, line );
+		add_text_path( qpath, x, y, font, line );
 		y += fm.lineSpacing();
 	}
 
@@ -352,7 +352,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 				doc->drawContents(&painter, drawRect);
 			}
 		} else {
+			mlt_log_timings_begin()
 			path_rect = get_text_path(&text_path, filter_properties, argument, scale);
+			mlt_log_timings_end( MLT_FILTER_SERVICE(filter), "get_text_path" )
 			transform_painter(&painter, rect, path_rect, filter_properties, profile);
 			paint_background(&painter, path_rect, filter_properties);
 			paint_text(&painter, &text_path, filter_properties);
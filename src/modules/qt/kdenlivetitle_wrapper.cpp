@@ -177,7 +177,7 @@ public:
 		foreach(const QString &line, lines)
 		{
 			QPainterPath linePath;
-			linePath.addText(0, linePos, m_font, line);
+			add_text_path(&linePath, 0, linePos, m_font, line);
 			linePos += m_lineSpacing;
 			if ( m_align == Qt::AlignHCenter )
 			{
@@ -293,6 +293,43 @@ static void qscene_delete( void *data )
 	scene = NULL;
 }
 
+/** Find the smallest rectangle outside of which a rendered title is fully transparent.
+ *
+ * A title is drawn only when it changes, and most of it is usually empty, so it pays
+ * to tell the transitions which part of the frame they need to blend.
+ */
+
+static mlt_rect find_content( const uint8_t *rgba, int width, int height )
+{
+	mlt_rect rect = { 0, 0, 0, 0, 1.0 };
+	int left = width, right = -1, top = -1, bottom = -1;
+	for ( int y = 0; y < height; y++ )
+	{
+		const uint8_t *p = rgba + y * width * 4 + 3;
+		int first = 0;
+		while ( first < width && !p[ first * 4 ] )
+			first++;
+		if ( first == width )
+			continue;
+		int last = width - 1;
+		while ( !p[ last * 4 ] )
+			last--;
+		if ( top < 0 )
+			top = y;
+		bottom = y;
+		left = first < left ? first : left;
+		right = last > right ? last : right;
+	}
+	if ( top >= 0 )
+	{
+		rect.x = left;
+		rect.y = top;
+		rect.w = right - left + 1;
+		rect.h = bottom - top + 1;
+	}
+	return rect;
+}
+
 
 void loadFromXml( producer_ktitle self, QGraphicsScene *scene, const char *templateXml, const char *templateText )
 {
@@ -824,6 +861,7 @@ void drawKdenliveTitle( producer_ktitle self, mlt_frame frame, mlt_image_format
 		self->format = mlt_image_rgba;
 
 		convert_qimage_to_mlt_rgba(&img, self->rgba_image, width, height);
+		mlt_properties_set_rect( producer_props, "_content_rect", find_content( self->rgba_image, width, height ) );
 		self->current_image = (uint8_t *) mlt_pool_alloc( image_size );
 		memcpy( self->current_image, self->rgba_image, image_size );
 		mlt_properties_set_data( producer_props, "_cached_buffer", self->rgba_image, image_size, mlt_pool_release, NULL );
@@ -112,6 +112,10 @@ static int producer_get_image( mlt_frame frame, uint8_t **buffer, mlt_image_form
 			memcpy( image_copy, self->current_alpha, self->current_width * self->current_height );
 			mlt_frame_set_alpha( frame, image_copy, self->current_width * self->current_height, mlt_pool_release );
 		}
+
+		// Tell the transitions where the title is not transparent
+		if ( mlt_properties_get( producer_props, "_content_rect" ) )
+			mlt_frame_set_image_content( frame, mlt_properties_get_rect( producer_props, "_content_rect" ) );
 	}
 	else
 	{
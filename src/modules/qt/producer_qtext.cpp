@@ -212,7 +212,7 @@ static void generate_qpath( mlt_properties producer_properties )
 				x += width - line_width;
 				break;
 		}
-		qPath->addText( x, y, font, line );
+		add_text_path( qPath, x, y, font, line );
 		y += fm.lineSpacing();
 	}
 
@@ -369,7 +369,9 @@ static int producer_get_frame( mlt_producer producer, mlt_frame_ptr frame, int i
 		// Regenerate the QPainterPath if necessary
 		if( check_qpath( producer_properties ) )
 		{
+			mlt_log_timings_begin()
 			generate_qpath( producer_properties );
+			mlt_log_timings_end( MLT_PRODUCER_SERVICE( producer ), "generate_qpath" )
 		}
 
 		// Give the frame a copy of the painter path
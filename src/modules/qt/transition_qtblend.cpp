@@ -21,6 +21,7 @@
 #include <framework/mlt.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <QImage>
 #include <QPainter>
 #include <QTransform>
@@ -185,12 +186,16 @@ static int get_image( mlt_frame a_frame, uint8_t **image, mlt_image_format *form
 	// Check if we have transparency
 	if ( !hasAlpha )
 	{
-		// fetch image
-		error = mlt_frame_get_image( b_frame, &b_image, format, width, height, 1 );
-		if ( *format == mlt_image_rgba || mlt_frame_get_alpha( b_frame ) )
+		// fetch image, first not writable to learn if it is known to be opaque
+		error = mlt_frame_get_image( b_frame, &b_image, format, width, height, 0 );
+		if ( mlt_frame_get_image_opacity( b_frame ) != 255 && ( *format == mlt_image_rgba || mlt_frame_get_alpha( b_frame ) ) )
 		{
 			hasAlpha = true;
 		}
+		else
+		{
+			error = mlt_frame_get_image( b_frame, &b_image, format, width, height, 1 );
+		}
 	}
 	if ( !hasAlpha )
 	{
@@ -202,7 +207,30 @@ static int get_image( mlt_frame a_frame, uint8_t **image, mlt_image_format *form
 	}
 	// Get RGBA image to process
 	*format = mlt_image_rgba;
-	error = mlt_frame_get_image( b_frame, &b_image, format, &b_width, &b_height, writable );
+	error = mlt_frame_get_image( b_frame, &b_image, format, &b_width, &b_height, 0 );
+
+	// Nothing to draw over the bottom frame if the top frame is known to be transparent
+	if ( !error && mlt_frame_get_image_opacity( b_frame ) == 0 &&
+		 mlt_properties_get_int( transition_properties, "compositing" ) == QPainter::CompositionMode_SourceOver )
+	{
+		free( interps );
+		return mlt_frame_get_image( a_frame, image, format, width, height, writable );
+	}
+	// Only draw the region of the top frame that is not transparent, when it is known
+	mlt_rect content;
+	QRectF source( 0, 0, b_width, b_height );
+	if ( !error && mlt_frame_get_image_content( b_frame, &content ) &&
+		 mlt_properties_get_int( transition_properties, "compositing" ) == QPainter::CompositionMode_SourceOver )
+	{
+		QRectF known( floor( content.x ), floor( content.y ), ceil( content.x + content.w ) - floor( content.x ),
+					  ceil( content.y + content.h ) - floor( content.y ) );
+		source = source.intersected( known );
+	}
+	// Fill instead of drawing the top frame if it is known to be one colour
+	mlt_color color;
+	bool solid = !error && mlt_frame_get_image_solid( b_frame, &color );
+	if ( writable && !solid )
+		error = mlt_frame_get_image( b_frame, &b_image, format, &b_width, &b_height, writable );
 
 	// Get bottom frame
 	uint8_t *a_image = NULL;
@@ -234,7 +262,8 @@ static int get_image( mlt_frame a_frame, uint8_t **image, mlt_image_format *form
 
 	// convert top mlt image to qimage
 	QImage topImg;
-	convert_mlt_to_qimage_rgba( b_image, &topImg, b_width, b_height );
+	if ( !solid )
+		convert_mlt_to_qimage_rgba( b_image, &topImg, b_width, b_height );
 
 
 	// setup Qt drawing
@@ -245,7 +274,13 @@ static int get_image( mlt_frame a_frame, uint8_t **image, mlt_image_format *form
 	painter.setOpacity(opacity);
 
 	// Composite top frame
-	painter.drawImage(0, 0, topImg);
+	if ( !source.isEmpty() )
+	{
+		if ( solid )
+			painter.fillRect( source, QColor( color.r, color.g, color.b, color.a ) );
+		else
+			painter.drawImage( source.topLeft(), topImg, source );
+	}
 
 	// finish Qt drawing
 	painter.end();
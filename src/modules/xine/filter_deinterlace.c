@@ -225,6 +225,16 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 		else if ( strcmp( method_str, "greedy" ) == 0 )
 			method = DEINTERLACE_GREEDY;
 
+		// Use a cheaper method when a real-time consumer is behind
+		mlt_quality quality = mlt_frame_get_quality( frame );
+		int degraded = 0;
+		if ( method != DEINTERLACE_NONE && quality == mlt_quality_draft )
+			degraded = method != DEINTERLACE_ONEFIELD;
+		else if ( quality == mlt_quality_reduced )
+			degraded = method == DEINTERLACE_YADIF || method == DEINTERLACE_YADIF_NOSPATIAL;
+		if ( degraded )
+			method = quality == mlt_quality_draft ? DEINTERLACE_ONEFIELD : DEINTERLACE_LINEARBLEND;
+
 		// Some producers like pixbuf want rescale_width & _height, but will not get them if you request
 		// the previous image first. So, on the first iteration, we use linearblend.
 		if ( ( method == DEINTERLACE_YADIF || method == DEINTERLACE_YADIF_NOSPATIAL ) &&
@@ -259,7 +269,7 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 				if ( !progressive )
 					mlt_properties_set_int( MLT_SERVICE_PROPERTIES(service), "_need_previous_next", 1 );
 			}
-			else
+			else if ( !degraded )
 			{
 				// Signal that we no longer need previous and next frames
 				mlt_properties_set_int( MLT_SERVICE_PROPERTIES(service), "_need_previous_next", 0 );
@@ -307,6 +317,9 @@ static int filter_get_image( mlt_frame frame, uint8_t **image, mlt_image_format
 		error = mlt_frame_get_image( frame, image, format, width, height, writable );
 	}
 
+	// Deinterlacing either replaces the image or requests it writable, so keep what is known about it
+	mlt_frame_keep_image_facts( frame );
+
 	if ( !deinterlace || progressive )
 	{
 		// Signal that we no longer need previous and next frames
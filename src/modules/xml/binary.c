@@ -0,0 +1,502 @@
+/*
+ * binary.c -- a binary encoding of MLT XML documents
+ * Copyright (C) 2026 Meltytech, LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// The document is stored as the sequence of SAX events that the xml producer
+// handles, so that loading it only replays those events without tokenising,
+// unescaping or validating text. All integers are 32-bit little-endian.
+//
+//   header   "MLTB", version, string count, record count, string data size
+//   offsets  the offset of each string within the string data
+//   records  1 | attributes << 2, name, (attribute name, value) * attributes
+//            2, name                    (end of element)
+//            3, text                    (character data)
+//   strings  each distinct name and value once, terminated by a NUL
+//
+// Strings are referenced by index. Since they are stored in order, string i
+// ends right before the offset of string i + 1, and loading a mapped file
+// needs no copies of them.
+
+#include "binary.h"
+
+#include <framework/mlt_types.h>
+#include <libxml/parserInternals.h> // for xmlCreateMemoryParserCtxt
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BINARY_MAGIC "MLTB"
+#define BINARY_VERSION (1)
+#define HEADER_SIZE (20)
+
+enum
+{
+	RECORD_START = 1,
+	RECORD_END = 2,
+	RECORD_TEXT = 3
+};
+
+typedef struct
+{
+	char *data;           // the string data
+	size_t data_size;
+	size_t data_used;
+	uint32_t *offsets;    // the offset of each string in data
+	uint32_t count;
+	uint32_t size;
+	uint32_t *table;      // a hash table of string index + 1
+	uint32_t table_size;
+	uint32_t *records;
+	size_t record_count;
+	size_t record_size;
+	char *text;           // character data not yet stored
+	size_t text_used;
+	size_t text_size;
+	int error;
+} writer;
+
+static inline void put_u32( unsigned char *p, uint32_t value )
+{
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static inline uint32_t get_u32( const unsigned char *p )
+{
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t) p[3] << 24 );
+}
+
+static uint32_t hash_string( const char *s, size_t length )
+{
+	uint32_t hash = 2166136261u;
+	for ( size_t i = 0; i < length; i++ )
+		hash = ( hash ^ (unsigned char) s[i] ) * 16777619u;
+	return hash;
+}
+
+static int grow_table( writer *self )
+{
+	uint32_t size = self->table_size ? self->table_size * 2 : 1024;
+	uint32_t *table = calloc( size, sizeof( uint32_t ) );
+	if ( !table )
+		return 1;
+	for ( uint32_t i = 0; i < self->count; i++ )
+	{
+		const char *s = self->data + self->offsets[i];
+		uint32_t j = hash_string( s, strlen( s ) ) & ( size - 1 );
+		while ( table[j] )
+			j = ( j + 1 ) & ( size - 1 );
+		table[j] = i + 1;
+	}
+	free( self->table );
+	self->table = table;
+	self->table_size = size;
+	return 0;
+}
+
+static uint32_t intern( writer *self, const char *s )
+{
+	size_t length = strlen( s );
+	uint32_t hash = hash_string( s, length );
+
+	if ( self->error )
+		return 0;
+	if ( self->count * 2 >= self->table_size && grow_table( self ) )
+	{
+		self->error = 1;
+		return 0;
+	}
+
+	// Look for the string
+	uint32_t j = hash & ( self->table_size - 1 );
+	while ( self->table[j] )
+	{
+		const char *entry = self->data + self->offsets[ self->table[j] - 1 ];
+		if ( !strncmp( entry, s, length ) && entry[ length ] == '\0' )
+			return self->table[j] - 1;
+		j = ( j + 1 ) & ( self->table_size - 1 );
+	}
+
+	// Add it
+	if ( self->count == self->size )
+	{
+		uint32_t size = self->size ? self->size * 2 : 1024;
+		uint32_t *offsets = realloc( self->offsets, size * sizeof( uint32_t ) );
+		if ( !offsets )
+		{
+			self->error = 1;
+			return 0;
+		}
+		self->offsets = offsets;
+		self->size = size;
+	}
+	if ( self->data_used + length + 1 > self->data_size )
+	{
+		size_t size = ( self->data_used + length + 1 ) * 2;
+		char *data = realloc( self->data, size );
+		if ( !data || size > UINT32_MAX )
+		{
+			if ( data )
+				self->data = data;
+			self->error = 1;
+			return 0;
+		}
+		self->data = data;
+		self->data_size = size;
+	}
+	memcpy( self->data + self->data_used, s, length + 1 );
+	self->offsets[ self->count ] = self->data_used;
+	self->data_used += length + 1;
+	self->table[j] = self->count + 1;
+	return self->count++;
+}
+
+static void push( writer *self, uint32_t word )
+{
+	if ( self->record_count == self->record_size )
+	{
+		size_t size = self->record_size ? self->record_size * 2 : 4096;
+		uint32_t *records = realloc( self->records, size * sizeof( uint32_t ) );
+		if ( !records )
+		{
+			self->error = 1;
+			return;
+		}
+		self->records = records;
+		self->record_size = size;
+	}
+	self->records[ self->record_count++ ] = word;
+}
+
+// Character data may arrive in pieces, so it is collected until the next tag.
+static void flush_text( writer *self )
+{
+	if ( self->text_used )
+	{
+		self->text[ self->text_used ] = '\0';
+		push( self, RECORD_TEXT );
+		push( self, intern( self, self->text ) );
+		self->text_used = 0;
+	}
+}
+
+static void on_start_element( void *ctx, const xmlChar *name, const xmlChar **atts )
+{
+	writer *self = ( ( xmlParserCtxtPtr ) ctx )->_private;
+	uint32_t count = 0;
+
+	flush_text( self );
+	while ( atts && atts[ 2 * count ] )
+		count++;
+	push( self, ( count << 2 ) | RECORD_START );
+	push( self, intern( self, (const char*) name ) );
+	for ( uint32_t i = 0; i < 2 * count; i++ )
+		push( self, intern( self, atts[i] ? (const char*) atts[i] : "" ) );
+}
+
+static void on_end_element( void *ctx, const xmlChar *name )
+{
+	writer *self = ( ( xmlParserCtxtPtr ) ctx )->_private;
+
+	flush_text( self );
+	push( self, RECORD_END );
+	push( self, intern( self, (const char*) name ) );
+}
+
+static void on_characters( void *ctx, const xmlChar *ch, int len )
+{
+	writer *self = ( ( xmlParserCtxtPtr ) ctx )->_private;
+
+	if ( self->text_used + len + 1 > self->text_size )
+	{
+		size_t size = ( self->text_used + len + 1 ) * 2;
+		char *text = realloc( self->text, size );
+		if ( !text )
+		{
+			self->error = 1;
+			return;
+		}
+		self->text = text;
+		self->text_size = size;
+	}
+	memcpy( self->text + self->text_used, ch, len );
+	self->text_used += len;
+}
+
+static void on_error( void *ctx, const char *msg, ... )
+{
+	writer *self = ( ( xmlParserCtxtPtr ) ctx )->_private;
+	self->error = 1;
+}
+
+/** Encode a document.
+ *
+ * \param xml a document made by the xml consumer
+ * \param length the length of \p xml
+ * \param[out] size the number of bytes returned
+ * \return the encoded document, which must be freed, or NULL on error
+ */
+
+void *mlt_xml_binary_encode( const char *xml, size_t length, size_t *size )
+{
+	writer self;
+	unsigned char *result = NULL;
+	xmlSAXHandler sax;
+	xmlSAXHandlerPtr sax_orig;
+	xmlParserCtxtPtr context = length <= INT_MAX ? xmlCreateMemoryParserCtxt( xml, length ) : NULL;
+
+	if ( !context )
+		return NULL;
+	memset( &self, 0, sizeof( self ) );
+	memset( &sax, 0, sizeof( sax ) );
+	sax.startElement = on_start_element;
+	sax.endElement = on_end_element;
+	sax.characters = on_characters;
+	sax.cdataBlock = on_characters;
+	sax.error = on_error;
+	sax.fatalError = on_error;
+	sax_orig = context->sax;
+	context->sax = &sax;
+	context->_private = &self;
+	xmlParseDocument( context );
+	if ( !context->wellFormed )
+		self.error = 1;
+	context->sax = sax_orig;
+	context->_private = NULL;
+	if ( context->myDoc )
+		xmlFreeDoc( context->myDoc );
+	xmlFreeParserCtxt( context );
+
+	if ( !self.error && self.record_count < UINT32_MAX / 4 )
+	{
+		*size = HEADER_SIZE + 4 * (size_t) self.count + 4 * self.record_count + self.data_used;
+		result = malloc( *size );
+	}
+	if ( result )
+	{
+		unsigned char *p = result;
+		memcpy( p, BINARY_MAGIC, 4 );
+		put_u32( p + 4, BINARY_VERSION );
+		put_u32( p + 8, self.count );
+		put_u32( p + 12, self.record_count );
+		put_u32( p + 16, self.data_used );
+		p += HEADER_SIZE;
+		for ( uint32_t i = 0; i < self.count; i++, p += 4 )
+			put_u32( p, self.offsets[i] );
+		for ( size_t i = 0; i < self.record_count; i++, p += 4 )
+			put_u32( p, self.records[i] );
+		memcpy( p, self.data, self.data_used );
+	}
+
+	free( self.data );
+	free( self.offsets );
+	free( self.table );
+	free( self.records );
+	free( self.text );
+	return result;
+}
+
+/** Map a file into memory.
+ *
+ * \param filename the name of the file
+ * \param[out] size the size of the file
+ * \return the file contents or NULL on error
+ */
+
+void *mlt_xml_binary_map( const char *filename, size_t *size )
+{
+	void *data = NULL;
+#ifdef _WIN32
+	FILE *file = mlt_fopen( filename, "rb" );
+	if ( file )
+	{
+		if ( !fseek( file, 0, SEEK_END ) && ftell( file ) > 0 )
+		{
+			*size = ftell( file );
+			data = malloc( *size );
+			rewind( file );
+			if ( data && fread( data, 1, *size, file ) != *size )
+			{
+				free( data );
+				data = NULL;
+			}
+		}
+		fclose( file );
+	}
+#else
+	int fd = open( filename, O_RDONLY );
+	if ( fd >= 0 )
+	{
+		struct stat info;
+		if ( !fstat( fd, &info ) && info.st_size > 0 )
+		{
+			*size = info.st_size;
+			data = mmap( NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if ( data == MAP_FAILED )
+				data = NULL;
+		}
+		close( fd );
+	}
+#endif
+	return data;
+}
+
+/** Release a file mapped by mlt_xml_binary_map().
+ *
+ * \param data the file contents
+ * \param size the size of the file
+ */
+
+void mlt_xml_binary_unmap( void *data, size_t size )
+{
+	if ( data )
+	{
+#ifdef _WIN32
+		free( data );
+#else
+		munmap( data, size );
+#endif
+	}
+}
+
+/** Replay the SAX events of an encoded document.
+ *
+ * The document is checked before any callback is called. Only the
+ * startElement, endElement and characters callbacks are used.
+ * \param data the encoded document
+ * \param size the size of \p data
+ * \param sax the callbacks
+ * \param ctx the context passed to the callbacks
+ * \return true if the document is not valid
+ */
+
+int mlt_xml_binary_parse( const void *data, size_t size, xmlSAXHandler *sax, void *ctx )
+{
+	const unsigned char *bytes = data;
+	int error = 1;
+
+	if ( size < HEADER_SIZE || memcmp( bytes, BINARY_MAGIC, 4 ) || get_u32( bytes + 4 ) != BINARY_VERSION )
+		return error;
+
+	uint32_t count = get_u32( bytes + 8 );
+	uint32_t record_count = get_u32( bytes + 12 );
+	uint32_t data_size = get_u32( bytes + 16 );
+	if ( HEADER_SIZE + 4 * (uint64_t) count + 4 * (uint64_t) record_count + data_size != size )
+		return error;
+
+	const unsigned char *offsets = bytes + HEADER_SIZE;
+	const unsigned char *records = offsets + 4 * (size_t) count;
+	const char *strings = (const char*) records + 4 * (size_t) record_count;
+	const xmlChar **table = malloc( ( count + 1 ) * sizeof( xmlChar* ) );
+	uint32_t *stack = malloc( ( record_count / 2 + 1 ) * sizeof( uint32_t ) );
+	const xmlChar **atts = NULL;
+	uint32_t atts_size = 0;
+
+	// Check the strings
+	error = !table || !stack;
+	for ( uint32_t i = 0; i < count && !error; i++ )
+	{
+		uint32_t start = get_u32( offsets + 4 * i );
+		uint32_t end = i + 1 < count ? get_u32( offsets + 4 * ( i + 1 ) ) : data_size;
+		error = start >= end || end > data_size || strings[ end - 1 ] != '\0';
+		table[i] = (const xmlChar*) strings + start;
+	}
+
+	// Check the records, then replay them
+	for ( int replay = 0; replay < 2 && !error; replay++ )
+	{
+		uint32_t depth = 0;
+		uint32_t i = 0;
+		while ( i < record_count && !error )
+		{
+			uint32_t word = get_u32( records + 4 * i );
+			uint32_t n = word >> 2;
+			uint32_t name = i + 1 < record_count ? get_u32( records + 4 * ( i + 1 ) ) : count;
+
+			if ( name >= count )
+			{
+				error = 1;
+			}
+			else if ( ( word & 3 ) == RECORD_START )
+			{
+				if ( n > ( record_count - i - 2 ) / 2 )
+				{
+					error = 1;
+					break;
+				}
+				if ( !replay )
+				{
+					for ( uint32_t j = 0; j < 2 * n && !error; j++ )
+						error = get_u32( records + 4 * ( i + 2 + j ) ) >= count;
+					stack[ depth++ ] = name;
+					if ( 2 * n + 1 > atts_size )
+						atts_size = 2 * n + 1;
+				}
+				else
+				{
+					for ( uint32_t j = 0; j < 2 * n; j++ )
+						atts[j] = table[ get_u32( records + 4 * ( i + 2 + j ) ) ];
+					atts[ 2 * n ] = NULL;
+					if ( sax->startElement )
+						sax->startElement( ctx, table[ name ], atts );
+				}
+				i += 2 + 2 * n;
+			}
+			else if ( ( word & 3 ) == RECORD_END && n == 0 )
+			{
+				if ( !replay )
+					error = depth == 0 || stack[ --depth ] != name;
+				else if ( sax->endElement )
+					sax->endElement( ctx, table[ name ] );
+				i += 2;
+			}
+			else if ( ( word & 3 ) == RECORD_TEXT && n == 0 )
+			{
+				if ( replay && sax->characters )
+					sax->characters( ctx, table[ name ], strlen( (const char*) table[ name ] ) );
+				i += 2;
+			}
+			else
+			{
+				error = 1;
+			}
+		}
+		if ( !replay )
+		{
+			error = error || depth != 0 || record_count == 0;
+			atts = error ? NULL : malloc( atts_size * sizeof( xmlChar* ) );
+			error = error || !atts;
+		}
+	}
+
+	free( atts );
+	free( stack );
+	free( table );
+	return error;
+}
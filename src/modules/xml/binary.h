@@ -0,0 +1,31 @@
+/*
+ * binary.h -- a binary encoding of MLT XML documents
+ * Copyright (C) 2026 Meltytech, LLC
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MLT_XML_BINARY_H
+#define MLT_XML_BINARY_H
+
+#include <stddef.h>
+#include <libxml/parser.h>
+
+void *mlt_xml_binary_encode( const char *xml, size_t length, size_t *size );
+void *mlt_xml_binary_map( const char *filename, size_t *size );
+void mlt_xml_binary_unmap( void *data, size_t size );
+int mlt_xml_binary_parse( const void *data, size_t size, xmlSAXHandler *sax, void *ctx );
+
+#endif // MLT_XML_BINARY_H
@@ -1,5 +1,5 @@
 /*
- * consumer_xml.c -- a libxml2 serialiser of mlt service networks
+ * consumer_xml.c -- an XML serialiser of mlt service networks
  * Copyright (C) 2003-2021 Meltytech, LLC
  *
  * This library is free software; you can redistribute it and/or
@@ -18,6 +18,7 @@
  */
 
 #include "common.h"
+#include "binary.h"
 
 #include <framework/mlt.h>
 #include <stdio.h>
@@ -25,37 +26,136 @@
 #include <string.h>
 #include <unistd.h>
 #include <locale.h>
-#include <libxml/tree.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 #define ID_SIZE 128
 #define TIME_PROPERTY "_consumer_xml"
+#define STAMP_PROPERTY "_consumer_xml.stamp"
+#define WATCHING_PROPERTY "_consumer_xml.watching"
+#define FRAGMENT_PROPERTY "_consumer_xml.fragment"
 
-#define _x (const xmlChar*)
-#define _s (const char*)
+typedef enum
+{
+	xml_existing,
+	xml_producer,
+	xml_multitrack,
+	xml_playlist,
+	xml_tractor,
+	xml_filter,
+	xml_transition,
+	xml_chain,
+	xml_link,
+	xml_hide
+}
+xml_type;
+
+static const char *id_prefix[] = { NULL, "producer", "multitrack", "playlist", "tractor", "filter", "transition", "chain", "link" };
+
+// An id given to a service, and whether the element with the id is hidden
+typedef struct
+{
+	mlt_service service;
+	char *id;
+	int hide;
+}
+xml_id;
+
+// The ids of the document, indexed by service and by id
+typedef struct
+{
+	xml_id *ids;
+	int count;
+	int *by_service;          // open addressing tables of indices into ids plus one
+	int *by_id;
+	int size;                 // the size of the tables, a power of two
+}
+xml_id_map;
+
+// The text of the document as it is written
+typedef struct
+{
+	char *data;
+	size_t used;
+	size_t size;
+}
+xml_buffer;
+
+// An id assigned or looked up while writing a fragment, or a lookup in the
+// hide map when the type is xml_hide
+typedef struct
+{
+	xml_type type;
+	mlt_service service;
+	char *id;
+	int hide;
+}
+xml_id_call;
+
+// A service that a consumer listens to for changes, shared by the maps of
+// the saves that reached it
+typedef struct
+{
+	mlt_properties properties;
+	mlt_consumer consumer;
+	int64_t since;
+	int refs;
+}
+xml_watch;
+
+// The text of an element that is a child of the root, kept on its service
+// for the next incremental save together with what it was made from
+typedef struct
+{
+	mlt_service service;
+	char *key;
+	char *id;
+	int64_t stamp;
+	int64_t made;
+	mlt_properties *watched;
+	int watched_count;
+	int watched_size;
+	xml_id_call *calls;
+	int call_count;
+	int call_size;
+	size_t start;
+	char *text;
+	size_t size;
+}
+xml_fragment;
 
 // This maintains counters for adding ids to elements
 struct serialise_context_s
 {
-	mlt_properties id_map;
-	int producer_count;
-	int multitrack_count;
-	int playlist_count;
-	int tractor_count;
-	int filter_count;
-	int transition_count;
-	int chain_count;
-	int link_count;
+	xml_id_map id_map;
+	int id_count[ xml_link + 1 ];
 	int pass;
-	mlt_properties hide_map;
 	char *root;
 	char *store;
 	int no_meta;
 	mlt_profile profile;
 	mlt_time_format time_format;
+	xml_buffer output;        // the children of the root element
+	xml_buffer attributes;    // the attributes of the root element
+	const char **elements;    // the names of the open elements
+	int elements_size;
+	int depth;
+	int pending;              // the start tag of the innermost element is open
+	int text;                 // the innermost element has character data
+	int format;
+	int ascii;                // write characters outside of ASCII as references
+	char *key;                // the settings that fragments depend on, when incremental
+	xml_fragment *fragment;   // the fragment being written
+	mlt_consumer consumer;
+	mlt_properties watching;  // the services reached by this save
+	mlt_properties watched;   // the services reached by the previous save
 };
 typedef struct serialise_context_s* serialise_context;
 
+// Incremented whenever a watched service changes
+static atomic_int_fast64_t change_count;
+
 /** Forward references to static functions.
 */
 
@@ -64,102 +164,612 @@ static int consumer_stop( mlt_consumer parent );
 static int consumer_is_stopped( mlt_consumer consumer );
 static void consumer_close( mlt_consumer parent );
 static void *consumer_thread( void *arg );
-static void serialise_service( serialise_context context, mlt_service service, xmlNode *node );
+static void serialise_service( serialise_context context, mlt_service service );
 
-typedef enum
+/** Append to the text of the document.
+*/
+
+static void buffer_append( xml_buffer *buffer, const char *s, size_t length )
 {
-	xml_existing,
-	xml_producer,
-	xml_multitrack,
-	xml_playlist,
-	xml_tractor,
-	xml_filter,
-	xml_transition,
-	xml_chain,
-	xml_link,
+	if ( buffer->used + length + 1 > buffer->size )
+	{
+		size_t size = ( buffer->used + length + 1 ) * 2;
+		char *data = realloc( buffer->data, size );
+		if ( data == NULL )
+			return;
+		buffer->data = data;
+		buffer->size = size;
+	}
+	memcpy( buffer->data + buffer->used, s, length );
+	buffer->used += length;
+	buffer->data[ buffer->used ] = '\0';
+}
+
+static void buffer_puts( xml_buffer *buffer, const char *s )
+{
+	buffer_append( buffer, s, strlen( s ) );
+}
+
+static unsigned int decode_utf8( const unsigned char *s, int *length )
+{
+	int n = *s >= 0xf0 ? 4 : *s >= 0xe0 ? 3 : *s >= 0xc0 ? 2 : 1;
+	unsigned int c = n == 1 ? *s : *s & ( 0x3f >> ( n - 1 ) );
+	int i;
+
+	for ( i = 1; i < n; i++ )
+	{
+		if ( ( s[ i ] & 0xc0 ) != 0x80 )
+		{
+			*length = 1;
+			return *s;
+		}
+		c = ( c << 6 ) | ( s[ i ] & 0x3f );
+	}
+	*length = n;
+	return c;
+}
+
+/** Append text replacing the characters that XML reserves.
+ *
+ * This escapes the same characters as libxml2 does when it saves a document.
+*/
+
+static void buffer_escape( xml_buffer *buffer, const char *s, int attribute, int ascii )
+{
+	const unsigned char *p = ( const unsigned char* ) s;
+	const unsigned char *run = p;
+	char temp[ 16 ];
+
+	for ( ; *p; p++ )
+	{
+		const char *entity = NULL;
+		int length = 1;
+
+		switch ( *p )
+		{
+			case '<': entity = "&lt;"; break;
+			case '>': entity = "&gt;"; break;
+			case '&': entity = "&amp;"; break;
+			case '\r': entity = attribute || !ascii ? "&#13;" : "&#xD;"; break;
+			case '"': entity = attribute ? "&quot;" : NULL; break;
+			case '\n': entity = attribute ? "&#10;" : NULL; break;
+			case '\t': entity = attribute ? "&#9;" : NULL; break;
+			default:
+				if ( ascii && *p >= 0x80 )
+				{
+					sprintf( temp, "&#x%X;", decode_utf8( p, &length ) );
+					entity = temp;
+				}
+				break;
+		}
+		if ( entity )
+		{
+			buffer_append( buffer, ( const char* ) run, p - run );
+			buffer_puts( buffer, entity );
+			p += length - 1;
+			run = p + 1;
+		}
+	}
+	buffer_append( buffer, ( const char* ) run, p - run );
+}
+
+static void xml_indent( serialise_context context )
+{
+	static const char spaces[] = "                                ";
+	int n = 2 * context->depth;
+
+	for ( ; n > 0; n -= sizeof( spaces ) - 1 )
+		buffer_append( &context->output, spaces, n < sizeof( spaces ) - 1 ? n : sizeof( spaces ) - 1 );
+}
+
+/** Start an element within the innermost open one.
+ *
+ * Elements are written as they are made, so attributes must be added
+ * before anything is written inside of the element.
+*/
+
+static void xml_start( serialise_context context, const char *name )
+{
+	if ( context->pending )
+		buffer_puts( &context->output, context->format ? ">\n" : ">" );
+	if ( context->depth + 1 >= context->elements_size )
+	{
+		context->elements_size += 16;
+		context->elements = realloc( context->elements, context->elements_size * sizeof( const char* ) );
+	}
+	context->elements[ ++ context->depth ] = name;
+	if ( context->format )
+		xml_indent( context );
+	buffer_puts( &context->output, "<" );
+	buffer_puts( &context->output, name );
+	context->pending = 1;
+	context->text = 0;
+}
+
+/** Add an attribute to the innermost open element, or to the root element.
+*/
+
+static void xml_attribute( serialise_context context, const char *name, const char *value )
+{
+	xml_buffer *buffer = context->depth ? &context->output : &context->attributes;
+
+	// The start tag has already been written
+	if ( context->depth && !context->pending )
+		return;
+	buffer_puts( buffer, " " );
+	buffer_puts( buffer, name );
+	buffer_puts( buffer, "=\"" );
+	buffer_escape( buffer, value ? value : "", 1, context->ascii );
+	buffer_puts( buffer, "\"" );
+}
+
+static void xml_text( serialise_context context, const char *value )
+{
+	if ( context->pending )
+		buffer_puts( &context->output, ">" );
+	context->pending = 0;
+	context->text = 1;
+	buffer_escape( &context->output, value, 0, context->ascii );
+}
+
+/** End the innermost open element.
+*/
+
+static void xml_end( serialise_context context )
+{
+	const char *name = context->elements[ context->depth ];
+
+	if ( context->pending )
+	{
+		buffer_puts( &context->output, "/>" );
+	}
+	else
+	{
+		if ( context->format && !context->text )
+			xml_indent( context );
+		buffer_puts( &context->output, "</" );
+		buffer_puts( &context->output, name );
+		buffer_puts( &context->output, ">" );
+	}
+	if ( context->format )
+		buffer_puts( &context->output, "\n" );
+	context->depth --;
+	context->pending = 0;
+	context->text = 0;
+}
+
+static void xml_property( serialise_context context, const char *name, const char *value )
+{
+	xml_start( context, "property" );
+	xml_attribute( context, "name", name );
+	if ( value )
+		xml_text( context, value );
+	xml_end( context );
+}
+
+static void on_property_changed( mlt_properties owner, void *object, mlt_event_data event_data )
+{
+	const char *name = mlt_event_data_to_string( event_data );
+
+	// The serialiser sets these itself, and they are not written to elements
+	if ( name && name[0] != '_' && strcmp( name, "mlt_type" ) && strcmp( name, "root" ) )
+		mlt_properties_set_int64( owner, STAMP_PROPERTY, atomic_fetch_add( &change_count, 1 ) + 1 );
+}
+
+static void on_changed( mlt_properties owner, void *object, mlt_event_data event_data )
+{
+	mlt_properties_set_int64( owner, STAMP_PROPERTY, atomic_fetch_add( &change_count, 1 ) + 1 );
+}
+
+/** Stop listening to the services when incremental saving is turned off.
+*/
+
+static void on_consumer_property_changed( mlt_properties owner, mlt_consumer consumer, mlt_event_data event_data )
+{
+	const char *name = mlt_event_data_to_string( event_data );
+
+	if ( name && !strcmp( name, "incremental" ) && !mlt_properties_get_int( owner, "incremental" ) )
+		mlt_properties_set_data( owner, WATCHING_PROPERTY, NULL, 0, NULL, NULL );
+}
+
+/** Stop listening to a service once no save has reached it.
+*/
+
+static void watch_close( xml_watch *watch )
+{
+	if ( -- watch->refs == 0 )
+	{
+		mlt_events_disconnect( watch->properties, watch->consumer );
+		mlt_properties_close( watch->properties );
+		free( watch );
+	}
+}
+
+/** Listen to a service for changes until a save no longer reaches it.
+ *
+ * The consumer keeps the services it listens to. The listeners belong to the
+ * consumer rather than to the services, because services block their own
+ * listeners while they update themselves.
+*/
+
+static void watch_service( serialise_context context, mlt_properties properties )
+{
+	char key[ 32 ];
+
+	snprintf( key, sizeof( key ), "%p", ( void* )properties );
+	if ( !mlt_properties_get_data( context->watching, key, NULL ) )
+	{
+		xml_watch *watch = mlt_properties_get_data( context->watched, key, NULL );
+		if ( watch )
+		{
+			watch->refs ++;
+		}
+		else
+		{
+			watch = calloc( 1, sizeof( xml_watch ) );
+			watch->properties = properties;
+			watch->consumer = context->consumer;
+			watch->refs = 1;
+			watch->since = atomic_fetch_add( &change_count, 1 ) + 1;
+			mlt_properties_inc_ref( properties );
+			mlt_events_listen( properties, context->consumer, "property-changed", ( mlt_listener )on_property_changed );
+			mlt_events_listen( properties, context->consumer, "service-changed", ( mlt_listener )on_changed );
+			mlt_events_listen( properties, context->consumer, "producer-changed", ( mlt_listener )on_changed );
+			mlt_events_listen( properties, context->consumer, "chain-changed", ( mlt_listener )on_changed );
+		}
+		mlt_properties_set_data( context->watching, key, watch, 0, ( mlt_destructor )watch_close, NULL );
+	}
+}
+
+/** Determine if the previous save has listened to a service since a time.
+*/
+
+static int is_watched( serialise_context context, mlt_properties properties, int64_t time )
+{
+	xml_watch *watch;
+	char key[ 32 ];
+
+	snprintf( key, sizeof( key ), "%p", ( void* )properties );
+	watch = mlt_properties_get_data( context->watched, key, NULL );
+	return watch && watch->since <= time;
+}
+
+/** Note that the fragment being written depends on some properties.
+*/
+
+static void serialise_watch( serialise_context context, mlt_properties properties )
+{
+	xml_fragment *fragment = context->fragment;
+
+	if ( context->key == NULL )
+		return;
+	watch_service( context, properties );
+	if ( fragment )
+	{
+		if ( fragment->watched_count == fragment->watched_size )
+		{
+			fragment->watched_size += 16;
+			fragment->watched = realloc( fragment->watched, fragment->watched_size * sizeof( mlt_properties ) );
+		}
+		// The fragment is kept on its own service, which must not hold itself
+		if ( properties != MLT_SERVICE_PROPERTIES( fragment->service ) )
+			mlt_properties_inc_ref( properties );
+		fragment->watched[ fragment->watched_count ++ ] = properties;
+	}
+}
+
+static void fragment_add_call( xml_fragment *fragment, xml_type type, mlt_service service, const char *id, int hide )
+{
+	xml_id_call *call;
+
+	if ( fragment->call_count == fragment->call_size )
+	{
+		fragment->call_size += 16;
+		fragment->calls = realloc( fragment->calls, fragment->call_size * sizeof( xml_id_call ) );
+	}
+	call = &fragment->calls[ fragment->call_count ++ ];
+	call->type = type;
+	call->service = service;
+	call->id = id ? strdup( id ) : NULL;
+	call->hide = hide;
+}
+
+static void fragment_close( xml_fragment *fragment )
+{
+	int i;
+
+	for ( i = 0; i < fragment->watched_count; i++ )
+		if ( fragment->watched[ i ] != MLT_SERVICE_PROPERTIES( fragment->service ) )
+			mlt_properties_close( fragment->watched[ i ] );
+	for ( i = 0; i < fragment->call_count; i++ )
+		free( fragment->calls[ i ].id );
+	free( fragment->calls );
+	free( fragment->watched );
+	free( fragment->key );
+	free( fragment->id );
+	free( fragment->text );
+	free( fragment );
+}
+
+static size_t hash_service( mlt_service service )
+{
+	uintptr_t x = ( uintptr_t ) service;
+	return ( size_t )( ( x >> 4 ) * 2654435761u );
+}
+
+static size_t hash_id( const char *id )
+{
+	size_t hash = 5381;
+	while ( *id )
+		hash = hash * 33 + ( unsigned char ) *id ++;
+	return hash;
+}
+
+static xml_id *id_map_service( xml_id_map *map, mlt_service service )
+{
+	size_t mask = map->size - 1;
+	size_t i = hash_service( service );
+
+	for ( ; map->size && map->by_service[ i & mask ]; i++ )
+		if ( map->ids[ map->by_service[ i & mask ] - 1 ].service == service )
+			return &map->ids[ map->by_service[ i & mask ] - 1 ];
+	return NULL;
+}
+
+static xml_id *id_map_id( xml_id_map *map, const char *id )
+{
+	size_t mask = map->size - 1;
+	size_t i = hash_id( id );
+
+	for ( ; map->size && map->by_id[ i & mask ]; i++ )
+		if ( !strcmp( map->ids[ map->by_id[ i & mask ] - 1 ].id, id ) )
+			return &map->ids[ map->by_id[ i & mask ] - 1 ];
+	return NULL;
+}
+
+static void id_map_index( xml_id_map *map, int index )
+{
+	size_t mask = map->size - 1;
+	size_t i;
+
+	for ( i = hash_service( map->ids[ index ].service ); map->by_service[ i & mask ]; i++ );
+	map->by_service[ i & mask ] = index + 1;
+	for ( i = hash_id( map->ids[ index ].id ); map->by_id[ i & mask ]; i++ );
+	map->by_id[ i & mask ] = index + 1;
+}
+
+/** Give an id to a service that does not have one yet.
+ *
+ * \return the copy of the id kept by the map
+*/
+
+static char *id_map_add( xml_id_map *map, const char *id, mlt_service service )
+{
+	int i;
+
+	if ( 2 * ( map->count + 1 ) > map->size )
+	{
+		int size = map->size ? 2 * map->size : 64;
+		xml_id *ids = realloc( map->ids, size / 2 * sizeof( xml_id ) );
+		if ( ids == NULL )
+			return NULL;
+		map->ids = ids;
+		free( map->by_service );
+		free( map->by_id );
+		map->by_service = calloc( size, sizeof( int ) );
+		map->by_id = calloc( size, sizeof( int ) );
+		map->size = size;
+		for ( i = 0; i < map->count; i++ )
+			id_map_index( map, i );
+	}
+	map->ids[ map->count ].service = service;
+	map->ids[ map->count ].id = strdup( id );
+	map->ids[ map->count ].hide = 0;
+	id_map_index( map, map->count );
+	return map->ids[ map->count ++ ].id;
+}
+
+static void id_map_close( xml_id_map *map )
+{
+	int i;
+
+	for ( i = 0; i < map->count; i++ )
+		free( map->ids[ i ].id );
+	free( map->ids );
+	free( map->by_service );
+	free( map->by_id );
 }
-xml_type;
 
 /** Create or retrieve an id associated to this service.
 */
 
 static char *xml_get_id( serialise_context context, mlt_service service, xml_type type )
 {
+	xml_id_map *map = &context->id_map;
+	xml_id *entry = id_map_service( map, service );
 	char *id = NULL;
-	int i = 0;
-	mlt_properties map = context->id_map;
-
-	// Search the map for the service
-	for ( i = 0; i < mlt_properties_count( map ); i ++ )
-		if ( mlt_properties_get_data_at( map, i, NULL ) == service )
-			break;
 
 	// If the service is not in the map, and the type indicates a new id is needed...
-	if ( i >= mlt_properties_count( map ) && type != xml_existing )
+	if ( entry == NULL && type != xml_existing )
 	{
 		// Attempt to reuse existing id
 		id = mlt_properties_get( MLT_SERVICE_PROPERTIES( service ), "id" );
 
 		// If no id, or the id is used in the map (for another service), then
 		// create a new one.
-		if ( id == NULL || mlt_properties_get_data( map, id, NULL ) != NULL )
+		if ( id == NULL || id_map_id( map, id ) != NULL )
 		{
 			char temp[ ID_SIZE ];
 			do
-			{
-				switch( type )
-				{
-					case xml_producer:
-						sprintf( temp, "producer%d", context->producer_count ++ );
-						break;
-					case xml_multitrack:
-						sprintf( temp, "multitrack%d", context->multitrack_count ++ );
-						break;
-					case xml_playlist:
-						sprintf( temp, "playlist%d", context->playlist_count ++ );
-						break;
-					case xml_tractor:
-						sprintf( temp, "tractor%d", context->tractor_count ++ );
-						break;
-					case xml_filter:
-						sprintf( temp, "filter%d", context->filter_count ++ );
-						break;
-					case xml_transition:
-						sprintf( temp, "transition%d", context->transition_count ++ );
-						break;
-					case xml_chain:
-						sprintf( temp, "chain%d", context->chain_count ++ );
-						break;
-					case xml_link:
-						sprintf( temp, "link%d", context->link_count ++ );
-						break;
-					case xml_existing:
-						// Never gets here
-						break;
-				}
-			}
-			while( mlt_properties_get_data( map, temp, NULL ) != NULL );
-
-			// Set the data at the generated name
-			mlt_properties_set_data( map, temp, service, 0, NULL, NULL );
-
-			// Get the pointer to the name (i is the end of the list)
-			id = mlt_properties_get_name( map, i );
+				sprintf( temp, "%s%d", id_prefix[ type ], context->id_count[ type ] ++ );
+			while( id_map_id( map, temp ) != NULL );
+			id = id_map_add( map, temp, service );
 		}
 		else
 		{
 			// Store the existing id in the map
-			mlt_properties_set_data( map, id, service, 0, NULL, NULL );
+			id = id_map_add( map, id, service );
 		}
 	}
-	else if ( type == xml_existing )
+	else if ( entry != NULL && type == xml_existing )
 	{
-		id = mlt_properties_get_name( map, i );
+		id = entry->id;
 	}
 
+	if ( context->fragment )
+		fragment_add_call( context->fragment, type, service, id, 0 );
+
 	return id;
 }
 
+static void xml_set_hide( serialise_context context, const char *id, int hide )
+{
+	xml_id *entry = id_map_id( &context->id_map, id );
+	if ( entry )
+		entry->hide = hide;
+}
+
+static int find_hide( serialise_context context, const char *id )
+{
+	xml_id *entry = id ? id_map_id( &context->id_map, id ) : NULL;
+	return entry ? entry->hide : 0;
+}
+
+static int xml_get_hide( serialise_context context, const char *id )
+{
+	int hide = find_hide( context, id );
+	if ( context->fragment )
+		fragment_add_call( context->fragment, xml_hide, NULL, id, hide );
+	return hide;
+}
+
+/** Work out the id that xml_get_id() would return without changing the map.
+ *
+ * Ids predicted earlier for the same fragment are kept in \p pending.
+*/
+
+static const char *predict_id( serialise_context context, mlt_service service, xml_type type, int *count, xml_id_map *pending )
+{
+	xml_id_map *map = &context->id_map;
+	xml_id *entry = id_map_service( map, service );
+	const char *id = NULL;
+
+	if ( entry == NULL )
+		entry = id_map_service( pending, service );
+	if ( entry != NULL || type == xml_existing )
+		return entry != NULL && type == xml_existing ? entry->id : NULL;
+
+	id = mlt_properties_get( MLT_SERVICE_PROPERTIES( service ), "id" );
+	if ( id == NULL || id_map_id( map, id ) || id_map_id( pending, id ) )
+	{
+		char temp[ ID_SIZE ];
+		do
+			sprintf( temp, "%s%d", id_prefix[ type ], count[ type ] ++ );
+		while( id_map_id( map, temp ) || id_map_id( pending, temp ) );
+		return id_map_add( pending, temp, service );
+	}
+	return id_map_add( pending, id, service );
+}
+
+/** Assign the ids of a fragment again if they come out the same as before.
+*/
+
+static int fragment_replay( serialise_context context, xml_fragment *fragment )
+{
+	xml_id_map pending = { NULL, 0, NULL, NULL, 0 };
+	int count[ xml_link + 1 ];
+	int result = 1;
+	int i;
+
+	memcpy( count, context->id_count, sizeof( count ) );
+	for ( i = 0; result && i < fragment->call_count; i++ )
+	{
+		xml_id_call *call = &fragment->calls[ i ];
+		if ( call->type == xml_hide )
+		{
+			result = find_hide( context, call->id ) == call->hide;
+		}
+		else
+		{
+			const char *id = predict_id( context, call->service, call->type, count, &pending );
+			result = id == call->id || ( id && call->id && !strcmp( id, call->id ) );
+		}
+	}
+	id_map_close( &pending );
+
+	for ( i = 0; result && i < fragment->call_count; i++ )
+		if ( fragment->calls[ i ].type != xml_hide )
+			xml_get_id( context, fragment->calls[ i ].service, fragment->calls[ i ].type );
+
+	return result;
+}
+
+/** Reuse the text of an element from the previous save, or start to record it.
+ *
+ * Services are watched in the order they are reached, so each one is only
+ * looked at once whatever holds it is known to be unchanged.
+ * \return true if the element was written
+*/
+
+static int fragment_begin( serialise_context context, mlt_service service, const char *id )
+{
+	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
+	xml_fragment *fragment = NULL;
+	int i;
+
+	if ( context->key == NULL || context->fragment != NULL || context->depth )
+		return 0;
+
+	fragment = mlt_properties_get_data( properties, FRAGMENT_PROPERTY, NULL );
+	if ( fragment && !strcmp( fragment->key, context->key ) && !strcmp( fragment->id, id ) )
+	{
+		// The services must not have changed, nor gone unwatched by this consumer
+		for ( i = 0; i < fragment->watched_count; i++ )
+			if ( mlt_properties_get_int64( fragment->watched[ i ], STAMP_PROPERTY ) > fragment->stamp
+				|| !is_watched( context, fragment->watched[ i ], fragment->made ) )
+				break;
+		if ( i == fragment->watched_count && fragment_replay( context, fragment ) )
+		{
+			for ( i = 0; i < fragment->watched_count; i++ )
+				watch_service( context, fragment->watched[ i ] );
+			buffer_append( &context->output, fragment->text, fragment->size );
+			return 1;
+		}
+	}
+
+	fragment = calloc( 1, sizeof( xml_fragment ) );
+	fragment->service = service;
+	fragment->key = strdup( context->key );
+	fragment->id = strdup( id );
+	fragment->stamp = atomic_load( &change_count );
+	fragment->start = context->output.used;
+	context->fragment = fragment;
+	serialise_watch( context, properties );
+	return 0;
+}
+
+static void fragment_end( serialise_context context, mlt_service service )
+{
+	xml_fragment *fragment = context->fragment;
+
+	if ( fragment && fragment->service == service )
+	{
+		context->fragment = NULL;
+		fragment->made = atomic_load( &change_count );
+		fragment->size = context->output.used - fragment->start;
+		fragment->text = malloc( fragment->size );
+		if ( fragment->text )
+		{
+			memcpy( fragment->text, context->output.data + fragment->start, fragment->size );
+			mlt_properties_set_data( MLT_SERVICE_PROPERTIES( service ), FRAGMENT_PROPERTY, fragment, 0, ( mlt_destructor )fragment_close, NULL );
+		}
+		else
+		{
+			fragment_close( fragment );
+		}
+	}
+}
+
 /** This is what will be called by the factory - anything can be passed in
 	via the argument, but keep it simple.
 */
@@ -176,7 +786,7 @@ mlt_consumer consumer_xml_init( mlt_profile profile, mlt_service_type type, cons
 		consumer->start = consumer_start;
 		consumer->stop = consumer_stop;
 		consumer->is_stopped = consumer_is_stopped;
-		
+
 		// Assign close callback
 		consumer->close = consumer_close;
 
@@ -184,6 +794,8 @@ mlt_consumer consumer_xml_init( mlt_profile profile, mlt_service_type type, cons
 		mlt_properties_set_int( MLT_CONSUMER_PROPERTIES( consumer ), "real_time", 0 );
 		mlt_properties_set_int( MLT_CONSUMER_PROPERTIES( consumer ), "prefill", 1 );
 		mlt_properties_set_int( MLT_CONSUMER_PROPERTIES( consumer ), "terminate_on_pause", 1 );
+		mlt_properties_set_int( MLT_CONSUMER_PROPERTIES( consumer ), "_binary", id && !strcmp( id, "xml-binary" ) );
+		mlt_events_listen( MLT_CONSUMER_PROPERTIES( consumer ), consumer, "property-changed", ( mlt_listener )on_consumer_property_changed );
 
 		// Return the consumer produced
 		return consumer;
@@ -196,10 +808,9 @@ mlt_consumer consumer_xml_init( mlt_profile profile, mlt_service_type type, cons
 	return NULL;
 }
 
-static void serialise_properties( serialise_context context, mlt_properties properties, xmlNode *node )
+static void serialise_properties( serialise_context context, mlt_properties properties )
 {
 	int i;
-	xmlNode *p;
 
 	// Enumerate the properties
 	for ( i = 0; i < mlt_properties_count( properties ); i++ )
@@ -243,24 +854,22 @@ static void serialise_properties( serialise_context context, mlt_properties prop
 						char *s = calloc( 1, strlen( value_orig ) - rootlen + 1 );
 						strncat( s, value_orig, prefix_size );
 						strcat( s, value + rootlen + 1 );
-						p = xmlNewTextChild( node, NULL, _x("property"), _x(s) );
+						xml_property( context, name, s );
 						free( s );
 					} else {
-						p = xmlNewTextChild( node, NULL, _x("property"), _x(value_orig + rootlen + 1) );
+						xml_property( context, name, value_orig + rootlen + 1 );
 					}
 				}
 				else
-					p = xmlNewTextChild( node, NULL, _x("property"), _x(value_orig) );
-				xmlNewProp( p, _x("name"), _x(name) );
+					xml_property( context, name, value_orig );
 			}
 		}
 	}
 }
 
-static void serialise_store_properties( serialise_context context, mlt_properties properties, xmlNode *node, const char *store )
+static void serialise_store_properties( serialise_context context, mlt_properties properties, const char *store )
 {
 	int i;
-	xmlNode *p;
 
 	// Enumerate the properties
 	for ( i = 0; store != NULL && i < mlt_properties_count( properties ); i++ )
@@ -274,19 +883,17 @@ static void serialise_store_properties( serialise_context context, mlt_propertie
 				int rootlen = strlen( context->root );
 				// convert absolute path to relative
 				if ( rootlen && !strncmp( value, context->root, rootlen ) && value[ rootlen ] == '/' )
-					p = xmlNewTextChild( node, NULL, _x("property"), _x(value + rootlen + 1) );
+					xml_property( context, name, value + rootlen + 1 );
 				else
-					p = xmlNewTextChild( node, NULL, _x("property"), _x(value) );
-				xmlNewProp( p, _x("name"), _x(name) );
+					xml_property( context, name, value );
 			}
 		}
 	}
 }
 
-static inline void serialise_service_filters( serialise_context context, mlt_service service, xmlNode *node )
+static inline void serialise_service_filters( serialise_context context, mlt_service service )
 {
 	int i;
-	xmlNode *p;
 	mlt_filter filter = NULL;
 
 	// Enumerate the filters
@@ -299,24 +906,25 @@ static inline void serialise_service_filters( serialise_context context, mlt_ser
 			char *id = xml_get_id( context, MLT_FILTER_SERVICE( filter ), xml_filter );
 			if ( id != NULL )
 			{
-				p = xmlNewChild( node, NULL, _x("filter"), NULL );
-				xmlNewProp( p, _x("id"), _x(id) );
+				serialise_watch( context, properties );
+				xml_start( context, "filter" );
+				xml_attribute( context, "id", id );
 				if ( mlt_properties_get( properties, "title" ) )
-					xmlNewProp( p, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+					xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 				if ( mlt_properties_get_position( properties, "in" ) )
-					xmlNewProp( p, _x("in"), _x( mlt_properties_get_time( properties, "in", context->time_format ) ) );
+					xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
 				if ( mlt_properties_get_position( properties, "out" ) )
-					xmlNewProp( p, _x("out"), _x( mlt_properties_get_time( properties, "out", context->time_format ) ) );
-				serialise_properties( context, properties, p );
-				serialise_service_filters( context, MLT_FILTER_SERVICE( filter ), p );
+					xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
+				serialise_properties( context, properties );
+				serialise_service_filters( context, MLT_FILTER_SERVICE( filter ) );
+				xml_end( context );
 			}
 		}
 	}
 }
 
-static void serialise_producer( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_producer( serialise_context context, mlt_service service )
 {
-	xmlNode *child = node;
 	mlt_service parent = MLT_SERVICE( mlt_producer_cut_parent( MLT_PRODUCER( service ) ) );
 
 	if ( context->pass == 0 )
@@ -327,15 +935,6 @@ static void serialise_producer( serialise_context context, mlt_service service,
 		if ( id == NULL )
 			return;
 
-		child = xmlNewChild( node, NULL, _x("producer"), NULL );
-
-		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
-		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
-		xmlNewProp( child, _x("in"), _x(mlt_properties_get_time( properties, "in", context->time_format )) );
-		xmlNewProp( child, _x("out"), _x(mlt_properties_get_time( properties, "out", context->time_format )) );
-
 		// If the xml producer fails to load a producer, it creates a text producer that says INVALID
 		// and sets the xml_mlt_service property to the original service.
 		const char *xml_mlt_service = mlt_properties_get(properties, "_xml_mlt_service");
@@ -344,25 +943,40 @@ static void serialise_producer( serialise_context context, mlt_service service,
 			mlt_properties_set(properties, "mlt_service", xml_mlt_service);
 		}
 
-		serialise_properties( context, properties, child );
-		serialise_service_filters( context, service, child );
+		// Filters belong to the cut, so only keep the text of a whole producer
+		if ( service != parent || !fragment_begin( context, parent, id ) )
+		{
+			xml_start( context, "producer" );
+
+			// Set the id
+			xml_attribute( context, "id", id );
+			if ( mlt_properties_get( properties, "title" ) )
+				xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
+			xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
+			xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
+
+			serialise_properties( context, properties );
+			serialise_service_filters( context, service );
+			xml_end( context );
+			fragment_end( context, parent );
+		}
 
 		// Add producer to the map
-		mlt_properties_set_int( context->hide_map, id, mlt_properties_get_int( properties, "hide" ) );
+		xml_set_hide( context, id, mlt_properties_get_int( properties, "hide" ) );
 	}
 	else
 	{
 		char *id = xml_get_id( context, parent, xml_existing );
 		mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
-		xmlNewProp( node, _x("parent"), _x(id) );
-		xmlNewProp( node, _x("in"), _x(mlt_properties_get_time( properties, "in", context->time_format )) );
-		xmlNewProp( node, _x("out"), _x(mlt_properties_get_time( properties, "out", context->time_format )) );
+		xml_attribute( context, "parent", id );
+		xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
+		xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 	}
 }
 
-static void serialise_tractor( serialise_context context, mlt_service service, xmlNode *node );
+static void serialise_tractor( serialise_context context, mlt_service service );
 
-static void serialise_multitrack( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_multitrack( serialise_context context, mlt_service service )
 {
 	int i;
 
@@ -372,7 +986,7 @@ static void serialise_multitrack( serialise_context context, mlt_service service
 		for ( i = 0; i < mlt_multitrack_count( MLT_MULTITRACK( service ) ); i++ )
 		{
 			mlt_producer producer = mlt_producer_cut_parent( mlt_multitrack_track( MLT_MULTITRACK( service ), i ) );
-			serialise_service( context, MLT_SERVICE( producer ), node );
+			serialise_service( context, MLT_SERVICE( producer ) );
 		}
 	}
 	else
@@ -382,10 +996,11 @@ static void serialise_multitrack( serialise_context context, mlt_service service
 		if ( id == NULL )
 			return;
 
+		serialise_watch( context, MLT_SERVICE_PROPERTIES( service ) );
+
 		// Serialise the tracks
 		for ( i = 0; i < mlt_multitrack_count( MLT_MULTITRACK( service ) ); i++ )
 		{
-			xmlNode *track = xmlNewChild( node, NULL, _x("track"), NULL );
 			int hide = 0;
 			mlt_producer producer = mlt_multitrack_track( MLT_MULTITRACK( service ), i );
 			mlt_properties properties = MLT_PRODUCER_PROPERTIES( producer );
@@ -393,30 +1008,36 @@ static void serialise_multitrack( serialise_context context, mlt_service service
 			mlt_service parent = MLT_SERVICE( mlt_producer_cut_parent( producer ) );
 
 			char *id = xml_get_id( context, MLT_SERVICE( parent ), xml_existing );
-			xmlNewProp( track, _x("producer"), _x(id) );
+			serialise_watch( context, properties );
+			xml_start( context, "track" );
+			xml_attribute( context, "producer", id );
 			if ( mlt_producer_is_cut( producer ) )
 			{
-				xmlNewProp( track, _x("in"), _x( mlt_properties_get_time( properties, "in", context->time_format ) ) );
-				xmlNewProp( track, _x("out"), _x( mlt_properties_get_time( properties, "out", context->time_format ) ) );
-				serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( producer ), track, context->store );
-				serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( producer ), track, "xml_" );
-				if ( !context->no_meta )
-					serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( producer ), track, "meta." );
-				serialise_service_filters( context, MLT_PRODUCER_SERVICE( producer ), track );
+				xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
+				xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 			}
 
-			hide = mlt_properties_get_int( context->hide_map, id );
+			hide = xml_get_hide( context, id );
 			if ( hide )
-				xmlNewProp( track, _x("hide"), _x( hide == 1 ? "video" : ( hide == 2 ? "audio" : "both" ) ) );
+				xml_attribute( context, "hide", hide == 1 ? "video" : ( hide == 2 ? "audio" : "both" ) );
+
+			if ( mlt_producer_is_cut( producer ) )
+			{
+				serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( producer ), context->store );
+				serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( producer ), "xml_" );
+				if ( !context->no_meta )
+					serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( producer ), "meta." );
+				serialise_service_filters( context, MLT_PRODUCER_SERVICE( producer ) );
+			}
+			xml_end( context );
 		}
-		serialise_service_filters( context, service, node );
+		serialise_service_filters( context, service );
 	}
 }
 
-static void serialise_playlist( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_playlist( serialise_context context, mlt_service service )
 {
 	int i;
-	xmlNode *child = node;
 	mlt_playlist_clip_info info;
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
 
@@ -438,28 +1059,31 @@ static void serialise_playlist( serialise_context context, mlt_service service,
 					char *service_s = mlt_properties_get( MLT_PRODUCER_PROPERTIES( producer ), "mlt_service" );
 					char *resource_s = mlt_properties_get( MLT_PRODUCER_PROPERTIES( producer ), "resource" );
 					if ( resource_s != NULL && !strcmp( resource_s, "<playlist>" ) )
-						serialise_playlist( context, MLT_SERVICE( producer ), node );
+						serialise_playlist( context, MLT_SERVICE( producer ) );
 					else if ( service_s != NULL && strcmp( service_s, "blank" ) != 0 )
-						serialise_service( context, MLT_SERVICE( producer ), node );
+						serialise_service( context, MLT_SERVICE( producer ) );
 				}
 			}
 		}
 
-		child = xmlNewChild( node, NULL, _x("playlist"), NULL );
+		// Add producer to the map
+		xml_set_hide( context, id, mlt_properties_get_int( properties, "hide" ) );
+
+		if ( fragment_begin( context, service, id ) )
+			return;
+
+		xml_start( context, "playlist" );
 
 		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
+		xml_attribute( context, "id", id );
 		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+			xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 
 		// Store application specific properties
-		serialise_store_properties( context, properties, child, context->store );
-		serialise_store_properties( context, properties, child, "xml_" );
+		serialise_store_properties( context, properties, context->store );
+		serialise_store_properties( context, properties, "xml_" );
 		if ( !context->no_meta )
-			serialise_store_properties( context, properties, child, "meta." );
-
-		// Add producer to the map
-		mlt_properties_set_int( context->hide_map, id, mlt_properties_get_int( properties, "hide" ) );
+			serialise_store_properties( context, properties, "meta." );
 
 		// Iterate over the playlist entries
 		for ( i = 0; i < mlt_playlist_count( MLT_PLAYLIST( service ) ); i++ )
@@ -471,56 +1095,60 @@ static void serialise_playlist( serialise_context context, mlt_service service,
 				char *service_s = mlt_properties_get( producer_props, "mlt_service" );
 				if ( service_s != NULL && strcmp( service_s, "blank" ) == 0 )
 				{
-					xmlNode *entry = xmlNewChild( child, NULL, _x("blank"), NULL );
+					xml_start( context, "blank" );
 					mlt_properties_set_data( producer_props, "_profile", context->profile, 0, NULL, NULL );
 					mlt_properties_set_position( producer_props, TIME_PROPERTY, info.frame_count );
-					xmlNewProp( entry, _x("length"), _x( mlt_properties_get_time( producer_props, TIME_PROPERTY, context->time_format ) ) );
+					xml_attribute( context, "length", mlt_properties_get_time( producer_props, TIME_PROPERTY, context->time_format ) );
+					xml_end( context );
 				}
 				else
 				{
 					char temp[ 20 ];
-					xmlNode *entry = xmlNewChild( child, NULL, _x("entry"), NULL );
+					serialise_watch( context, MLT_PRODUCER_PROPERTIES( info.cut ) );
+					xml_start( context, "entry" );
 					id = xml_get_id( context, MLT_SERVICE( producer ), xml_existing );
-					xmlNewProp( entry, _x("producer"), _x(id) );
+					xml_attribute( context, "producer", id );
 					mlt_properties_set_position( producer_props, TIME_PROPERTY, info.frame_in );
-					xmlNewProp( entry, _x("in"), _x( mlt_properties_get_time( producer_props, TIME_PROPERTY, context->time_format ) ) );
+					xml_attribute( context, "in", mlt_properties_get_time( producer_props, TIME_PROPERTY, context->time_format ) );
 					mlt_properties_set_position( producer_props, TIME_PROPERTY, info.frame_out );
-					xmlNewProp( entry, _x("out"), _x( mlt_properties_get_time( producer_props, TIME_PROPERTY, context->time_format ) ) );
+					xml_attribute( context, "out", mlt_properties_get_time( producer_props, TIME_PROPERTY, context->time_format ) );
 					if ( info.repeat > 1 )
 					{
 						sprintf( temp, "%d", info.repeat );
-						xmlNewProp( entry, _x("repeat"), _x(temp) );
+						xml_attribute( context, "repeat", temp );
 					}
 					if ( mlt_producer_is_cut( info.cut ) )
 					{
-						serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( info.cut ), entry, context->store );
-						serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( info.cut ), entry, "xml_" );
+						serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( info.cut ), context->store );
+						serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( info.cut ), "xml_" );
 						if ( !context->no_meta )
-							serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( info.cut ), entry, "meta." );
-						serialise_service_filters( context, MLT_PRODUCER_SERVICE( info.cut ), entry );
+							serialise_store_properties( context, MLT_PRODUCER_PROPERTIES( info.cut ), "meta." );
+						serialise_service_filters( context, MLT_PRODUCER_SERVICE( info.cut ) );
 					}
+					xml_end( context );
 				}
 			}
 		}
 
-		serialise_service_filters( context, service, child );
+		serialise_service_filters( context, service );
+		xml_end( context );
+		fragment_end( context, service );
 	}
-	else if ( xmlStrcmp( node->name, _x("tractor") ) != 0 )
+	else if ( !context->depth || strcmp( context->elements[ context->depth ], "tractor" ) )
 	{
 		char *id = xml_get_id( context, service, xml_existing );
-		xmlNewProp( node, _x("producer"), _x(id) );
+		xml_attribute( context, "producer", id );
 	}
 }
 
-static void serialise_tractor( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_tractor( serialise_context context, mlt_service service )
 {
-	xmlNode *child = node;
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
 
 	if ( context->pass == 0 )
 	{
 		// Recurse on connected producer
-		serialise_service( context, mlt_service_producer( service ), node );
+		serialise_service( context, mlt_service_producer( service ) );
 	}
 	else
 	{
@@ -529,36 +1157,44 @@ static void serialise_tractor( serialise_context context, mlt_service service, x
 		if ( id == NULL )
 			return;
 
-		child = xmlNewChild( node, NULL, _x("tractor"), NULL );
+		if ( fragment_begin( context, service, id ) )
+			return;
+		if ( mlt_service_identify( service ) == mlt_service_tractor_type )
+			serialise_watch( context, mlt_field_properties( mlt_tractor_field( MLT_TRACTOR( service ) ) ) );
+
+		xml_start( context, "tractor" );
 
 		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
+		xml_attribute( context, "id", id );
 		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+			xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 		if ( mlt_properties_get_position( properties, "in" ) >= 0 )
-			xmlNewProp( child, _x("in"), _x(mlt_properties_get_time( properties, "in", context->time_format )) );
+			xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
 		if ( mlt_properties_get_position( properties, "out" ) >= 0 )
-			xmlNewProp( child, _x("out"), _x(mlt_properties_get_time( properties, "out", context->time_format )) );
+			xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 
 		// Store application specific properties
-		serialise_store_properties( context, MLT_SERVICE_PROPERTIES( service ), child, context->store );
-		serialise_store_properties( context, MLT_SERVICE_PROPERTIES( service ), child, "xml_" );
+		serialise_store_properties( context, MLT_SERVICE_PROPERTIES( service ), context->store );
+		serialise_store_properties( context, MLT_SERVICE_PROPERTIES( service ), "xml_" );
 		if ( !context->no_meta )
-			serialise_store_properties( context, MLT_SERVICE_PROPERTIES( service ), child, "meta." );
+			serialise_store_properties( context, MLT_SERVICE_PROPERTIES( service ), "meta." );
 
 		// Recurse on connected producer
-		serialise_service( context, mlt_service_producer( service ), child );
-		serialise_service_filters( context, service, child );
+		serialise_service( context, mlt_service_producer( service ) );
+		serialise_service_filters( context, service );
+		xml_end( context );
+		fragment_end( context, service );
 	}
 }
 
-static void serialise_filter( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_filter( serialise_context context, mlt_service service )
 {
-	xmlNode *child = node;
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
 
 	// Recurse on connected producer
-	serialise_service( context, mlt_service_producer( service ), node );
+	if ( context->pass == 1 )
+		serialise_watch( context, properties );
+	serialise_service( context, mlt_service_producer( service ) );
 
 	if ( context->pass == 1 )
 	{
@@ -567,29 +1203,31 @@ static void serialise_filter( serialise_context context, mlt_service service, xm
 		if ( id == NULL )
 			return;
 
-		child = xmlNewChild( node, NULL, _x("filter"), NULL );
+		xml_start( context, "filter" );
 
 		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
+		xml_attribute( context, "id", id );
 		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+			xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 		if ( mlt_properties_get_position( properties, "in" ) )
-			xmlNewProp( child, _x("in"), _x( mlt_properties_get_time( properties, "in", context->time_format ) ) );
+			xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
 		if ( mlt_properties_get_position( properties, "out" ) )
-			xmlNewProp( child, _x("out"), _x( mlt_properties_get_time( properties, "out", context->time_format ) ) );
+			xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 
-		serialise_properties( context, properties, child );
-		serialise_service_filters( context, service, child );
+		serialise_properties( context, properties );
+		serialise_service_filters( context, service );
+		xml_end( context );
 	}
 }
 
-static void serialise_transition( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_transition( serialise_context context, mlt_service service )
 {
-	xmlNode *child = node;
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
 
 	// Recurse on connected producer
-	serialise_service( context, MLT_SERVICE( MLT_TRANSITION( service )->producer ), node );
+	if ( context->pass == 1 )
+		serialise_watch( context, properties );
+	serialise_service( context, MLT_SERVICE( MLT_TRANSITION( service )->producer ) );
 
 	if ( context->pass == 1 )
 	{
@@ -598,25 +1236,25 @@ static void serialise_transition( serialise_context context, mlt_service service
 		if ( id == NULL )
 			return;
 
-		child = xmlNewChild( node, NULL, _x("transition"), NULL );
+		xml_start( context, "transition" );
 
 		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
+		xml_attribute( context, "id", id );
 		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+			xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 		if ( mlt_properties_get_position( properties, "in" ) )
-			xmlNewProp( child, _x("in"), _x( mlt_properties_get_time( properties, "in", context->time_format ) ) );
+			xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
 		if ( mlt_properties_get_position( properties, "out" ) )
-			xmlNewProp( child, _x("out"), _x( mlt_properties_get_time( properties, "out", context->time_format ) ) );
+			xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 
-		serialise_properties( context, properties, child );
-		serialise_service_filters( context, service, child );
+		serialise_properties( context, properties );
+		serialise_service_filters( context, service );
+		xml_end( context );
 	}
 }
 
-static void serialise_link( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_link( serialise_context context, mlt_service service )
 {
-	xmlNode *child = node;
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
 
 	if ( context->pass == 0 )
@@ -626,26 +1264,27 @@ static void serialise_link( serialise_context context, mlt_service service, xmlN
 		if ( id == NULL )
 			return;
 
-		child = xmlNewChild( node, NULL, _x("link"), NULL );
+		serialise_watch( context, properties );
+		xml_start( context, "link" );
 
 		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
+		xml_attribute( context, "id", id );
 		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+			xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 		if ( mlt_properties_get_position( properties, "in" ) )
-			xmlNewProp( child, _x("in"), _x( mlt_properties_get_time( properties, "in", context->time_format ) ) );
+			xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
 		if ( mlt_properties_get_position( properties, "out" ) )
-			xmlNewProp( child, _x("out"), _x( mlt_properties_get_time( properties, "out", context->time_format ) ) );
+			xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 
-		serialise_properties( context, properties, child );
-		serialise_service_filters( context, service, child );
+		serialise_properties( context, properties );
+		serialise_service_filters( context, service );
+		xml_end( context );
 	}
 }
 
-static void serialise_chain( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_chain( serialise_context context, mlt_service service )
 {
 	int i = 0;
-	xmlNode *child = node;
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
 
 	if ( context->pass == 0 )
@@ -655,18 +1294,21 @@ static void serialise_chain( serialise_context context, mlt_service service, xml
 		if ( id == NULL )
 			return;
 
-		child = xmlNewChild( node, NULL, _x("chain"), NULL );
+		if ( fragment_begin( context, service, id ) )
+			return;
+
+		xml_start( context, "chain" );
 
 		// Set the id
-		xmlNewProp( child, _x("id"), _x(id) );
+		xml_attribute( context, "id", id );
 		if ( mlt_properties_get( properties, "title" ) )
-			xmlNewProp( child, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+			xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 		if ( mlt_properties_get_position( properties, "in" ) )
-			xmlNewProp( child, _x("in"), _x( mlt_properties_get_time( properties, "in", context->time_format ) ) );
+			xml_attribute( context, "in", mlt_properties_get_time( properties, "in", context->time_format ) );
 		if ( mlt_properties_get_position( properties, "out" ) )
-			xmlNewProp( child, _x("out"), _x( mlt_properties_get_time( properties, "out", context->time_format ) ) );
+			xml_attribute( context, "out", mlt_properties_get_time( properties, "out", context->time_format ) );
 
-		serialise_properties( context, properties, child );
+		serialise_properties( context, properties );
 
 		// Serialize links
 		for ( i = 0; i < mlt_chain_link_count( MLT_CHAIN( service ) ); i++ )
@@ -674,15 +1316,17 @@ static void serialise_chain( serialise_context context, mlt_service service, xml
 			mlt_link link = mlt_chain_link( MLT_CHAIN( service ), i );
 			if ( link )
 			{
-				serialise_link( context, MLT_LINK_SERVICE(link), child );
+				serialise_link( context, MLT_LINK_SERVICE(link) );
 			}
 		}
 
-		serialise_service_filters( context, service, child );
+		serialise_service_filters( context, service );
+		xml_end( context );
+		fragment_end( context, service );
 	}
 }
 
-static void serialise_service( serialise_context context, mlt_service service, xmlNode *node )
+static void serialise_service( serialise_context context, mlt_service service )
 {
 	// Iterate over consumer/producer connections
 	while ( service != NULL )
@@ -697,15 +1341,15 @@ static void serialise_service( serialise_context context, mlt_service service, x
 			if ( mlt_properties_get( properties, "xml" ) == NULL && ( mlt_service != NULL && !strcmp( mlt_service, "tractor" ) ) )
 			{
 				context->pass = 0;
-				serialise_tractor( context, service, node );
+				serialise_tractor( context, service );
 				context->pass = 1;
-				serialise_tractor( context, service, node );
+				serialise_tractor( context, service );
 				context->pass = 0;
 				break;
 			}
 			else
 			{
-				serialise_producer( context, service, node );
+				serialise_producer( context, service );
 			}
 			if ( mlt_properties_get( properties, "xml" ) != NULL )
 				break;
@@ -719,23 +1363,23 @@ static void serialise_service( serialise_context context, mlt_service service, x
 			// Recurse on multitrack's tracks
 			if ( resource && strcmp( resource, "<multitrack>" ) == 0 )
 			{
-				serialise_multitrack( context, service, node );
+				serialise_multitrack( context, service );
 				break;
 			}
 
 			// Recurse on playlist's clips
 			else if ( resource && strcmp( resource, "<playlist>" ) == 0 )
 			{
-				serialise_playlist( context, service, node );
+				serialise_playlist( context, service );
 			}
 
 			// Recurse on tractor's producer
 			else if ( resource && strcmp( resource, "<tractor>" ) == 0 )
 			{
 				context->pass = 0;
-				serialise_tractor( context, service, node );
+				serialise_tractor( context, service );
 				context->pass = 1;
-				serialise_tractor( context, service, node );
+				serialise_tractor( context, service );
 				context->pass = 0;
 				break;
 			}
@@ -743,7 +1387,7 @@ static void serialise_service( serialise_context context, mlt_service service, x
 			// Treat it as a normal chain
 			else if ( mlt_properties_get_int( properties, "_original_type" ) == mlt_service_chain_type )
 			{
-				serialise_chain( context, service, node );
+				serialise_chain( context, service );
 				mlt_properties_set( properties, "mlt_type", "chain" );
 				if ( mlt_properties_get( properties, "xml" ) != NULL )
 					break;
@@ -752,7 +1396,7 @@ static void serialise_service( serialise_context context, mlt_service service, x
 			// Treat it as a normal producer
 			else
 			{
-				serialise_producer( context, service, node );
+				serialise_producer( context, service );
 				if ( mlt_properties_get( properties, "xml" ) != NULL )
 					break;
 			}
@@ -761,21 +1405,21 @@ static void serialise_service( serialise_context context, mlt_service service, x
 		// Tell about a chain
 		else if ( strcmp( mlt_type, "chain" ) == 0 )
 		{
-			serialise_chain( context, service, node );
+			serialise_chain( context, service );
 			break;
 		}
 
 		// Tell about a filter
 		else if ( strcmp( mlt_type, "filter" ) == 0 )
 		{
-			serialise_filter( context, service, node );
+			serialise_filter( context, service );
 			break;
 		}
 
 		// Tell about a transition
 		else if ( strcmp( mlt_type, "transition" ) == 0 )
 		{
-			serialise_transition( context, service, node );
+			serialise_transition( context, service );
 			break;
 		}
 
@@ -784,7 +1428,7 @@ static void serialise_service( serialise_context context, mlt_service service, x
 	}
 }
 
-static void serialise_other( mlt_properties properties, struct serialise_context_s *context, xmlNodePtr root )
+static void serialise_other( mlt_properties properties, struct serialise_context_s *context )
 {
 	int i;
 	for ( i = 0; i < mlt_properties_count( properties ); i++ )
@@ -795,27 +1439,55 @@ static void serialise_other( mlt_properties properties, struct serialise_context
 			mlt_service service = mlt_properties_get_data_at( properties, i, NULL );
 			if ( service )
 			{
-				mlt_properties_set_int( MLT_SERVICE_PROPERTIES( service ), "xml_retain", 1 );
-				serialise_service( context, service, root );
+				if ( mlt_properties_get_int( MLT_SERVICE_PROPERTIES( service ), "xml_retain" ) != 1 )
+					mlt_properties_set_int( MLT_SERVICE_PROPERTIES( service ), "xml_retain", 1 );
+				serialise_service( context, service );
 			}
 		}
 	}
 }
 
-xmlDocPtr xml_make_doc( mlt_consumer consumer, mlt_service service )
+/** Describe the settings that change the text of the elements.
+*/
+
+static char *serialise_key( serialise_context context )
+{
+	mlt_profile profile = context->profile;
+	char *key = NULL;
+	int size = snprintf( NULL, 0, "%d\n%d\n%d\n%d\n%d\n%d\n%s\n%s", context->format, context->ascii,
+		context->no_meta, context->time_format, profile ? profile->frame_rate_num : 0,
+		profile ? profile->frame_rate_den : 0, context->root, context->store ? context->store : "" );
+
+	key = malloc( size + 1 );
+	if ( key )
+		sprintf( key, "%d\n%d\n%d\n%d\n%d\n%d\n%s\n%s", context->format, context->ascii,
+			context->no_meta, context->time_format, profile ? profile->frame_rate_num : 0,
+			profile ? profile->frame_rate_den : 0, context->root, context->store ? context->store : "" );
+	return key;
+}
+
+/** Write the document as text.
+ *
+ * \param format indent the elements on their own lines
+ * \param ascii write characters outside of ASCII as character references
+ * \param[out] length the length of the returned text
+ * \return the text, which the caller must free
+*/
+
+static char *serialise_document( mlt_consumer consumer, mlt_service service, int format, int ascii, size_t *length )
 {
 	mlt_properties properties = MLT_SERVICE_PROPERTIES( service );
-	xmlDocPtr doc = xmlNewDoc( _x("1.0") );
-	xmlNodePtr root = xmlNewNode( NULL, _x("mlt") );
 	struct serialise_context_s *context = calloc( 1, sizeof( struct serialise_context_s ) );
 	mlt_profile profile = mlt_service_profile( MLT_CONSUMER_SERVICE( consumer ) );
+	xml_buffer document = { NULL, 0, 0 };
 	char tmpstr[ 32 ];
 
-	xmlDocSetRootElement( doc, root );
+	context->format = format;
+	context->ascii = ascii;
 
 	// Indicate the numeric locale
 	if ( mlt_properties_get_lcnumeric( properties ) )
-		xmlNewProp( root, _x("LC_NUMERIC"), _x( mlt_properties_get_lcnumeric( properties ) ) );
+		xml_attribute( context, "LC_NUMERIC", mlt_properties_get_lcnumeric( properties ) );
 	else
 #ifdef _WIN32
 	{
@@ -824,20 +1496,20 @@ xmlDocPtr xml_make_doc( mlt_consumer consumer, mlt_service service )
 		free( lcnumeric );
 		mlt_properties_to_utf8( properties, "_xml_lcnumeric_in", "_xml_lcnumeric_out" );
 		lcnumeric = mlt_properties_get( properties, "_xml_lcnumeric_out" );
-		xmlNewProp( root, _x("LC_NUMERIC"), _x( lcnumeric ) );
+		xml_attribute( context, "LC_NUMERIC", lcnumeric );
 	}
 #else
-		xmlNewProp( root, _x("LC_NUMERIC"), _x( setlocale( LC_NUMERIC, NULL ) ) );
+		xml_attribute( context, "LC_NUMERIC", setlocale( LC_NUMERIC, NULL ) );
 #endif
 
 	// Indicate the version
-	xmlNewProp( root, _x("version"), _x( mlt_version_get_string() ) );
+	xml_attribute( context, "version", mlt_version_get_string() );
 
 	// If we have root, then deal with it now
 	if ( mlt_properties_get( properties, "root" ) != NULL )
 	{
 		if ( !mlt_properties_get_int( MLT_CONSUMER_PROPERTIES( consumer ), "no_root" ) )
-			xmlNewProp( root, _x("root"), _x(mlt_properties_get( properties, "root" )) );
+			xml_attribute( context, "root", mlt_properties_get( properties, "root" ) );
 		context->root = strdup( mlt_properties_get( properties, "root" ) );
 	}
 	else
@@ -859,43 +1531,50 @@ xmlDocPtr xml_make_doc( mlt_consumer consumer, mlt_service service )
 
 	// Assign a title property
 	if ( mlt_properties_get( properties, "title" ) != NULL )
-		xmlNewProp( root, _x("title"), _x(mlt_properties_get( properties, "title" )) );
+		xml_attribute( context, "title", mlt_properties_get( properties, "title" ) );
 
 	// Add a profile child element
 	if ( profile )
 	{
 		if ( !mlt_properties_get_int( MLT_CONSUMER_PROPERTIES( consumer ), "no_profile" ) )
 		{
-			xmlNodePtr profile_node = xmlNewChild( root, NULL, _x("profile"), NULL );
+			xml_start( context, "profile" );
 			if ( profile->description )
-				xmlNewProp( profile_node, _x("description"), _x(profile->description) );
+				xml_attribute( context, "description", profile->description );
 			sprintf( tmpstr, "%d", profile->width );
-			xmlNewProp( profile_node, _x("width"), _x(tmpstr) );
+			xml_attribute( context, "width", tmpstr );
 			sprintf( tmpstr, "%d", profile->height );
-			xmlNewProp( profile_node, _x("height"), _x(tmpstr) );
+			xml_attribute( context, "height", tmpstr );
 			sprintf( tmpstr, "%d", profile->progressive );
-			xmlNewProp( profile_node, _x("progressive"), _x(tmpstr) );
+			xml_attribute( context, "progressive", tmpstr );
 			sprintf( tmpstr, "%d", profile->sample_aspect_num );
-			xmlNewProp( profile_node, _x("sample_aspect_num"), _x(tmpstr) );
+			xml_attribute( context, "sample_aspect_num", tmpstr );
 			sprintf( tmpstr, "%d", profile->sample_aspect_den );
-			xmlNewProp( profile_node, _x("sample_aspect_den"), _x(tmpstr) );
+			xml_attribute( context, "sample_aspect_den", tmpstr );
 			sprintf( tmpstr, "%d", profile->display_aspect_num );
-			xmlNewProp( profile_node, _x("display_aspect_num"), _x(tmpstr) );
+			xml_attribute( context, "display_aspect_num", tmpstr );
 			sprintf( tmpstr, "%d", profile->display_aspect_den );
-			xmlNewProp( profile_node, _x("display_aspect_den"), _x(tmpstr) );
+			xml_attribute( context, "display_aspect_den", tmpstr );
 			sprintf( tmpstr, "%d", profile->frame_rate_num );
-			xmlNewProp( profile_node, _x("frame_rate_num"), _x(tmpstr) );
+			xml_attribute( context, "frame_rate_num", tmpstr );
 			sprintf( tmpstr, "%d", profile->frame_rate_den );
-			xmlNewProp( profile_node, _x("frame_rate_den"), _x(tmpstr) );
+			xml_attribute( context, "frame_rate_den", tmpstr );
 			sprintf( tmpstr, "%d", profile->colorspace );
-			xmlNewProp( profile_node, _x("colorspace"), _x(tmpstr) );
+			xml_attribute( context, "colorspace", tmpstr );
+			xml_end( context );
 		}
 		context->profile = profile;
 	}
 
-	// Construct the context maps
-	context->id_map = mlt_properties_new();
-	context->hide_map = mlt_properties_new();
+	// Keep the elements for the next save
+	if ( mlt_properties_get_int( MLT_CONSUMER_PROPERTIES( consumer ), "incremental" ) )
+	{
+		context->key = serialise_key( context );
+		context->consumer = consumer;
+		context->watching = mlt_properties_new();
+		context->watched = mlt_properties_get_data( MLT_CONSUMER_PROPERTIES( consumer ), WATCHING_PROPERTY, NULL );
+		mlt_properties_inc_ref( context->watched );
+	}
 
 	// Ensure producer is a framework producer
 	mlt_properties_set_int( properties, "_original_type", mlt_service_identify( service ) );
@@ -903,38 +1582,67 @@ xmlDocPtr xml_make_doc( mlt_consumer consumer, mlt_service service )
 
 	// In pass one, we serialise the end producers and playlists,
 	// adding them to a map keyed by address.
-	serialise_other( MLT_SERVICE_PROPERTIES( service ), context, root );
-	serialise_service( context, service, root );
+	serialise_other( MLT_SERVICE_PROPERTIES( service ), context );
+	serialise_service( context, service );
 
 	// In pass two, we serialise the tractor and reference the
 	// producers and playlists
 	context->pass++;
-	serialise_other( MLT_SERVICE_PROPERTIES( service ), context, root );
-	serialise_service( context, service, root );
+	serialise_other( MLT_SERVICE_PROPERTIES( service ), context );
+	serialise_service( context, service );
+
+	// Put the root element around the children
+	buffer_puts( &document, ascii ? "<?xml version=\"1.0\"?>\n" : "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n" );
+	buffer_puts( &document, "<mlt" );
+	if ( context->attributes.used )
+		buffer_append( &document, context->attributes.data, context->attributes.used );
+	if ( context->output.used )
+	{
+		buffer_puts( &document, format ? ">\n" : ">" );
+		buffer_append( &document, context->output.data, context->output.used );
+		buffer_puts( &document, "</mlt>\n" );
+	}
+	else
+	{
+		buffer_puts( &document, "/>\n" );
+	}
+
+	// Stop listening to the services that this save did not reach
+	if ( context->watching )
+		mlt_properties_set_data( MLT_CONSUMER_PROPERTIES( consumer ), WATCHING_PROPERTY, context->watching, 0, ( mlt_destructor )mlt_properties_close, NULL );
+	else
+		mlt_properties_set_data( MLT_CONSUMER_PROPERTIES( consumer ), WATCHING_PROPERTY, NULL, 0, NULL, NULL );
+	mlt_properties_close( context->watched );
 
 	// Cleanup resource
-	mlt_properties_close( context->id_map );
-	mlt_properties_close( context->hide_map );
+	id_map_close( &context->id_map );
+	free( context->output.data );
+	free( context->attributes.data );
+	free( context->elements );
+	free( context->key );
 	free( context->root );
 	free( context );
 
-	return doc;
+	*length = document.used;
+	return document.data;
 }
 
-
 static void output_xml( mlt_consumer consumer )
 {
 	// Get the producer service
 	mlt_service service = mlt_service_producer( MLT_CONSUMER_SERVICE( consumer ) );
 	mlt_properties properties = MLT_CONSUMER_PROPERTIES( consumer );
 	char *resource =  mlt_properties_get( properties, "resource" );
-	xmlDocPtr doc = NULL;
+	const char *title = mlt_properties_get( properties, "title" );
+	char *text = NULL;
+	size_t length = 0;
 
 	if ( !service ) return;
 
 	// Set the title if provided
-	if ( mlt_properties_get( properties, "title" ) )
-		mlt_properties_set( MLT_SERVICE_PROPERTIES( service ), "title", mlt_properties_get( properties, "title" ) );
+	if ( title && ( !mlt_properties_get( MLT_SERVICE_PROPERTIES( service ), "title" )
+			|| strcmp( title, mlt_properties_get( MLT_SERVICE_PROPERTIES( service ), "title" ) ) ) )
+		mlt_properties_set( MLT_SERVICE_PROPERTIES( service ), "title", title );
 
 	// Check for a root on the consumer properties and pass to service
 	if ( mlt_properties_get( properties, "root" ) )
@@ -949,34 +1657,62 @@ static void output_xml( mlt_consumer consumer )
 		free( cwd );
 	}
 
-	// Make the document
-	doc = xml_make_doc( consumer, service );
-
 	// Handle the output
-	if ( resource == NULL || !strcmp( resource, "" ) )
+	if ( mlt_properties_get_int( properties, "_binary" ) )
 	{
-		xmlDocFormatDump( stdout, doc, 1 );
+		size_t size = 0;
+		void *buffer = NULL;
+
+		text = serialise_document( consumer, service, 0, 0, &length );
+		buffer = text ? mlt_xml_binary_encode( text, length, &size ) : NULL;
+		if ( buffer == NULL )
+		{
+			mlt_log_error( MLT_CONSUMER_SERVICE( consumer ), "failed to encode the document\n" );
+		}
+		else if ( resource == NULL || !strcmp( resource, "" ) )
+		{
+			fwrite( buffer, 1, size, stdout );
+		}
+		else if ( strchr( resource, '.' ) == NULL )
+		{
+			// The data property has the size of the document
+			mlt_properties_set_data( properties, resource, buffer, size, free, NULL );
+			buffer = NULL;
+		}
+		else
+		{
+			FILE *file = mlt_fopen( resource, "wb" );
+			if ( file == NULL || fwrite( buffer, 1, size, file ) != size )
+				mlt_log_error( MLT_CONSUMER_SERVICE( consumer ), "failed to write %s\n", resource );
+			if ( file )
+				fclose( file );
+		}
+		free( buffer );
+	}
+	else if ( resource == NULL || !strcmp( resource, "" ) )
+	{
+		text = serialise_document( consumer, service, 1, 1, &length );
+		if ( text )
+			fwrite( text, 1, length, stdout );
 	}
 	else if ( strchr( resource, '.' ) == NULL )
 	{
-		xmlChar *buffer = NULL;
-		int length = 0;
-		xmlDocDumpMemoryEnc( doc, &buffer, &length, "utf-8" );
-		mlt_properties_set( properties, resource, _s(buffer) );
-#ifdef _WIN32
-		xmlFreeFunc xmlFree = NULL;
-		xmlMemGet( &xmlFree, NULL, NULL, NULL);
-#endif
-		xmlFree( buffer );
+		text = serialise_document( consumer, service, 0, 0, &length );
+		mlt_properties_set( properties, resource, text );
 	}
 	else
 	{
-		xmlSaveFormatFileEnc( resource, doc, "utf-8", 1 );
+		text = serialise_document( consumer, service, 1, 0, &length );
+		FILE *file = text ? mlt_fopen( resource, "wb" ) : NULL;
+		if ( file == NULL || fwrite( text, 1, length, file ) != length )
+			mlt_log_error( MLT_CONSUMER_SERVICE( consumer ), "failed to write %s\n", resource );
+		if ( file )
+			fclose( file );
 	}
 
-	// Close the document
-	xmlFreeDoc( doc );
+	free( text );
 }
+
 static int consumer_start( mlt_consumer consumer )
 {
 	mlt_properties properties = MLT_CONSUMER_PROPERTIES( consumer );
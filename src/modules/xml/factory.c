@@ -34,12 +34,16 @@ static mlt_properties metadata( mlt_service_type type, const char *id, void *dat
 MLT_REPOSITORY
 {
 	MLT_REGISTER( mlt_service_consumer_type, "xml", consumer_xml_init );
+	MLT_REGISTER( mlt_service_consumer_type, "xml-binary", consumer_xml_init );
 	MLT_REGISTER( mlt_service_producer_type, "xml", producer_xml_init );
 	MLT_REGISTER( mlt_service_producer_type, "xml-string", producer_xml_init );
 	MLT_REGISTER( mlt_service_producer_type, "xml-nogl", producer_xml_init );
+	MLT_REGISTER( mlt_service_producer_type, "xml-binary", producer_xml_init );
 
 	MLT_REGISTER_METADATA( mlt_service_consumer_type, "xml", metadata, "consumer_xml.yml" );
+	MLT_REGISTER_METADATA( mlt_service_consumer_type, "xml-binary", metadata, "consumer_xml-binary.yml" );
 	MLT_REGISTER_METADATA( mlt_service_producer_type, "xml", metadata, "producer_xml.yml" );
 	MLT_REGISTER_METADATA( mlt_service_producer_type, "xml-string", metadata, "producer_xml-string.yml" );
 	MLT_REGISTER_METADATA( mlt_service_producer_type, "xml-nogl", metadata, "producer_xml-nogl.yml" );
+	MLT_REGISTER_METADATA( mlt_service_producer_type, "xml-binary", metadata, "producer_xml-binary.yml" );
 }
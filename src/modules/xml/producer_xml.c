@@ -21,6 +21,7 @@
 //       when the returned producer is closed).
 
 #include "common.h"
+#include "binary.h"
 
 #include <framework/mlt.h>
 #include <framework/mlt_log.h>
@@ -38,11 +39,6 @@
 #define _x (const xmlChar*)
 #define _s (const char*)
 
-#undef DEBUG
-#ifdef DEBUG
-extern xmlDocPtr xml_make_doc( mlt_service service );
-#endif
-
 enum service_type
 {
 	mlt_invalid_type,
@@ -1976,6 +1972,43 @@ static void context_close( deserialise_context context )
 	free( context );
 }
 
+/** Create a parser context for a document.
+ *
+ * For a binary document, this is only a holder for our context.
+ */
+
+static struct _xmlParserCtxt *parser_new( const char *filename, const char *data, const void *binary )
+{
+	if ( binary )
+		return calloc( 1, sizeof( struct _xmlParserCtxt ) );
+	else if ( filename )
+		return xmlCreateFileParserCtxt( filename );
+	else
+		return xmlCreateMemoryParserCtxt( data, strlen( data ) );
+}
+
+static void parser_parse( struct _xmlParserCtxt *xmlcontext, const void *binary, size_t binary_size )
+{
+	if ( binary )
+		xmlcontext->wellFormed = !mlt_xml_binary_parse( binary, binary_size, xmlcontext->sax, xmlcontext );
+	else
+		xmlParseDocument( xmlcontext );
+}
+
+static void parser_close( struct _xmlParserCtxt *xmlcontext, const void *binary )
+{
+	if ( binary )
+	{
+		free( xmlcontext );
+	}
+	else
+	{
+		if ( xmlcontext->myDoc )
+			xmlFreeDoc( xmlcontext->myDoc );
+		xmlFreeParserCtxt( xmlcontext );
+	}
+}
+
 mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype, const char *id, char *data )
 {
 	xmlSAXHandler *sax, *sax_orig;
@@ -1986,6 +2019,9 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 	int well_formed = 0;
 	char *filename = NULL;
 	int is_filename = strcmp( id, "xml-string" );
+	int is_binary = !strcmp( id, "xml-binary" );
+	void *binary = NULL;
+	size_t binary_size = 0;
 
 	// Strip file:// prefix
 	if ( data && strlen( data ) >= 7 && strncmp( data, "file://", 7 ) == 0 )
@@ -2042,6 +2078,12 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 			context_close( context );
 			return NULL;
 		}
+
+		if ( is_binary && !( binary = mlt_xml_binary_map( filename, &binary_size ) ) )
+		{
+			context_close( context );
+			return NULL;
+		}
 	}
 
 	// We need to track the number of registered filters
@@ -2060,14 +2102,12 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 	xmlSubstituteEntitiesDefault( 1 );
 	// This is used to facilitate entity substitution in the SAX parser
 	context->entity_doc = xmlNewDoc( _x("1.0") );
-	if ( is_filename )
-		xmlcontext = xmlCreateFileParserCtxt( filename );
-	else
-		xmlcontext = xmlCreateMemoryParserCtxt( data, strlen( data ) );
+	xmlcontext = parser_new( is_filename ? filename : NULL, data, binary );
 
 	// Invalid context - clean up and return NULL
 	if ( xmlcontext == NULL )
 	{
+		mlt_xml_binary_unmap( binary, binary_size );
 		context_close( context );
 		free( sax );
 		return NULL;
@@ -2077,19 +2117,18 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 	sax_orig = xmlcontext->sax;
 	xmlcontext->sax = sax;
 	xmlcontext->_private = ( void* )context;	
-	xmlParseDocument( xmlcontext );
+	parser_parse( xmlcontext, binary, binary_size );
 	well_formed = xmlcontext->wellFormed;
 	
 	// Cleanup after parsing
 	xmlcontext->sax = sax_orig;
 	xmlcontext->_private = NULL;
-	if ( xmlcontext->myDoc )
-		xmlFreeDoc( xmlcontext->myDoc );
-	xmlFreeParserCtxt( xmlcontext );
+	parser_close( xmlcontext, binary );
 
 	// Bad xml - clean up and return NULL
 	if ( !well_formed )
 	{
+		mlt_xml_binary_unmap( binary, binary_size );
 		context_close( context );
 		free( sax );
 		return NULL;
@@ -2097,14 +2136,12 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 
 	// Setup the second pass
 	context->pass ++;
-	if ( is_filename )
-		xmlcontext = xmlCreateFileParserCtxt( filename );
-	else
-		xmlcontext = xmlCreateMemoryParserCtxt( data, strlen( data ) );
+	xmlcontext = parser_new( is_filename ? filename : NULL, data, binary );
 
 	// Invalid context - clean up and return NULL
 	if ( xmlcontext == NULL )
 	{
+		mlt_xml_binary_unmap( binary, binary_size );
 		context_close( context );
 		free( sax );
 		return NULL;
@@ -2138,7 +2175,7 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 	sax_orig = xmlcontext->sax;
 	xmlcontext->sax = sax;
 	xmlcontext->_private = ( void* )context;
-	xmlParseDocument( xmlcontext );
+	parser_parse( xmlcontext, binary, binary_size );
 	well_formed = xmlcontext->wellFormed;
 
 	// Cleanup after parsing
@@ -2148,9 +2185,8 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 	xmlMemoryDump( ); // for debugging
 	xmlcontext->sax = sax_orig;
 	xmlcontext->_private = NULL;
-	if ( xmlcontext->myDoc )
-		xmlFreeDoc( xmlcontext->myDoc );
-	xmlFreeParserCtxt( xmlcontext );
+	parser_close( xmlcontext, binary );
+	mlt_xml_binary_unmap( binary, binary_size );
 
 	// Get the last producer on the stack
 	enum service_type type;
@@ -2164,13 +2200,6 @@ mlt_producer producer_xml_init( mlt_profile profile, mlt_service_type servtype,
 			service = NULL;
 	}
 
-#ifdef DEBUG
-	xmlDocPtr doc = xml_make_doc( service );
-	xmlDocFormatDump( stdout, doc, 1 );
-	xmlFreeDoc( doc );
-	service = NULL;
-#endif
-	
 	if ( well_formed && service != NULL )
 	{
 		char *title = mlt_properties_get( context->producer_map, "title" );
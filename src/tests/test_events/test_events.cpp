@@ -51,6 +51,14 @@ private:
         self->checkOwner(owner);
     }
 
+    static void onInheritChanged(mlt_properties owner, int* count, mlt_event_data)
+    {
+        // All of the properties are set before the first notification.
+        QCOMPARE(mlt_properties_get_int(owner, "a"), 1);
+        QCOMPARE(mlt_properties_get_int(owner, "b"), 2);
+        ++*count;
+    }
+
 private Q_SLOTS:
     
     void ListenToPropertyChanged()
@@ -93,7 +101,36 @@ private Q_SLOTS:
         producer.set("foo", 1);
         delete event;
     }
-  
+
+    void HasListeners()
+    {
+        Profile profile;
+        Filter filter(profile, "crop");
+        QVERIFY(filter.is_valid());
+        QVERIFY(!mlt_events_has_listeners(filter.get_properties(), "property-changed"));
+        Event* event = filter.listen("property-changed", this, (mlt_listener) onPropertyChanged);
+        QVERIFY(mlt_events_has_listeners(filter.get_properties(), "property-changed"));
+        QVERIFY(!mlt_events_has_listeners(filter.get_properties(), "service-changed"));
+        delete event;
+        QVERIFY(!mlt_events_has_listeners(filter.get_properties(), "property-changed"));
+    }
+
+    void InheritFiresAfterAllSet()
+    {
+        Profile profile;
+        Filter filter(profile, "crop");
+        Properties source;
+        source.set("a", 1);
+        source.set("b", 2);
+        int count = 0;
+        Event* event = filter.listen("property-changed", &count, (mlt_listener) onInheritChanged);
+        filter.inherit(source);
+        QCOMPARE(count, 2);
+        count = 0;
+        filter.pass_list(source, "a,b,a");
+        QCOMPARE(count, 2);
+        delete event;
+    }
 };
 
 QTEST_APPLESS_MAIN(TestEvents)
@@ -17,6 +17,7 @@
  */
 
 #include <QtTest>
+#include <QTemporaryDir>
 #include <mlt++/Mlt.h>
 using namespace Mlt;
 
@@ -70,6 +71,382 @@ private Q_SLOTS:
         delete frame;
     }
 
+    void AnalyzeInChunksMatchesInOrder()
+    {
+        Profile profile("dv_pal");
+        Producer producer(profile, "tone:");
+        producer.set("length", 4500);
+        producer.set("out", 4499);
+        producer.set("level", "0=-30;4499=-10");
+        double loudness[2] = {0.0, 0.0};
+
+        for (int i = 0; i < 2; i++) {
+            Filter filter(profile, "loudness");
+            if (!filter.is_valid())
+                QSKIP("loudness filter is not available");
+            producer.attach(filter);
+            QCOMPARE(filter.analyze(producer, i + 1), 0);
+            QVERIFY(filter.get("results"));
+            QCOMPARE(sscanf(filter.get("results"), "L: %lf", &loudness[i]), 1);
+            producer.detach(filter);
+        }
+        QVERIFY(qAbs(loudness[0] - loudness[1]) < 0.05);
+    }
+
+    void RenderCacheSeesNestedChanges()
+    {
+        Profile profile("dv_pal");
+        Producer colour(profile, "colour:0xff0000ff");
+        Playlist inner(profile);
+        Playlist outer(profile);
+        Filter cache(profile, "render_cache");
+        inner.append(colour, 0, 9);
+        outer.append(inner);
+        outer.attach(cache);
+
+        int red = firstByte(outer, 0);
+        QVERIFY(red > 200);
+        // A hit must not share changes made to a writable image.
+        QCOMPARE(firstByte(outer, 0, true), red);
+        QCOMPARE(firstByte(outer, 0), red);
+
+        // A change inside the nested playlist is a new segment.
+        colour.set("resource", "0x0000ffff");
+        QVERIFY(firstByte(outer, 0) < 50);
+
+        // So is a change to a filter attached to the clip.
+        Filter brightness(profile, "brightness");
+        brightness.set("level", 1.0);
+        colour.attach(brightness);
+        colour.set("resource", "0xc8c8c8ff");
+        int before = firstByte(outer, 0);
+        brightness.set("level", 0.5);
+        QVERIFY(firstByte(outer, 0) < before);
+    }
+
+    void RenderCacheHitSharesImage()
+    {
+        Profile profile("dv_pal");
+        Producer noise(profile, "noise");
+        Playlist playlist(profile);
+        Filter cache(profile, "render_cache");
+        playlist.append(noise, 0, 9);
+        playlist.attach(cache);
+
+        mlt_image_format format = mlt_image_rgba;
+        int width = 0;
+        int height = 0;
+        Frame *first = playlist.get_frame();
+        uint8_t *a = first->get_image(format, width, height);
+        playlist.seek(0);
+        format = mlt_image_rgba;
+        width = height = 0;
+        Frame *second = playlist.get_frame();
+        uint8_t *b = second->get_image(format, width, height);
+        QVERIFY(a == b);
+        delete first;
+        delete second;
+    }
+
+    void RenderCacheIgnoresReportedResults()
+    {
+        Profile profile("dv_pal");
+        Producer noise(profile, "noise");
+        Playlist playlist(profile);
+        Filter cache(profile, "render_cache");
+        Filter meter(profile, "loudness_meter");
+        if (!meter.is_valid())
+            QSKIP("loudness_meter filter is not available");
+        noise.attach(meter);
+        playlist.append(noise, 0, 9);
+        playlist.attach(cache);
+
+        // The meter reports its levels in its properties on every frame.
+        uint8_t *images[4];
+        int positions[4] = {0, 1, 0, 0};
+        for (int i = 0; i < 4; i++) {
+            mlt_image_format format = mlt_image_rgba;
+            mlt_audio_format audio_format = mlt_audio_float;
+            int width = 0;
+            int height = 0;
+            int frequency = 48000;
+            int channels = 2;
+            int samples = 1920;
+            playlist.seek(positions[i]);
+            Frame *frame = playlist.get_frame();
+            images[i] = frame->get_image(format, width, height);
+            frame->get_audio(audio_format, frequency, channels, samples);
+            delete frame;
+        }
+        QVERIFY(images[2] == images[3]);
+    }
+
+    void RenderCacheTrimsDirectory()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        Profile profile("dv_pal");
+        Producer noise(profile, "noise");
+        Playlist playlist(profile);
+        Filter cache(profile, "render_cache", dir.path().toUtf8().constData());
+        cache.set("frames", 0);
+        cache.set("disk_size", 5);
+        playlist.append(noise, 0, 99);
+        playlist.attach(cache);
+
+        for (int i = 0; i < 20; i++)
+            firstByte(playlist, i);
+        qint64 size = 0;
+        for (const QFileInfo &info : QDir(dir.path()).entryInfoList(QDir::Files))
+            size += info.size();
+        QVERIFY(size > 0);
+        QVERIFY(size <= 5 * 1024 * 1024);
+    }
+
+    void KeyersDoNotChangeSharedImages()
+    {
+        Profile profile("dv_pal");
+        Producer colour(profile, "colour", "0x00ff0080");
+        Filter chroma(profile, "chroma");
+        chroma.set("key", 0x00ff00ff);
+        Filter lumakey(profile, "lumakey");
+
+        // The colour producer gives every frame the same shared buffers
+        mlt_image_format format = mlt_image_yuv422;
+        int width = 0;
+        int height = 0;
+        Frame *clean = colour.get_frame();
+        QVERIFY(clean->get_image(format, width, height));
+        QCOMPARE(int(mlt_frame_get_alpha(clean->get_frame())[0]), 128);
+
+        colour.seek(0);
+        Frame *keyed = colour.get_frame();
+        chroma.process(*keyed);
+        format = mlt_image_yuv422;
+        width = height = 0;
+        QVERIFY(keyed->get_image(format, width, height));
+        QCOMPARE(int(mlt_frame_get_alpha(keyed->get_frame())[0]), 0);
+        QCOMPARE(int(mlt_frame_get_alpha(clean->get_frame())[0]), 128);
+        delete keyed;
+
+        colour.seek(0);
+        keyed = colour.get_frame();
+        lumakey.process(*keyed);
+        format = mlt_image_rgba;
+        width = height = 0;
+        QCOMPARE(int(keyed->get_image(format, width, height)[3]), 255);
+        delete keyed;
+
+        colour.seek(0);
+        Frame *other = colour.get_frame();
+        format = mlt_image_rgba;
+        width = height = 0;
+        QCOMPARE(int(other->get_image(format, width, height)[3]), 128);
+        delete other;
+        delete clean;
+    }
+
+    void StackedLoudnessMetersMatchSeparateOnes()
+    {
+        Profile profile("dv_pal");
+
+        // In the second pass the first meter does not measure the true peak,
+        // so the second one cannot reuse the analysis for it
+        for (bool mixed : {false, true}) {
+            Producer stacked(profile, "tone");
+            Producer alone(profile, "tone");
+            Filter first(profile, "loudness_meter");
+            Filter second(profile, "loudness_meter");
+            Filter single(profile, "loudness_meter");
+            for (Producer *producer : {&stacked, &alone}) {
+                producer->set("level", "0=-30;50=-6;100=-20;150=-12");
+                producer->set("frequency", 11900);
+            }
+            if (mixed)
+                first.set("calc_true_peak", 0);
+            stacked.attach(first);
+            stacked.attach(second);
+            alone.attach(single);
+
+            for (int i = 0; i < 200; i++) {
+                for (Producer *producer : {&stacked, &alone}) {
+                    producer->seek(i);
+                    Frame *frame = producer->get_frame();
+                    mlt_audio_format format = mlt_audio_float;
+                    int frequency = 48000;
+                    int channels = 2;
+                    int samples = mlt_audio_calculate_frame_samples(25, frequency, i);
+                    QVERIFY(frame->get_audio(format, frequency, channels, samples));
+                    delete frame;
+                }
+            }
+
+            for (const char *name : {"program", "range", "max_true_peak", "max_peak"}) {
+                QVERIFY(qAbs(second.get_double(name) - single.get_double(name)) < 1e-6);
+                if (!mixed || strcmp(name, "max_true_peak"))
+                    QVERIFY(qAbs(first.get_double(name) - single.get_double(name)) < 1e-6);
+            }
+            QVERIFY(single.get_double("program") > -20.0);
+        }
+    }
+
+    void RotoscopingMaskIsReusedOnlyForTheSameShape()
+    {
+        Profile profile("dv_pal");
+        Producer colour(profile, "colour", "0xffffffff");
+        const int size = 720 * 576;
+
+        // A constant square covering the middle quarter of the frame
+        Filter constant(profile, "rotoscoping");
+        QVERIFY(constant.is_valid());
+        constant.set("spline", rectangleSpline(0.25, 0.25, 0.75, 0.75).constData());
+        QByteArray square = rotoscopingMask(colour, constant, 0);
+        void *cached = constant.get_data("_mask");
+        QVERIFY(cached);
+        QCOMPARE(square.size(), size);
+        QCOMPARE(square.count(char(255)), 360 * 288);
+        QCOMPARE(square.count(char(0)), size - 360 * 288);
+        QCOMPARE(uchar(square[144 * 720 + 180]), uchar(255));
+        QCOMPARE(uchar(square[143 * 720 + 179]), uchar(0));
+        QCOMPARE(rotoscopingMask(colour, constant, 3), square);
+        QCOMPARE(constant.get_data("_mask"), cached);
+
+        // A square moving right, which is held after its last keyframe. The
+        // coordinates are exact in binary, so the halfway shape matches a
+        // constant one.
+        Filter keyed(profile, "rotoscoping");
+        QByteArray spline = "{\"0\":" + rectangleSpline(0.25, 0.25, 0.75, 0.75)
+            + ",\"10\":" + rectangleSpline(0.375, 0.25, 0.875, 0.75) + "}";
+        keyed.set("spline", spline.constData());
+        Filter halfway(profile, "rotoscoping");
+        halfway.set("spline", rectangleSpline(0.3125, 0.25, 0.8125, 0.75).constData());
+        QCOMPARE(rotoscopingMask(colour, keyed, 0), square);
+        cached = keyed.get_data("_mask");
+        QCOMPARE(rotoscopingMask(colour, keyed, 5), rotoscopingMask(colour, halfway, 0));
+        QVERIFY(keyed.get_data("_mask") != cached);
+        QByteArray last = rotoscopingMask(colour, keyed, 10);
+        QVERIFY(last != square);
+        cached = keyed.get_data("_mask");
+        QCOMPARE(rotoscopingMask(colour, keyed, 20), last);
+        QCOMPARE(keyed.get_data("_mask"), cached);
+        QCOMPARE(rotoscopingMask(colour, keyed, 0), square);
+
+        // Antialiasing gives the edge pixels of a triangle their coverage
+        Filter triangle(profile, "rotoscoping");
+        triangle.set("spline", "[[[0.25,0.25],[0.25,0.25],[0.25,0.25]],"
+                               "[[0.75,0.25],[0.75,0.25],[0.75,0.25]],"
+                               "[[0.25,0.75],[0.25,0.75],[0.25,0.75]]]");
+        QByteArray hard = rotoscopingMask(colour, triangle, 0);
+        cached = triangle.get_data("_mask");
+        QCOMPARE(hard.count(char(0)) + hard.count(char(255)), size);
+        triangle.set("antialias", 1);
+        QByteArray smooth = rotoscopingMask(colour, triangle, 0);
+        QVERIFY(triangle.get_data("_mask") != cached);
+        cached = triangle.get_data("_mask");
+        QCOMPARE(rotoscopingMask(colour, triangle, 7), smooth);
+        QCOMPARE(triangle.get_data("_mask"), cached);
+        QVERIFY(smooth.count(char(0)) + smooth.count(char(255)) < size);
+        QCOMPARE(uchar(smooth[200 * 720 + 250]), uchar(255));
+        QCOMPARE(uchar(smooth[400 * 720 + 500]), uchar(0));
+        double coverage = 0.0;
+        for (char value : smooth)
+            coverage += uchar(value) / 255.0;
+        QVERIFY(qAbs(coverage - 360 * 288 / 2) < 10.0);
+    }
+
+    void LoudnessMeterMeasuresReferenceTones()
+    {
+        Profile profile("dv_pal");
+
+        // A 1 kHz sine at -23 dBFS in every channel. The surround channels of
+        // 5.1 weigh 1.41, and its LFE and any channels after the sixth do not
+        // count, so 6 and 16 channels measure 10 * log10(5.82 / 2) dB more
+        // than stereo.
+        const struct { int channels; double program; } tones[] = {
+            {1, -26.01}, {2, -23.0}, {6, -18.36}, {16, -18.36}
+        };
+        for (const auto &tone : tones) {
+            Filter meter(profile, "loudness_meter");
+            meterTone(profile, meter, tone.channels, -23.0, 1000.0, 0.0);
+            QVERIFY(qAbs(meter.get_double("program") - tone.program) < 0.1);
+            QVERIFY(qAbs(meter.get_double("max_peak") + 23.0) < 0.01);
+            QVERIFY(qAbs(meter.get_double("max_true_peak") + 23.0) < 0.1);
+        }
+
+        // A 12 kHz sine at -6 dBFS sampled 45 degrees from its peaks, so the
+        // samples are 3 dB below the true peak. EBU Tech 3341 allows the true
+        // peak to read 0.4 dB low or 0.2 dB high.
+        Filter meter(profile, "loudness_meter");
+        meterTone(profile, meter, 2, -6.0, 12000.0, 45.0);
+        QVERIFY(qAbs(meter.get_double("max_peak") + 9.03) < 0.05);
+        QVERIFY(meter.get_double("max_true_peak") > -6.4);
+        QVERIFY(meter.get_double("max_true_peak") < -5.8);
+    }
+
+private:
+    static int firstByte(Producer &producer, int position, bool writable = false)
+    {
+        mlt_image_format format = mlt_image_rgba;
+        int width = 0;
+        int height = 0;
+        producer.seek(position);
+        Frame *frame = producer.get_frame();
+        uint8_t *image = frame->get_image(format, width, height, writable);
+        int result = image[0];
+        if (writable)
+            image[0] = 7;
+        delete frame;
+        return result;
+    }
+
+    static QByteArray rectangleSpline(double left, double top, double right, double bottom)
+    {
+        // The handles are on the points, so the edges are straight
+        QByteArray spline = "[";
+        const double corners[4][2] = {{left, top}, {right, top}, {right, bottom}, {left, bottom}};
+        for (int i = 0; i < 4; i++) {
+            QByteArray point = QString("[%1,%2]").arg(corners[i][0]).arg(corners[i][1]).toLatin1();
+            spline += (i ? ",[" : "[") + point + "," + point + "," + point + "]";
+        }
+        return spline + "]";
+    }
+
+    static QByteArray rotoscopingMask(Producer &producer, Filter &filter, int position)
+    {
+        mlt_image_format format = mlt_image_yuv422;
+        int width = 0;
+        int height = 0;
+        producer.seek(position);
+        Frame *frame = producer.get_frame();
+        filter.process(*frame);
+        frame->get_image(format, width, height);
+        QByteArray mask((const char *) mlt_frame_get_alpha(frame->get_frame()), width * height);
+        delete frame;
+        return mask;
+    }
+
+    static void meterTone(Profile &profile, Filter &meter, int channels, double level,
+                          double frequency, double phase)
+    {
+        Producer tone(profile, "tone");
+        tone.set("level", level);
+        tone.set("frequency", frequency);
+        tone.set("phase", phase);
+        // The tone is planar, which the meter needs converted
+        Filter convert(profile, "audioconvert");
+        tone.attach(convert);
+        tone.attach(meter);
+        for (int i = 0; i < 100; i++) {
+            tone.seek(i);
+            Frame *frame = tone.get_frame();
+            mlt_audio_format format = mlt_audio_float;
+            int rate = 48000;
+            int count = channels;
+            int samples = mlt_audio_calculate_frame_samples(25, rate, i);
+            QVERIFY(frame->get_audio(format, rate, count, samples));
+            delete frame;
+        }
+    }
 };
 
 QTEST_APPLESS_MAIN(TestFilter)
@@ -93,6 +93,255 @@ private Q_SLOTS:
         QCOMPARE(f1.ref_count(), 2);
         mlt_frame_close(frame);
     }
+
+    void ClosedFrameIsReinitialised()
+    {
+        mlt_frame frame = mlt_frame_init(NULL);
+        int count = mlt_properties_count(MLT_FRAME_PROPERTIES(frame));
+        mlt_properties_set(MLT_FRAME_PROPERTIES(frame), "foo", "bar");
+        mlt_frame_push_get_image(frame, NULL);
+        mlt_frame_push_audio(frame, NULL);
+        mlt_frame_close(frame);
+
+        frame = mlt_frame_init(NULL);
+        QCOMPARE(mlt_properties_count(MLT_FRAME_PROPERTIES(frame)), count);
+        QCOMPARE(mlt_properties_ref_count(MLT_FRAME_PROPERTIES(frame)), 1);
+        QVERIFY(!mlt_properties_get(MLT_FRAME_PROPERTIES(frame), "foo"));
+        QCOMPARE(mlt_properties_get_int(MLT_FRAME_PROPERTIES(frame), "width"), 720);
+        QCOMPARE(mlt_deque_count(MLT_FRAME_IMAGE_STACK(frame)), 0);
+        QCOMPARE(mlt_deque_count(MLT_FRAME_AUDIO_STACK(frame)), 0);
+        QVERIFY(!frame->convert_image);
+        mlt_frame_close(frame);
+    }
+
+    void QualityDefaultsToFull()
+    {
+        mlt_frame frame = mlt_frame_init(NULL);
+        QCOMPARE(mlt_frame_get_quality(frame), mlt_quality_full);
+        mlt_frame_set_quality(frame, mlt_quality_draft);
+        QCOMPARE(mlt_frame_get_quality(frame), mlt_quality_draft);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "consumer_quality", 10);
+        QCOMPARE(mlt_frame_get_quality(frame), mlt_quality_draft);
+        mlt_frame_close(frame);
+    }
+
+    void SharedImageIsCopiedOnWrite()
+    {
+        // Shared buffers and their copies come from the memory pool
+        Factory::init();
+        int size = mlt_image_format_size(mlt_image_rgb, 4, 2, NULL);
+        uint8_t *shared = (uint8_t *) mlt_image_shared_alloc(size);
+        memset(shared, 1, size);
+        mlt_frame a = mlt_frame_init(NULL);
+        mlt_frame b = mlt_frame_init(NULL);
+        for (mlt_frame frame : {a, b}) {
+            mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "format", mlt_image_rgb);
+            mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "width", 4);
+            mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "height", 2);
+            mlt_frame_set_image_shared(frame, shared, size);
+        }
+        mlt_image_shared_release(shared);
+        QCOMPARE(mlt_image_shared_count(shared), 2);
+
+        // Reading does not copy
+        uint8_t *image = NULL;
+        mlt_image_format format = mlt_image_rgb;
+        int width = 4;
+        int height = 2;
+        mlt_frame_get_image(a, &image, &format, &width, &height, 0);
+        QCOMPARE(image, shared);
+
+        // Writing copies and drops the reference
+        mlt_frame_get_image(a, &image, &format, &width, &height, 1);
+        QVERIFY(image != shared);
+        QCOMPARE(image[0], uint8_t(1));
+        QCOMPARE(mlt_image_shared_count(shared), 1);
+
+        // The last holder writes in place
+        mlt_frame_get_image(b, &image, &format, &width, &height, 1);
+        QCOMPARE(image, shared);
+
+        // A deep clone shares the image
+        mlt_frame clone = mlt_frame_clone(b, 1);
+        QCOMPARE((uint8_t *) mlt_properties_get_data(MLT_FRAME_PROPERTIES(clone), "image", NULL), shared);
+        QCOMPARE(mlt_image_shared_count(shared), 2);
+        mlt_frame_close(clone);
+        mlt_frame_close(b);
+        mlt_frame_close(a);
+    }
+
+    void OpacityIsForgottenWhenWritable()
+    {
+        int size = mlt_image_format_size(mlt_image_rgb, 4, 2, NULL);
+        mlt_frame frame = mlt_frame_init(NULL);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "format", mlt_image_rgb);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "width", 4);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "height", 2);
+        mlt_frame_set_image(frame, (uint8_t *) malloc(size), size, free);
+        QCOMPARE(mlt_frame_get_image_opacity(frame), -1);
+        mlt_frame_set_image_opacity(frame, 255);
+
+        // Reading keeps it
+        uint8_t *image = NULL;
+        mlt_image_format format = mlt_image_rgb;
+        int width = 4;
+        int height = 2;
+        mlt_frame_get_image(frame, &image, &format, &width, &height, 0);
+        QCOMPARE(mlt_frame_get_image_opacity(frame), 255);
+
+        // Writing forgets it
+        mlt_frame_get_image(frame, &image, &format, &width, &height, 1);
+        QCOMPARE(mlt_frame_get_image_opacity(frame), -1);
+
+        // So does replacing the image
+        mlt_frame_set_image_opacity(frame, 0);
+        QCOMPARE(mlt_frame_get_image_opacity(frame), 0);
+        mlt_frame_set_image(frame, (uint8_t *) malloc(size), size, free);
+        QCOMPARE(mlt_frame_get_image_opacity(frame), -1);
+        mlt_frame_close(frame);
+    }
+
+    void OpacityIsForgottenByFiltersThatDoNotKeepIt()
+    {
+        // A producer declares its image opaque; one filter keeps that, the other does not
+        for (bool keep : {false, true}) {
+            mlt_frame frame = mlt_frame_init(NULL);
+            mlt_frame_push_get_image(frame, opaqueImage);
+            mlt_frame_push_service(frame, (void *) keep);
+            mlt_frame_push_get_image(frame, filterImage);
+            uint8_t *image = NULL;
+            mlt_image_format format = mlt_image_rgb;
+            int width = 4;
+            int height = 2;
+            QCOMPARE(mlt_frame_get_image(frame, &image, &format, &width, &height, 0), 0);
+            QCOMPARE(mlt_frame_get_image_opacity(frame), keep ? 255 : -1);
+            mlt_frame_close(frame);
+        }
+
+        // Without a filter the producer's declaration holds
+        mlt_frame frame = mlt_frame_init(NULL);
+        mlt_frame_push_get_image(frame, opaqueImage);
+        uint8_t *image = NULL;
+        mlt_image_format format = mlt_image_rgb;
+        int width = 4;
+        int height = 2;
+        QCOMPARE(mlt_frame_get_image(frame, &image, &format, &width, &height, 0), 0);
+        QCOMPARE(mlt_frame_get_image_opacity(frame), 255);
+        mlt_frame_close(frame);
+    }
+
+    void ImageContentIsForgottenWhenWritable()
+    {
+        int size = mlt_image_format_size(mlt_image_rgba, 8, 8, NULL);
+        mlt_frame frame = mlt_frame_init(NULL);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "format", mlt_image_rgba);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "width", 8);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "height", 8);
+        mlt_frame_set_image(frame, (uint8_t *) malloc(size), size, free);
+        QVERIFY(!mlt_frame_get_image_content(frame, NULL));
+        mlt_rect rect = {2, 4, 3, 2, 1.0};
+        mlt_frame_set_image_content(frame, rect);
+
+        // Reading keeps it
+        uint8_t *image = NULL;
+        mlt_image_format format = mlt_image_rgba;
+        int width = 8;
+        int height = 8;
+        mlt_frame_get_image(frame, &image, &format, &width, &height, 0);
+        mlt_rect content;
+        QVERIFY(mlt_frame_get_image_content(frame, &content));
+        QCOMPARE(content.x, 2.0);
+        QCOMPARE(content.y, 4.0);
+        QCOMPARE(content.w, 3.0);
+        QCOMPARE(content.h, 2.0);
+
+        // Writing forgets it
+        mlt_frame_get_image(frame, &image, &format, &width, &height, 1);
+        QVERIFY(!mlt_frame_get_image_content(frame, NULL));
+        mlt_frame_close(frame);
+    }
+
+    void ImageContentIsForgottenByFiltersThatDoNotKeepIt()
+    {
+        for (bool keep : {false, true}) {
+            mlt_frame frame = mlt_frame_init(NULL);
+            mlt_frame_push_get_image(frame, titleImage);
+            mlt_frame_push_service(frame, (void *) keep);
+            mlt_frame_push_get_image(frame, filterImage);
+            uint8_t *image = NULL;
+            mlt_image_format format = mlt_image_rgba;
+            int width = 8;
+            int height = 8;
+            QCOMPARE(mlt_frame_get_image(frame, &image, &format, &width, &height, 0), 0);
+            mlt_rect content;
+            QCOMPARE(bool(mlt_frame_get_image_content(frame, &content)), keep);
+            if (keep)
+                QCOMPARE(content.x, 2.0);
+            mlt_frame_close(frame);
+        }
+    }
+
+    void SolidColourImpliesOpacity()
+    {
+        int size = mlt_image_format_size(mlt_image_rgba, 4, 2, NULL);
+        mlt_frame frame = mlt_frame_init(NULL);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "format", mlt_image_rgba);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "width", 4);
+        mlt_properties_set_int(MLT_FRAME_PROPERTIES(frame), "height", 2);
+        mlt_frame_set_image(frame, (uint8_t *) malloc(size), size, free);
+        QVERIFY(!mlt_frame_get_image_solid(frame, NULL));
+        mlt_color red = {255, 0, 0, 128};
+        mlt_frame_set_image_solid(frame, red);
+        mlt_color color;
+        QVERIFY(mlt_frame_get_image_solid(frame, &color));
+        QCOMPARE(color.r, uint8_t(255));
+        QCOMPARE(color.a, uint8_t(128));
+        QCOMPARE(mlt_frame_get_image_opacity(frame), 128);
+
+        // Declaring only the opacity replaces it
+        mlt_frame_set_image_opacity(frame, 255);
+        QVERIFY(!mlt_frame_get_image_solid(frame, NULL));
+
+        // Writing forgets it
+        mlt_frame_set_image_solid(frame, red);
+        uint8_t *image = NULL;
+        mlt_image_format format = mlt_image_rgba;
+        int width = 4;
+        int height = 2;
+        mlt_frame_get_image(frame, &image, &format, &width, &height, 1);
+        QVERIFY(!mlt_frame_get_image_solid(frame, NULL));
+        QCOMPARE(mlt_frame_get_image_opacity(frame), -1);
+        mlt_frame_close(frame);
+    }
+
+private:
+    static int titleImage(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int)
+    {
+        int size = mlt_image_format_size(*format, *width, *height, NULL);
+        *image = (uint8_t *) calloc(1, size);
+        mlt_frame_set_image(frame, *image, size, free);
+        mlt_rect rect = {2, 4, 3, 2, 1.0};
+        mlt_frame_set_image_content(frame, rect);
+        return 0;
+    }
+
+    static int opaqueImage(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int)
+    {
+        int size = mlt_image_format_size(*format, *width, *height, NULL);
+        *image = (uint8_t *) calloc(1, size);
+        mlt_frame_set_image(frame, *image, size, free);
+        mlt_frame_set_image_opacity(frame, 255);
+        return 0;
+    }
+
+    static int filterImage(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable)
+    {
+        bool keep = mlt_frame_pop_service(frame) != NULL;
+        int error = mlt_frame_get_image(frame, image, format, width, height, writable);
+        if (keep)
+            mlt_frame_keep_image_facts(frame);
+        return error;
+    }
 };
 
 QTEST_APPLESS_MAIN(TestFrame)
@@ -132,6 +132,70 @@ private Q_SLOTS:
 		i.init_alpha();
 		QVERIFY(i.plane(3) != nullptr);
 	}
+
+	void BoxBlurAverage()
+	{
+		uint8_t line[] = { 0, 0, 90, 0, 0 };
+		QCOMPARE(mlt_image_box_blur(line, 5, 1, 1, 2, 1, 1, 0, 1), 0);
+		// Each pixel averages itself and its neighbours inside the image.
+		QCOMPARE(int(line[0]), 0);
+		QCOMPARE(int(line[1]), 30);
+		QCOMPARE(int(line[2]), 30);
+		QCOMPARE(int(line[3]), 30);
+		QCOMPARE(int(line[4]), 0);
+	}
+
+	void BoxBlurAreaFadesEdges()
+	{
+		uint8_t image[4 * 4];
+		memset(image, 200, sizeof(image));
+		QCOMPARE(mlt_image_box_blur(image, 4, 4, 1, 1, 1, 1, 1, 0), 0);
+		QCOMPARE(int(image[0]), 50);
+		QCOMPARE(int(image[1 * 4 + 1]), 200);
+		QCOMPARE(int(image[3 * 4 + 3]), 50);
+	}
+
+	void BoxBlurRejectsEmptyWindow()
+	{
+		uint8_t pixel = 0;
+		QVERIFY(mlt_image_box_blur(&pixel, 1, 1, 1, 0, 0, 1, 1, 0) != 0);
+		QVERIFY(mlt_image_box_blur(&pixel, 1, 1, 1, 0, 1, 1, 0, 1) != 0);
+	}
+
+	void ApplyLutsYuv422()
+	{
+		// Three pixels: Y U Y V Y U
+		uint8_t image[] = { 10, 20, 30, 40, 50, 60 };
+		uint8_t y[256], u[256], v[256];
+		for (int i = 0; i < 256; i++) {
+			y[i] = i + 1;
+			u[i] = 128;
+			v[i] = 255 - i;
+		}
+		const uint8_t *luts[4] = { y, u, v, nullptr };
+		QCOMPARE(mlt_image_apply_luts(image, mlt_image_yuv422, 3, 1, luts), 0);
+		QCOMPARE(int(image[0]), 11);
+		QCOMPARE(int(image[1]), 128);
+		QCOMPARE(int(image[2]), 31);
+		QCOMPARE(int(image[3]), 215);
+		QCOMPARE(int(image[4]), 51);
+		QCOMPARE(int(image[5]), 128);
+	}
+
+	void ApplyLutsRgbaKeepsAlpha()
+	{
+		uint8_t image[] = { 1, 2, 3, 4 };
+		uint8_t invert[256];
+		for (int i = 0; i < 256; i++)
+			invert[i] = 255 - i;
+		const uint8_t *luts[4] = { invert, nullptr, invert, nullptr };
+		QCOMPARE(mlt_image_apply_luts(image, mlt_image_rgba, 1, 1, luts), 0);
+		QCOMPARE(int(image[0]), 254);
+		QCOMPARE(int(image[1]), 2);
+		QCOMPARE(int(image[2]), 252);
+		QCOMPARE(int(image[3]), 4);
+		QVERIFY(mlt_image_apply_luts(image, mlt_image_yuv420p, 1, 1, luts) != 0);
+	}
 };
 
 QTEST_APPLESS_MAIN(TestImage)
@@ -62,6 +62,180 @@ private Q_SLOTS:
 
 		delete cutService;
 	}
+
+	void BinaryProjectRoundTrips()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		QByteArray fileName = dir.filePath("project.mltb").toUtf8();
+		qputenv("MLT_XML_DEEP", "1");
+
+		Profile profile("dv_pal");
+		Playlist playlist(profile);
+		Producer red(profile, "color:red");
+		Producer blue(profile, "color:blue");
+		Filter filter(profile, "brightness");
+		filter.set("level", "0=0;50=0.5;99=1");
+		red.attach(filter);
+		playlist.append(red, 0, 99);
+		playlist.append(blue, 0, 49);
+
+		// Serialise to XML and load it back to get the canonical document
+		Consumer xml(profile, "xml", "string");
+		xml.connect(playlist);
+		xml.start();
+		Producer original(profile, "xml-string", xml.get("string"));
+		QVERIFY(original.is_valid());
+
+		// Write it in binary form and load it through the loader
+		Consumer binary(profile, "xml-binary", fileName.constData());
+		QVERIFY(binary.is_valid());
+		binary.connect(original);
+		binary.start();
+		Producer loaded(profile, fileName.constData());
+		QVERIFY(loaded.is_valid());
+		QCOMPARE(loaded.get_playtime(), original.get_playtime());
+
+		// Both serialise to the same document
+		Consumer a(profile, "xml", "string");
+		a.connect(original);
+		a.start();
+		Consumer b(profile, "xml", "string");
+		b.connect(loaded);
+		b.start();
+		QCOMPARE(QString(b.get("string")), QString(a.get("string")));
+		qunsetenv("MLT_XML_DEEP");
+	}
+
+	void IncrementalSaveMatchesFullSave()
+	{
+		Profile profile("dv_pal");
+		Tractor tractor(profile);
+		Playlist video(profile);
+		Playlist audio(profile);
+		Producer red(profile, "color:red");
+		Producer blue(profile, "color:blue");
+		Filter filter(profile, "brightness");
+		red.attach(filter);
+		video.append(red, 0, 99);
+		video.append(blue, 0, 49);
+		audio.append(blue, 0, 149);
+		tractor.set_track(video, 0);
+		tractor.set_track(audio, 1);
+
+		Consumer incremental(profile, "xml", "string");
+		incremental.set("incremental", 1);
+		incremental.connect(tractor);
+		for (int i = 0; i < 4; i++) {
+			if (i == 1)
+				filter.set("level", "0=0;50=0.5;99=1");
+			else if (i == 2)
+				video.move(0, 1);
+			else if (i == 3)
+				audio.set("hide", 1);
+			incremental.start();
+
+			Consumer full(profile, "xml", "string");
+			full.connect(tractor);
+			full.start();
+			QCOMPARE(QString(incremental.get("string")), QString(full.get("string")));
+		}
+	}
+
+	void LoadProject_data()
+	{
+		QTest::addColumn<QString>("service");
+		QTest::newRow("xml") << "xml";
+		QTest::newRow("xml-binary") << "xml-binary";
+	}
+
+	void LoadProject()
+	{
+		QFETCH(QString, service);
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		QByteArray fileName = dir.filePath(service == "xml" ? "project.mlt" : "project.mltb").toUtf8();
+		qputenv("MLT_XML_DEEP", "1");
+
+		// A project with many long keyframe animations
+		Profile profile("dv_pal");
+		Playlist playlist(profile);
+		for (int i = 0; i < 20; i++) {
+			Producer producer(profile, "color:red");
+			Filter filter(profile, "brightness");
+			QString level;
+			for (int j = 0; j < 1000; j++)
+				level += QString("%1=%2;").arg(j).arg(j % 100 / 100.0);
+			filter.set("level", level.toUtf8().constData());
+			producer.attach(filter);
+			playlist.append(producer, 0, 999);
+		}
+		Consumer consumer(profile, service.toUtf8().constData(), fileName.constData());
+		consumer.connect(playlist);
+		consumer.start();
+
+		QBENCHMARK {
+			Producer loaded(profile, service.toUtf8().constData(), fileName.constData());
+			QCOMPARE(loaded.get_playtime(), 20000);
+		}
+		qunsetenv("MLT_XML_DEEP");
+	}
+
+	void AvformatImageAfterAudioOnly()
+	{
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		QByteArray fileName = dir.filePath("red.nut").toUtf8();
+		Profile profile("dv_pal");
+		{
+			Producer colour(profile, "colour:0xff0000ff");
+			colour.set_in_and_out(0, 24);
+			Consumer consumer(profile, "avformat", fileName.constData());
+			if (!consumer.is_valid())
+				QSKIP("avformat is not available");
+			consumer.set("vcodec", "rawvideo");
+			consumer.set("acodec", "pcm_s16le");
+			consumer.set("terminate_on_pause", 1);
+			consumer.set("real_time", 0);
+			consumer.connect(colour);
+			consumer.run();
+		}
+
+		Producer producer(profile, "avformat", fileName.constData());
+		QVERIFY(producer.is_valid());
+		producer.set("audio_only_threshold", 5);
+
+		// Read only audio for long enough to switch to audio-only mode
+		for (int i = 0; i < 10; i++) {
+			Frame *frame = producer.get_frame();
+			mlt_audio_format format = mlt_audio_s16;
+			int frequency = 48000;
+			int channels = 2;
+			int samples = mlt_audio_calculate_frame_samples(25, frequency, i);
+			QVERIFY(frame->get_audio(format, frequency, channels, samples));
+			delete frame;
+		}
+
+		// A late image request must still get the video
+		Frame *frame = producer.get_frame();
+		mlt_image_format format = mlt_image_rgb;
+		int width = 0;
+		int height = 0;
+		uint8_t *image = frame->get_image(format, width, height);
+		QVERIFY(image);
+		QCOMPARE(width, 720);
+		QVERIFY(image[0] > 200);
+		QVERIFY(image[1] < 50);
+		delete frame;
+
+		// And the frames after it are read normally again
+		frame = producer.get_frame();
+		width = height = 0;
+		image = frame->get_image(format, width, height);
+		QVERIFY(image);
+		QVERIFY(image[0] > 200);
+		delete frame;
+	}
 };
 
 QTEST_APPLESS_MAIN(TestProducer)
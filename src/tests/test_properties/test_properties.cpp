@@ -1229,6 +1229,49 @@ private Q_SLOTS:
         QCOMPARE(p.get_int("foo"), 123);
         QCOMPARE(p.get_double("foo"), 123.4);
     }
+
+    void DataIsOnlyReturnedForData()
+    {
+        Properties p;
+        int size = -1;
+        p.set("key", 0x12345678);
+        QVERIFY(!p.get_data("key", size));
+        p.set("key", 3.14);
+        QVERIFY(!p.get_data("key", size));
+        p.set("key", &size, sizeof(size));
+        QCOMPARE(p.get_data("key", size), (void*) &size);
+        QCOMPARE(size, int(sizeof(size)));
+        p.set("key", 1);
+        QVERIFY(!p.get_data("key"));
+    }
+
+    void ResetRemovesAllProperties()
+    {
+        mlt_properties properties = mlt_properties_new();
+        int destroyed = 0;
+        mlt_properties_set_data(properties, "data", &destroyed, 0,
+            [](void *p) { ++*static_cast<int*>(p); }, NULL);
+        for (int i = 0; i < 100; i++)
+            mlt_properties_set_int(properties, QString("key%1").arg(i).toUtf8().constData(), i);
+        mlt_properties_inc_ref(properties);
+
+        mlt_properties_reset(properties);
+        QCOMPARE(destroyed, 1);
+        QCOMPARE(mlt_properties_count(properties), 0);
+        QCOMPARE(mlt_properties_ref_count(properties), 1);
+        QVERIFY(!mlt_properties_get(properties, "key1"));
+
+        // The recycled storage must behave like new.
+        for (int i = 0; i < 150; i++)
+            mlt_properties_set(properties, QString("name%1").arg(i).toUtf8().constData(), "value");
+        QCOMPARE(mlt_properties_count(properties), 150);
+        QCOMPARE(mlt_properties_get_name(properties, 149), "name149");
+        QCOMPARE(mlt_properties_get(properties, "name0"), "value");
+        QCOMPARE(mlt_properties_get_int(properties, "key0"), 0);
+        mlt_properties_rename(properties, "name0", "renamed");
+        QCOMPARE(mlt_properties_get(properties, "renamed"), "value");
+        mlt_properties_close(properties);
+    }
 };
 
 QTEST_APPLESS_MAIN(TestProperties)
@@ -402,6 +402,84 @@ private Q_SLOTS:
         QCOMPARE(t.count(), 1);
         QCOMPARE(filter.get_track(), 0);
     }
+
+    void ParallelTracksMatchSerialAudio()
+    {
+        QByteArray results[2];
+        for (int parallel = 0; parallel < 2; parallel++) {
+            Tractor t(profile);
+            t.set("parallel_tracks", parallel);
+            for (int i = 0; i < 3; i++) {
+                Producer p(profile, "tone");
+                QVERIFY(p.is_valid());
+                p.set("frequency", 200 + 100 * i);
+                t.set_track(p, t.count());
+            }
+            for (int i = 1; i < 3; i++) {
+                Transition trans(profile, "mix");
+                QVERIFY(trans.is_valid());
+                trans.set("always_active", 1);
+                trans.set("sum", 1);
+                t.plant_transition(trans, 0, i);
+            }
+            Frame* frame = t.get_frame();
+            mlt_audio_format format = mlt_audio_s16;
+            int frequency = 48000;
+            int channels = 2;
+            int samples = 1920;
+            void* audio = frame->get_audio(format, frequency, channels, samples);
+            QVERIFY(audio != nullptr);
+            results[parallel] = QByteArray((const char*) audio, samples * channels * 2);
+            delete frame;
+        }
+        QCOMPARE(results[1], results[0]);
+    }
+
+    void MixManyTracksMatchesSum()
+    {
+        const int count = 5;
+        const int frequency = 48000;
+        const int channels = 2;
+        const int samples = 1920;
+        Tractor t(profile);
+        float expected[samples * channels] = {0};
+        for (int i = 0; i < count; i++) {
+            Producer p(profile, "tone");
+            QVERIFY(p.is_valid());
+            p.set("frequency", 200 + 100 * i);
+            p.set("level", -20);
+            t.set_track(p, t.count());
+
+            Producer q(profile, "tone");
+            q.set("frequency", 200 + 100 * i);
+            q.set("level", -20);
+            Frame* frame = q.get_frame();
+            mlt_audio_format format = mlt_audio_f32le;
+            int f = frequency, c = channels, n = samples;
+            float* audio = (float*) frame->get_audio(format, f, c, n);
+            QVERIFY(audio != nullptr);
+            for (int j = 0; j < samples * channels; j++)
+                expected[j] += audio[j];
+            delete frame;
+        }
+        for (int i = 1; i < count; i++) {
+            Transition trans(profile, "mix");
+            QVERIFY(trans.is_valid());
+            trans.set("always_active", 1);
+            trans.set("sum", 1);
+            t.plant_transition(trans, 0, i);
+        }
+        Frame* frame = t.get_frame();
+        mlt_audio_format format = mlt_audio_f32le;
+        int f = frequency, c = channels, n = samples;
+        float* audio = (float*) frame->get_audio(format, f, c, n);
+        QVERIFY(audio != nullptr);
+        QCOMPARE(n, samples);
+        QCOMPARE(c, channels);
+        for (int j = 0; j < samples * channels; j++)
+            QVERIFY(qAbs(audio[j] - expected[j]) < 1e-5);
+        delete frame;
+    }
 };
 
 QTEST_APPLESS_MAIN(TestTractor)